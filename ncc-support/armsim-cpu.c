@@ -0,0 +1,1282 @@
+/* Copyright 2025 Piers Wombwell
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* ARM (v4T, plus the v5 and v6T2 instructions the compiler can be asked
+ * for) and Thumb execution, and the cycle counting for each core.
+ * Coprocessor instructions are not simulated: build code for the
+ * simulator with the default software floating point.
+ */
+
+#include "armsim.h"
+
+#include <ctype.h>
+#include <string.h>
+
+void (*sim_trace)(ArmSim *s, uint32 pc, uint32 instr);
+void (*sim_profile)(ArmSim *s, uint32 pc);
+
+/* Cycle counts for the SIM_PIPE cores follow the ARM9TDMI and SA-110
+ * technical reference manuals with hot caches: one cycle an instruction
+ * plus the listed penalties. The ARM7TDMI is counted in N, S and I
+ * cycles so that the memory system can be described with -nwait/-swait.
+ */
+const SimCore sim_cores[] = {
+    /*  name         model     arch br lu ls mul mull rs */
+    { "ARM7TDMI",  SIM_NSI,   4,  0, 0, 0, 0,  0,   0 },
+    { "ARM9TDMI",  SIM_PIPE,  4,  2, 1, 1, 2,  1,   1 },
+    { "ARM9E",     SIM_PIPE,  5,  2, 1, 1, 1,  1,   1 },
+    { "StrongARM", SIM_PIPE,  4,  1, 1, 0, 1,  1,   1 },
+    { "ARMv7",     SIM_PIPE,  7,  2, 2, 0, 1,  1,   1 },
+    { "CortexM3",  SIM_PIPE,  7,  2, 1, 0, 1,  3,   0 },
+    { NULL }
+};
+
+const SimCore *sim_findcore(const char *name)
+{
+    const SimCore *c;
+    for (c = sim_cores; c->name != NULL; c++) {
+        const char *p = c->name, *q = name;
+        while (*p && *q && toupper((unsigned char)*p) == toupper((unsigned char)*q))
+            p++, q++;
+        if (*p == 0 && *q == 0)
+            return c;
+    }
+    return NULL;
+}
+
+/* Memory --------------------------------------------------------------- */
+
+static uint8 *memptr(ArmSim *s, uint32 a, uint32 n, bool write)
+{
+    uint32 lo = write ? SIM_IMAGE_BASE : SIM_RT_BASE;
+    if (a < lo || a > s->memsize - n)
+        sim_fatal(s, "%s of %u bytes at 0x%08lx is outside memory",
+                  write ? "write" : "read", (unsigned)n, (unsigned long)a);
+    return s->mem + a;
+}
+
+uint32 sim_rd32(ArmSim *s, uint32 a)
+{
+    const uint8 *p = memptr(s, a, 4, false);
+    if (s->bigend)
+        return (uint32)p[0] << 24 | (uint32)p[1] << 16 | (uint32)p[2] << 8 | p[3];
+    return (uint32)p[3] << 24 | (uint32)p[2] << 16 | (uint32)p[1] << 8 | p[0];
+}
+
+uint32 sim_rd16(ArmSim *s, uint32 a)
+{
+    const uint8 *p = memptr(s, a, 2, false);
+    return s->bigend ? (uint32)p[0] << 8 | p[1] : (uint32)p[1] << 8 | p[0];
+}
+
+uint32 sim_rd8(ArmSim *s, uint32 a)
+{
+    return *memptr(s, a, 1, false);
+}
+
+void sim_wr32(ArmSim *s, uint32 a, uint32 v)
+{
+    uint8 *p = memptr(s, a, 4, true);
+    if (s->bigend)
+        p[0] = (uint8)(v >> 24), p[1] = (uint8)(v >> 16), p[2] = (uint8)(v >> 8), p[3] = (uint8)v;
+    else
+        p[3] = (uint8)(v >> 24), p[2] = (uint8)(v >> 16), p[1] = (uint8)(v >> 8), p[0] = (uint8)v;
+}
+
+void sim_wr16(ArmSim *s, uint32 a, uint32 v)
+{
+    uint8 *p = memptr(s, a, 2, true);
+    if (s->bigend)
+        p[0] = (uint8)(v >> 8), p[1] = (uint8)v;
+    else
+        p[1] = (uint8)(v >> 8), p[0] = (uint8)v;
+}
+
+void sim_wr8(ArmSim *s, uint32 a, uint32 v)
+{
+    *memptr(s, a, 1, true) = (uint8)v;
+}
+
+/* LDR from a word address that is not aligned: rotated on v4 and v5,
+ * a true unaligned access from v6.
+ */
+static uint32 load_word(ArmSim *s, uint32 a)
+{
+    uint32 v, rot;
+    if ((a & 3) == 0) return sim_rd32(s, a);
+    if (s->core->arch >= 7) {
+        uint32 b0 = sim_rd8(s, a), b1 = sim_rd8(s, a+1),
+               b2 = sim_rd8(s, a+2), b3 = sim_rd8(s, a+3);
+        return s->bigend ? b0 << 24 | b1 << 16 | b2 << 8 | b3
+                         : b3 << 24 | b2 << 16 | b1 << 8 | b0;
+    }
+    v = sim_rd32(s, a & ~3u);
+    rot = (a & 3) * 8;
+    return v >> rot | v << (32 - rot);
+}
+
+/* Timing --------------------------------------------------------------- */
+
+static void cyc_nsi(ArmSim *s, int S, int N, int I)
+{
+    s->st.scycles += S;
+    s->st.ncycles += N;
+    s->st.icycles += I;
+    s->st.cycles += (SimCount)(S * s->swait + N * s->nwait + I);
+}
+
+static void use(ArmSim *s, uint32 regs)
+{
+    if (s->prevload & regs) {
+        s->st.cycles += s->prevlat;
+        s->st.interlocks++;
+        s->prevload = 0;
+    }
+}
+
+static void t_dp(ArmSim *s, bool regshift)
+{
+    if (s->core->model == SIM_NSI)
+        cyc_nsi(s, 1 + s->wrotepc, s->wrotepc, regshift);
+    else
+        s->st.cycles += 1 + (regshift ? s->core->regshift : 0) +
+                        (s->wrotepc ? s->core->branch : 0);
+}
+
+/* Early termination: the number of 8-bit steps the multiplier takes. */
+static int mul_steps(uint32 rs, bool sign)
+{
+    int m;
+    for (m = 1; m < 4; m++) {
+        uint32 top = rs >> (8 * m);
+        if (top == 0 || (sign && top == (0xffffffffu >> (8 * m))))
+            break;
+    }
+    return m;
+}
+
+static void t_mul(ArmSim *s, uint32 rs, bool sign, bool lng, bool acc, uint32 rd)
+{
+    int m = mul_steps(rs, sign);
+    if (s->core->model == SIM_NSI)
+        cyc_nsi(s, 1, 0, m + acc + lng);
+    else {
+        s->st.cycles += s->core->mulbase + m - 1 + (lng ? s->core->mullong : 0);
+        s->lastload = rd, s->lastlat = 1;
+    }
+}
+
+static void t_ldr(ArmSim *s, uint32 rd, bool sub)
+{
+    if (s->core->model == SIM_NSI)
+        cyc_nsi(s, 1 + s->wrotepc, 1 + s->wrotepc, 1);
+    else {
+        s->st.cycles += 1 + (s->wrotepc ? s->core->branch + 2 : 0);
+        s->lastload = rd;
+        s->lastlat = s->core->loaduse + (sub ? s->core->loadsub : 0);
+    }
+}
+
+static void t_str(ArmSim *s)
+{
+    if (s->core->model == SIM_NSI)
+        cyc_nsi(s, 0, 2, 0);
+    else
+        s->st.cycles += 1;
+}
+
+static void t_ldm(ArmSim *s, int n, uint32 last)
+{
+    if (s->core->model == SIM_NSI)
+        cyc_nsi(s, n + s->wrotepc, 1 + s->wrotepc, 1);
+    else {
+        s->st.cycles += (n < 2 ? 2 : n) + (s->wrotepc ? s->core->branch + 2 : 0);
+        s->lastload = last, s->lastlat = s->core->loaduse;
+    }
+}
+
+static void t_stm(ArmSim *s, int n)
+{
+    if (s->core->model == SIM_NSI)
+        cyc_nsi(s, n - 1, 2, 0);
+    else
+        s->st.cycles += n < 2 ? 2 : n;
+}
+
+static void t_branch(ArmSim *s)
+{
+    if (s->core->model == SIM_NSI)
+        cyc_nsi(s, 2, 1, 0);
+    else
+        s->st.cycles += 1 + s->core->branch;
+}
+
+static void t_skip(ArmSim *s)
+{
+    if (s->core->model == SIM_NSI)
+        cyc_nsi(s, 1, 0, 0);
+    else
+        s->st.cycles += 1;
+}
+
+/* Registers and flags ------------------------------------------------- */
+
+static void set_pc(ArmSim *s, uint32 v)
+{
+    s->nextpc = v;
+    s->wrotepc = true;
+    s->st.branches++;
+    s->st.taken++;
+}
+
+/* A PC load that may change state: BX semantics from v5, none before. */
+static void load_pc(ArmSim *s, uint32 v)
+{
+    if (s->core->arch >= 5) {
+        s->thumb = v & 1;
+        v &= s->thumb ? ~1u : ~3u;
+    } else
+        v &= s->thumb ? ~1u : ~3u;
+    set_pc(s, v);
+}
+
+static void bx(ArmSim *s, uint32 v)
+{
+    s->thumb = v & 1;
+    set_pc(s, v & ~1u);
+}
+
+static bool cond_passed(ArmSim *s, unsigned cond)
+{
+    switch (cond) {
+    case 0x0: return s->z;
+    case 0x1: return !s->z;
+    case 0x2: return s->c;
+    case 0x3: return !s->c;
+    case 0x4: return s->n;
+    case 0x5: return !s->n;
+    case 0x6: return s->v;
+    case 0x7: return !s->v;
+    case 0x8: return s->c && !s->z;
+    case 0x9: return !s->c || s->z;
+    case 0xa: return s->n == s->v;
+    case 0xb: return s->n != s->v;
+    case 0xc: return !s->z && s->n == s->v;
+    case 0xd: return s->z || s->n != s->v;
+    default:  return true;
+    }
+}
+
+static void set_nz(ArmSim *s, uint32 r)
+{
+    s->n = r >> 31;
+    s->z = r == 0;
+}
+
+static uint32 add_flags(ArmSim *s, uint32 a, uint32 b, uint32 cin, bool setflags)
+{
+    uint32 r = a + b + cin;
+    if (setflags) {
+        set_nz(s, r);
+        s->c = cin ? r <= a : r < a;
+        s->v = ((~(a ^ b) & (a ^ r)) >> 31) & 1;
+    }
+    return r;
+}
+
+/* The data-processing operations, shared by both instruction sets.
+ * Returns false for the compare operations, which write no register.
+ */
+static bool alu(ArmSim *s, unsigned op, uint32 a, uint32 b, bool shc,
+                bool setflags, uint32 *res)
+{
+    uint32 r;
+    switch (op) {
+    case 0x0: r = a & b; break;                                 /* AND */
+    case 0x1: r = a ^ b; break;                                 /* EOR */
+    case 0x2: *res = add_flags(s, a, ~b, 1, setflags); return true;         /* SUB */
+    case 0x3: *res = add_flags(s, b, ~a, 1, setflags); return true;         /* RSB */
+    case 0x4: *res = add_flags(s, a, b, 0, setflags); return true;          /* ADD */
+    case 0x5: *res = add_flags(s, a, b, s->c, setflags); return true;       /* ADC */
+    case 0x6: *res = add_flags(s, a, ~b, s->c, setflags); return true;      /* SBC */
+    case 0x7: *res = add_flags(s, b, ~a, s->c, setflags); return true;      /* RSC */
+    case 0x8: r = a & b; set_nz(s, r); s->c = shc; return false;            /* TST */
+    case 0x9: r = a ^ b; set_nz(s, r); s->c = shc; return false;            /* TEQ */
+    case 0xa: add_flags(s, a, ~b, 1, true); return false;                   /* CMP */
+    case 0xb: add_flags(s, a, b, 0, true); return false;                    /* CMN */
+    case 0xc: r = a | b; break;                                 /* ORR */
+    case 0xd: r = b; break;                                     /* MOV */
+    case 0xe: r = a & ~b; break;                                /* BIC */
+    default:  r = ~b; break;                                    /* MVN */
+    }
+    if (setflags) {
+        set_nz(s, r);
+        s->c = shc;
+    }
+    *res = r;
+    return true;
+}
+
+static uint32 shift(ArmSim *s, uint32 v, unsigned type, uint32 amt,
+                    bool byreg, bool *carry)
+{
+    *carry = s->c;
+    if (byreg) {
+        if (amt == 0) return v;
+        if (amt >= 32) {
+            switch (type) {
+            case 0: *carry = amt == 32 ? v & 1 : 0; return 0;
+            case 1: *carry = amt == 32 ? v >> 31 : 0; return 0;
+            case 2: *carry = v >> 31; return *carry ? 0xffffffffu : 0;
+            default:
+                amt &= 31;
+                if (amt == 0) { *carry = v >> 31; return v; }
+                break;
+            }
+        }
+    } else if (amt == 0) {
+        switch (type) {
+        case 0: return v;
+        case 1: *carry = v >> 31; return 0;
+        case 2: *carry = v >> 31; return *carry ? 0xffffffffu : 0;
+        default: *carry = v & 1; return v >> 1 | (uint32)s->c << 31;    /* RRX */
+        }
+    }
+    switch (type) {
+    case 0: *carry = (v >> (32 - amt)) & 1; return v << amt;
+    case 1: *carry = (v >> (amt - 1)) & 1; return v >> amt;
+    case 2: *carry = (v >> (amt - 1)) & 1;
+            return v >> 31 ? ~(~v >> amt) : v >> amt;
+    default: *carry = (v >> (amt - 1)) & 1; return v >> amt | v << (32 - amt);
+    }
+}
+
+static int popcount16(uint32 list)
+{
+    int n = 0;
+    for (list &= 0xffff; list; list &= list - 1) n++;
+    return n;
+}
+
+static void undefined(ArmSim *s, uint32 instr)
+{
+    sim_fatal(s, "undefined instruction 0x%0*lx", s->thumb ? 4 : 8,
+              (unsigned long)instr);
+}
+
+static void swi(ArmSim *s, uint32 n)
+{
+    sim_fatal(s, "unsupported SWI 0x%lx", (unsigned long)n);
+}
+
+/* ARM ------------------------------------------------------------------ */
+
+static void arm_dataproc(ArmSim *s, uint32 instr)
+{
+    unsigned op = (instr >> 21) & 15, rd = (instr >> 12) & 15;
+    bool S = (instr >> 20) & 1, carry, regshift = false;
+    uint32 a = s->r[(instr >> 16) & 15], b, res, uses = 1u << ((instr >> 16) & 15);
+
+    if (instr & (1u << 25)) {
+        uint32 rot = ((instr >> 8) & 15) * 2;
+        b = instr & 0xff;
+        carry = s->c;
+        if (rot) {
+            b = b >> rot | b << (32 - rot);
+            carry = b >> 31;
+        }
+    } else {
+        unsigned rm = instr & 15, type = (instr >> 5) & 3;
+        uses |= 1u << rm;
+        if (instr & 0x10) {
+            unsigned rs = (instr >> 8) & 15;
+            uint32 v = rm == 15 ? s->pc + 12 : s->r[rm];
+            if (((instr >> 16) & 15) == 15) a = s->pc + 12;
+            regshift = true;
+            uses |= 1u << rs;
+            b = shift(s, v, type, s->r[rs] & 0xff, true, &carry);
+        } else
+            b = shift(s, s->r[rm], type, (instr >> 7) & 31, false, &carry);
+    }
+    use(s, uses);
+    if (alu(s, op, a, b, carry, S, &res)) {
+        if (rd == 15)
+            set_pc(s, res & ~3u);
+        else
+            s->r[rd] = res;
+    }
+    t_dp(s, regshift);
+}
+
+static void arm_multiply(ArmSim *s, uint32 instr)
+{
+    unsigned rd = (instr >> 16) & 15, rn = (instr >> 12) & 15,
+             rs = (instr >> 8) & 15, rm = instr & 15;
+    bool acc = (instr >> 21) & 1, S = (instr >> 20) & 1;
+    uint32 r;
+    use(s, 1u << rm | 1u << rs | (acc ? 1u << rn : 0));
+    r = s->r[rm] * s->r[rs] + (acc ? s->r[rn] : 0);
+    s->r[rd] = r;
+    if (S) set_nz(s, r);
+    t_mul(s, s->r[rs], true, false, acc, 1u << rd);
+}
+
+static void arm_multiply_long(ArmSim *s, uint32 instr)
+{
+    unsigned hi = (instr >> 16) & 15, lo = (instr >> 12) & 15,
+             rs = (instr >> 8) & 15, rm = instr & 15;
+    bool sign = (instr >> 22) & 1, acc = (instr >> 21) & 1, S = (instr >> 20) & 1;
+    uint64_t r;
+    use(s, 1u << rm | 1u << rs | (acc ? 1u << hi | 1u << lo : 0));
+    if (sign)
+        r = (uint64_t)((int64_t)(int32)s->r[rm] * (int64_t)(int32)s->r[rs]);
+    else
+        r = (uint64_t)s->r[rm] * s->r[rs];
+    if (acc)
+        r += (uint64_t)s->r[hi] << 32 | s->r[lo];
+    s->r[lo] = (uint32)r;
+    s->r[hi] = (uint32)(r >> 32);
+    if (S) {
+        s->n = (uint32)(r >> 63);
+        s->z = r == 0;
+    }
+    t_mul(s, s->r[rs], sign, true, acc, 1u << hi | 1u << lo);
+}
+
+static void arm_single(ArmSim *s, uint32 instr)
+{
+    unsigned rn = (instr >> 16) & 15, rd = (instr >> 12) & 15;
+    bool P = (instr >> 24) & 1, U = (instr >> 23) & 1, B = (instr >> 22) & 1,
+         W = (instr >> 21) & 1, L = (instr >> 20) & 1;
+    uint32 off, addr, ea, uses = 1u << rn;
+
+    if (instr & (1u << 25)) {
+        bool carry;
+        if (instr & 0x10) undefined(s, instr);
+        uses |= 1u << (instr & 15);
+        off = shift(s, s->r[instr & 15], (instr >> 5) & 3, (instr >> 7) & 31,
+                    false, &carry);
+    } else
+        off = instr & 0xfff;
+    addr = U ? s->r[rn] + off : s->r[rn] - off;
+    ea = P ? addr : s->r[rn];
+    if (L) {
+        uint32 v;
+        use(s, uses);
+        v = B ? sim_rd8(s, ea) : load_word(s, ea);
+        if ((!P || W) && rn != 15) s->r[rn] = addr;
+        s->st.loads++, s->st.load_words++;
+        if (rd == 15)
+            load_pc(s, v);
+        else
+            s->r[rd] = v;
+        t_ldr(s, 1u << rd, B);
+    } else {
+        uint32 v = rd == 15 ? s->pc + 12 : s->r[rd];
+        use(s, uses | 1u << rd);
+        if (B)
+            sim_wr8(s, ea, v);
+        else
+            sim_wr32(s, ea & ~3u, v);
+        if ((!P || W) && rn != 15) s->r[rn] = addr;
+        s->st.stores++, s->st.store_words++;
+        t_str(s);
+    }
+}
+
+static void arm_halfword(ArmSim *s, uint32 instr)
+{
+    unsigned rn = (instr >> 16) & 15, rd = (instr >> 12) & 15,
+             sh = (instr >> 5) & 3;
+    bool P = (instr >> 24) & 1, U = (instr >> 23) & 1, I = (instr >> 22) & 1,
+         W = (instr >> 21) & 1, L = (instr >> 20) & 1;
+    uint32 off, addr, ea, uses = 1u << rn;
+
+    if (I)
+        off = (instr >> 4 & 0xf0) | (instr & 15);
+    else
+        off = s->r[instr & 15], uses |= 1u << (instr & 15);
+    addr = U ? s->r[rn] + off : s->r[rn] - off;
+    ea = P ? addr : s->r[rn];
+    if (!L && sh >= 2) {
+        /* LDRD/STRD (v5TE) */
+        if (s->core->arch < 5 || (rd & 1)) undefined(s, instr);
+        if (sh == 2) {
+            uint32 lo, hi;
+            use(s, uses);
+            lo = sim_rd32(s, ea & ~3u);
+            hi = sim_rd32(s, (ea & ~3u) + 4);
+            if ((!P || W) && rn != 15) s->r[rn] = addr;
+            s->r[rd] = lo, s->r[rd+1] = hi;
+            s->st.loads++, s->st.load_words += 2;
+            t_ldm(s, 2, 1u << (rd+1));
+        } else {
+            use(s, uses | 3u << rd);
+            sim_wr32(s, ea & ~3u, s->r[rd]);
+            sim_wr32(s, (ea & ~3u) + 4, s->r[rd+1]);
+            if ((!P || W) && rn != 15) s->r[rn] = addr;
+            s->st.stores++, s->st.store_words += 2;
+            t_stm(s, 2);
+        }
+        return;
+    }
+    if (L) {
+        uint32 v;
+        use(s, uses);
+        switch (sh) {
+        case 1: v = sim_rd16(s, ea & ~1u); break;
+        case 2: v = sim_rd8(s, ea); v = (v ^ 0x80) - 0x80; break;
+        default: v = sim_rd16(s, ea & ~1u); v = (v ^ 0x8000) - 0x8000; break;
+        }
+        if ((!P || W) && rn != 15) s->r[rn] = addr;
+        s->st.loads++, s->st.load_words++;
+        if (rd == 15)
+            load_pc(s, v);
+        else
+            s->r[rd] = v;
+        t_ldr(s, 1u << rd, true);
+    } else {
+        if (sh != 1) undefined(s, instr);
+        use(s, uses | 1u << rd);
+        sim_wr16(s, ea & ~1u, rd == 15 ? s->pc + 12 : s->r[rd]);
+        if ((!P || W) && rn != 15) s->r[rn] = addr;
+        s->st.stores++, s->st.store_words++;
+        t_str(s);
+    }
+}
+
+static void arm_block(ArmSim *s, uint32 instr)
+{
+    unsigned rn = (instr >> 16) & 15, r;
+    uint32 list = instr & 0xffff;
+    bool P = (instr >> 24) & 1, U = (instr >> 23) & 1,
+         W = (instr >> 21) & 1, L = (instr >> 20) & 1;
+    int n = popcount16(list);
+    uint32 base = s->r[rn], addr, wb;
+
+    if (n == 0) undefined(s, instr);
+    if (U)
+        addr = base + (P ? 4 : 0), wb = base + 4*n;
+    else
+        addr = base - 4*n + (P ? 0 : 4), wb = base - 4*n;
+    addr &= ~3u;
+    if (L) {
+        uint32 v[16], last = 0;
+        use(s, 1u << rn);
+        for (r = 0; r < 16; r++)
+            if (list & (1u << r)) {
+                v[r] = sim_rd32(s, addr);
+                addr += 4;
+                last = 1u << r;
+            }
+        if (W && rn != 15) s->r[rn] = wb;
+        for (r = 0; r < 15; r++)
+            if (list & (1u << r)) s->r[r] = v[r];
+        if (list & 0x8000) load_pc(s, v[15]);
+        s->st.loads++, s->st.load_words += n;
+        t_ldm(s, n, last);
+    } else {
+        use(s, 1u << rn | list);
+        for (r = 0; r < 16; r++)
+            if (list & (1u << r)) {
+                sim_wr32(s, addr, r == 15 ? s->pc + 12 : s->r[r]);
+                addr += 4;
+            }
+        if (W && rn != 15) s->r[rn] = wb;
+        s->st.stores++, s->st.store_words += n;
+        t_stm(s, n);
+    }
+}
+
+static void arm_misc(ArmSim *s, uint32 instr)
+{
+    if ((instr & 0x0ffffff0) == 0x012fff10) {               /* BX */
+        use(s, 1u << (instr & 15));
+        bx(s, s->r[instr & 15]);
+        t_branch(s);
+    } else if ((instr & 0x0ffffff0) == 0x012fff30 && s->core->arch >= 5) {
+        uint32 t = s->r[instr & 15];                        /* BLX reg */
+        use(s, 1u << (instr & 15));
+        s->r[14] = s->pc + 4;
+        bx(s, t);
+        t_branch(s);
+    } else if ((instr & 0x0fff0ff0) == 0x016f0f10 && s->core->arch >= 5) {
+        uint32 v = s->r[instr & 15];                        /* CLZ */
+        unsigned n = 0;
+        use(s, 1u << (instr & 15));
+        if (v == 0) n = 32;
+        else while (!(v & 0x80000000u)) v <<= 1, n++;
+        s->r[(instr >> 12) & 15] = n;
+        t_dp(s, false);
+    } else if ((instr & 0x0fbf0fff) == 0x010f0000) {        /* MRS */
+        s->r[(instr >> 12) & 15] = (uint32)s->n << 31 | (uint32)s->z << 30 |
+                                   (uint32)s->c << 29 | (uint32)s->v << 28 |
+                                   (uint32)s->thumb << 5 | 0x10;
+        t_dp(s, false);
+    } else if ((instr & 0x0db0f000) == 0x0120f000) {        /* MSR */
+        uint32 v;
+        if (instr & (1u << 25)) {
+            uint32 rot = ((instr >> 8) & 15) * 2;
+            v = instr & 0xff;
+            if (rot) v = v >> rot | v << (32 - rot);
+        } else
+            v = s->r[instr & 15];
+        if (instr & (1u << 19)) {
+            s->n = v >> 31, s->z = (v >> 30) & 1;
+            s->c = (v >> 29) & 1, s->v = (v >> 28) & 1;
+        }
+        t_dp(s, false);
+    } else if ((instr & 0x0fb00ff0) == 0x01000090) {        /* SWP, SWPB */
+        unsigned rn = (instr >> 16) & 15;
+        uint32 a = s->r[rn], m = s->r[instr & 15], v;
+        use(s, 1u << rn | 1u << (instr & 15));
+        if (instr & (1u << 22)) {
+            v = sim_rd8(s, a);
+            sim_wr8(s, a, m);
+        } else {
+            v = load_word(s, a);
+            sim_wr32(s, a & ~3u, m);
+        }
+        s->r[(instr >> 12) & 15] = v;
+        s->st.loads++, s->st.load_words++;
+        s->st.stores++, s->st.store_words++;
+        if (s->core->model == SIM_NSI)
+            cyc_nsi(s, 1, 2, 1);
+        else
+            s->st.cycles += 2;
+    } else
+        undefined(s, instr);
+}
+
+static void arm_execute(ArmSim *s, uint32 instr)
+{
+    switch ((instr >> 25) & 7) {
+    case 0:
+        if ((instr & 0x0fc000f0) == 0x00000090)
+            arm_multiply(s, instr);
+        else if ((instr & 0x0f8000f0) == 0x00800090)
+            arm_multiply_long(s, instr);
+        else if ((instr & 0x0e000090) == 0x00000090 && (instr & 0x60))
+            arm_halfword(s, instr);
+        else if ((instr & 0x01900000) == 0x01000000)
+            arm_misc(s, instr);
+        else
+            arm_dataproc(s, instr);
+        break;
+    case 1:
+        if ((instr & 0x0fb00000) == 0x03000000 && s->core->arch >= 7) {
+            unsigned rd = (instr >> 12) & 15;               /* MOVW, MOVT */
+            uint32 imm = (instr >> 4 & 0xf000) | (instr & 0xfff);
+            if (instr & (1u << 22))
+                s->r[rd] = (s->r[rd] & 0xffff) | imm << 16;
+            else
+                s->r[rd] = imm;
+            t_dp(s, false);
+        } else if ((instr & 0x01900000) == 0x01000000)
+            arm_misc(s, instr);
+        else
+            arm_dataproc(s, instr);
+        break;
+    case 2:
+    case 3:
+        arm_single(s, instr);
+        break;
+    case 4:
+        arm_block(s, instr);
+        break;
+    case 5: {
+        int32 off = (int32)(instr << 8) >> 6;
+        if (instr & (1u << 24)) s->r[14] = s->pc + 4;
+        set_pc(s, s->r[15] + off);
+        t_branch(s);
+        break;
+    }
+    case 6:
+        undefined(s, instr);
+        break;
+    default:
+        if (instr & (1u << 24))
+            swi(s, instr & 0xffffff);
+        else
+            sim_fatal(s, "coprocessor instruction 0x%08lx: compile with "
+                      "software floating point", (unsigned long)instr);
+        break;
+    }
+}
+
+static void arm_step(ArmSim *s)
+{
+    uint32 pc = s->pc, instr;
+
+    if (pc & 3) sim_fatal(s, "misaligned ARM PC");
+    instr = sim_rd32(s, pc);
+    s->r[15] = pc + 8;
+    s->nextpc = pc + 4;
+    if (sim_trace) sim_trace(s, pc, instr);
+    s->st.insts++;
+    if ((instr >> 28) == 0xf) {
+        if ((instr & 0x0e000000) == 0x0a000000 && s->core->arch >= 5) {
+            int32 off = (int32)(instr << 8) >> 6;           /* BLX imm */
+            s->r[14] = pc + 4;
+            s->thumb = true;
+            set_pc(s, pc + 8 + off + ((instr >> 23) & 2));
+            t_branch(s);
+        } else if ((instr & 0x0d70f000) == 0x0550f000)
+            t_dp(s, false);                                 /* PLD */
+        else
+            undefined(s, instr);
+    } else if (!cond_passed(s, instr >> 28)) {
+        s->st.skipped++;
+        if (((instr >> 25) & 7) == 5 || (instr & 0x0ffffff0) == 0x012fff10)
+            s->st.branches++;
+        t_skip(s);
+    } else
+        arm_execute(s, instr);
+}
+
+/* Thumb ---------------------------------------------------------------- */
+
+/* Thumb-2 -------------------------------------------------------------- */
+
+/* ThumbExpandImm_C: the modified immediate of a 32 bit data-processing
+ * instruction, with its shifter carry.
+ */
+static uint32 thumb_expand_imm(ArmSim *s, uint32 imm12, bool *carry)
+{
+    uint32 v = imm12 & 0xff;
+    unsigned rot = imm12 >> 7;
+    *carry = s->c;
+    switch (imm12 >> 8) {
+    case 0: return v;
+    case 1: return v << 16 | v;
+    case 2: return v << 24 | v << 8;
+    case 3: return v * 0x01010101u;
+    }
+    v = (imm12 & 0x7f) | 0x80;
+    v = v >> rot | v << (32 - rot);
+    *carry = v >> 31;
+    return v;
+}
+
+static int sigbits(uint32 v)
+{
+    int n = 0;
+    for (; v != 0; v >>= 1) n++;
+    return n;
+}
+
+/* SDIV/UDIV take 2 to 12 cycles, ending early when the quotient is short. */
+static void t_div(ArmSim *s, uint32 a, uint32 b, uint32 rd)
+{
+    int n = 2 + (sigbits(a) - sigbits(b)) / 4;
+    if (n < 2) n = 2;
+    if (n > 12) n = 12;
+    if (s->core->model == SIM_NSI)
+        cyc_nsi(s, 1, 0, n - 1);
+    else {
+        s->st.cycles += n;
+        s->lastload = rd, s->lastlat = 1;
+    }
+}
+
+/* The 32 bit instructions: branches, data processing with a modified or
+ * plain immediate, MOVW/MOVT, multiplies and divides.
+ */
+static void thumb32_execute(ArmSim *s, uint32 instr)
+{
+    uint32 pc = s->pc, instr2 = sim_rd16(s, pc + 2), res;
+    unsigned rn = instr & 15, rd = (instr2 >> 8) & 15;
+    uint32 imm12 = (instr >> 10 & 1) << 11 | (instr2 >> 12 & 7) << 8 | (instr2 & 0xff);
+
+    s->nextpc = pc + 4;
+    if ((instr & 0xf800) == 0xf000 && (instr2 & 0x8000)) {
+        uint32 S = instr >> 10 & 1, j1 = instr2 >> 13 & 1, j2 = instr2 >> 11 & 1;
+        int32 off;
+        if ((instr2 & 0x5000) == 0) {                       /* Bcc.W */
+            unsigned cond = (instr >> 6) & 15;
+            if (cond >= 14) undefined(s, instr);
+            off = (int32)(S << 31 | j2 << 30 | j1 << 29 | (instr & 0x3f) << 23 |
+                          (instr2 & 0x7ff) << 12) >> 11;
+            if (cond_passed(s, cond)) {
+                set_pc(s, pc + 4 + off);
+                t_branch(s);
+            } else {
+                s->st.branches++;
+                t_skip(s);
+            }
+            return;
+        }
+        off = (int32)(S << 31 | (j1 ^ S ^ 1) << 30 | (j2 ^ S ^ 1) << 29 |
+                      (instr & 0x3ff) << 19 | (instr2 & 0x7ff) << 8) >> 7;
+        if (instr2 & 0x4000) {                              /* BL, BLX */
+            s->r[14] = (pc + 4) | 1;
+            if (!(instr2 & 0x1000)) {
+                if (instr2 & 1) undefined(s, instr);
+                s->thumb = false;
+                set_pc(s, (pc + 4 + off) & ~3u);
+            } else
+                set_pc(s, pc + 4 + off);
+        } else                                              /* B.W */
+            set_pc(s, pc + 4 + off);
+        t_branch(s);
+        return;
+    }
+    if ((instr & 0xfa00) == 0xf000 && !(instr2 & 0x8000)) { /* modified immediate */
+        static const signed char ops[16] = {
+            0x0, 0xe, 0xc, -1, 0x1, -2, -2, -2, 0x4, -2, 0x5, 0x6, -2, 0x2, 0x3, -2
+        };
+        unsigned op = (instr >> 5) & 15;
+        bool S = (instr >> 4) & 1, carry;
+        uint32 a = rn == 15 ? 0 : s->r[rn], b = thumb_expand_imm(s, imm12, &carry);
+        int aop = ops[op];
+        if (aop == -2) undefined(s, instr);
+        use(s, 1u << rn);
+        if (aop == -1) {                                    /* ORN, MVN */
+            res = a | ~b;
+            if (S) set_nz(s, res), s->c = carry;
+            s->r[rd] = res;
+        } else {
+            if (rd == 15 && S)                              /* TST TEQ CMN CMP */
+                aop = op == 0 ? 0x8 : op == 4 ? 0x9 : op == 8 ? 0xb : 0xa;
+            if (alu(s, aop, a, b, carry, S, &res)) {
+                if (rd == 15) undefined(s, instr);
+                s->r[rd] = res;
+            }
+        }
+        t_dp(s, false);
+        return;
+    }
+    if ((instr & 0xfa00) == 0xf200 && !(instr2 & 0x8000)) { /* plain immediate */
+        switch ((instr >> 4) & 0x1f) {
+        case 0x00:                                          /* ADDW */
+            s->r[rd] = (rn == 15 ? (pc + 4) & ~3u : s->r[rn]) + imm12;
+            break;
+        case 0x0a:                                          /* SUBW */
+            s->r[rd] = (rn == 15 ? (pc + 4) & ~3u : s->r[rn]) - imm12;
+            break;
+        case 0x04:                                          /* MOVW */
+            s->r[rd] = (instr & 15) << 12 | imm12;
+            break;
+        case 0x0c:                                          /* MOVT */
+            s->r[rd] = (s->r[rd] & 0xffff) | ((instr & 15) << 12 | imm12) << 16;
+            break;
+        default:
+            undefined(s, instr);
+        }
+        use(s, 1u << rn | 1u << rd);
+        t_dp(s, false);
+        return;
+    }
+    if ((instr & 0xfff0) == 0xfb00 && (instr2 & 0xe0) == 0) {
+        unsigned ra = instr2 >> 12, rm = instr2 & 15;       /* MUL, MLA, MLS */
+        uint32 b = s->r[rm], p = s->r[rn] * b;
+        use(s, 1u << rn | 1u << rm | (ra == 15 ? 0 : 1u << ra));
+        if (instr2 & 0x10)
+            s->r[rd] = s->r[ra] - p;
+        else
+            s->r[rd] = ra == 15 ? p : s->r[ra] + p;
+        t_mul(s, b, false, false, ra != 15, 1u << rd);
+        return;
+    }
+    if ((instr & 0xffd0) == 0xfb90 && (instr2 & 0xf0f0) == 0xf0f0) {
+        unsigned rm = instr2 & 15;                          /* SDIV, UDIV */
+        uint32 a = s->r[rn], b = s->r[rm];
+        use(s, 1u << rn | 1u << rm);
+        if (b == 0)
+            res = 0;
+        else if (instr & 0x20)
+            res = a / b;
+        else if (a == 0x80000000u && b == 0xffffffffu)
+            res = a;
+        else {
+            res = (uint32)((int32)a / (int32)b);
+            if ((int32)a < 0) a = -a;
+            if ((int32)b < 0) b = -b;
+        }
+        s->r[rd] = res;
+        t_div(s, a, b, 1u << rd);
+        return;
+    }
+    undefined(s, instr);
+}
+
+static void thumb_execute(ArmSim *s, uint32 instr)
+{
+    uint32 pc = s->pc, res;
+    unsigned rd, rs, rn, op;
+    bool carry;
+
+    if ((instr >> 11) >= 0x1d && s->core->arch >= 7) {
+        thumb32_execute(s, instr);
+        return;
+    }
+    rd = instr & 7;
+    rs = (instr >> 3) & 7;
+
+    switch (instr >> 11) {
+    case 0x00: case 0x01: case 0x02:                        /* shift by immediate */
+        use(s, 1u << rs);
+        res = shift(s, s->r[rs], instr >> 11, (instr >> 6) & 31, false, &carry);
+        s->r[rd] = res;
+        set_nz(s, res);
+        s->c = carry;
+        t_dp(s, false);
+        break;
+    case 0x03: {                                            /* ADD/SUB */
+        uint32 b;
+        rn = (instr >> 6) & 7;
+        if (instr & 0x400)
+            b = rn, use(s, 1u << rs);
+        else
+            b = s->r[rn], use(s, 1u << rs | 1u << rn);
+        alu(s, instr & 0x200 ? 0x2 : 0x4, s->r[rs], b, s->c, true, &s->r[rd]);
+        t_dp(s, false);
+        break;
+    }
+    case 0x04: case 0x05: case 0x06: case 0x07: {           /* MOV/CMP/ADD/SUB #imm8 */
+        static const unsigned ops[4] = { 0xd, 0xa, 0x4, 0x2 };
+        rd = (instr >> 8) & 7;
+        use(s, 1u << rd);
+        if (alu(s, ops[(instr >> 11) & 3], s->r[rd], instr & 0xff, s->c, true, &res))
+            s->r[rd] = res;
+        t_dp(s, false);
+        break;
+    }
+    case 0x08:
+        if (!(instr & 0x400)) {                             /* ALU operations */
+            uint32 a = s->r[rd], b = s->r[rs];
+            op = (instr >> 6) & 15;
+            use(s, 1u << rd | 1u << rs);
+            switch (op) {
+            case 0x2: case 0x3: case 0x4: case 0x7: {       /* LSL LSR ASR ROR */
+                static const unsigned types[8] = { 0, 0, 0, 1, 2, 0, 0, 3 };
+                res = shift(s, a, types[op], b & 0xff, true, &carry);
+                s->r[rd] = res;
+                set_nz(s, res);
+                s->c = carry;
+                t_dp(s, true);
+                break;
+            }
+            case 0x9:                                       /* NEG */
+                s->r[rd] = add_flags(s, 0, ~b, 1, true);
+                t_dp(s, false);
+                break;
+            case 0xd:                                       /* MUL */
+                res = a * b;
+                s->r[rd] = res;
+                set_nz(s, res);
+                t_mul(s, a, true, false, false, 1u << rd);
+                break;
+            default: {
+                static const unsigned ops[16] = {
+                    0x0, 0x1, 0, 0, 0, 0x5, 0x6, 0, 0x8, 0, 0xa, 0xb, 0xc, 0, 0xe, 0xf
+                };
+                if (alu(s, ops[op], a, b, s->c, true, &res))
+                    s->r[rd] = res;
+                t_dp(s, false);
+                break;
+            }
+            }
+        } else {                                            /* hi registers, BX */
+            rd |= (instr >> 4) & 8;
+            rs |= (instr >> 3) & 8;
+            use(s, 1u << rd | 1u << rs);
+            switch ((instr >> 8) & 3) {
+            case 0:
+                res = s->r[rd] + s->r[rs];
+                if (rd == 15) set_pc(s, res & ~1u); else s->r[rd] = res;
+                t_dp(s, false);
+                break;
+            case 1:
+                alu(s, 0xa, s->r[rd], s->r[rs], s->c, true, &res);
+                t_dp(s, false);
+                break;
+            case 2:
+                if (rd == 15) set_pc(s, s->r[rs] & ~1u); else s->r[rd] = s->r[rs];
+                t_dp(s, false);
+                break;
+            default:
+                if (instr & 0x80) {
+                    if (s->core->arch < 5) undefined(s, instr);
+                    res = s->r[rs];
+                    s->r[14] = (pc + 2) | 1;
+                    bx(s, res);
+                } else
+                    bx(s, s->r[rs]);
+                t_branch(s);
+                break;
+            }
+        }
+        break;
+    case 0x09:                                              /* LDR Rd, [PC, #imm] */
+        rd = (instr >> 8) & 7;
+        s->r[rd] = sim_rd32(s, ((pc + 4) & ~3u) + (instr & 0xff) * 4);
+        s->st.loads++, s->st.load_words++;
+        t_ldr(s, 1u << rd, false);
+        break;
+    case 0x0a: case 0x0b: {                                 /* load/store register offset */
+        uint32 a;
+        rn = (instr >> 6) & 7;
+        a = s->r[rs] + s->r[rn];
+        op = (instr >> 9) & 7;
+        if (op <= 2) {
+            use(s, 1u << rs | 1u << rn | 1u << rd);
+            if (op == 0) sim_wr32(s, a & ~3u, s->r[rd]);
+            else if (op == 1) sim_wr16(s, a & ~1u, s->r[rd]);
+            else sim_wr8(s, a, s->r[rd]);
+            s->st.stores++, s->st.store_words++;
+            t_str(s);
+        } else {
+            use(s, 1u << rs | 1u << rn);
+            switch (op) {
+            case 3: res = sim_rd8(s, a); res = (res ^ 0x80) - 0x80; break;
+            case 4: res = load_word(s, a); break;
+            case 5: res = sim_rd16(s, a & ~1u); break;
+            case 6: res = sim_rd8(s, a); break;
+            default: res = sim_rd16(s, a & ~1u); res = (res ^ 0x8000) - 0x8000; break;
+            }
+            s->r[rd] = res;
+            s->st.loads++, s->st.load_words++;
+            t_ldr(s, 1u << rd, op != 4);
+        }
+        break;
+    }
+    case 0x0c: case 0x0d: case 0x0e: case 0x0f:             /* load/store immediate */
+    case 0x10: case 0x11: {
+        bool byte = (instr >> 11) == 0x0e || (instr >> 11) == 0x0f,
+             half = (instr >> 11) >= 0x10, L = (instr >> 11) & 1;
+        uint32 a = s->r[rs] + ((instr >> 6) & 31) * (byte ? 1 : half ? 2 : 4);
+        if (L) {
+            use(s, 1u << rs);
+            s->r[rd] = byte ? sim_rd8(s, a) : half ? sim_rd16(s, a) : load_word(s, a);
+            s->st.loads++, s->st.load_words++;
+            t_ldr(s, 1u << rd, byte || half);
+        } else {
+            use(s, 1u << rs | 1u << rd);
+            if (byte) sim_wr8(s, a, s->r[rd]);
+            else if (half) sim_wr16(s, a, s->r[rd]);
+            else sim_wr32(s, a, s->r[rd]);
+            s->st.stores++, s->st.store_words++;
+            t_str(s);
+        }
+        break;
+    }
+    case 0x12: case 0x13: {                                 /* SP-relative load/store */
+        uint32 a = s->r[13] + (instr & 0xff) * 4;
+        rd = (instr >> 8) & 7;
+        if (instr & 0x800) {
+            use(s, 1u << 13);
+            s->r[rd] = sim_rd32(s, a);
+            s->st.loads++, s->st.load_words++;
+            t_ldr(s, 1u << rd, false);
+        } else {
+            use(s, 1u << 13 | 1u << rd);
+            sim_wr32(s, a, s->r[rd]);
+            s->st.stores++, s->st.store_words++;
+            t_str(s);
+        }
+        break;
+    }
+    case 0x14: case 0x15:                                   /* ADD Rd, PC/SP, #imm */
+        rd = (instr >> 8) & 7;
+        s->r[rd] = (instr & 0x800 ? s->r[13] : (pc + 4) & ~3u) + (instr & 0xff) * 4;
+        t_dp(s, false);
+        break;
+    case 0x16: case 0x17:
+        if ((instr & 0xff00) == 0xb000) {                   /* ADD SP, #imm */
+            uint32 off = (instr & 0x7f) * 4;
+            s->r[13] += instr & 0x80 ? -off : off;
+            t_dp(s, false);
+        } else if ((instr & 0xff00) == 0xbf00 && s->core->arch >= 7) {
+            if ((instr & 15) != 0) {                        /* IT */
+                if ((instr & 0xf0) == 0xf0) undefined(s, instr);
+                s->itstate = instr & 0xff;
+            }                                               /* else NOP */
+            t_dp(s, false);
+        } else if ((instr & 0xf500) == 0xb100 && s->core->arch >= 7) {
+            rn = instr & 7;                                 /* CBZ, CBNZ */
+            if ((s->r[rn] == 0) != ((instr >> 11) & 1)) {
+                set_pc(s, pc + 4 + ((instr >> 3) & 0x40) + ((instr >> 2) & 0x3e));
+                t_branch(s);
+            } else {
+                s->st.branches++;
+                t_skip(s);
+            }
+        } else if ((instr & 0xf600) == 0xb400) {            /* PUSH, POP */
+            uint32 list = instr & 0xff, a, last = 0;
+            int n = popcount16(list) + ((instr >> 8) & 1);
+            unsigned r;
+            if (instr & 0x800) {
+                a = s->r[13];
+                use(s, 1u << 13);
+                for (r = 0; r < 8; r++)
+                    if (list & (1u << r)) {
+                        s->r[r] = sim_rd32(s, a);
+                        a += 4;
+                        last = 1u << r;
+                    }
+                if (instr & 0x100) {
+                    load_pc(s, sim_rd32(s, a) | (s->core->arch >= 5 ? 0 : 1));
+                    a += 4;
+                }
+                s->r[13] = a;
+                s->st.loads++, s->st.load_words += n;
+                t_ldm(s, n, last);
+            } else {
+                a = s->r[13] - 4*n;
+                use(s, 1u << 13 | list);
+                s->r[13] = a;
+                for (r = 0; r < 8; r++)
+                    if (list & (1u << r)) {
+                        sim_wr32(s, a, s->r[r]);
+                        a += 4;
+                    }
+                if (instr & 0x100) sim_wr32(s, a, s->r[14]);
+                s->st.stores++, s->st.store_words += n;
+                t_stm(s, n);
+            }
+        } else
+            undefined(s, instr);
+        break;
+    case 0x18: case 0x19: {                                 /* STMIA, LDMIA */
+        uint32 list = instr & 0xff, a, last = 0;
+        int n = popcount16(list);
+        unsigned r;
+        rn = (instr >> 8) & 7;
+        a = s->r[rn];
+        if (n == 0) undefined(s, instr);
+        if (instr & 0x800) {
+            use(s, 1u << rn);
+            for (r = 0; r < 8; r++)
+                if (list & (1u << r)) {
+                    s->r[r] = sim_rd32(s, a);
+                    a += 4;
+                    last = 1u << r;
+                }
+            if (!(list & (1u << rn))) s->r[rn] = a;
+            s->st.loads++, s->st.load_words += n;
+            t_ldm(s, n, last);
+        } else {
+            use(s, 1u << rn | list);
+            for (r = 0; r < 8; r++)
+                if (list & (1u << r)) {
+                    sim_wr32(s, a, s->r[r]);
+                    a += 4;
+                }
+            s->r[rn] = a;
+            s->st.stores++, s->st.store_words += n;
+            t_stm(s, n);
+        }
+        break;
+    }
+    case 0x1a: case 0x1b: {                                 /* Bcc, SWI */
+        unsigned cond = (instr >> 8) & 15;
+        if (cond == 15)
+            swi(s, instr & 0xff);
+        else if (cond == 14)
+            undefined(s, instr);
+        else if (cond_passed(s, cond)) {
+            set_pc(s, pc + 4 + ((int32)(instr << 24) >> 23));
+            t_branch(s);
+        } else {
+            s->st.branches++;
+            t_skip(s);
+        }
+        break;
+    }
+    case 0x1c:                                              /* B */
+        set_pc(s, pc + 4 + ((int32)(instr << 21) >> 20));
+        t_branch(s);
+        break;
+    case 0x1d:                                              /* BLX suffix (v5) */
+        if (s->core->arch < 5 || (instr & 1)) undefined(s, instr);
+        res = s->r[14] + (instr & 0x7ff) * 2;
+        s->r[14] = (pc + 2) | 1;
+        s->thumb = false;
+        set_pc(s, res & ~3u);
+        t_branch(s);
+        break;
+    case 0x1e:                                              /* BL prefix */
+        s->r[14] = pc + 4 + ((int32)(instr << 21) >> 9);
+        t_dp(s, false);
+        break;
+    default:                                                /* BL suffix */
+        res = s->r[14] + (instr & 0x7ff) * 2;
+        s->r[14] = (pc + 2) | 1;
+        set_pc(s, res);
+        t_branch(s);
+        break;
+    }
+}
+
+/* Inside an IT block only the compares set the flags. */
+static bool thumb_compare(uint32 instr)
+{
+    return (instr >> 11) == 0x05 || (instr & 0xff00) == 0x4500 ||
+           ((instr & 0xff00) == 0x4200 && (instr & 0xc0) != 0x40) ||
+           instr >= 0xe800;
+}
+
+static void thumb_step(ArmSim *s)
+{
+    uint32 pc = s->pc, instr;
+
+    instr = sim_rd16(s, pc);
+    s->r[15] = pc + 4;
+    s->nextpc = pc + 2;
+    if (sim_trace) sim_trace(s, pc, instr);
+    s->st.insts++, s->st.thumb++;
+    if (s->itstate == 0)
+        thumb_execute(s, instr);
+    else {
+        unsigned cond = s->itstate >> 4;
+        s->itstate = (s->itstate & 7) == 0 ? 0
+                   : (s->itstate & 0xe0) | ((s->itstate << 1) & 0x1f);
+        if (!cond_passed(s, cond)) {
+            if ((instr >> 11) >= 0x1d) s->nextpc = pc + 4;
+            s->st.skipped++;
+            t_skip(s);
+        } else if (!thumb_compare(instr)) {
+            bool n = s->n, z = s->z, c = s->c, v = s->v;
+            thumb_execute(s, instr);
+            s->n = n, s->z = z, s->c = c, s->v = v;
+        } else
+            thumb_execute(s, instr);
+    }
+    s->pc = s->nextpc;
+}
+
+/* Run until the PC reaches stop or the program exits. */
+void sim_run(ArmSim *s, uint32 stop)
+{
+    while (!s->halted) {
+        uint32 pc = s->pc;
+        if (pc == stop) return;
+        if (pc - SIM_RT_BASE < SIM_RT_LIMIT - SIM_RT_BASE) {
+            sim_rt_call(s, pc);
+            continue;
+        }
+        if (sim_profile) sim_profile(s, pc);
+        s->prevload = s->lastload, s->prevlat = s->lastlat;
+        s->lastload = 0;
+        s->wrotepc = false;
+        if (s->thumb)
+            thumb_step(s);
+        else {
+            arm_step(s);
+            s->pc = s->nextpc;
+        }
+    }
+}
@@ -0,0 +1,1866 @@
+/* Copyright 2025 Piers Wombwell
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* The simulator's runtime: the compiler's support functions (division,
+ * software floating point, long long), the parts of the C library the
+ * test programs use, and the test harness calls. Each function has one
+ * word in [SIM_RT_BASE, SIM_RT_LIMIT); a branch there runs the host
+ * implementation, which takes its arguments from the APCS registers and
+ * stack and returns to lr.
+ *
+ * Floating point values are passed and stored in FPA word order (most
+ * significant word first), long long least significant word first, as
+ * the compiler's softfp code expects.
+ */
+
+#include "armsim.h"
+
+#include <ctype.h>
+#include <float.h>
+#include <math.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct RtEntry {
+    const char *name;
+    void (*fn)(ArmSim *s);
+    int cost;           /* approximate cycles taken by the ARM library routine */
+} RtEntry;
+
+/* FPA status bits as seen by __fp_status(): cumulative flags in the low
+ * byte, trap enables in the third.
+ */
+#define FPSR_IOC    0x00000001u
+#define FPSR_DZC    0x00000002u
+#define FPSR_OFC    0x00000004u
+#define FPSR_IOE    0x00010000u
+#define FPSR_DZE    0x00020000u
+#define FPSR_OFE    0x00040000u
+
+static uint32 fpsr = FPSR_IOE | FPSR_DZE | FPSR_OFE;
+
+static uint32 iob, errno_cell, huge_val, ctype_tab, argv0;
+static int test_failures, test_total;
+static bool test_failed;
+
+/* Signals, numbered as in the ARM C library's signal.h. A handler of 0
+ * is SIG_DFL.
+ */
+#define SIGABRT     1
+#define SIGFPE      2
+#define NSIG        16
+
+static uint32 sig_handler[NSIG];
+
+/* Lets a runtime function that raises a signal abandon itself; see
+ * deliver_signal().
+ */
+static jmp_buf rt_abandon;
+
+#define FILE_SIZE   40      /* sizeof(FILE) in the ARM C library */
+#define FILE_OCNT   8
+
+/* Arguments and results ------------------------------------------------ */
+
+static uint32 arg(ArmSim *s, int i)
+{
+    return i < 4 ? s->r[i] : sim_rd32(s, s->r[13] + 4 * (i - 4));
+}
+
+static void ret(ArmSim *s, uint32 v)
+{
+    s->r[0] = v;
+}
+
+static double bits_to_d(uint32 hi, uint32 lo)
+{
+    uint64_t b = (uint64_t)hi << 32 | lo;
+    double d;
+    memcpy(&d, &b, sizeof d);
+    return d;
+}
+
+static uint64_t d_to_bits(double d)
+{
+    uint64_t b;
+    memcpy(&b, &d, sizeof b);
+    return b;
+}
+
+static float bits_to_f(uint32 w)
+{
+    float f;
+    memcpy(&f, &w, sizeof f);
+    return f;
+}
+
+static uint32 f_to_bits(float f)
+{
+    uint32 w;
+    memcpy(&w, &f, sizeof w);
+    return w;
+}
+
+static double darg(ArmSim *s, int i)
+{
+    return bits_to_d(arg(s, i), arg(s, i + 1));
+}
+
+static float farg(ArmSim *s, int i)
+{
+    return bits_to_f(arg(s, i));
+}
+
+static void dret(ArmSim *s, double d)
+{
+    uint64_t b = d_to_bits(d);
+    s->r[0] = (uint32)(b >> 32);
+    s->r[1] = (uint32)b;
+}
+
+static void fret(ArmSim *s, float f)
+{
+    s->r[0] = f_to_bits(f);
+}
+
+static uint64_t llarg(ArmSim *s, int i)
+{
+    return (uint64_t)arg(s, i + 1) << 32 | arg(s, i);
+}
+
+static void llret(ArmSim *s, uint64_t v)
+{
+    s->r[0] = (uint32)v;
+    s->r[1] = (uint32)(v >> 32);
+}
+
+static void wr_double(ArmSim *s, uint32 a, double d)
+{
+    uint64_t b = d_to_bits(d);
+    sim_wr32(s, a, (uint32)(b >> 32));
+    sim_wr32(s, a + 4, (uint32)b);
+}
+
+/* Host pointer to n bytes of simulated memory. */
+static uint8 *ptr(ArmSim *s, uint32 a, uint32 n)
+{
+    if (n == 0) return s->mem;
+    if (a < SIM_IMAGE_BASE || a > s->memsize || n > s->memsize - a)
+        sim_fatal(s, "block of %lu bytes at 0x%08lx is outside memory",
+                  (unsigned long)n, (unsigned long)a);
+    return s->mem + a;
+}
+
+static char *str(ArmSim *s, uint32 a)
+{
+    char *p = (char *)ptr(s, a, 1);
+    if (memchr(p, 0, s->memsize - a) == NULL)
+        sim_fatal(s, "unterminated string at 0x%08lx", (unsigned long)a);
+    return p;
+}
+
+static uint32 addr_of(ArmSim *s, const void *p)
+{
+    return p == NULL ? 0 : (uint32)((const uint8 *)p - s->mem);
+}
+
+static void set_errno(ArmSim *s, int e)
+{
+    sim_wr32(s, errno_cell, (uint32)e);
+}
+
+/* Floating point exceptions ------------------------------------------- */
+
+static void deliver_signal(ArmSim *s, int sig, const char *what);
+
+static void fp_raise(ArmSim *s, uint32 flag)
+{
+    fpsr |= flag;
+    if (fpsr & (flag << 16))
+        deliver_signal(s, SIGFPE,
+                       flag == FPSR_IOC ? "floating point exception: invalid operation" :
+                       flag == FPSR_DZC ? "floating point exception: divide by zero" :
+                                          "floating point exception: overflow");
+}
+
+static bool d_snan(double d)
+{
+    uint64_t b = d_to_bits(d);
+    return isnan(d) && !(b & ((uint64_t)1 << 51));
+}
+
+static bool f_snan(float f)
+{
+    return isnan(f) && !(f_to_bits(f) & (1u << 22));
+}
+
+static double dcheck(ArmSim *s, double a, double b, double r, bool div)
+{
+    if (d_snan(a) || d_snan(b) || (isnan(r) && !isnan(a) && !isnan(b)))
+        fp_raise(s, FPSR_IOC);
+    else if (div && b == 0 && !isnan(a) && !isinf(a))
+        fp_raise(s, FPSR_DZC);
+    else if (isinf(r) && !isinf(a) && !isinf(b))
+        fp_raise(s, FPSR_OFC);
+    return r;
+}
+
+static float fcheck(ArmSim *s, float a, float b, float r, bool div)
+{
+    if (f_snan(a) || f_snan(b) || (isnan(r) && !isnan(a) && !isnan(b)))
+        fp_raise(s, FPSR_IOC);
+    else if (div && b == 0 && !isnan(a) && !isinf(a))
+        fp_raise(s, FPSR_DZC);
+    else if (isinf(r) && !isinf(a) && !isinf(b))
+        fp_raise(s, FPSR_OFC);
+    return r;
+}
+
+/* Comparisons: ordered ones are invalid with any NaN, equality only with
+ * a signalling NaN.
+ */
+static int dcmp(ArmSim *s, double a, double b, bool ordered)
+{
+    if (isnan(a) || isnan(b)) {
+        if (ordered || d_snan(a) || d_snan(b)) fp_raise(s, FPSR_IOC);
+        return 2;
+    }
+    return a < b ? -1 : a > b;
+}
+
+static int fcmp(ArmSim *s, float a, float b, bool ordered)
+{
+    if (isnan(a) || isnan(b)) {
+        if (ordered || f_snan(a) || f_snan(b)) fp_raise(s, FPSR_IOC);
+        return 2;
+    }
+    return a < b ? -1 : a > b;
+}
+
+/* Set the flags for a result-in-flags comparison as CMP would for an
+ * ordered result; unord gives the flags wanted for an unordered one.
+ */
+static void cmp_flags(ArmSim *s, int c, int unord)
+{
+    if (c == 2) c = unord;
+    if (c == 2) {
+        s->n = s->z = s->v = false;
+        s->c = true;
+        return;
+    }
+    s->n = c < 0;
+    s->z = c == 0;
+    s->c = c >= 0;
+    s->v = false;
+}
+
+static int32 dfix(ArmSim *s, double d)
+{
+    if (isnan(d) || d >= 2147483648.0 || d <= -2147483649.0) {
+        fp_raise(s, FPSR_IOC);
+        return isnan(d) ? 0 : d > 0 ? 0x7fffffff : (int32)0x80000000;
+    }
+    return (int32)d;
+}
+
+static uint32 dfixu(ArmSim *s, double d)
+{
+    if (isnan(d) || d >= 4294967296.0 || d <= -1.0) {
+        fp_raise(s, FPSR_IOC);
+        return isnan(d) || d < 0 ? 0 : 0xffffffff;
+    }
+    return (uint32)d;
+}
+
+/* Compiler support ------------------------------------------------------ */
+
+static void divide_by_zero(ArmSim *s)
+{
+    deliver_signal(s, SIGFPE, "integer divide by zero");
+}
+
+static void rt_sdiv(ArmSim *s)
+{
+    int32 d = (int32)s->r[0], n = (int32)s->r[1];
+    if (d == 0) divide_by_zero(s);
+    if (d == -1)
+        s->r[0] = -(uint32)n, s->r[1] = 0;
+    else
+        s->r[0] = (uint32)(n / d), s->r[1] = (uint32)(n % d);
+}
+
+static void rt_udiv(ArmSim *s)
+{
+    uint32 d = s->r[0], n = s->r[1];
+    if (d == 0) divide_by_zero(s);
+    s->r[0] = n / d, s->r[1] = n % d;
+}
+
+static void rt_sdiv10(ArmSim *s)
+{
+    int32 n = (int32)s->r[0];
+    s->r[0] = (uint32)(n / 10), s->r[1] = (uint32)(n % 10);
+}
+
+static void rt_udiv10(ArmSim *s)
+{
+    uint32 n = s->r[0];
+    s->r[0] = n / 10, s->r[1] = n % 10;
+}
+
+static void rt_srem10(ArmSim *s) { ret(s, (uint32)((int32)s->r[0] % 10)); }
+static void rt_urem10(ArmSim *s) { ret(s, s->r[0] % 10); }
+
+static void rt_srem(ArmSim *s) { rt_sdiv(s); ret(s, s->r[1]); }
+static void rt_urem(ArmSim *s) { rt_udiv(s); ret(s, s->r[1]); }
+static void rt_mul(ArmSim *s) { ret(s, s->r[0] * s->r[1]); }
+
+static void rt_divtest(ArmSim *s)
+{
+    if (s->r[0] == 0) divide_by_zero(s);
+}
+
+static void rt_stkovf(ArmSim *s)
+{
+    sim_fatal(s, "stack overflow (sp 0x%08lx)", (unsigned long)s->r[13]);
+}
+
+static void rt_memcheck(ArmSim *s)
+{
+    ptr(s, s->r[0], 1);
+}
+
+#define DOP(name, expr, div) \
+    static void name(ArmSim *s) \
+    { \
+        double a = darg(s, 0), b = darg(s, 2); \
+        dret(s, dcheck(s, a, b, expr, div)); \
+    }
+
+DOP(rt_dadd, a + b, false)
+DOP(rt_dsub, a - b, false)
+DOP(rt_drsb, b - a, false)
+DOP(rt_dmul, a * b, false)
+DOP(rt_ddiv, a / b, true)
+
+static void rt_drdiv(ArmSim *s)
+{
+    double a = darg(s, 0), b = darg(s, 2);
+    dret(s, dcheck(s, b, a, b / a, true));
+}
+
+#define FOP(name, expr, div) \
+    static void name(ArmSim *s) \
+    { \
+        float a = farg(s, 0), b = farg(s, 1); \
+        fret(s, fcheck(s, a, b, expr, div)); \
+    }
+
+FOP(rt_fadd, a + b, false)
+FOP(rt_fsub, a - b, false)
+FOP(rt_frsb, b - a, false)
+FOP(rt_fmul, a * b, false)
+FOP(rt_fdiv, a / b, true)
+
+static void rt_frdiv(ArmSim *s)
+{
+    float a = farg(s, 0), b = farg(s, 1);
+    fret(s, fcheck(s, b, a, b / a, true));
+}
+
+static void rt_dneg(ArmSim *s) { s->r[0] ^= 0x80000000u; }
+static void rt_fneg(ArmSim *s) { s->r[0] ^= 0x80000000u; }
+static void rt_dfix(ArmSim *s) { ret(s, (uint32)dfix(s, darg(s, 0))); }
+static void rt_dfixu(ArmSim *s) { ret(s, dfixu(s, darg(s, 0))); }
+static void rt_ffix(ArmSim *s) { ret(s, (uint32)dfix(s, farg(s, 0))); }
+static void rt_ffixu(ArmSim *s) { ret(s, dfixu(s, farg(s, 0))); }
+static void rt_dflt(ArmSim *s) { dret(s, (int32)s->r[0]); }
+static void rt_dfltu(ArmSim *s) { dret(s, s->r[0]); }
+static void rt_fflt(ArmSim *s) { fret(s, (float)(int32)s->r[0]); }
+static void rt_ffltu(ArmSim *s) { fret(s, (float)s->r[0]); }
+
+static void rt_d2f(ArmSim *s)
+{
+    double d = darg(s, 0);
+    float f = (float)d;
+    if (d_snan(d)) fp_raise(s, FPSR_IOC);
+    else if (isinf(f) && !isinf(d)) fp_raise(s, FPSR_OFC);
+    fret(s, f);
+}
+
+static void rt_f2d(ArmSim *s)
+{
+    float f = farg(s, 0);
+    if (f_snan(f)) fp_raise(s, FPSR_IOC);
+    dret(s, f);
+}
+
+#define DREL(name, test, ordered) \
+    static void name(ArmSim *s) \
+    { \
+        int c = dcmp(s, darg(s, 0), darg(s, 2), ordered); \
+        ret(s, c != 2 && (test)); \
+    }
+
+DREL(rt_deq, c == 0, false)
+DREL(rt_dgr, c > 0, true)
+DREL(rt_dgeq, c >= 0, true)
+DREL(rt_dls, c < 0, true)
+DREL(rt_dleq, c <= 0, true)
+
+static void rt_dneq(ArmSim *s)
+{
+    ret(s, dcmp(s, darg(s, 0), darg(s, 2), false) != 0);
+}
+
+#define FREL(name, test, ordered) \
+    static void name(ArmSim *s) \
+    { \
+        int c = fcmp(s, farg(s, 0), farg(s, 1), ordered); \
+        ret(s, c != 2 && (test)); \
+    }
+
+FREL(rt_feq, c == 0, false)
+FREL(rt_fgr, c > 0, true)
+FREL(rt_fgeq, c >= 0, true)
+FREL(rt_fls, c < 0, true)
+FREL(rt_fleq, c <= 0, true)
+
+static void rt_fneq(ArmSim *s)
+{
+    ret(s, fcmp(s, farg(s, 0), farg(s, 1), false) != 0);
+}
+
+/* Result in flags: _xcmpge is tested with HI/HS so unordered must clear
+ * C; _xcmple with LO/LS so it must set C and clear Z; _xcmpeq with EQ/NE.
+ */
+static void rt_dcmpeq(ArmSim *s) { cmp_flags(s, dcmp(s, darg(s, 0), darg(s, 2), false), 2); }
+static void rt_dcmpge(ArmSim *s) { cmp_flags(s, dcmp(s, darg(s, 0), darg(s, 2), true), -1); }
+static void rt_dcmple(ArmSim *s) { cmp_flags(s, dcmp(s, darg(s, 0), darg(s, 2), true), 2); }
+static void rt_fcmpeq(ArmSim *s) { cmp_flags(s, fcmp(s, farg(s, 0), farg(s, 1), false), 2); }
+static void rt_fcmpge(ArmSim *s) { cmp_flags(s, fcmp(s, farg(s, 0), farg(s, 1), true), -1); }
+static void rt_fcmple(ArmSim *s) { cmp_flags(s, fcmp(s, farg(s, 0), farg(s, 1), true), 2); }
+
+/* long long */
+
+#define LLOP(name, expr) \
+    static void name(ArmSim *s) \
+    { \
+        uint64_t a = llarg(s, 0), b = llarg(s, 2); \
+        llret(s, expr); \
+    }
+
+LLOP(rt_ll_add, a + b)
+LLOP(rt_ll_sub, a - b)
+LLOP(rt_ll_rsb, b - a)
+LLOP(rt_ll_mul, a * b)
+LLOP(rt_ll_and, a & b)
+LLOP(rt_ll_or, a | b)
+LLOP(rt_ll_eor, a ^ b)
+
+static void rt_ll_not(ArmSim *s) { llret(s, ~llarg(s, 0)); }
+static void rt_ll_neg(ArmSim *s) { llret(s, -llarg(s, 0)); }
+
+/* The ARM library's divisions return the quotient in a1/a2 and the
+ * remainder in a3/a4; the remainder entries just return the remainder.
+ */
+static void ll_udivmod(ArmSim *s, uint64_t n, uint64_t d, bool rem)
+{
+    uint64_t q, r;
+    if (d == 0) divide_by_zero(s);
+    q = n / d, r = n % d;
+    llret(s, rem ? r : q);
+    s->r[2] = (uint32)(rem ? q : r);
+    s->r[3] = (uint32)((rem ? q : r) >> 32);
+}
+
+static void ll_sdivmod(ArmSim *s, int64_t n, int64_t d, bool rem)
+{
+    uint64_t q, r;
+    if (d == 0) divide_by_zero(s);
+    if (d == -1)
+        q = -(uint64_t)n, r = 0;
+    else
+        q = (uint64_t)(n / d), r = (uint64_t)(n % d);
+    llret(s, rem ? r : q);
+    s->r[2] = (uint32)(rem ? q : r);
+    s->r[3] = (uint32)((rem ? q : r) >> 32);
+}
+
+static void rt_ll_udiv(ArmSim *s) { ll_udivmod(s, llarg(s, 0), llarg(s, 2), false); }
+static void rt_ll_urdv(ArmSim *s) { ll_udivmod(s, llarg(s, 2), llarg(s, 0), false); }
+static void rt_ll_urem(ArmSim *s) { ll_udivmod(s, llarg(s, 0), llarg(s, 2), true); }
+static void rt_ll_urrem(ArmSim *s) { ll_udivmod(s, llarg(s, 2), llarg(s, 0), true); }
+static void rt_ll_sdiv(ArmSim *s) { ll_sdivmod(s, (int64_t)llarg(s, 0), (int64_t)llarg(s, 2), false); }
+static void rt_ll_srdv(ArmSim *s) { ll_sdivmod(s, (int64_t)llarg(s, 2), (int64_t)llarg(s, 0), false); }
+static void rt_ll_srem(ArmSim *s) { ll_sdivmod(s, (int64_t)llarg(s, 0), (int64_t)llarg(s, 2), true); }
+static void rt_ll_srrem(ArmSim *s) { ll_sdivmod(s, (int64_t)llarg(s, 2), (int64_t)llarg(s, 0), true); }
+
+static void rt_ll_shift_l(ArmSim *s)
+{
+    uint32 n = s->r[2];
+    llret(s, n >= 64 ? 0 : llarg(s, 0) << n);
+}
+
+static void rt_ll_ushift_r(ArmSim *s)
+{
+    uint32 n = s->r[2];
+    llret(s, n >= 64 ? 0 : llarg(s, 0) >> n);
+}
+
+static void rt_ll_sshift_r(ArmSim *s)
+{
+    int64_t v = (int64_t)llarg(s, 0);
+    uint32 n = s->r[2];
+    if (n >= 64) n = 63;
+    llret(s, (uint64_t)(v < 0 ? ~(~v >> n) : v >> n));
+}
+
+static int llcmpu(uint64_t a, uint64_t b) { return a < b ? -1 : a > b; }
+static int llcmps(int64_t a, int64_t b) { return a < b ? -1 : a > b; }
+
+#define LLREL(name, cmp, type, test) \
+    static void name(ArmSim *s) \
+    { \
+        int c = cmp((type)llarg(s, 0), (type)llarg(s, 2)); \
+        ret(s, test); \
+    }
+
+LLREL(rt_ll_cmpne, llcmpu, uint64_t, c != 0)
+LLREL(rt_ll_ucmpgt, llcmpu, uint64_t, c > 0)
+LLREL(rt_ll_ucmpge, llcmpu, uint64_t, c >= 0)
+LLREL(rt_ll_ucmplt, llcmpu, uint64_t, c < 0)
+LLREL(rt_ll_ucmple, llcmpu, uint64_t, c <= 0)
+LLREL(rt_ll_scmpgt, llcmps, int64_t, c > 0)
+LLREL(rt_ll_scmplt, llcmps, int64_t, c < 0)
+
+/* _ll_cmpeq, _ll_scmpge and _ll_scmple serve both conventions: the
+ * value for the APCS one, the flags (an unsigned compare for cmpeq, a
+ * signed one otherwise) when the compiler wants the result in flags.
+ */
+static void rt_ll_cmpeq(ArmSim *s)
+{
+    int c = llcmpu(llarg(s, 0), llarg(s, 2));
+    cmp_flags(s, c, c);
+    ret(s, c == 0);
+}
+
+static void rt_ll_scmpge(ArmSim *s)
+{
+    int c = llcmps((int64_t)llarg(s, 0), (int64_t)llarg(s, 2));
+    cmp_flags(s, c, c);
+    ret(s, c >= 0);
+}
+
+static void rt_ll_scmple(ArmSim *s)
+{
+    int c = llcmps((int64_t)llarg(s, 0), (int64_t)llarg(s, 2));
+    cmp_flags(s, -c, -c);
+    ret(s, c <= 0);
+}
+
+static void rt_ll_from_l(ArmSim *s) { llret(s, (uint64_t)(int64_t)(int32)s->r[0]); }
+static void rt_ll_from_u(ArmSim *s) { llret(s, s->r[0]); }
+static void rt_ll_to_l(ArmSim *s) { (void)s; }
+static void rt_ll_sto_d(ArmSim *s) { dret(s, (double)(int64_t)llarg(s, 0)); }
+static void rt_ll_uto_d(ArmSim *s) { dret(s, (double)llarg(s, 0)); }
+static void rt_ll_sto_f(ArmSim *s) { fret(s, (float)(int64_t)llarg(s, 0)); }
+static void rt_ll_uto_f(ArmSim *s) { fret(s, (float)llarg(s, 0)); }
+
+static uint64_t ll_sfrom(ArmSim *s, double d)
+{
+    if (isnan(d) || d >= 9223372036854775808.0 || d < -9223372036854775808.0) {
+        fp_raise(s, FPSR_IOC);
+        return isnan(d) ? 0 : d > 0 ? 0x7fffffffffffffffull : 0x8000000000000000ull;
+    }
+    return (uint64_t)(int64_t)d;
+}
+
+static uint64_t ll_ufrom(ArmSim *s, double d)
+{
+    if (isnan(d) || d >= 18446744073709551616.0 || d <= -1.0) {
+        fp_raise(s, FPSR_IOC);
+        return isnan(d) || d < 0 ? 0 : ~(uint64_t)0;
+    }
+    return (uint64_t)d;
+}
+
+static void rt_ll_sfrom_d(ArmSim *s) { llret(s, ll_sfrom(s, darg(s, 0))); }
+static void rt_ll_sfrom_f(ArmSim *s) { llret(s, ll_sfrom(s, farg(s, 0))); }
+static void rt_ll_ufrom_d(ArmSim *s) { llret(s, ll_ufrom(s, darg(s, 0))); }
+static void rt_ll_ufrom_f(ArmSim *s) { llret(s, ll_ufrom(s, farg(s, 0))); }
+
+static void rt_fp_status(ArmSim *s)
+{
+    uint32 old = fpsr, mask = s->r[0];
+    fpsr = (fpsr & ~mask) | (s->r[1] & mask);
+    ret(s, old);
+}
+
+/* Calls back into simulated code --------------------------------------- */
+
+/* Call fn(a1, a2) and return its result, leaving the caller's pc alone. */
+uint32 sim_call(ArmSim *s, uint32 fn, uint32 a1, uint32 a2)
+{
+    uint32 pc = s->pc;
+    bool thumb = s->thumb;
+    jmp_buf abandon;
+    memcpy(abandon, rt_abandon, sizeof(jmp_buf));
+    s->r[0] = a1, s->r[1] = a2;
+    s->r[14] = SIM_RT_RETURN;
+    s->pc = fn & ~1u;
+    s->thumb = fn & 1;
+    sim_run(s, SIM_RT_RETURN);
+    memcpy(rt_abandon, abandon, sizeof(jmp_buf));
+    if (s->halted)
+        return 0;
+    s->pc = pc, s->thumb = thumb;
+    return s->r[0];
+}
+
+/* Heap: a bump allocator with a free list of exact-sized blocks, each
+ * preceded by a word holding its size.
+ */
+
+static uint32 free_list;
+
+static uint32 heap_alloc(ArmSim *s, uint32 n)
+{
+    uint32 prev = 0, b;
+    n = (n + 7) & ~7u;
+    if (n == 0) n = 8;
+    for (b = free_list; b != 0; prev = b, b = sim_rd32(s, b))
+        if (sim_rd32(s, b - 4) == n) {
+            if (prev == 0)
+                free_list = sim_rd32(s, b);
+            else
+                sim_wr32(s, prev, sim_rd32(s, b));
+            return b;
+        }
+    if (s->heap_limit - s->heap < n + 8)
+        return 0;
+    b = s->heap + 8;
+    sim_wr32(s, b - 4, n);
+    s->heap = b + n;
+    return b;
+}
+
+static void heap_free(ArmSim *s, uint32 b)
+{
+    if (b == 0) return;
+    sim_wr32(s, b, free_list);
+    free_list = b;
+}
+
+static void rt_malloc(ArmSim *s) { ret(s, heap_alloc(s, s->r[0])); }
+static void rt_free(ArmSim *s) { heap_free(s, s->r[0]); }
+
+static void rt_calloc(ArmSim *s)
+{
+    uint32 n = s->r[0] * s->r[1], b = heap_alloc(s, n);
+    if (b) memset(ptr(s, b, n), 0, n);
+    ret(s, b);
+}
+
+static void rt_realloc(ArmSim *s)
+{
+    uint32 old = s->r[0], n = s->r[1], b;
+    if (old == 0) {
+        ret(s, heap_alloc(s, n));
+        return;
+    }
+    b = heap_alloc(s, n);
+    if (b) {
+        uint32 size = sim_rd32(s, old - 4);
+        memcpy(ptr(s, b, n), ptr(s, old, size < n ? size : n), size < n ? size : n);
+        heap_free(s, old);
+    }
+    ret(s, b);
+}
+
+/* string.h -------------------------------------------------------------- */
+
+static void block_cost(ArmSim *s, uint32 n)
+{
+    s->st.cycles += n / 4;
+}
+
+static void rt_memcpy(ArmSim *s)
+{
+    uint32 n = s->r[2];
+    memmove(ptr(s, s->r[0], n), ptr(s, s->r[1], n), n);
+    block_cost(s, n);
+}
+
+static void rt_memset(ArmSim *s)
+{
+    uint32 n = s->r[2];
+    memset(ptr(s, s->r[0], n), (int)s->r[1], n);
+    block_cost(s, n);
+}
+
+static void rt_memcmp(ArmSim *s)
+{
+    uint32 n = s->r[2];
+    ret(s, (uint32)memcmp(ptr(s, s->r[0], n), ptr(s, s->r[1], n), n));
+    block_cost(s, n);
+}
+
+static void rt_memchr(ArmSim *s)
+{
+    uint32 n = s->r[2];
+    ret(s, addr_of(s, memchr(ptr(s, s->r[0], n), (int)s->r[1], n)));
+}
+
+static void rt_strlen(ArmSim *s) { ret(s, (uint32)strlen(str(s, s->r[0]))); }
+
+static void rt_strcpy(ArmSim *s)
+{
+    const char *src = str(s, s->r[1]);
+    size_t n = strlen(src) + 1;
+    memmove(ptr(s, s->r[0], (uint32)n), src, n);
+}
+
+static void rt_strncpy(ArmSim *s)
+{
+    uint32 n = s->r[2];
+    char *d = (char *)ptr(s, s->r[0], n);
+    const char *src = (const char *)ptr(s, s->r[1], 1);
+    uint32 i;
+    for (i = 0; i < n && src[i] != 0; i++) d[i] = src[i];
+    for (; i < n; i++) d[i] = 0;
+}
+
+static void rt_strcat(ArmSim *s)
+{
+    uint32 d = s->r[0] + (uint32)strlen(str(s, s->r[0]));
+    const char *src = str(s, s->r[1]);
+    size_t n = strlen(src) + 1;
+    memmove(ptr(s, d, (uint32)n), src, n);
+}
+
+static void rt_strncat(ArmSim *s)
+{
+    uint32 d = s->r[0] + (uint32)strlen(str(s, s->r[0])), n = s->r[2], i;
+    const char *src = (const char *)ptr(s, s->r[1], 1);
+    for (i = 0; i < n && src[i] != 0; i++)
+        sim_wr8(s, d + i, (uint8)src[i]);
+    sim_wr8(s, d + i, 0);
+}
+
+static void rt_strcmp(ArmSim *s) { ret(s, (uint32)strcmp(str(s, s->r[0]), str(s, s->r[1]))); }
+static void rt_strncmp(ArmSim *s) { ret(s, (uint32)strncmp(str(s, s->r[0]), str(s, s->r[1]), s->r[2])); }
+static void rt_strchr(ArmSim *s) { ret(s, addr_of(s, strchr(str(s, s->r[0]), (int)(s->r[1] & 0xff)))); }
+static void rt_strrchr(ArmSim *s) { ret(s, addr_of(s, strrchr(str(s, s->r[0]), (int)(s->r[1] & 0xff)))); }
+static void rt_strstr(ArmSim *s) { ret(s, addr_of(s, strstr(str(s, s->r[0]), str(s, s->r[1])))); }
+
+/* ctype.h -------------------------------------------------------------- */
+
+static void rt_toupper(ArmSim *s) { ret(s, (uint32)toupper((int)s->r[0])); }
+static void rt_tolower(ArmSim *s) { ret(s, (uint32)tolower((int)s->r[0])); }
+static void rt_isblank(ArmSim *s) { ret(s, s->r[0] == ' ' || s->r[0] == '\t'); }
+
+/* stdlib.h ------------------------------------------------------------- */
+
+static void rt_exit(ArmSim *s)
+{
+    s->exitcode = (int)s->r[0];
+    s->halted = true;
+}
+
+static void rt_abort(ArmSim *s)
+{
+    fflush(stdout);
+    sim_fatal(s, "abort() called");
+}
+
+static void rt_abs(ArmSim *s) { ret(s, (int32)s->r[0] < 0 ? -s->r[0] : s->r[0]); }
+static void rt_atoi(ArmSim *s) { ret(s, (uint32)atoi(str(s, s->r[0]))); }
+
+static void rt_strtol(ArmSim *s)
+{
+    char *p = str(s, s->r[0]), *end;
+    long v = strtol(p, &end, (int)s->r[2]);
+    if (v > 0x7fffffffL) v = 0x7fffffffL, set_errno(s, 2);
+    if (v < -0x7fffffffL - 1) v = -0x7fffffffL - 1, set_errno(s, 2);
+    if (s->r[1]) sim_wr32(s, s->r[1], addr_of(s, end));
+    ret(s, (uint32)v);
+}
+
+static void rt_strtoul(ArmSim *s)
+{
+    char *p = str(s, s->r[0]), *end;
+    unsigned long v = strtoul(p, &end, (int)s->r[2]);
+    if (v > 0xffffffffUL) v = 0xffffffffUL, set_errno(s, 2);
+    if (s->r[1]) sim_wr32(s, s->r[1], addr_of(s, end));
+    ret(s, (uint32)v);
+}
+
+static void rt_strtod(ArmSim *s)
+{
+    char *p = str(s, s->r[0]), *end;
+    double d = strtod(p, &end);
+    if (s->r[1]) sim_wr32(s, s->r[1], addr_of(s, end));
+    dret(s, d);
+}
+
+static void rt_atof(ArmSim *s) { dret(s, atof(str(s, s->r[0]))); }
+
+static uint32 rand_next = 1;
+
+static void rt_rand(ArmSim *s)
+{
+    rand_next = rand_next * 1103515245u + 12345u;
+    ret(s, (rand_next >> 16) & 0x7fff);
+}
+
+static void rt_srand(ArmSim *s) { rand_next = s->r[0]; }
+static void rt_getenv(ArmSim *s) { ret(s, 0); }
+
+static void rt_qsort(ArmSim *s)
+{
+    uint32 base = s->r[0], n = s->r[1], size = s->r[2], cmp = s->r[3];
+    uint32 gap, i, j;
+    uint8 *tmp;
+
+    if (n < 2 || size == 0) return;
+    tmp = (uint8 *)malloc(size);
+    /* Shell sort: the comparisons are simulated, so keep them few and
+     * keep the sort free of recursion.
+     */
+    for (gap = n / 2; gap > 0; gap /= 2)
+        for (i = gap; i < n; i++) {
+            memcpy(tmp, ptr(s, base + i * size, size), size);
+            for (j = i; j >= gap; j -= gap) {
+                uint32 hole = base + j * size, prev = hole - gap * size;
+                memcpy(ptr(s, hole, size), tmp, size);
+                if ((int32)sim_call(s, cmp, prev, hole) <= 0 || s->halted)
+                    break;
+                memcpy(ptr(s, hole, size), ptr(s, prev, size), size);
+                memcpy(ptr(s, prev, size), tmp, size);
+            }
+        }
+    free(tmp);
+}
+
+/* setjmp.h: the callee-saved registers, sp and lr in the first words of
+ * the jmp_buf.
+ */
+
+static void rt_setjmp(ArmSim *s)
+{
+    uint32 buf = s->r[0];
+    int r;
+    for (r = 4; r <= 14; r++)
+        sim_wr32(s, buf + 4 * (r - 4), s->r[r]);
+    ret(s, 0);
+}
+
+static void rt_longjmp(ArmSim *s)
+{
+    uint32 buf = s->r[0], v = s->r[1], lr;
+    int r;
+    for (r = 4; r <= 13; r++)
+        s->r[r] = sim_rd32(s, buf + 4 * (r - 4));
+    lr = sim_rd32(s, buf + 4 * 10);
+    s->r[14] = lr;
+    s->pc = lr & ~1u;
+    s->thumb = lr & 1;
+    ret(s, v ? v : 1);
+}
+
+/* math.h --------------------------------------------------------------- */
+
+/* As the ARM C library: domain errors give -HUGE_VAL and EDOM, range
+ * errors +-HUGE_VAL (DBL_MAX) and ERANGE.
+ */
+static void math_result(ArmSim *s, double x, double r)
+{
+    if (isnan(r) && !isnan(x)) {
+        set_errno(s, 1);                /* EDOM */
+        r = -DBL_MAX;
+    } else if (isinf(r) && !isinf(x)) {
+        set_errno(s, 2);                /* ERANGE */
+        r = r < 0 ? -DBL_MAX : DBL_MAX;
+    }
+    dret(s, r);
+}
+
+#define MATH1(name, fn) \
+    static void name(ArmSim *s) { double x = darg(s, 0); math_result(s, x, fn(x)); }
+
+MATH1(rt_sqrt, sqrt)
+MATH1(rt_sin, sin)
+MATH1(rt_cos, cos)
+MATH1(rt_tan, tan)
+MATH1(rt_asin, asin)
+MATH1(rt_acos, acos)
+MATH1(rt_atan, atan)
+MATH1(rt_sinh, sinh)
+MATH1(rt_cosh, cosh)
+MATH1(rt_tanh, tanh)
+MATH1(rt_exp, exp)
+MATH1(rt_log, log)
+MATH1(rt_log10, log10)
+MATH1(rt_floor, floor)
+MATH1(rt_ceil, ceil)
+MATH1(rt_fabs, fabs)
+
+static void rt_atan2(ArmSim *s) { dret(s, atan2(darg(s, 0), darg(s, 2))); }
+static void rt_fmod(ArmSim *s) { dret(s, fmod(darg(s, 0), darg(s, 2))); }
+
+static void rt_pow(ArmSim *s)
+{
+    double x = darg(s, 0);
+    math_result(s, x, pow(x, darg(s, 2)));
+}
+
+static void rt_ldexp(ArmSim *s) { dret(s, ldexp(darg(s, 0), (int)s->r[2])); }
+
+static void rt_frexp(ArmSim *s)
+{
+    int e;
+    double m = frexp(darg(s, 0), &e);
+    sim_wr32(s, s->r[2], (uint32)e);
+    dret(s, m);
+}
+
+static void rt_modf(ArmSim *s)
+{
+    double i, f = modf(darg(s, 0), &i);
+    wr_double(s, s->r[2], i);
+    dret(s, f);
+}
+
+/* stdio.h -------------------------------------------------------------- */
+
+static FILE *host_stream(ArmSim *s, uint32 f)
+{
+    if (f == iob) return stdin;
+    if (f == iob + FILE_SIZE) return stdout;
+    if (f == iob + 2 * FILE_SIZE) return stderr;
+    sim_fatal(s, "unsupported stream 0x%08lx", (unsigned long)f);
+    return NULL;
+}
+
+/* The arguments of a variadic function, from an APCS argument position or
+ * a va_list (a pointer to the next argument word).
+ */
+typedef struct VaArgs {
+    ArmSim *s;
+    int next;
+    uint32 ap;
+} VaArgs;
+
+static uint32 va_word(VaArgs *va)
+{
+    if (va->ap != 0) {
+        uint32 w = sim_rd32(va->s, va->ap);
+        va->ap += 4;
+        return w;
+    }
+    return arg(va->s, va->next++);
+}
+
+typedef struct OutBuf {
+    char *p;
+    size_t len, size;
+} OutBuf;
+
+static void out_append(OutBuf *o, const char *p, size_t n)
+{
+    if (o->len + n + 1 > o->size) {
+        o->size = (o->len + n + 1) * 2;
+        o->p = (char *)realloc(o->p, o->size);
+    }
+    memcpy(o->p + o->len, p, n);
+    o->len += n;
+    o->p[o->len] = 0;
+}
+
+/* Format into o using the host printf for each conversion. */
+static void format(ArmSim *s, OutBuf *o, const char *fmt, VaArgs *va)
+{
+    while (*fmt) {
+        char spec[32], tmp[512];
+        const char *start = fmt;
+        int n = 0, lng = 0, width = -1, prec = -1;
+        size_t k = 0;
+
+        if (*fmt != '%') {
+            const char *e = strchr(fmt, '%');
+            if (e == NULL) e = fmt + strlen(fmt);
+            out_append(o, fmt, (size_t)(e - fmt));
+            fmt = e;
+            continue;
+        }
+        spec[k++] = *fmt++;
+        while (strchr("-+ #0", *fmt) && k < 8) spec[k++] = *fmt++;
+        if (*fmt == '*') { width = (int)va_word(va); fmt++; }
+        else while (isdigit((unsigned char)*fmt)) width = (width < 0 ? 0 : width * 10) + *fmt++ - '0';
+        if (*fmt == '.') {
+            fmt++;
+            prec = 0;
+            if (*fmt == '*') { prec = (int)va_word(va); fmt++; }
+            else while (isdigit((unsigned char)*fmt)) prec = prec * 10 + *fmt++ - '0';
+        }
+        while (*fmt == 'l' || *fmt == 'h' || *fmt == 'L') {
+            if (*fmt == 'l') lng++;
+            if (*fmt == 'L') lng = 2;
+            fmt++;
+        }
+        if (width >= 0) k += (size_t)sprintf(spec + k, "%d", width > 256 ? 256 : width);
+        if (prec >= 0) k += (size_t)sprintf(spec + k, ".%d", prec > 256 ? 256 : prec);
+        switch (*fmt) {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+            if (lng >= 2 && *fmt != 'c') {
+                uint64_t lo = va_word(va), v = lo | (uint64_t)va_word(va) << 32;
+                spec[k++] = 'l', spec[k++] = 'l', spec[k++] = *fmt, spec[k] = 0;
+                n = sprintf(tmp, spec, v);
+            } else {
+                uint32 v = va_word(va);
+                spec[k++] = *fmt, spec[k] = 0;
+                if (*fmt == 'd' || *fmt == 'i')
+                    n = sprintf(tmp, spec, (int)(int32)v);
+                else
+                    n = sprintf(tmp, spec, (unsigned)v);
+            }
+            out_append(o, tmp, (size_t)n);
+            break;
+        case 'e': case 'E': case 'f': case 'g': case 'G': {
+            uint32 hi = va_word(va);
+            spec[k++] = *fmt, spec[k] = 0;
+            n = sprintf(tmp, spec, bits_to_d(hi, va_word(va)));
+            out_append(o, tmp, (size_t)n);
+            break;
+        }
+        case 'p':
+            n = sprintf(tmp, "0x%08lx", (unsigned long)va_word(va));
+            out_append(o, tmp, (size_t)n);
+            break;
+        case 's': {
+            uint32 a = va_word(va);
+            const char *p = a == 0 ? "(null)" : str(s, a);
+            size_t len = strlen(p);
+            if (prec >= 0 && (size_t)prec < len) len = (size_t)prec;
+            if (width >= 0 && (size_t)width > len && spec[1] != '-')
+                while (width-- > (int)len) out_append(o, " ", 1);
+            out_append(o, p, len);
+            if (width >= 0 && (size_t)width > len && spec[1] == '-')
+                while (width-- > (int)len) out_append(o, " ", 1);
+            break;
+        }
+        case 'n':
+            sim_wr32(s, va_word(va), (uint32)o->len);
+            break;
+        case '%':
+            out_append(o, "%", 1);
+            break;
+        default:
+            out_append(o, start, (size_t)(fmt - start) + (*fmt != 0));
+            break;
+        }
+        if (*fmt) fmt++;
+    }
+    if (o->p == NULL) out_append(o, "", 0);
+}
+
+static void print_to(ArmSim *s, FILE *f, uint32 fmt, VaArgs *va)
+{
+    OutBuf o = { NULL, 0, 0 };
+    format(s, &o, str(s, fmt), va);
+    fwrite(o.p, 1, o.len, f);
+    ret(s, (uint32)o.len);
+    free(o.p);
+}
+
+static void print_into(ArmSim *s, uint32 buf, uint32 max, uint32 fmt, VaArgs *va)
+{
+    OutBuf o = { NULL, 0, 0 };
+    format(s, &o, str(s, fmt), va);
+    if (max != 0) {
+        uint32 n = o.len < max ? (uint32)o.len : max - 1;
+        memcpy(ptr(s, buf, n + 1), o.p, n);
+        s->mem[buf + n] = 0;
+    }
+    ret(s, (uint32)o.len);
+    free(o.p);
+}
+
+static void rt_printf(ArmSim *s)
+{
+    VaArgs va = { s, 1, 0 };
+    print_to(s, stdout, s->r[0], &va);
+}
+
+static void rt_fprintf(ArmSim *s)
+{
+    VaArgs va = { s, 2, 0 };
+    print_to(s, host_stream(s, s->r[0]), s->r[1], &va);
+}
+
+static void rt_sprintf(ArmSim *s)
+{
+    VaArgs va = { s, 2, 0 };
+    print_into(s, s->r[0], 0xffffffffu, s->r[1], &va);
+}
+
+static void rt_snprintf(ArmSim *s)
+{
+    VaArgs va = { s, 3, 0 };
+    print_into(s, s->r[0], s->r[1], s->r[2], &va);
+}
+
+static void rt_vprintf(ArmSim *s)
+{
+    VaArgs va = { s, 0, 0 };
+    va.ap = s->r[1];
+    print_to(s, stdout, s->r[0], &va);
+}
+
+static void rt_vfprintf(ArmSim *s)
+{
+    VaArgs va = { s, 0, 0 };
+    va.ap = s->r[2];
+    print_to(s, host_stream(s, s->r[0]), s->r[1], &va);
+}
+
+static void rt_vsprintf(ArmSim *s)
+{
+    VaArgs va = { s, 0, 0 };
+    va.ap = s->r[2];
+    print_into(s, s->r[0], 0xffffffffu, s->r[1], &va);
+}
+
+static void rt_vsnprintf(ArmSim *s)
+{
+    VaArgs va = { s, 0, 0 };
+    va.ap = s->r[3];
+    print_into(s, s->r[0], s->r[1], s->r[2], &va);
+}
+
+static void rt_putchar(ArmSim *s) { ret(s, (uint32)putchar((int)s->r[0])); }
+static void rt_fputc(ArmSim *s) { ret(s, (uint32)fputc((int)s->r[0], host_stream(s, s->r[1]))); }
+static void rt_puts(ArmSim *s) { ret(s, (uint32)puts(str(s, s->r[0]))); }
+static void rt_fputs(ArmSim *s) { ret(s, (uint32)fputs(str(s, s->r[0]), host_stream(s, s->r[1]))); }
+static void rt_getchar(ArmSim *s) { ret(s, (uint32)getchar()); }
+static void rt_fgetc(ArmSim *s) { ret(s, (uint32)fgetc(host_stream(s, s->r[0]))); }
+
+static void rt_fflush(ArmSim *s)
+{
+    ret(s, (uint32)fflush(s->r[0] == 0 ? NULL : host_stream(s, s->r[0])));
+}
+
+static void rt_fwrite(ArmSim *s)
+{
+    uint32 n = s->r[1] * s->r[2];
+    FILE *f = host_stream(s, s->r[3]);
+    ret(s, s->r[1] == 0 ? 0 : (uint32)fwrite(ptr(s, s->r[0], n), 1, n, f) / s->r[1]);
+}
+
+static void rt_fgets(ArmSim *s)
+{
+    uint32 n = s->r[1];
+    char *buf = (char *)ptr(s, s->r[0], n);
+    ret(s, fgets(buf, (int)n, host_stream(s, s->r[2])) ? s->r[0] : 0);
+}
+
+/* The getc and putc macros call these when the buffer count runs out.
+ * Simulated streams are unbuffered, so the counts stay at zero.
+ */
+static void rt_flsbuf(ArmSim *s)
+{
+    sim_wr32(s, s->r[1] + FILE_OCNT, 0);
+    ret(s, (uint32)fputc((int)(s->r[0] & 0xff), host_stream(s, s->r[1])));
+}
+
+static void rt_filbuf(ArmSim *s)
+{
+    sim_wr32(s, s->r[0] + 4, 0);
+    ret(s, (uint32)fgetc(host_stream(s, s->r[0])));
+}
+
+/* sscanf: each conversion is done by the host sscanf on what is left of
+ * the input, and the result stored into simulated memory.
+ */
+static void rt_sscanf(ArmSim *s)
+{
+    const char *in = str(s, s->r[0]), *fmt = str(s, s->r[1]), *p = in;
+    VaArgs va = { s, 2, 0 };
+    int assigned = 0;
+
+    while (*fmt) {
+        char spec[64];
+        size_t k = 0;
+        int used = 0, lng = 0;
+        bool suppress = false;
+
+        if (isspace((unsigned char)*fmt)) {
+            while (isspace((unsigned char)*p)) p++;
+            fmt++;
+            continue;
+        }
+        if (*fmt != '%' || fmt[1] == '%') {
+            if (*fmt == '%') fmt++;
+            if (*p != *fmt) break;
+            p++, fmt++;
+            continue;
+        }
+        spec[k++] = *fmt++;
+        if (*fmt == '*') suppress = true, spec[k++] = *fmt++;
+        while (isdigit((unsigned char)*fmt) && k < 40) spec[k++] = *fmt++;
+        while (*fmt == 'l' || *fmt == 'h' || *fmt == 'L') {
+            lng += *fmt == 'l' ? 1 : *fmt == 'L' ? 2 : 0;
+            fmt++;
+        }
+        if (*fmt == '[') {
+            while (*fmt && *fmt != ']' && k < 60) spec[k++] = *fmt++;
+            if (*fmt == ']' && k == 2) spec[k++] = *fmt++;
+            while (*fmt && *fmt != ']' && k < 60) spec[k++] = *fmt++;
+            if (*fmt != ']') break;
+        }
+        if (*fmt == 'n') {
+            if (!suppress) sim_wr32(s, va_word(&va), (uint32)(p - in));
+            fmt++;
+            continue;
+        }
+        if (*p == 0 && *fmt != 'c') {
+            if (assigned == 0) assigned = -1;
+            break;
+        }
+        switch (*fmt) {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': {
+            long long v;
+            strcpy(spec + k, *fmt == 'd' || *fmt == 'i' ? "lli%n" : "llx%n");
+            if (*fmt == 'd') spec[k + 2] = 'd';
+            if (*fmt == 'u') spec[k + 2] = 'u';
+            if (*fmt == 'o') spec[k + 2] = 'o';
+            if (suppress ? sscanf(p, spec, &used) < 0 || used == 0
+                         : sscanf(p, spec, &v, &used) != 1)
+                goto done;
+            if (!suppress) {
+                uint32 a = va_word(&va);
+                sim_wr32(s, a, (uint32)v);
+                if (lng >= 2) sim_wr32(s, a + 4, (uint32)((uint64_t)v >> 32));
+                assigned++;
+            }
+            break;
+        }
+        case 'e': case 'f': case 'g': case 'E': case 'G': {
+            double d;
+            strcpy(spec + k, "lf%n");
+            if (suppress ? sscanf(p, spec, &used) < 0 || used == 0
+                         : sscanf(p, spec, &d, &used) != 1)
+                goto done;
+            if (!suppress) {
+                uint32 a = va_word(&va);
+                if (lng) wr_double(s, a, d);
+                else sim_wr32(s, a, f_to_bits((float)d));
+                assigned++;
+            }
+            break;
+        }
+        case 's': case 'c': case ']': {
+            char buf[4096];
+            spec[k++] = *fmt, spec[k] = 0;
+            strcat(spec, "%n");
+            if (suppress ? sscanf(p, spec, &used) < 0 || used == 0
+                         : sscanf(p, spec, buf, &used) != 1)
+                goto done;
+            if (!suppress) {
+                uint32 a = va_word(&va), n = *fmt == 'c' ? (uint32)used : (uint32)strlen(buf) + 1;
+                memcpy(ptr(s, a, n), buf, n);
+                assigned++;
+            }
+            break;
+        }
+        default:
+            goto done;
+        }
+        p += used;
+        fmt++;
+    }
+done:
+    ret(s, (uint32)assigned);
+}
+
+/* signal.h ------------------------------------------------------------- */
+
+static void rt_sig_dfl(ArmSim *s) { sim_fatal(s, "signal %lu", (unsigned long)s->r[0]); }
+static void rt_sig_ign(ArmSim *s) { (void)s; }
+
+static bool sig_ignored(uint32 h)
+{
+    return h == sim_rt_lookup("__SIG_IGN");
+}
+
+static bool sig_default(uint32 h)
+{
+    return h == 0 || h == sim_rt_lookup("__SIG_DFL");
+}
+
+/* A signal raised by the runtime on behalf of the caller (a floating
+ * point trap or division by zero): enter the handler as though the
+ * caller had called it, and abandon the runtime function. A handler
+ * that returns goes back to the caller with the result undefined.
+ */
+static void deliver_signal(ArmSim *s, int sig, const char *what)
+{
+    uint32 h = sig_handler[sig];
+    if (sig_ignored(h))
+        return;
+    if (sig_default(h))
+        sim_fatal(s, "%s", what);
+    sig_handler[sig] = 0;
+    s->r[0] = (uint32)sig;
+    s->r[14] = s->pc | s->thumb;
+    s->pc = h & ~1u;
+    s->thumb = h & 1;
+    longjmp(rt_abandon, 1);
+}
+
+static void rt_signal(ArmSim *s)
+{
+    uint32 sig = s->r[0], old;
+    if (sig == 0 || sig >= NSIG) {
+        ret(s, sim_rt_lookup("__SIG_ERR"));
+        return;
+    }
+    old = sig_handler[sig];
+    sig_handler[sig] = s->r[1];
+    ret(s, old ? old : sim_rt_lookup("__SIG_DFL"));
+}
+
+static void rt_raise(ArmSim *s)
+{
+    uint32 sig = s->r[0], h;
+    if (sig == 0 || sig >= NSIG) {
+        ret(s, 1);
+        return;
+    }
+    h = sig_handler[sig];
+    if (!sig_ignored(h)) {
+        if (sig_default(h))
+            sim_fatal(s, "signal %lu raised", (unsigned long)sig);
+        sig_handler[sig] = 0;
+        sim_call(s, h, sig, 0);
+    }
+    ret(s, 0);
+}
+
+/* time.h --------------------------------------------------------------- */
+
+/* clock() runs at 100Hz of simulated time, taking a cycle as 1/10us. */
+static void rt_clock(ArmSim *s) { ret(s, (uint32)(s->st.cycles / 100000)); }
+static void rt_time(ArmSim *s)
+{
+    if (s->r[0]) sim_wr32(s, s->r[0], 0);
+    ret(s, 0);
+}
+
+/* C++ support: operator new and delete, and the initialise and finalise
+ * hooks, which have nothing to do because armsim runs the C$$ctorvec
+ * and C$$dtorvec entries itself. Vector new and delete are not provided.
+ */
+
+static void rt_pvfn(ArmSim *s)
+{
+    fflush(stdout);
+    sim_fatal(s, "pure virtual function called");
+}
+
+static void rt_cpp_hook(ArmSim *s) { (void)s; }
+
+/* Thumb support: v4T has no BLX, so Thumb code calls through a pointer
+ * in rN with BL __call_via_rN, which is just BX rN.
+ */
+
+static void call_via(ArmSim *s, int n)
+{
+    s->pc = s->r[n] & ~1u;
+    s->thumb = s->r[n] & 1;
+}
+
+#define CALL_VIA(n) static void rt_call_via_r##n(ArmSim *s) { call_via(s, n); }
+CALL_VIA(0) CALL_VIA(1) CALL_VIA(2) CALL_VIA(3)
+CALL_VIA(4) CALL_VIA(5) CALL_VIA(6) CALL_VIA(7)
+
+/* Test harness --------------------------------------------------------- */
+
+static void test_fail(ArmSim *s, const char *what)
+{
+    char sym[256];
+    printf("FAILED: %s at %s\n", what,
+           sim_symbolise(s->pc - 4, sym));
+    test_failures++;
+    test_failed = true;
+}
+
+static void rt_begintest(ArmSim *s)
+{
+    (void)s;
+    test_failures = test_total = 0;
+}
+
+static void rt_endtest(ArmSim *s)
+{
+    (void)s;
+    if (test_failures)
+        printf("FAILED: %d of %d tests\n", test_failures, test_total);
+    else
+        printf("OK\n");
+    fflush(stdout);
+}
+
+/* testutili.h: the harness's internals, used by tests that check
+ * several things at once.
+ */
+static void rt_test_fail(ArmSim *s)
+{
+    (void)s;
+    test_failures++;
+    test_failed = true;
+}
+
+static void rt_test_execute(ArmSim *s) { (void)s; test_total++; }
+static void rt_test_isverbose(ArmSim *s) { ret(s, 0); }
+static void rt_test_name(ArmSim *s) { ret(s, argv0); }
+
+static void rt_eqi(ArmSim *s)
+{
+    char buf[80];
+    test_total++;
+    if (s->r[0] != s->r[1]) {
+        sprintf(buf, "EQI(%ld, %ld)", (long)(int32)s->r[0], (long)(int32)s->r[1]);
+        test_fail(s, buf);
+    }
+}
+
+static void rt_equ(ArmSim *s)
+{
+    char buf[80];
+    test_total++;
+    if (s->r[0] != s->r[1]) {
+        sprintf(buf, "EQU(%lu, %lu)", (unsigned long)s->r[0], (unsigned long)s->r[1]);
+        test_fail(s, buf);
+    }
+}
+
+static void rt_eqp(ArmSim *s)
+{
+    char buf[80];
+    test_total++;
+    if (s->r[0] != s->r[1]) {
+        sprintf(buf, "EQP(0x%08lx, 0x%08lx)", (unsigned long)s->r[0], (unsigned long)s->r[1]);
+        test_fail(s, buf);
+    }
+}
+
+static void rt_eqd(ArmSim *s)
+{
+    char buf[128];
+    double a = darg(s, 0), b = darg(s, 2);
+    test_total++;
+    if (!(a == b)) {
+        sprintf(buf, "EQD(%.17g, %.17g)", a, b);
+        test_fail(s, buf);
+    }
+}
+
+static void rt_eqll(ArmSim *s)
+{
+    char buf[128];
+    uint64_t a = llarg(s, 0), b = llarg(s, 2);
+    test_total++;
+    if (a != b) {
+        sprintf(buf, "EQLL(%lld, %lld)", (long long)a, (long long)b);
+        test_fail(s, buf);
+    }
+}
+
+static void rt_equu(ArmSim *s)
+{
+    char buf[128];
+    uint64_t a = llarg(s, 0), b = llarg(s, 2);
+    test_total++;
+    if (a != b) {
+        sprintf(buf, "EQUU(%llu, %llu)", (unsigned long long)a, (unsigned long long)b);
+        test_fail(s, buf);
+    }
+}
+
+static void rt_eqs(ArmSim *s)
+{
+    char buf[160];
+    const char *a = str(s, s->r[0]), *b = str(s, s->r[1]);
+    test_total++;
+    if (strcmp(a, b) != 0) {
+        sprintf(buf, "EQS(\"%.60s\", \"%.60s\")", a, b);
+        test_fail(s, buf);
+    }
+}
+
+/* The table ------------------------------------------------------------ */
+
+static void rt_return(ArmSim *s)
+{
+    sim_fatal(s, "return to a host call with none active");
+}
+
+/* The first two entries are fixed: see SIM_RT_RETURN and SIM_RT_EXIT. */
+static const RtEntry rt_table[] = {
+    { "$return",                    rt_return,       0 },
+    { "$exit",                      rt_exit,         0 },
+
+    { "__rt_sdiv",                  rt_sdiv,        45 },
+    { "__rt_udiv",                  rt_udiv,        40 },
+    { "__rt_sdiv10",                rt_sdiv10,      12 },
+    { "__rt_udiv10",                rt_udiv10,      10 },
+    { "__rt_divtest",               rt_divtest,      4 },
+    { "__rt_stkovf_split_small",    rt_stkovf,       0 },
+    { "__rt_stkovf_split_big",      rt_stkovf,       0 },
+    { "__rt_rd1chk",                rt_memcheck,     6 },
+    { "__rt_rd2chk",                rt_memcheck,     6 },
+    { "__rt_rd4chk",                rt_memcheck,     6 },
+    { "__rt_wr1chk",                rt_memcheck,     6 },
+    { "__rt_wr2chk",                rt_memcheck,     6 },
+    { "__rt_wr4chk",                rt_memcheck,     6 },
+    /* Older names, used by the RISC OS family. */
+    { "x$divide",                   rt_sdiv,        45 },
+    { "x$udivide",                  rt_udiv,        40 },
+    { "x$remainder",                rt_srem,        45 },
+    { "x$uremainder",               rt_urem,        40 },
+    { "x$multiply",                 rt_mul,          8 },
+    { "x$divtest",                  rt_divtest,      4 },
+    { "_kernel_sdiv10",             rt_sdiv10,      12 },
+    { "_kernel_udiv10",             rt_udiv10,      10 },
+    { "_kernel_srem10",             rt_srem10,      12 },
+    { "_kernel_urem10",             rt_urem10,      10 },
+    { "_kernel_stkovf_split_0frame", rt_stkovf,      0 },
+    { "_kernel_stkovf_split",       rt_stkovf,       0 },
+
+    { "_dadd",                      rt_dadd,        60 },
+    { "_dsub",                      rt_dsub,        60 },
+    { "_drsb",                      rt_drsb,        60 },
+    { "_dmul",                      rt_dmul,        70 },
+    { "_ddiv",                      rt_ddiv,       200 },
+    { "_drdiv",                     rt_drdiv,      200 },
+    { "_dneg",                      rt_dneg,         4 },
+    { "_dfix",                      rt_dfix,        25 },
+    { "_dfixu",                     rt_dfixu,       25 },
+    { "_dflt",                      rt_dflt,        25 },
+    { "_dfltu",                     rt_dfltu,       25 },
+    { "_deq",                       rt_deq,         20 },
+    { "_dneq",                      rt_dneq,        20 },
+    { "_dgr",                       rt_dgr,         20 },
+    { "_dgeq",                      rt_dgeq,        20 },
+    { "_dls",                       rt_dls,         20 },
+    { "_dleq",                      rt_dleq,        20 },
+    { "_dcmpeq",                    rt_dcmpeq,      16 },
+    { "_dcmpge",                    rt_dcmpge,      16 },
+    { "_dcmple",                    rt_dcmple,      16 },
+    { "_d2f",                       rt_d2f,         25 },
+    { "_fadd",                      rt_fadd,        45 },
+    { "_fsub",                      rt_fsub,        45 },
+    { "_frsb",                      rt_frsb,        45 },
+    { "_fmul",                      rt_fmul,        45 },
+    { "_fdiv",                      rt_fdiv,       120 },
+    { "_frdiv",                     rt_frdiv,      120 },
+    { "_fneg",                      rt_fneg,         4 },
+    { "_ffix",                      rt_ffix,        20 },
+    { "_ffixu",                     rt_ffixu,       20 },
+    { "_fflt",                      rt_fflt,        20 },
+    { "_ffltu",                     rt_ffltu,       20 },
+    { "_feq",                       rt_feq,         16 },
+    { "_fneq",                      rt_fneq,        16 },
+    { "_fgr",                       rt_fgr,         16 },
+    { "_fgeq",                      rt_fgeq,        16 },
+    { "_fls",                       rt_fls,         16 },
+    { "_fleq",                      rt_fleq,        16 },
+    { "_fcmpeq",                    rt_fcmpeq,      12 },
+    { "_fcmpge",                    rt_fcmpge,      12 },
+    { "_fcmple",                    rt_fcmple,      12 },
+    { "_f2d",                       rt_f2d,         20 },
+    { "__fp_status",                rt_fp_status,   10 },
+
+    { "_ll_add",                    rt_ll_add,       6 },
+    { "_ll_sub",                    rt_ll_sub,       6 },
+    { "_ll_rsb",                    rt_ll_rsb,       6 },
+    { "_ll_mul",                    rt_ll_mul,      20 },
+    { "_ll_udiv",                   rt_ll_udiv,    250 },
+    { "_ll_urdv",                   rt_ll_urdv,    250 },
+    { "_ll_urem",                   rt_ll_urem,    250 },
+    { "_ll_urrem",                  rt_ll_urrem,   250 },
+    { "_ll_sdiv",                   rt_ll_sdiv,    260 },
+    { "_ll_srdv",                   rt_ll_srdv,    260 },
+    { "_ll_srem",                   rt_ll_srem,    260 },
+    { "_ll_srrem",                  rt_ll_srrem,   260 },
+    { "_ll_and",                    rt_ll_and,       6 },
+    { "_ll_or",                     rt_ll_or,        6 },
+    { "_ll_eor",                    rt_ll_eor,       6 },
+    { "_ll_not",                    rt_ll_not,       5 },
+    { "_ll_neg",                    rt_ll_neg,       5 },
+    { "_ll_shift_l",                rt_ll_shift_l,  10 },
+    { "_ll_ushift_r",               rt_ll_ushift_r, 10 },
+    { "_ll_sshift_r",               rt_ll_sshift_r, 10 },
+    { "_ll_cmpeq",                  rt_ll_cmpeq,     8 },
+    { "_ll_cmpne",                  rt_ll_cmpne,     8 },
+    { "_ll_ucmpgt",                 rt_ll_ucmpgt,    8 },
+    { "_ll_ucmpge",                 rt_ll_ucmpge,    8 },
+    { "_ll_ucmplt",                 rt_ll_ucmplt,    8 },
+    { "_ll_ucmple",                 rt_ll_ucmple,    8 },
+    { "_ll_scmpgt",                 rt_ll_scmpgt,    8 },
+    { "_ll_scmpge",                 rt_ll_scmpge,    8 },
+    { "_ll_scmplt",                 rt_ll_scmplt,    8 },
+    { "_ll_scmple",                 rt_ll_scmple,    8 },
+    { "_ll_from_l",                 rt_ll_from_l,    4 },
+    { "_ll_from_u",                 rt_ll_from_u,    4 },
+    { "_ll_to_l",                   rt_ll_to_l,      3 },
+    { "_ll_sto_d",                  rt_ll_sto_d,    30 },
+    { "_ll_uto_d",                  rt_ll_uto_d,    30 },
+    { "_ll_sto_f",                  rt_ll_sto_f,    30 },
+    { "_ll_uto_f",                  rt_ll_uto_f,    30 },
+    { "_ll_sfrom_d",                rt_ll_sfrom_d,  30 },
+    { "_ll_sfrom_f",                rt_ll_sfrom_f,  30 },
+    { "_ll_ufrom_d",                rt_ll_ufrom_d,  30 },
+    { "_ll_ufrom_f",                rt_ll_ufrom_f,  30 },
+
+    { "_memcpy",                    rt_memcpy,      10 },
+    { "_memset",                    rt_memset,      10 },
+    { "memcpy",                     rt_memcpy,      12 },
+    { "memmove",                    rt_memcpy,      12 },
+    { "memset",                     rt_memset,      12 },
+    { "memcmp",                     rt_memcmp,      12 },
+    { "memchr",                     rt_memchr,      12 },
+    { "strlen",                     rt_strlen,      10 },
+    { "strcpy",                     rt_strcpy,      10 },
+    { "strncpy",                    rt_strncpy,     10 },
+    { "strcat",                     rt_strcat,      10 },
+    { "strncat",                    rt_strncat,     10 },
+    { "strcmp",                     rt_strcmp,      10 },
+    { "strncmp",                    rt_strncmp,     10 },
+    { "strchr",                     rt_strchr,      10 },
+    { "strrchr",                    rt_strrchr,     10 },
+    { "strstr",                     rt_strstr,      20 },
+    { "toupper",                    rt_toupper,      4 },
+    { "tolower",                    rt_tolower,      4 },
+    { "isblank",                    rt_isblank,      4 },
+
+    { "malloc",                     rt_malloc,      40 },
+    { "calloc",                     rt_calloc,      50 },
+    { "realloc",                    rt_realloc,     60 },
+    { "free",                       rt_free,        30 },
+    { "exit",                       rt_exit,         0 },
+    { "abort",                      rt_abort,        0 },
+    { "__nw__FUi",                  rt_malloc,      40 },
+    { "__dl__FPv",                  rt_free,        30 },
+    { "__pvfn__Fv",                 rt_pvfn,         0 },
+    { "__cpp_initialise",           rt_cpp_hook,     0 },
+    { "__cpp_finalise",             rt_cpp_hook,     0 },
+    { "__call_via_r0",              rt_call_via_r0,  3 },
+    { "__call_via_r1",              rt_call_via_r1,  3 },
+    { "__call_via_r2",              rt_call_via_r2,  3 },
+    { "__call_via_r3",              rt_call_via_r3,  3 },
+    { "__call_via_r4",              rt_call_via_r4,  3 },
+    { "__call_via_r5",              rt_call_via_r5,  3 },
+    { "__call_via_r6",              rt_call_via_r6,  3 },
+    { "__call_via_r7",              rt_call_via_r7,  3 },
+    { "abs",                        rt_abs,          4 },
+    { "labs",                       rt_abs,          4 },
+    { "atoi",                       rt_atoi,        30 },
+    { "atol",                       rt_atoi,        30 },
+    { "strtol",                     rt_strtol,      40 },
+    { "strtoul",                    rt_strtoul,     40 },
+    { "strtod",                     rt_strtod,     200 },
+    { "atof",                       rt_atof,       200 },
+    { "rand",                       rt_rand,        10 },
+    { "srand",                      rt_srand,        4 },
+    { "getenv",                     rt_getenv,      20 },
+    { "qsort",                      rt_qsort,       20 },
+    { "setjmp",                     rt_setjmp,      15 },
+    { "longjmp",                    rt_longjmp,     15 },
+
+    { "sqrt",                       rt_sqrt,       150 },
+    { "sin",                        rt_sin,        300 },
+    { "cos",                        rt_cos,        300 },
+    { "tan",                        rt_tan,        350 },
+    { "asin",                       rt_asin,       350 },
+    { "acos",                       rt_acos,       350 },
+    { "atan",                       rt_atan,       300 },
+    { "atan2",                      rt_atan2,      350 },
+    { "sinh",                       rt_sinh,       350 },
+    { "cosh",                       rt_cosh,       350 },
+    { "tanh",                       rt_tanh,       350 },
+    { "exp",                        rt_exp,        300 },
+    { "log",                        rt_log,        300 },
+    { "log10",                      rt_log10,      300 },
+    { "pow",                        rt_pow,        600 },
+    { "floor",                      rt_floor,       30 },
+    { "ceil",                       rt_ceil,        30 },
+    { "fabs",                       rt_fabs,         6 },
+    { "fmod",                       rt_fmod,       100 },
+    { "ldexp",                      rt_ldexp,       20 },
+    { "frexp",                      rt_frexp,       20 },
+    { "modf",                       rt_modf,        40 },
+
+    { "printf",                     rt_printf,     200 },
+    { "fprintf",                    rt_fprintf,    200 },
+    { "sprintf",                    rt_sprintf,    200 },
+    { "snprintf",                   rt_snprintf,   200 },
+    { "vprintf",                    rt_vprintf,    200 },
+    { "vfprintf",                   rt_vfprintf,   200 },
+    { "vsprintf",                   rt_vsprintf,   200 },
+    { "vsnprintf",                  rt_vsnprintf,  200 },
+    { "_printf",                    rt_printf,     150 },
+    { "_fprintf",                   rt_fprintf,    150 },
+    { "_sprintf",                   rt_sprintf,    150 },
+    { "_printf$Z",                  rt_printf,     150 },
+    { "_fprintf$Z",                 rt_fprintf,    150 },
+    { "_sprintf$Z",                 rt_sprintf,    150 },
+    { "putchar",                    rt_putchar,     20 },
+    { "putc",                       rt_fputc,       20 },
+    { "fputc",                      rt_fputc,       20 },
+    { "puts",                       rt_puts,        40 },
+    { "fputs",                      rt_fputs,       40 },
+    { "getchar",                    rt_getchar,     20 },
+    { "getc",                       rt_fgetc,       20 },
+    { "fgetc",                      rt_fgetc,       20 },
+    { "fgets",                      rt_fgets,       40 },
+    { "fflush",                     rt_fflush,      20 },
+    { "fwrite",                     rt_fwrite,      40 },
+    { "__flsbuf",                   rt_flsbuf,      20 },
+    { "__filbuf",                   rt_filbuf,      20 },
+    { "sscanf",                     rt_sscanf,     200 },
+    { "signal",                     rt_signal,      20 },
+    { "raise",                      rt_raise,       20 },
+    { "__SIG_DFL",                  rt_sig_dfl,      0 },
+    { "__SIG_IGN",                  rt_sig_ign,      0 },
+    { "__SIG_ERR",                  rt_sig_dfl,      0 },
+    { "clock",                      rt_clock,       10 },
+    { "time",                       rt_time,        10 },
+
+    { "BeginTest",                  rt_begintest,    0 },
+    { "EndTest",                    rt_endtest,      0 },
+    { "EQI",                        rt_eqi,          0 },
+    { "EQU",                        rt_equ,          0 },
+    { "EQP",                        rt_eqp,          0 },
+    { "EQD",                        rt_eqd,          0 },
+    { "EQS",                        rt_eqs,          0 },
+    { "EQLL",                       rt_eqll,         0 },
+    { "EQUU",                       rt_equu,         0 },
+    { "test_fail",                  rt_test_fail,    0 },
+    { "test_execute",               rt_test_execute, 0 },
+    { "test_isverbose",             rt_test_isverbose, 0 },
+    { "test_name",                  rt_test_name,    0 },
+    { NULL }
+};
+
+uint32 sim_rt_lookup(const char *name)
+{
+    const RtEntry *e;
+    if (strcmp(name, "__iob") == 0) return iob;
+    if (strcmp(name, "__errno") == 0) return errno_cell;
+    if (strcmp(name, "__huge_val") == 0) return huge_val;
+    if (strcmp(name, "__ctype") == 0) return ctype_tab;
+    /* Thumb code calls the support routines by their "__16" names. */
+    if (strncmp(name, "__16", 4) == 0) return sim_rt_lookup(name + 4);
+    for (e = rt_table; e->name != NULL; e++)
+        if (strcmp(e->name, name) == 0)
+            return SIM_RT_BASE + 4 * (uint32)(e - rt_table);
+    return 0;
+}
+
+/* Lay out the runtime's data at base and return the end of it. */
+uint32 sim_rt_init(ArmSim *s, uint32 base)
+{
+    uint32 c;
+
+    base = (base + 7) & ~7u;
+    iob = base;
+    base += 3 * FILE_SIZE;
+    errno_cell = base;              /* errno.h: errno is __errno itself */
+    sim_wr32(s, errno_cell, 0);
+    base += 8;
+    huge_val = base;
+    wr_double(s, huge_val, DBL_MAX);
+    base += 8;
+    ctype_tab = base + 1;           /* __ctype[EOF] is a zero byte */
+    for (c = 0; c < 256; c++) {
+        uint32 f = 0;
+        if (c < 128) {
+            if (isspace(c)) f |= 1;
+            if (ispunct(c)) f |= 2;
+            if (c == ' ') f |= 4;
+            if (islower(c)) f |= 8;
+            if (isupper(c)) f |= 16;
+            if (isdigit(c)) f |= 32;
+            if (iscntrl(c)) f |= 64;
+            if (isxdigit(c) && !isdigit(c)) f |= 128;
+        } else
+            f = 64;
+        sim_wr8(s, ctype_tab + c, f);
+    }
+    base += 257;
+    free_list = 0;
+    test_failed = false;
+    memset(sig_handler, 0, sizeof sig_handler);
+    return (base + 7) & ~7u;
+}
+
+/* Copy the arguments for main() onto the top of the stack; returns argv. */
+uint32 sim_rt_argv(ArmSim *s, int argc, char **argv)
+{
+    uint32 sp = s->r[13], vec;
+    int i;
+    for (i = argc - 1; i >= 0; i--) {
+        uint32 n = (uint32)strlen(argv[i]) + 1;
+        sp -= n;
+        memcpy(ptr(s, sp, n), argv[i], n);
+        argv[i] = (char *)(size_t)sp;
+    }
+    sp &= ~7u;
+    sp -= 4 * (uint32)(argc + 1);
+    vec = sp;
+    for (i = 0; i < argc; i++)
+        sim_wr32(s, vec + 4 * (uint32)i, (uint32)(size_t)argv[i]);
+    sim_wr32(s, vec + 4 * (uint32)argc, 0);
+    s->r[13] = sp & ~7u;
+    argv0 = argc > 0 ? (uint32)(size_t)argv[0] : 0;
+    return vec;
+}
+
+bool sim_rt_testfailed(void)
+{
+    return test_failed;
+}
+
+void sim_rt_call(ArmSim *s, uint32 addr)
+{
+    uint32 i = (addr - SIM_RT_BASE) / 4, lr = s->r[14];
+    const RtEntry *e;
+
+    if ((addr & 3) || i >= sizeof rt_table / sizeof rt_table[0] - 1)
+        sim_fatal(s, "branch to unmapped address 0x%08lx", (unsigned long)addr);
+    e = &rt_table[i];
+    s->st.rtcalls++;
+    s->st.cycles += (SimCount)e->cost;
+    s->pc = lr & ~1u;
+    s->thumb = lr & 1;
+    if (setjmp(rt_abandon) == 0)
+        e->fn(s);
+}
@@ -0,0 +1,951 @@
+/* Copyright 2025 Piers Wombwell
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* armsim: link AOF objects against the host runtime and run them.
+ *
+ *   armsim [options] file.o... [-- program arguments]
+ *
+ * The exit status is the program's, or 1 if it returned 0 after a test
+ * harness check failed, or EXIT_fatal if the simulation went wrong.
+ * -stats writes one "name value" line per counter to stderr so that
+ * scripts can compare runs.
+ */
+
+#include "armsim.h"
+#include "aof.h"
+#include "chunkfmt.h"
+#include "disass.h"
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SYM_ABSOLUTE    0x00000004
+#define SYM_COMMON      0x00000040
+
+#define FT_BYTE         0
+#define FT_HALF         1
+#define FT_WORD         2
+#define FT_INSTR        3
+
+typedef struct Obj Obj;
+
+typedef struct Area {
+    Obj *obj;
+    const char *name;
+    uint32 attr, size, nrelocs;
+    const uint8 *data;          /* NULL for zero-initialised areas */
+    const uint8 *relocs;
+    uint32 base;
+    struct Area *canon;         /* the copy kept of a common area */
+} Area;
+
+struct Obj {
+    const char *file;
+    uint8 *image;
+    bool bigend;
+    uint32 nareas, nsyms;
+    Area *areas;
+    const uint8 *symt, *strt;
+    uint32 strtsize;
+};
+
+typedef struct Sym {
+    struct Sym *next;
+    const char *name;
+    uint32 addr;
+    bool thumb;
+    bool defined;
+} Sym;
+
+/* Function and data symbols by address, for symbolising and profiling. */
+typedef struct AddrSym {
+    uint32 addr;
+    const char *name;
+} AddrSym;
+
+static ArmSim sim;
+static Obj *objs;
+static int nobjs;
+static Area **layout;
+static int nlayout;
+static uint32 code_base, code_limit, data_limit;
+
+#define SYM_HASHSIZE 1024
+static Sym *symtab[SYM_HASHSIZE];
+
+static AddrSym *addrsyms;
+static int naddrsyms;
+
+static SimCount *prof_count, *prof_cycles;
+static uint32 prof_lastpc;
+static SimCount prof_lastcycles;
+
+static void fatal(const char *fmt, ...)
+{
+    va_list ap;
+    fprintf(stderr, "armsim: ");
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputc('\n', stderr);
+    exit(EXIT_fatal);
+}
+
+void sim_fatal(ArmSim *s, const char *fmt, ...)
+{
+    char buf[256];
+    va_list ap;
+    fflush(stdout);
+    fprintf(stderr, "armsim: ");
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fprintf(stderr, " at 0x%08lx (%s)\n", (unsigned long)s->pc,
+            sim_symbolise(s->pc, buf));
+    exit(EXIT_fatal);
+}
+
+static void *xalloc(size_t n)
+{
+    void *p = calloc(1, n == 0 ? 1 : n);
+    if (p == NULL) fatal("out of memory");
+    return p;
+}
+
+/* Symbols -------------------------------------------------------------- */
+
+static unsigned sym_hash(const char *name)
+{
+    unsigned h = 0;
+    while (*name) h = h * 31 + (unsigned char)*name++;
+    return h % SYM_HASHSIZE;
+}
+
+static Sym *sym_lookup(const char *name, bool create)
+{
+    Sym **p = &symtab[sym_hash(name)], *sym;
+    for (sym = *p; sym != NULL; sym = sym->next)
+        if (strcmp(sym->name, name) == 0)
+            return sym;
+    if (!create) return NULL;
+    sym = (Sym *)xalloc(sizeof(Sym));
+    sym->name = name;
+    sym->next = *p;
+    *p = sym;
+    return sym;
+}
+
+static int addrsym_cmp(const void *a, const void *b)
+{
+    const AddrSym *x = (const AddrSym *)a, *y = (const AddrSym *)b;
+    return x->addr < y->addr ? -1 : x->addr > y->addr;
+}
+
+static void addrsym_add(uint32 addr, const char *name)
+{
+    static int size;
+    if (naddrsyms == size) {
+        size = size ? 2 * size : 256;
+        addrsyms = (AddrSym *)realloc(addrsyms, size * sizeof(AddrSym));
+        if (addrsyms == NULL) fatal("out of memory");
+    }
+    addrsyms[naddrsyms].addr = addr;
+    addrsyms[naddrsyms].name = name;
+    naddrsyms++;
+}
+
+static int addrsym_find(uint32 addr)
+{
+    int lo = 0, hi = naddrsyms - 1, found = -1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (addrsyms[mid].addr <= addr)
+            found = mid, lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+    return found;
+}
+
+const char *sim_symbolise(uint32 addr, char *buf)
+{
+    int i;
+    if (addr >= SIM_RT_BASE && addr < SIM_RT_LIMIT) {
+        sprintf(buf, "runtime");
+        return buf;
+    }
+    i = addrsym_find(addr);
+    if (i < 0 || addr >= data_limit)
+        sprintf(buf, "0x%08lx", (unsigned long)addr);
+    else if (addr == addrsyms[i].addr)
+        sprintf(buf, "%.200s", addrsyms[i].name);
+    else
+        sprintf(buf, "%.200s+0x%lx", addrsyms[i].name,
+                (unsigned long)(addr - addrsyms[i].addr));
+    return buf;
+}
+
+/* Loading -------------------------------------------------------------- */
+
+static uint32 get32(const Obj *o, const uint8 *p)
+{
+    if (o->bigend)
+        return (uint32)p[0] << 24 | (uint32)p[1] << 16 | (uint32)p[2] << 8 | p[3];
+    return (uint32)p[3] << 24 | (uint32)p[2] << 16 | (uint32)p[1] << 8 | p[0];
+}
+
+static const char *obj_string(const Obj *o, uint32 off)
+{
+    if (off < 4 || off >= o->strtsize)
+        fatal("%s: bad string table offset %lu", o->file, (unsigned long)off);
+    return (const char *)o->strt + off;
+}
+
+static const uint8 *find_chunk(const Obj *o, const uint8 *image, long size,
+                               const char *key, uint32 *len)
+{
+    uint32 n = get32(o, image + 8), i;
+    for (i = 0; i < n; i++) {
+        const uint8 *e = image + 12 + 16 * i;
+        if (memcmp(e, key, 8) == 0) {
+            uint32 off = get32(o, e + 8), sz = get32(o, e + 12);
+            if (off == 0) continue;
+            if (off > (uint32)size || sz > (uint32)size - off)
+                fatal("%s: chunk %.8s is truncated", o->file, key);
+            *len = sz;
+            return image + off;
+        }
+    }
+    return NULL;
+}
+
+static void load_object(Obj *o, const char *file)
+{
+    FILE *f = fopen(file, "rb");
+    const uint8 *head, *area;
+    uint32 headlen, arealen = 0, symtlen = 0, i, pos = 0;
+    long size;
+
+    if (f == NULL) fatal("can't open '%s'", file);
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    o->file = file;
+    o->image = (uint8 *)xalloc((size_t)size);
+    if (size < 12 || fread(o->image, 1, (size_t)size, f) != (size_t)size)
+        fatal("can't read '%s'", file);
+    fclose(f);
+
+    o->bigend = false;
+    if (get32(o, o->image) != CF_MAGIC) {
+        o->bigend = true;
+        if (get32(o, o->image) != CF_MAGIC)
+            fatal("%s: not a chunk file", file);
+    }
+    head = find_chunk(o, o->image, size, "OBJ_HEAD", &headlen);
+    area = find_chunk(o, o->image, size, "OBJ_AREA", &arealen);
+    o->strt = find_chunk(o, o->image, size, "OBJ_STRT", &o->strtsize);
+    o->symt = find_chunk(o, o->image, size, "OBJ_SYMT", &symtlen);
+    if (head == NULL || headlen < 24 || get32(o, head) != AOF_RELOC)
+        fatal("%s: not an AOF object", file);
+    if (o->strt == NULL) o->strtsize = 0;
+    o->nareas = get32(o, head + 8);
+    o->nsyms = o->symt == NULL ? 0 : get32(o, head + 12);
+    if (headlen < 24 + 20 * o->nareas || symtlen < 16 * o->nsyms)
+        fatal("%s: header is truncated", file);
+    o->areas = (Area *)xalloc(o->nareas * sizeof(Area));
+    for (i = 0; i < o->nareas; i++) {
+        const uint8 *h = head + 24 + 20 * i;
+        Area *a = &o->areas[i];
+        a->obj = o;
+        a->name = obj_string(o, get32(o, h));
+        a->attr = get32(o, h + 4);
+        a->size = get32(o, h + 8);
+        a->nrelocs = get32(o, h + 12);
+        a->canon = a;
+        if (!(a->attr & AOF_0INITAT)) {
+            if (area == NULL || pos + a->size + 8 * a->nrelocs > arealen)
+                fatal("%s: area %s is truncated", file, a->name);
+            a->data = area + pos;
+            a->relocs = area + pos + a->size;
+            pos += a->size + 8 * a->nrelocs;
+        }
+    }
+}
+
+/* Linking -------------------------------------------------------------- */
+
+static Area *find_area(Obj *o, const char *name)
+{
+    uint32 i;
+    for (i = 0; i < o->nareas; i++)
+        if (strcmp(o->areas[i].name, name) == 0)
+            return &o->areas[i];
+    return NULL;
+}
+
+/* Common blocks (COMDEF, COMREF and common symbols) are merged by name:
+ * the first definition is kept, with the largest size asked for.
+ */
+static Area *common_block(Area *a)
+{
+    int i;
+    uint32 j;
+    for (i = 0; i < nobjs; i++)
+        for (j = 0; j < objs[i].nareas; j++) {
+            Area *b = &objs[i].areas[j];
+            if (b == a) return a;
+            if (b->canon == b && (b->attr & (AOF_COMDEFAT | AOF_COMREFAT)) &&
+                strcmp(b->name, a->name) == 0) {
+                if (a->size > b->size) {
+                    if (b->data != NULL && (b->attr & aof_COMDEFAT))
+                        fatal("common area %s is larger in %s", a->name, a->obj->file);
+                    b->size = a->size;
+                }
+                if (b->data == NULL && a->data != NULL) {
+                    b->data = a->data, b->relocs = a->relocs;
+                    b->nrelocs = a->nrelocs, b->attr = a->attr;
+                    b->obj = a->obj;
+                    a->canon = b;
+                    a->data = NULL, a->nrelocs = 0;
+                    return b;
+                }
+                return b;
+            }
+        }
+    return a;
+}
+
+static int area_class(const Area *a)
+{
+    if (a->attr & AOF_DEBUGAT) return -1;
+    if (a->attr & AOF_CODEAT) return 0;
+    if (a->attr & AOF_0INITAT) return 3;
+    if (a->attr & AOF_RONLYAT) return 1;
+    return 2;
+}
+
+static void add_common_symbols(void)
+{
+    int i;
+    uint32 j;
+    for (i = 0; i < nobjs; i++) {
+        Obj *o = &objs[i];
+        for (j = 0; j < o->nsyms; j++) {
+            const uint8 *e = o->symt + 16 * j;
+            uint32 at = get32(o, e + 4);
+            if ((at & 3) == SYM_REFAT && (at & SYM_COMMON)) {
+                /* A common symbol becomes a zero-initialised COMREF area. */
+                Area *a = (Area *)xalloc(sizeof(Area));
+                a->obj = o;
+                a->name = obj_string(o, get32(o, e));
+                a->attr = 2 | AOF_0INITAT | AOF_COMREFAT;
+                a->size = get32(o, e + 8);
+                a->canon = a;
+                layout = (Area **)realloc(layout, (nlayout + 1) * sizeof(Area *));
+                layout[nlayout++] = a;
+            }
+        }
+    }
+}
+
+static void layout_areas(void)
+{
+    int cls, i, n = nlayout;
+    uint32 j, addr = SIM_IMAGE_BASE;
+    Area **commons = layout;
+
+    layout = NULL;
+    nlayout = 0;
+    for (cls = 0; cls < 4; cls++) {
+        for (i = 0; i < nobjs + n; i++) {
+            int k, count = i < nobjs ? (int)objs[i].nareas : 1;
+            for (k = 0; k < count; k++) {
+                Area *a = i < nobjs ? &objs[i].areas[k] : commons[i - nobjs];
+                uint32 align;
+                if (a->attr & (AOF_COMDEFAT | AOF_COMREFAT)) {
+                    Area *c = common_block(a);
+                    if (c != a) { a->canon = c; continue; }
+                }
+                if (area_class(a) != cls) continue;
+                align = 1u << ((a->attr & 0xff) < 2 ? 2 : (a->attr & 0xff));
+                addr = (addr + align - 1) & ~(align - 1);
+                a->base = addr;
+                addr += a->size;
+                layout = (Area **)realloc(layout, (nlayout + 1) * sizeof(Area *));
+                layout[nlayout++] = a;
+            }
+        }
+        if (cls == 0) code_limit = addr;
+    }
+    code_base = SIM_IMAGE_BASE;
+    data_limit = addr;
+    for (j = 0; (int)j < n; j++)
+        if (commons[j]->canon != commons[j])
+            commons[j]->base = commons[j]->canon->base;
+    free(commons);
+    for (i = 0; i < nobjs; i++)
+        for (j = 0; j < objs[i].nareas; j++) {
+            Area *a = &objs[i].areas[j];
+            if (a->canon != a) a->base = a->canon->base;
+        }
+}
+
+static void define_symbols(void)
+{
+    int i;
+    uint32 j;
+
+    for (i = 0; i < nobjs; i++) {
+        Obj *o = &objs[i];
+        for (j = 0; j < o->nsyms; j++) {
+            const uint8 *e = o->symt + 16 * j;
+            const char *name = obj_string(o, get32(o, e));
+            uint32 at = get32(o, e + 4), value = get32(o, e + 8);
+            Area *a = NULL;
+            Sym *sym;
+
+            if (!(at & 1)) continue;
+            if (!(at & SYM_ABSOLUTE)) {
+                a = find_area(o, obj_string(o, get32(o, e + 12)));
+                if (a == NULL)
+                    fatal("%s: symbol %s is in an unknown area", o->file, name);
+                if (a->attr & AOF_DEBUGAT) continue;
+                value += a->canon->base;
+            }
+            if (a != NULL && (a->attr & AOF_CODEAT))
+                addrsym_add(value, name);
+            if ((at & 3) != SYM_GLOBALDEFAT) continue;
+            sym = sym_lookup(name, true);
+            if (sym->defined) {
+                if (a != NULL && (a->attr & AOF_COMDEFAT)) continue;
+                fatal("%s: symbol %s is defined more than once", o->file, name);
+            }
+            sym->defined = true;
+            sym->addr = value;
+            sym->thumb = a != NULL && (a->attr & AOF_CODEAT) &&
+                         !(at & SYM_DATAAT) &&
+                         ((at & SYM_THUMB) || (a->attr & AOF_THUMB));
+        }
+    }
+    for (i = 0; i < nlayout; i++) {
+        Area *a = layout[i];
+        if (area_class(a) == 0)
+            addrsym_add(a->base, a->name);
+        else if (a->attr & AOF_COMREFAT) {
+            Sym *sym = sym_lookup(a->name, true);
+            if (!sym->defined) {
+                sym->defined = true;
+                sym->addr = a->base;
+            }
+        }
+    }
+    addrsym_add(SIM_IMAGE_BASE, "image$base");
+}
+
+static void load_areas(ArmSim *s)
+{
+    int i;
+    for (i = 0; i < nlayout; i++) {
+        Area *a = layout[i];
+        if (a->base + a->size > s->memsize)
+            fatal("image does not fit in memory (use -mem)");
+        if (a->data != NULL)
+            memcpy(s->mem + a->base, a->data, a->size);
+    }
+}
+
+/* Interworking veneers for calls that change state on a v4T core: ARM to
+ * Thumb is LDR ip, [pc]; BX ip; DCD target+1, Thumb to ARM is BX pc; NOP
+ * then LDR pc, [pc, #-4]; DCD target.
+ */
+static uint32 veneer_next;
+
+static uint32 make_veneer(ArmSim *s, uint32 target, bool to_thumb)
+{
+    uint32 v = veneer_next;
+    if (v + 12 > s->memsize) fatal("no room for interworking veneers");
+    if (to_thumb) {
+        sim_wr32(s, v, 0xe59fc000);
+        sim_wr32(s, v + 4, 0xe12fff1c);
+        sim_wr32(s, v + 8, target | 1);
+    } else {
+        sim_wr16(s, v, 0x4778);
+        sim_wr16(s, v + 2, 0x46c0);
+        sim_wr32(s, v + 4, 0xe51ff004);
+        sim_wr32(s, v + 8, target);
+    }
+    veneer_next += 12;
+    return v;
+}
+
+/* Split |v| into at most n ARM rotated 8-bit immediates. */
+static bool split_immediates(uint32 v, int n, uint32 *imm)
+{
+    int i;
+    for (i = 0; i < n; i++) {
+        int lo = 0, rot;
+        if (v == 0) { imm[i] = 0; continue; }
+        while (!(v & (3u << lo))) lo += 2;
+        rot = (32 - lo) & 31;
+        imm[i] = (uint32)(rot / 2) << 8 | ((v >> lo) & 0xff);
+        v &= ~(0xffu << lo);
+    }
+    return v == 0;
+}
+
+static uint32 imm_value(uint32 instr)
+{
+    uint32 rot = ((instr >> 8) & 15) * 2, v = instr & 0xff;
+    return rot ? v >> rot | v << (32 - rot) : v;
+}
+
+static void reloc_arm(ArmSim *s, Area *a, uint32 at, int ninstr, uint32 delta,
+                      Sym *sym, bool pcrel)
+{
+    uint32 instr = sim_rd32(s, at);
+
+    if ((instr & 0x0e000000) == 0x0a000000) {           /* B, BL */
+        int32 off = (int32)(instr << 8) >> 6;
+        uint32 target = at + 8 + off + delta;
+        if (sym != NULL && sym->thumb && pcrel) {
+            if (sim.core->arch >= 5 && (instr & 0x01000000) && (instr >> 28) == 14)
+                instr = 0xfa000000 | ((target & 2) << 23);
+            else
+                target = make_veneer(s, target, true);
+        }
+        off = (int32)(target - (at + 8));
+        if (off < -0x2000000 || off >= 0x2000000 || ((off & 3) && (instr >> 28) != 15))
+            fatal("%s: branch to %s out of range", a->obj->file, sym ? sym->name : a->name);
+        sim_wr32(s, at, (instr & 0xff000000) | (((uint32)off >> 2) & 0xffffff));
+    } else if ((instr & 0x0c000000) == 0x04000000) {    /* LDR, STR */
+        int32 off = instr & 0xfff;
+        if (!(instr & 0x00800000)) off = -off;
+        off += (int32)delta;
+        if (off <= -0x1000 || off >= 0x1000)
+            fatal("%s: load/store offset out of range in %s", a->obj->file, a->name);
+        instr &= ~0x00800fffu;
+        sim_wr32(s, at, instr | (off < 0 ? -off : off | 0x00800000));
+    } else if ((instr & 0x0e400090) == 0x00400090) {    /* LDRH etc, immediate */
+        int32 off = (instr >> 4 & 0xf0) | (instr & 15);
+        if (!(instr & 0x00800000)) off = -off;
+        off += (int32)delta;
+        if (off <= -0x100 || off >= 0x100)
+            fatal("%s: load/store offset out of range in %s", a->obj->file, a->name);
+        instr &= ~0x00800f0fu;
+        if (off < 0) off = -off; else instr |= 0x00800000;
+        sim_wr32(s, at, instr | (off & 0xf0) << 4 | (off & 15));
+    } else if ((instr & 0x0de00000) == 0x00800000 ||    /* ADD/SUB sequence */
+               (instr & 0x0de00000) == 0x00400000) {
+        uint32 imm[3], value = 0, i;
+        bool sub = (instr & 0x01e00000) == 0x00400000;
+        if (ninstr == 0) ninstr = 3;
+        for (i = 0; i < (uint32)ninstr; i++)
+            value += imm_value(sim_rd32(s, at + 4 * i));
+        value = (sub ? -value : value) + delta;
+        sub = (int32)value < 0;
+        if (sub) value = -value;
+        if (!split_immediates(value, ninstr, imm))
+            fatal("%s: address constant out of range in %s", a->obj->file, a->name);
+        for (i = 0; i < (uint32)ninstr; i++) {
+            uint32 w = sim_rd32(s, at + 4 * i) & ~0x01e00fffu;
+            sim_wr32(s, at + 4 * i, w | (sub ? 0x00400000 : 0x00800000) | imm[i]);
+        }
+    } else
+        fatal("%s: can't relocate instruction 0x%08lx in %s", a->obj->file,
+              (unsigned long)instr, a->name);
+}
+
+static void reloc_thumb(ArmSim *s, Area *a, uint32 at, uint32 delta, Sym *sym)
+{
+    uint32 instr = sim_rd16(s, at);
+
+    if ((instr & 0xf800) == 0xf000) {                   /* BL pair */
+        uint32 lo = sim_rd16(s, at + 2);
+        int32 off = ((int32)(instr << 21) >> 9) | (lo & 0x7ff) << 1;
+        uint32 target = at + 4 + off + delta;
+        if (sym != NULL && !sym->thumb && sym->addr >= SIM_IMAGE_BASE) {
+            if (sim.core->arch >= 5) {
+                lo = (lo & ~0x1800u) | 0xe800;
+                target = (target & ~3u) | ((at + 4) & 2);
+            } else
+                target = make_veneer(s, target, false);
+        }
+        off = (int32)(target - (at + 4));
+        if (off < -0x400000 || off >= 0x400000)
+            fatal("%s: branch to %s out of range", a->obj->file, sym ? sym->name : a->name);
+        sim_wr16(s, at, 0xf000 | (((uint32)off >> 12) & 0x7ff));
+        sim_wr16(s, at + 2, (lo & 0xf800) | (((uint32)off >> 1) & 0x7ff));
+    } else if ((instr & 0xf800) == 0xe000) {            /* B */
+        int32 off = ((int32)(instr << 21) >> 20) + (int32)delta;
+        if (off < -0x800 || off >= 0x800)
+            fatal("%s: branch out of range in %s", a->obj->file, a->name);
+        sim_wr16(s, at, 0xe000 | (((uint32)off >> 1) & 0x7ff));
+    } else if ((instr & 0xf000) == 0xd000) {            /* Bcc */
+        int32 off = ((int32)(instr << 24) >> 23) + (int32)delta;
+        if (off < -0x100 || off >= 0x100)
+            fatal("%s: branch out of range in %s", a->obj->file, a->name);
+        sim_wr16(s, at, (instr & 0xff00) | (((uint32)off >> 1) & 0xff));
+    } else if ((instr & 0xf800) == 0x4800 || (instr & 0xf800) == 0xa000) {
+        int32 off = (int32)(instr & 0xff) * 4 + (int32)delta;   /* LDR/ADR pc */
+        if (off < 0 || off >= 0x400 || (off & 3))
+            fatal("%s: literal out of range in %s", a->obj->file, a->name);
+        sim_wr16(s, at, (instr & 0xff00) | (uint32)off >> 2);
+    } else
+        fatal("%s: can't relocate Thumb instruction 0x%04lx in %s", a->obj->file,
+              (unsigned long)instr, a->name);
+}
+
+static void relocate(ArmSim *s)
+{
+    int i;
+    for (i = 0; i < nlayout; i++) {
+        Area *a = layout[i];
+        Obj *o = a->obj;
+        uint32 k;
+        if (a->data == NULL) continue;
+        for (k = 0; k < a->nrelocs; k++) {
+            uint32 off = get32(o, a->relocs + 8 * k),
+                   flags = get32(o, a->relocs + 8 * k + 4),
+                   sid = flags & 0xffffff, ft = (flags >> 24) & 3, value, at;
+            bool thumb = off & 1, thumbsym = false;
+            Sym *sym = NULL;
+
+            if (!(flags & REL_TYPE2))
+                fatal("%s: type 1 relocations are not supported", o->file);
+            if ((flags & REL_B) && !(flags & REL_R))
+                fatal("%s: based relocation in %s: compile without "
+                      "-apcs /reentrant", o->file, a->name);
+            if (flags & REL_A) {
+                const uint8 *e;
+                const char *name;
+                if (sid >= o->nsyms) fatal("%s: bad symbol index", o->file);
+                e = o->symt + 16 * sid;
+                name = obj_string(o, get32(o, e));
+                if ((get32(o, e + 4) & 3) == SYM_LOCALDEFAT) {
+                    uint32 at2 = get32(o, e + 4);
+                    value = get32(o, e + 8);
+                    if (!(at2 & SYM_ABSOLUTE)) {
+                        Area *d = find_area(o, obj_string(o, get32(o, e + 12)));
+                        value += d->canon->base;
+                        thumbsym = (d->attr & AOF_CODEAT) &&
+                                   !(at2 & SYM_DATAAT) &&
+                                   ((at2 & SYM_THUMB) || (d->attr & AOF_THUMB));
+                    }
+                } else {
+                    sym = sym_lookup(name, false);
+                    if (sym == NULL || !sym->defined) {
+                        uint32 rt = sim_rt_lookup(name);
+                        if (rt == 0 && !(get32(o, e + 4) & SYM_WEAKAT))
+                            fatal("%s: undefined symbol %s", o->file, name);
+                        sym = sym_lookup(name, true);
+                        sym->addr = rt;
+                        sym->defined = rt != 0;
+                    }
+                    value = sym->addr;
+                    thumbsym = sym->thumb;
+                }
+            } else {
+                if (sid >= o->nareas) fatal("%s: bad area index", o->file);
+                value = o->areas[sid].canon->base;
+            }
+            if (flags & REL_R) value -= a->base;
+            off &= ~1u;
+            if (off >= a->size) fatal("%s: relocation outside %s", o->file, a->name);
+            at = a->base + off;
+            switch (ft) {
+            case FT_BYTE: sim_wr8(s, at, sim_rd8(s, at) + value); break;
+            case FT_HALF: sim_wr16(s, at, sim_rd16(s, at) + value); break;
+            case FT_WORD:
+                /* As armlink: the address of Thumb code is odd, so that
+                 * BX to it enters Thumb state (but not that of data, such
+                 * as a vtable, in a Thumb code area).
+                 */
+                if (thumbsym && !(flags & REL_R)) value |= 1;
+                sim_wr32(s, at, sim_rd32(s, at) + value);
+                break;
+            default:
+                if (thumb)
+                    reloc_thumb(s, a, at, value, sym);
+                else
+                    reloc_arm(s, a, at, (int)((flags >> 29) & 3), value, sym,
+                              (flags & REL_R) != 0);
+                break;
+            }
+        }
+    }
+}
+
+/* Tracing and profiling ------------------------------------------------ */
+
+static char *trace_cb(dis_cb_type type, int32 offset, unsigned32 address,
+                      int w, void *cb_arg, char *buf)
+{
+    (void)offset; (void)w; (void)cb_arg;
+    if (type == D_BORBL) {
+        char sym[256];
+        return buf + sprintf(buf, "%s", sim_symbolise(address, sym));
+    }
+    return buf + sprintf(buf, "0x%lx", (unsigned long)address);
+}
+
+static void trace(ArmSim *s, uint32 pc, uint32 instr)
+{
+    char line[512], sym[256];
+    line[0] = 0;
+    if (s->thumb)
+        disass_16(instr, sim_rd16(s, pc + 2), pc, line, NULL, trace_cb);
+    else
+        disass(instr, pc, line, NULL, trace_cb);
+    fprintf(stderr, "%08lx %-24s %08lx  %s\n", (unsigned long)pc,
+            sim_symbolise(pc, sym), (unsigned long)instr, line);
+}
+
+static void profile(ArmSim *s, uint32 pc)
+{
+    if (prof_lastpc != 0)
+        prof_cycles[(prof_lastpc - code_base) / 2] += s->st.cycles - prof_lastcycles;
+    if (pc < code_base || pc >= code_limit) {
+        prof_lastpc = 0;
+        return;
+    }
+    prof_count[(pc - code_base) / 2]++;
+    prof_lastpc = pc;
+    prof_lastcycles = s->st.cycles;
+}
+
+typedef struct ProfLine {
+    const char *name;
+    SimCount count, cycles;
+} ProfLine;
+
+static int profline_cmp(const void *a, const void *b)
+{
+    const ProfLine *x = (const ProfLine *)a, *y = (const ProfLine *)b;
+    return x->cycles > y->cycles ? -1 : x->cycles < y->cycles;
+}
+
+static void profile_report(ArmSim *s)
+{
+    ProfLine *lines = (ProfLine *)xalloc((naddrsyms + 1) * sizeof(ProfLine));
+    int n = 0, i;
+    uint32 a;
+
+    profile(s, 0);
+    for (a = code_base; a < code_limit; a += 2) {
+        SimCount c = prof_count[(a - code_base) / 2];
+        if (c == 0) continue;
+        i = addrsym_find(a);
+        if (n == 0 || lines[n-1].name != (i < 0 ? "?" : addrsyms[i].name)) {
+            lines[n].name = i < 0 ? "?" : addrsyms[i].name;
+            lines[n].count = lines[n].cycles = 0;
+            n++;
+        }
+        lines[n-1].count += c;
+        lines[n-1].cycles += prof_cycles[(a - code_base) / 2];
+    }
+    qsort(lines, n, sizeof(ProfLine), profline_cmp);
+    fprintf(stderr, "%12s %6s %12s  %s\n", "cycles", "%", "insts", "function");
+    for (i = 0; i < n; i++)
+        fprintf(stderr, "%12llu %6.2f %12llu  %s\n", lines[i].cycles,
+                s->st.cycles ? 100.0 * lines[i].cycles / s->st.cycles : 0.0,
+                lines[i].count, lines[i].name);
+    free(lines);
+}
+
+static void stats_report(ArmSim *s)
+{
+    const SimStats *st = &s->st;
+    fprintf(stderr, "core %s\n", s->core->name);
+    fprintf(stderr, "cycles %llu\n", st->cycles);
+    fprintf(stderr, "instructions %llu\n", st->insts);
+    fprintf(stderr, "thumb_instructions %llu\n", st->thumb);
+    fprintf(stderr, "skipped %llu\n", st->skipped);
+    fprintf(stderr, "loads %llu\n", st->loads);
+    fprintf(stderr, "load_words %llu\n", st->load_words);
+    fprintf(stderr, "stores %llu\n", st->stores);
+    fprintf(stderr, "store_words %llu\n", st->store_words);
+    fprintf(stderr, "branches %llu\n", st->branches);
+    fprintf(stderr, "branches_taken %llu\n", st->taken);
+    if (s->core->model == SIM_NSI) {
+        fprintf(stderr, "n_cycles %llu\n", st->ncycles);
+        fprintf(stderr, "s_cycles %llu\n", st->scycles);
+        fprintf(stderr, "i_cycles %llu\n", st->icycles);
+    } else
+        fprintf(stderr, "interlocks %llu\n", st->interlocks);
+    fprintf(stderr, "runtime_calls %llu\n", st->rtcalls);
+    fprintf(stderr, "code_bytes %lu\n", (unsigned long)(code_limit - code_base));
+    fprintf(stderr, "data_bytes %lu\n", (unsigned long)(data_limit - code_limit));
+}
+
+/* Driver --------------------------------------------------------------- */
+
+/* Call each word of the named areas as a function: the C++ static
+ * constructors (C$$ctorvec) in link order, destructors in reverse.
+ */
+static void call_vector(ArmSim *s, const char *name, bool reverse)
+{
+    int i;
+    uint32 j;
+
+    for (i = 0; i < nlayout && !s->halted; i++) {
+        Area *a = layout[reverse ? nlayout - 1 - i : i];
+        if (strcmp(a->name, name) != 0) continue;
+        for (j = 0; j + 4 <= a->size && !s->halted; j += 4)
+            sim_call(s, sim_rd32(s, a->base + (reverse ? a->size - 4 - j : j)),
+                     0, 0);
+    }
+}
+
+static void usage(void)
+{
+    const SimCore *c;
+    fprintf(stderr,
+"usage: armsim [options] file.o... [-- args]\n"
+"  -core <name>     timing model (default ARM7TDMI):");
+    for (c = sim_cores; c->name != NULL; c++)
+        fprintf(stderr, " %s", c->name);
+    fprintf(stderr, "\n"
+"  -nwait <n>       ARM7TDMI: cycles per non-sequential access (default 1)\n"
+"  -swait <n>       ARM7TDMI: cycles per sequential access (default 1)\n"
+"  -mem <bytes>     memory size, K or M suffix allowed (default 16M)\n"
+"  -stats           report counts on stderr\n"
+"  -profile         report a flat profile by function on stderr\n"
+"  -trace           trace each instruction on stderr\n");
+    exit(EXIT_error);
+}
+
+static uint32 parse_size(const char *arg)
+{
+    char *end;
+    unsigned long v = strtoul(arg, &end, 0);
+    if (*end == 'K' || *end == 'k') v <<= 10, end++;
+    else if (*end == 'M' || *end == 'm') v <<= 20, end++;
+    if (*end != 0 || v < 0x100000 || v > 0x40000000) {
+        fprintf(stderr, "armsim: bad memory size '%s'\n", arg);
+        usage();
+    }
+    return (uint32)v;
+}
+
+int main(int argc, char **argv)
+{
+    ArmSim *s = &sim;
+    bool stats = false, prof = false;
+    char **files, **pargv;
+    int nfiles = 0, pargc = 1, i;
+    uint32 rtdata, argvaddr;
+    Sym *mainsym;
+
+    s->core = &sim_cores[0];
+    s->nwait = s->swait = 1;
+    s->memsize = SIM_MEMSIZE;
+    files = (char **)xalloc(argc * sizeof(char *));
+    pargv = (char **)xalloc((argc + 1) * sizeof(char *));
+    for (i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        if (strcmp(a, "--") == 0) {
+            for (i++; i < argc; i++) pargv[pargc++] = argv[i];
+            break;
+        } else if (a[0] != '-')
+            files[nfiles++] = argv[i];
+        else if (strcmp(a, "-core") == 0 && i + 1 < argc) {
+            s->core = sim_findcore(argv[++i]);
+            if (s->core == NULL) {
+                fprintf(stderr, "armsim: unknown core '%s'\n", argv[i]);
+                usage();
+            }
+        } else if (strcmp(a, "-nwait") == 0 && i + 1 < argc)
+            s->nwait = atoi(argv[++i]);
+        else if (strcmp(a, "-swait") == 0 && i + 1 < argc)
+            s->swait = atoi(argv[++i]);
+        else if (strcmp(a, "-mem") == 0 && i + 1 < argc)
+            s->memsize = parse_size(argv[++i]);
+        else if (strcmp(a, "-stats") == 0)
+            stats = true;
+        else if (strcmp(a, "-profile") == 0)
+            prof = true;
+        else if (strcmp(a, "-trace") == 0)
+            sim_trace = trace;
+        else
+            usage();
+    }
+    if (nfiles == 0) usage();
+    pargv[0] = nfiles > 0 ? files[0] : "a.out";
+
+    objs = (Obj *)xalloc(nfiles * sizeof(Obj));
+    for (i = 0; i < nfiles; i++) {
+        load_object(&objs[i], files[i]);
+        if (objs[i].bigend != objs[0].bigend)
+            fatal("%s: objects have different byte orders", files[i]);
+    }
+    nobjs = nfiles;
+    s->bigend = objs[0].bigend;
+    s->mem = (uint8 *)xalloc(s->memsize);
+
+    add_common_symbols();
+    layout_areas();
+    define_symbols();
+    qsort(addrsyms, naddrsyms, sizeof(AddrSym), addrsym_cmp);
+    load_areas(s);
+    /* Veneers go after the image, with room for one per relocation. */
+    veneer_next = (data_limit + 7) & ~7u;
+    rtdata = veneer_next;
+    for (i = 0; i < nlayout; i++)
+        rtdata += 12 * layout[i]->nrelocs;
+    s->image_limit = sim_rt_init(s, rtdata);
+    relocate(s);
+
+    s->heap = s->image_limit;
+    s->stack_limit = s->memsize - SIM_STACKSIZE;
+    s->heap_limit = s->stack_limit;
+    if (s->heap >= s->heap_limit)
+        fatal("image does not fit in memory (use -mem)");
+
+    mainsym = sym_lookup("main", false);
+    if (mainsym == NULL || !mainsym->defined || mainsym->addr < SIM_IMAGE_BASE)
+        fatal("no definition of main");
+    s->r[13] = s->memsize;
+    argvaddr = sim_rt_argv(s, pargc, pargv);
+    s->r[10] = s->stack_limit + 256;    /* sl, with room for the handler */
+    s->r[11] = 0;
+
+    if (prof) {
+        size_t n = (code_limit - code_base) / 2 + 1;
+        prof_count = (SimCount *)xalloc(n * sizeof(SimCount));
+        prof_cycles = (SimCount *)xalloc(n * sizeof(SimCount));
+        sim_profile = profile;
+    }
+    call_vector(s, "C$$ctorvec", false);
+    if (!s->halted) {
+        s->r[0] = (uint32)pargc;
+        s->r[1] = argvaddr;
+        s->r[14] = SIM_RT_EXIT;
+        s->pc = mainsym->addr;
+        s->thumb = mainsym->thumb;
+        sim_run(s, 0);
+        /* exit() and returning from main() both run the destructors. */
+        s->halted = false;
+        call_vector(s, "C$$dtorvec", true);
+        s->halted = true;
+    }
+    fflush(stdout);
+    if (stats) stats_report(s);
+    if (prof) profile_report(s);
+    if (s->exitcode == 0 && sim_rt_testfailed())
+        return 1;
+    return s->exitcode;
+}
@@ -0,0 +1,123 @@
+/* Copyright 2025 Piers Wombwell
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+/* armsim: a user-mode ARM/Thumb simulator for the compiler's own AOF
+ * output. It links the objects it is given, binds anything they import
+ * from the C library or the compiler's support routines to a small
+ * runtime written in C on the host (armsim-rt.c), and runs main().
+ */
+
+#include "host.h"
+
+/* Simulated address space. The bottom 16K is unmapped so that null
+ * pointers fault; runtime entry points occupy one word each from
+ * SIM_RT_BASE; the image is loaded at SIM_IMAGE_BASE with the runtime's
+ * own data, then the heap, after it; the stack grows down from the top.
+ */
+#define SIM_RT_BASE      0x4000u
+#define SIM_RT_LIMIT     0x8000u
+#define SIM_IMAGE_BASE   0x8000u
+
+#define SIM_MEMSIZE      0x01000000u  /* default, -mem to change */
+#define SIM_STACKSIZE    0x00100000u
+
+/* Timing models. */
+typedef enum {
+    SIM_NSI,        /* ARM7-style: count N, S and I cycles separately */
+    SIM_PIPE        /* 5-stage core with interlocks and caches assumed hot */
+} SimModel;
+
+typedef struct SimCore {
+    const char *name;
+    SimModel model;
+    int arch;           /* 4 (v4T), 5 (v5TE), 7 (v6T2/v7 MOVW/MOVT, Thumb-2) */
+    int branch;         /* SIM_PIPE: extra cycles when the PC is written */
+    int loaduse;        /* SIM_PIPE: stall if the next instruction uses a load */
+    int loadsub;        /* SIM_PIPE: further stall for byte/halfword loads */
+    int mulbase;        /* SIM_PIPE: MUL/MLA cycles with an 8-bit multiplier */
+    int mullong;        /* SIM_PIPE: extra cycles for the long multiplies */
+    int regshift;       /* SIM_PIPE: extra cycles for a register-specified shift */
+} SimCore;
+
+typedef unsigned long long SimCount;
+
+typedef struct SimStats {
+    SimCount cycles;
+    SimCount insts, thumb, skipped;
+    SimCount loads, load_words, stores, store_words;
+    SimCount branches, taken;
+    SimCount ncycles, scycles, icycles;
+    SimCount interlocks;
+    SimCount rtcalls;
+} SimStats;
+
+typedef struct ArmSim {
+    uint32 r[16];           /* r[15] is the architectural PC while executing */
+    uint32 pc;              /* address of the current instruction */
+    uint32 nextpc;
+    bool n, z, c, v;
+    bool thumb;
+    unsigned itstate;       /* Thumb-2 IT block: firstcond[3:1], firstcond[0]:mask */
+    bool bigend;
+
+    uint8 *mem;
+    uint32 memsize;
+    uint32 image_limit;     /* end of the loaded image */
+    uint32 heap, heap_limit;
+    uint32 stack_limit;
+
+    const SimCore *core;
+    int nwait, swait;       /* SIM_NSI: cycles per N and S memory access */
+    SimStats st;
+    uint32 lastload;        /* SIM_PIPE: registers this instruction loaded */
+    int lastlat;            /* ... and how long until they can be used */
+    uint32 prevload;        /* the same for the previous instruction */
+    int prevlat;
+    bool wrotepc;
+
+    bool halted;
+    int exitcode;
+} ArmSim;
+
+/* armsim.c */
+extern void sim_fatal(ArmSim *s, const char *fmt, ...);
+extern const char *sim_symbolise(uint32 addr, char *buf);
+
+/* armsim-cpu.c */
+extern const SimCore sim_cores[];
+extern const SimCore *sim_findcore(const char *name);
+extern void sim_run(ArmSim *s, uint32 stop);
+extern void (*sim_trace)(ArmSim *s, uint32 pc, uint32 instr);
+extern void (*sim_profile)(ArmSim *s, uint32 pc);
+
+extern uint32 sim_rd32(ArmSim *s, uint32 a);
+extern uint32 sim_rd16(ArmSim *s, uint32 a);
+extern uint32 sim_rd8(ArmSim *s, uint32 a);
+extern void sim_wr32(ArmSim *s, uint32 a, uint32 v);
+extern void sim_wr16(ArmSim *s, uint32 a, uint32 v);
+extern void sim_wr8(ArmSim *s, uint32 a, uint32 v);
+
+/* armsim-rt.c */
+#define SIM_RT_RETURN    SIM_RT_BASE         /* back to a host caller */
+#define SIM_RT_EXIT      (SIM_RT_BASE + 4)   /* main() returned */
+
+extern uint32 sim_rt_lookup(const char *name);
+extern uint32 sim_rt_init(ArmSim *s, uint32 base);
+extern void sim_rt_call(ArmSim *s, uint32 addr);
+extern uint32 sim_call(ArmSim *s, uint32 fn, uint32 a1, uint32 a2);
+extern uint32 sim_rt_argv(ArmSim *s, int argc, char **argv);
+extern bool sim_rt_testfailed(void);
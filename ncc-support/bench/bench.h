@@ -0,0 +1,40 @@
+/* Copyright 2025 Piers Wombwell
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks of the code ncc generates, run under armsim by make bench.
+// Each runs its kernels a fixed number of times, folding the results
+// into a checksum that must match the one the same source gives when
+// compiled natively, so that miscompiled code cannot pass as fast code.
+// Nothing here depends on char signedness or the size of long.
+
+#ifndef bench_h
+#define bench_h
+
+#include <stdio.h>
+
+static int bench_check(const char *name, unsigned sum, unsigned expect)
+{
+    if (sum != expect) {
+        printf("FAILED: %s: checksum %08x, expected %08x\n", name, sum, expect);
+        return 1;
+    }
+    printf("%s %08x\n", name, sum);
+    return 0;
+}
+
+// Mix v into a running checksum.
+#define BENCH_MIX(sum, v) ((sum) = ((sum) << 5 | (sum) >> 27) ^ (unsigned)(v))
+
+#endif
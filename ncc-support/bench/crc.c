@@ -0,0 +1,70 @@
+/* Copyright 2025 Piers Wombwell
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Table-driven CRC-32 and bitwise CRC-16/CCITT.
+
+#include "bench.h"
+
+#define N 2048
+
+static unsigned crc_table[256];
+static unsigned char buf[N];
+
+static void make_table(void)
+{
+    unsigned n, c;
+    int k;
+    for (n = 0; n < 256; n++) {
+        c = n;
+        for (k = 0; k < 8; k++)
+            c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        crc_table[n] = c;
+    }
+}
+
+static unsigned crc32(unsigned crc, const unsigned char *p, int n)
+{
+    crc = ~crc;
+    while (n-- > 0)
+        crc = crc_table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+static unsigned crc16(unsigned crc, const unsigned char *p, int n)
+{
+    int k;
+    while (n-- > 0) {
+        crc ^= (unsigned)*p++ << 8;
+        for (k = 0; k < 8; k++)
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc & 0xffff;
+}
+
+int main(void)
+{
+    unsigned sum = 0, x = 12345;
+    int i;
+
+    make_table();
+    for (i = 0; i < N; i++) {
+        x = x * 1103515245u + 12345;
+        buf[i] = (unsigned char)(x >> 16);
+    }
+    for (i = 0; i < 8; i++)
+        BENCH_MIX(sum, crc32(i, buf + i, N - i));
+    BENCH_MIX(sum, crc16(0xffff, buf, N / 2));
+    return bench_check("crc", sum, 0xb804f14f);
+}
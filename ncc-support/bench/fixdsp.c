@@ -0,0 +1,87 @@
+/* Copyright 2025 Piers Wombwell
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Fixed-point signal processing: a Q15 FIR filter, a Q14 biquad and a
+// saturating mix, on 16-bit samples.
+
+#include "bench.h"
+
+#define N     512
+#define TAPS  16
+
+static short in[N], out[N];
+static const short taps[TAPS] = {
+    -120, -340, -210, 680, 1900, 3100, 4200, 4700,
+    4700, 4200, 3100, 1900, 680, -210, -340, -120
+};
+
+static void fir(short *y, const short *x, int n)
+{
+    int i, k;
+    for (i = TAPS - 1; i < n; i++) {
+        int acc = 0;
+        for (k = 0; k < TAPS; k++)
+            acc += x[i - k] * taps[k];
+        y[i] = (short)(acc >> 15);
+    }
+}
+
+static void biquad(short *y, const short *x, int n)
+{
+    static const int b0 = 4096, b1 = 8192, b2 = 4096, a1 = -12000, a2 = 5000;
+    int x1 = 0, x2 = 0, y1 = 0, y2 = 0, i;
+    for (i = 0; i < n; i++) {
+        int acc = b0 * x[i] + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+        int v = acc >> 14;
+        if (v > 32767) v = 32767;
+        if (v < -32768) v = -32768;
+        x2 = x1, x1 = x[i];
+        y2 = y1, y1 = v;
+        y[i] = (short)v;
+    }
+}
+
+static int saturate(int v)
+{
+    return v > 32767 ? 32767 : v < -32768 ? -32768 : v;
+}
+
+static void mix(short *y, const short *a, const short *b, int n)
+{
+    int i;
+    for (i = 0; i < n; i++)
+        y[i] = (short)saturate(a[i] + b[i]);
+}
+
+int main(void)
+{
+    unsigned sum = 0, x = 1;
+    int i, j;
+
+    for (i = 0; i < N; i++) {
+        x = x * 69069u + 1;
+        in[i] = (short)((int)(x >> 16) - 32768);
+    }
+    for (j = 0; j < 4; j++) {
+        fir(out, in, N);
+        for (i = 0; i < N; i += 17) BENCH_MIX(sum, out[i]);
+        biquad(out, in, N);
+        for (i = 0; i < N; i += 17) BENCH_MIX(sum, out[i]);
+        mix(out, in, out, N);
+        for (i = 0; i < N; i += 17) BENCH_MIX(sum, out[i]);
+        in[j] = out[N - 1 - j];
+    }
+    return bench_check("fixdsp", sum, 0xe7cf2e6d);
+}
@@ -0,0 +1,89 @@
+/* Copyright 2025 Piers Wombwell
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// long long arithmetic: a 64-bit xorshift generator, multiply-accumulate,
+// shifts by variable amounts, division and comparison.
+
+#include "bench.h"
+
+typedef unsigned long long u64;
+typedef long long s64;
+
+static u64 state = 0x2545f4914f6cdd1dULL;
+
+static u64 next(void)
+{
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545f4914f6cdd1dULL;
+}
+
+static u64 mac(const u64 *a, const u64 *b, int n)
+{
+    u64 acc = 0;
+    int i;
+    for (i = 0; i < n; i++)
+        acc += a[i] * b[i];
+    return acc;
+}
+
+static s64 shifts(s64 v, int n)
+{
+    return (s64)((u64)v << (n & 31)) ^ (v >> (n & 63)) ^
+           (s64)((u64)v >> (63 - (n & 63)));
+}
+
+static unsigned popcount(u64 v)
+{
+    unsigned n = 0;
+    while (v != 0) {
+        v &= v - 1;
+        n++;
+    }
+    return n;
+}
+
+#define N 64
+
+int main(void)
+{
+    static u64 a[N], b[N];
+    unsigned sum = 0;
+    s64 min = 0, max = 0;
+    u64 m;
+    int i, j;
+
+    for (j = 0; j < 4; j++) {
+        for (i = 0; i < N; i++) {
+            a[i] = next();
+            b[i] = next() >> 7;
+        }
+        m = mac(a, b, N);
+        BENCH_MIX(sum, m);
+        BENCH_MIX(sum, m >> 32);
+        for (i = 0; i < N; i++) {
+            s64 v = shifts((s64)a[i], i + j);
+            if (v < min) min = v;
+            if (v > max) max = v;
+            BENCH_MIX(sum, popcount(v));
+            BENCH_MIX(sum, a[i] / (b[i] >> 40 | 1));
+            BENCH_MIX(sum, (s64)a[i] % 1000003);
+        }
+    }
+    BENCH_MIX(sum, min >> 32);
+    BENCH_MIX(sum, max >> 32);
+    return bench_check("int64", sum, 0x85c75826);
+}
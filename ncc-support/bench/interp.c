@@ -0,0 +1,84 @@
+/* Copyright 2025 Piers Wombwell
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// A switch-dispatched stack machine, running programs that sum squares
+// and compute Fibonacci numbers.
+
+#include "bench.h"
+
+enum {
+    OP_PUSH, OP_LOAD, OP_STORE, OP_ADD, OP_SUB, OP_MUL, OP_AND, OP_DUP,
+    OP_SWAP, OP_DROP, OP_JMP, OP_JNZ, OP_LT, OP_INC, OP_HALT
+};
+
+static int run(const int *code, int *vars)
+{
+    int stack[32], *sp = stack, pc = 0;
+    for (;;) {
+        int op = code[pc++];
+        switch (op) {
+        case OP_PUSH:  *sp++ = code[pc++]; break;
+        case OP_LOAD:  *sp++ = vars[code[pc++]]; break;
+        case OP_STORE: vars[code[pc++]] = *--sp; break;
+        case OP_ADD:   sp--, sp[-1] += sp[0]; break;
+        case OP_SUB:   sp--, sp[-1] -= sp[0]; break;
+        case OP_MUL:   sp--, sp[-1] *= sp[0]; break;
+        case OP_AND:   sp--, sp[-1] &= sp[0]; break;
+        case OP_DUP:   sp[0] = sp[-1], sp++; break;
+        case OP_SWAP:  { int t = sp[-1]; sp[-1] = sp[-2]; sp[-2] = t; } break;
+        case OP_DROP:  sp--; break;
+        case OP_JMP:   pc = code[pc]; break;
+        case OP_JNZ:   pc = *--sp ? code[pc] : pc + 1; break;
+        case OP_LT:    sp--, sp[-1] = sp[-1] < sp[0]; break;
+        case OP_INC:   vars[code[pc++]]++; break;
+        case OP_HALT:  return sp > stack ? sp[-1] : 0;
+        }
+    }
+}
+
+// for (i = 0; i < n; i++) s += i * i & 0xffff;
+static const int squares[] = {
+    /*  0 */ OP_PUSH, 0, OP_STORE, 1,
+    /*  4 */ OP_PUSH, 0, OP_STORE, 2,
+    /*  8 */ OP_LOAD, 1, OP_LOAD, 0, OP_LT, OP_JNZ, 17, OP_JMP, 33,
+    /* 17 */ OP_LOAD, 1, OP_DUP, OP_MUL, OP_PUSH, 0xffff, OP_AND,
+    /* 24 */ OP_LOAD, 2, OP_ADD, OP_STORE, 2, OP_INC, 1, OP_JMP, 8,
+    /* 33 */ OP_LOAD, 2, OP_HALT
+};
+
+// a = 0, b = 1; while (n--) { t = a + b; a = b; b = t; } return a;
+static const int fib[] = {
+    /*  0 */ OP_PUSH, 0, OP_STORE, 1,
+    /*  4 */ OP_PUSH, 1, OP_STORE, 2,
+    /*  8 */ OP_LOAD, 0, OP_JNZ, 14, OP_JMP, 33,
+    /* 14 */ OP_LOAD, 1, OP_LOAD, 2, OP_DUP, OP_STORE, 1, OP_ADD,
+    /* 22 */ OP_STORE, 2, OP_LOAD, 0, OP_PUSH, 1, OP_SUB, OP_STORE, 0,
+    /* 31 */ OP_JMP, 8,
+    /* 33 */ OP_LOAD, 1, OP_HALT
+};
+
+int main(void)
+{
+    unsigned sum = 0;
+    int vars[4], i;
+
+    for (i = 0; i < 16; i++) {
+        vars[0] = 200 + i;
+        BENCH_MIX(sum, run(squares, vars));
+        vars[0] = 30 + i;
+        BENCH_MIX(sum, run(fib, vars));
+    }
+    return bench_check("interp", sum, 0xbf306ced);
+}
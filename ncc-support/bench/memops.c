@@ -0,0 +1,67 @@
+/* Copyright 2025 Piers Wombwell
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Byte and word copy, fill and strlen loops, at every alignment.
+
+#include "bench.h"
+
+#define N 1024
+
+static unsigned char src[N + 8], dst[N + 8];
+static unsigned wsrc[N / 4], wdst[N / 4];
+
+static void copy_bytes(unsigned char *d, const unsigned char *s, int n)
+{
+    while (n-- > 0) *d++ = *s++;
+}
+
+static void copy_words(unsigned *d, const unsigned *s, int n)
+{
+    int i;
+    for (i = 0; i < n; i++) d[i] = s[i];
+}
+
+static void fill(unsigned char *d, int c, int n)
+{
+    while (n-- > 0) *d++ = (unsigned char)c;
+}
+
+static int length(const char *s)
+{
+    const char *p = s;
+    while (*p) p++;
+    return p - s;
+}
+
+int main(void)
+{
+    unsigned sum = 0;
+    int i, j;
+
+    for (i = 0; i < N + 8; i++) src[i] = (unsigned char)(i * 7 + 1);
+    for (i = 0; i < N / 4; i++) wsrc[i] = (unsigned)i * 0x01010101u;
+    for (i = 0; i < 16; i++) {
+        copy_bytes(dst + (i & 7), src + (i >> 1 & 7), N - 16 * i);
+        copy_words(wdst, wsrc, N / 4);
+        for (j = 0; j < N; j += 61) BENCH_MIX(sum, dst[j]);
+        BENCH_MIX(sum, wdst[i * 13]);
+        src[N - 32 * i - 1] = 0;
+        BENCH_MIX(sum, length((const char *)src + i));
+        src[N - 32 * i - 1] = 1;
+        fill(dst + i, i, N / 2);
+        BENCH_MIX(sum, dst[N / 4] + dst[N / 2 + 7]);
+    }
+    return bench_check("memops", sum, 0x8efdd7cd);
+}
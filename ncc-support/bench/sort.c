@@ -0,0 +1,85 @@
+/* Copyright 2025 Piers Wombwell
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Recursive quicksort with an insertion sort for short runs, and a
+// binary search over the result.
+
+#include "bench.h"
+
+#define N 1000
+
+static int data[N];
+
+static void insertion(int *a, int n)
+{
+    int i, j;
+    for (i = 1; i < n; i++) {
+        int v = a[i];
+        for (j = i; j > 0 && a[j - 1] > v; j--) a[j] = a[j - 1];
+        a[j] = v;
+    }
+}
+
+static void quick(int *a, int n)
+{
+    while (n > 12) {
+        int pivot = a[n / 2], i = 0, j = n - 1;
+        for (;;) {
+            while (a[i] < pivot) i++;
+            while (a[j] > pivot) j--;
+            if (i >= j) break;
+            { int t = a[i]; a[i] = a[j]; a[j] = t; }
+            i++, j--;
+        }
+        if (j + 1 < n - j - 1) {
+            quick(a, j + 1);
+            a += j + 1, n -= j + 1;
+        } else {
+            quick(a + j + 1, n - j - 1);
+            n = j + 1;
+        }
+    }
+    insertion(a, n);
+}
+
+static int search(const int *a, int n, int key)
+{
+    int lo = 0, hi = n;
+    while (lo < hi) {
+        int mid = (lo + hi) >> 1;
+        if (a[mid] < key) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+int main(void)
+{
+    unsigned sum = 0, x = 7;
+    int i;
+
+    for (i = 0; i < N; i++) {
+        x = x * 1664525u + 1013904223u;
+        data[i] = (int)(x >> 8) - (1 << 23);
+    }
+    quick(data, N);
+    for (i = 1; i < N; i++)
+        if (data[i - 1] > data[i]) {
+            printf("FAILED: sort: out of order at %d\n", i);
+            return 1;
+        }
+    for (i = 0; i < N; i += 7) BENCH_MIX(sum, data[i]);
+    for (i = 0; i < 200; i++) BENCH_MIX(sum, search(data, N, i * 80000 - 8000000));
+    return bench_check("sort", sum, 0x4989fef4);
+}
@@ -0,0 +1,84 @@
+/* Copyright 2025 Piers Wombwell
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Structure assignment, and structures passed and returned by value.
+
+#include "bench.h"
+
+typedef struct { int x, y, z; } Vec;
+typedef struct { short id; unsigned char flags, kind; int pos[6]; } Item;
+typedef struct { int data[25]; } Block;
+
+static Vec add(Vec a, Vec b)
+{
+    Vec r;
+    r.x = a.x + b.x, r.y = a.y + b.y, r.z = a.z + b.z;
+    return r;
+}
+
+static Vec scale(Vec a, int k)
+{
+    a.x *= k, a.y *= k, a.z *= k;
+    return a;
+}
+
+static Item items[32];
+static Block blocks[4];
+
+static void rotate(Item *v, int n)
+{
+    Item t = v[0];
+    int i;
+    for (i = 1; i < n; i++) v[i - 1] = v[i];
+    v[n - 1] = t;
+}
+
+static unsigned sum_block(Block b)
+{
+    unsigned s = 0;
+    int i;
+    for (i = 0; i < 25; i++) s += (unsigned)b.data[i] * (unsigned)(i + 1);
+    return s;
+}
+
+int main(void)
+{
+    unsigned sum = 0;
+    Vec v = { 1, 2, 3 }, w = { 4, -5, 6 };
+    int i, j;
+
+    for (i = 0; i < 32; i++) {
+        items[i].id = (short)i;
+        items[i].flags = (unsigned char)(i * 3);
+        items[i].kind = (unsigned char)(i & 7);
+        for (j = 0; j < 6; j++) items[i].pos[j] = i * j;
+    }
+    for (i = 0; i < 4; i++)
+        for (j = 0; j < 25; j++) blocks[i].data[j] = i * 100 + j;
+
+    for (i = 0; i < 200; i++) {
+        v = add(scale(v, 3), w);
+        v.x &= 0xffff, v.y &= 0xffff, v.z &= 0xffff;
+        BENCH_MIX(sum, v.x ^ v.y ^ v.z);
+        if ((i & 7) == 0) {
+            rotate(items, 32);
+            BENCH_MIX(sum, items[0].id + items[5].pos[3] + items[9].flags);
+            blocks[i & 3] = blocks[(i >> 3) & 3];
+            blocks[i & 3].data[i % 25] += i;
+            BENCH_MIX(sum, sum_block(blocks[i & 3]));
+        }
+    }
+    return bench_check("structs", sum, 0xc99438c9);
+}
@@ -0,0 +1,84 @@
+/* Copyright 2025 Piers Wombwell
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// C++ virtual dispatch through a small class hierarchy, with objects
+// made by new.
+
+#include "bench.h"
+
+class Shape {
+public:
+    virtual ~Shape() {}
+    virtual int area() const = 0;
+    virtual int perimeter() const = 0;
+    virtual int sides() const { return 0; }
+};
+
+class Rect : public Shape {
+    int w, h;
+public:
+    Rect(int w0, int h0) : w(w0), h(h0) {}
+    virtual int area() const { return w * h; }
+    virtual int perimeter() const { return 2 * (w + h); }
+    virtual int sides() const { return 4; }
+};
+
+class Square : public Rect {
+public:
+    Square(int s) : Rect(s, s) {}
+    virtual int sides() const { return 4; }
+};
+
+class Tri : public Shape {
+    int a, b, c;
+public:
+    Tri(int a0, int b0, int c0) : a(a0), b(b0), c(c0) {}
+    virtual int area() const { return a * b / 2; }
+    virtual int perimeter() const { return a + b + c; }
+    virtual int sides() const { return 3; }
+};
+
+class Circle : public Shape {
+    int r;
+public:
+    Circle(int r0) : r(r0) {}
+    virtual int area() const { return 355 * r * r / 113; }
+    virtual int perimeter() const { return 710 * r / 113; }
+};
+
+#define N 64
+
+int main()
+{
+    Shape *shapes[N];
+    unsigned sum = 0;
+    int i, j;
+
+    for (i = 0; i < N; i++) {
+        switch (i & 3) {
+        case 0: shapes[i] = new Rect(i + 1, i + 2); break;
+        case 1: shapes[i] = new Square(i); break;
+        case 2: shapes[i] = new Tri(3 + i, 4 + i, 5 + i); break;
+        default: shapes[i] = new Circle(i); break;
+        }
+    }
+    for (j = 0; j < 20; j++)
+        for (i = 0; i < N; i++) {
+            const Shape *s = shapes[(i * 7 + j) & (N - 1)];
+            BENCH_MIX(sum, s->area() + s->perimeter() * s->sides());
+        }
+    for (i = 0; i < N; i++) delete shapes[i];
+    return bench_check("vdispatch", sum, 0xc9d846a8);
+}
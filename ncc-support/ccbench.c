@@ -0,0 +1,331 @@
+/* Copyright 2025 Piers Wombwell
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* ccbench: measure how fast the compiler compiles.
+ *
+ *   ccbench -gen <dir>
+ *       Write the synthetic inputs, each aimed at one part of the
+ *       compiler, into dir.
+ *   ccbench [-reps n] [-name label] -- compiler args...
+ *       Run the compile n times (default 3) and once more with -zqU,
+ *       then write "label metric value" lines to stdout.
+ *
+ * cpu_us is the least user+system time of the n runs and maxrss_kb the
+ * peak resident set of any of them. The -zqU run gives the compiler's
+ * own figures: front- and back-end time, CSE, dataflow and regalloc
+ * time (these include the cost of the debugging output, so compare them
+ * with each other rather than with cpu_us) and show_store_use()'s store
+ * totals. status is ok, or failed if any run of the compiler failed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+static void fatal(const char *msg, const char *arg)
+{
+    fprintf(stderr, "ccbench: %s%s\n", msg, arg);
+    exit(2);
+}
+
+/* Synthetic inputs ----------------------------------------------------- */
+
+static unsigned long seed = 1;
+
+static int rnd(int n)
+{
+    seed = seed * 1103515245ul + 12345ul;
+    return (int)((seed >> 16) & 0x7fff) % n;
+}
+
+static FILE *create(const char *dir, const char *name)
+{
+    char path[1024];
+    FILE *f;
+    sprintf(path, "%.900s/%s", dir, name);
+    f = fopen(path, "w");
+    if (f == NULL) fatal("can't write ", path);
+    seed = 1;
+    return f;
+}
+
+/* One function with a long loop body over many locals: regalloc.c and
+ * cse.c.
+ */
+static void gen_bigfunc(const char *dir)
+{
+    FILE *f = create(dir, "bigfunc.c");
+    int k;
+    fprintf(f, "int big(int *a, int n)\n{\n    int i");
+    for (k = 0; k < 32; k++) fprintf(f, ", v%d = a[%d]", k, k);
+    fprintf(f, ";\n    for (i = 0; i < n; i++) {\n");
+    for (k = 0; k < 800; k++) {
+        int x = rnd(32), y = rnd(32), z = rnd(32), w = rnd(32);
+        fprintf(f, "        v%d = v%d * %d + (v%d ^ a[(i + %d) & 255]);\n",
+                x, y, rnd(7) + 2, z, k);
+        if (k % 4 == 3)
+            fprintf(f, "        if (v%d > v%d) v%d += v%d >> %d;\n",
+                    x, y, z, w, rnd(8) + 1);
+    }
+    fprintf(f, "    }\n    return v0");
+    for (k = 1; k < 32; k++) fprintf(f, " + v%d", k);
+    fprintf(f, ";\n}\n");
+    fclose(f);
+}
+
+/* Long chains of macros, balanced trees of them, and nested #if: pp.c. */
+static void gen_macros(const char *dir)
+{
+    FILE *f = create(dir, "macros.c");
+    int k;
+    fprintf(f, "#define N0(x) ((x) + 1)\n");
+    for (k = 1; k <= 100; k++)
+        fprintf(f, "#define N%d(x) N%d((x) ^ %d)\n", k, k - 1, k);
+    fprintf(f, "#define M0(x) ((x) * 3)\n");
+    for (k = 1; k <= 10; k++)
+        fprintf(f, "#define M%d(x) (M%d(x) + M%d((x) + %d))\n", k, k - 1, k - 1, k);
+    for (k = 0; k < 40; k++)
+        fprintf(f, "#if %d > 0\n", k + 1);
+    fprintf(f, "#define DEEP 1\n");
+    for (k = 0; k < 40; k++)
+        fprintf(f, "#endif\n");
+    for (k = 0; k < 60; k++)
+        fprintf(f, "int n%d(int y) { return N100(y + %d) + DEEP; }\n", k, k);
+    for (k = 0; k < 8; k++)
+        fprintf(f, "int m%d(int y) { return M10(y - %d); }\n", k, k);
+    fclose(f);
+}
+
+/* Large initialised tables: vargen.c. */
+static void gen_initialiser(const char *dir)
+{
+    FILE *f = create(dir, "initialiser.c");
+    int k;
+    fprintf(f, "struct rec { int id; short kind; unsigned char flags[4];\n"
+               "             const char *name; double w; };\n");
+    fprintf(f, "const struct rec table[] = {\n");
+    for (k = 0; k < 8000; k++)
+        fprintf(f, "    { %d, %d, { %d, %d, %d, %d }, \"n%d\", %d.%d },\n",
+                k, rnd(1000) - 500, rnd(256), rnd(256), rnd(256), rnd(256),
+                k, rnd(100), rnd(100));
+    fprintf(f, "};\n\nconst int ints[] = {\n");
+    for (k = 0; k < 40000; k++)
+        fprintf(f, "%d,%s", rnd(30000) - 15000, k % 16 == 15 ? "\n" : " ");
+    fprintf(f, "};\n");
+    fclose(f);
+}
+
+/* Thousands of small functions: per-function overheads everywhere. */
+static void gen_manyfuncs(const char *dir)
+{
+    FILE *f = create(dir, "manyfuncs.c");
+    int k;
+    for (k = 0; k < 2000; k++) {
+        fprintf(f, "static int f%d(int a, int b) { return a * %d + (b >> %d) - %d; }\n",
+                k, rnd(100), rnd(16), k);
+        fprintf(f, "int e%d(int x)\n{\n    int r = f%d(x, x + %d);\n",
+                k, k, rnd(10));
+        if (k > 0)
+            fprintf(f, "    if (r & 1) r += e%d(x - 1);\n", rnd(k));
+        fprintf(f, "    return r;\n}\n");
+    }
+    fclose(f);
+}
+
+/* Nested class templates, function templates and overload sets:
+ * cppfe/xsyn.c and cppfe/overload.c. Nesting is kept shallow enough for
+ * the mangled names to stay distinct.
+ */
+static void gen_templates(const char *dir)
+{
+    FILE *f = create(dir, "templates.cpp");
+    int k, j;
+    fprintf(f, "template <class T> struct Wrap {\n"
+               "    T inner; int extra;\n"
+               "    int depth() const { return inner.depth() + extra; }\n"
+               "};\n"
+               "template <class T, class U> struct Pair {\n"
+               "    T first; U second;\n"
+               "    int depth() const { return first.depth() * second.depth(); }\n"
+               "};\n"
+               "template <class T> T pick(T a, T b) { return a.depth() < b.depth() ? b : a; }\n"
+               "template <class T> int measure(const T &t) { return t.depth(); }\n");
+    for (k = 0; k < 60; k++) {
+        char t[256];
+        fprintf(f, "struct L%d { int v; int depth() const { return v + %d; } };\n", k, k);
+        sprintf(t, "L%d", k);
+        for (j = 0; j < 5; j++) {
+            char u[256];
+            if (j == 2 && k > 0)
+                sprintf(u, "Pair<%.200s, L%d >", t, k - 1);
+            else
+                sprintf(u, "Wrap<%.200s >", t);
+            strcpy(t, u);
+        }
+        fprintf(f, "typedef %s D%d;\n", t, k);
+        fprintf(f, "int g%d(D%d *a, D%d *b) { return measure(pick(*a, *b)); }\n", k, k, k);
+        fprintf(f, "int h(const L%d &);\n", k);
+    }
+    for (k = 0; k < 60; k++) {
+        fprintf(f, "int call%d()\n{\n    int r = 0;\n", k);
+        for (j = 0; j < 40; j++)
+            fprintf(f, "    { L%d x; x.v = %d; r += h(x); }\n", (k + j * 7) % 60, j);
+        fprintf(f, "    return r;\n}\n");
+    }
+    fclose(f);
+}
+
+/* Running the compiler ------------------------------------------------- */
+
+static long tv_us(struct timeval tv)
+{
+    return (long)tv.tv_sec * 1000000L + (long)tv.tv_usec;
+}
+
+/* Run argv with its output to log (appended), and return its exit status,
+ * or -1 if it didn't exit normally.
+ */
+static int run(char **argv, const char *log)
+{
+    int status;
+    pid_t pid = fork();
+    if (pid < 0) fatal("can't fork", "");
+    if (pid == 0) {
+        int fd = open(log, O_WRONLY | O_CREAT | O_APPEND, 0666);
+        if (fd >= 0) {
+            dup2(fd, 1);
+            dup2(fd, 2);
+            close(fd);
+        }
+        execvp(argv[0], argv);
+        fprintf(stderr, "ccbench: can't run %s\n", argv[0]);
+        _exit(127);
+    }
+    if (waitpid(pid, &status, 0) < 0) fatal("waitpid failed", "");
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static long ticks_us(long t)
+{
+    return (long)((double)t * 1000000.0 / CLOCKS_PER_SEC);
+}
+
+static void report(const char *label, const char *metric, long value)
+{
+    printf("%s %s %ld\n", label, metric, value);
+}
+
+/* Pick the compiler's figures out of its -zqU output. */
+static void parse_log(const char *label, const char *log)
+{
+    char line[1024];
+    FILE *f = fopen(log, "r");
+    if (f == NULL) return;
+    while (fgets(line, sizeof line, f) != NULL) {
+        long a, b, c, d;
+        if (sscanf(line, "Time: %ldcs front-end %ldcs back-end", &a, &b) == 2) {
+            report(label, "front_us", ticks_us(a));
+            report(label, "back_us", ticks_us(b));
+        } else if (sscanf(line, "Dataflow time %ldcs, regalloc time %ld+%ldcs",
+                          &a, &b, &c) == 3) {
+            report(label, "dataflow_us", ticks_us(a));
+            report(label, "regalloc_us", ticks_us(b + c));
+        } else if (sscanf(line, "CSE max sets: %ld (%ld bytes): time %ld cs",
+                          &a, &b, &c) == 3) {
+            report(label, "cse_us", ticks_us(c));
+        } else if (sscanf(line, "Total store use (excluding stdio buffers/stack) %ld bytes",
+                          &a) == 1) {
+            report(label, "store_bytes", a);
+        } else if (sscanf(line, "Local store use %ld+%ld/%ld bytes - front end max %ld",
+                          &a, &b, &c, &d) == 4) {
+            report(label, "local_store_bytes", c);
+        }
+    }
+    fclose(f);
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "usage: ccbench -gen <dir>\n"
+        "       ccbench [-reps n] [-name label] -- compiler args...\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    const char *label = "compile";
+    char log[64], **zargv;
+    struct rusage ru0, ru1;
+    long best = -1, maxrss;
+    int reps = 3, i, n, failed = 0;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-gen") == 0 && i + 1 < argc) {
+            gen_bigfunc(argv[i + 1]);
+            gen_macros(argv[i + 1]);
+            gen_initialiser(argv[i + 1]);
+            gen_manyfuncs(argv[i + 1]);
+            gen_templates(argv[i + 1]);
+            return 0;
+        } else if (strcmp(argv[i], "-reps") == 0 && i + 1 < argc)
+            reps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-name") == 0 && i + 1 < argc)
+            label = argv[++i];
+        else if (strcmp(argv[i], "--") == 0)
+            break;
+        else
+            usage();
+    }
+    if (++i >= argc || reps < 1) usage();
+    argv += i, argc -= i;
+
+    sprintf(log, "/tmp/ccbench.%ld.log", (long)getpid());
+    remove(log);
+    for (n = 0; n < reps; n++) {
+        long us;
+        getrusage(RUSAGE_CHILDREN, &ru0);
+        if (run(argv, log) != 0) failed = 1;
+        getrusage(RUSAGE_CHILDREN, &ru1);
+        us = tv_us(ru1.ru_utime) - tv_us(ru0.ru_utime) +
+             tv_us(ru1.ru_stime) - tv_us(ru0.ru_stime);
+        if (best < 0 || us < best) best = us;
+    }
+    maxrss = ru1.ru_maxrss;
+#ifdef __APPLE__
+    maxrss /= 1024;             /* bytes here, kilobytes elsewhere */
+#endif
+
+    /* The same compile with -zqU (DEBUG_STORE) for the compiler's figures. */
+    zargv = (char **)malloc((argc + 2) * sizeof(char *));
+    if (zargv == NULL) fatal("out of memory", "");
+    zargv[0] = argv[0];
+    zargv[1] = "-zqU";
+    memcpy(zargv + 2, argv + 1, argc * sizeof(char *));
+    remove(log);
+    if (run(zargv, log) != 0) failed = 1;
+
+    printf("%s status %s\n", label, failed ? "failed" : "ok");
+    report(label, "cpu_us", best);
+    report(label, "maxrss_kb", maxrss);
+    parse_log(label, log);
+    remove(log);
+    return failed;
+}
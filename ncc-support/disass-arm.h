@@ -13,6 +13,8 @@
  * limitations under the License.
  */
 
+extern const char *const cond_codes[16];
+
 extern char *emit_mnemonic(char *p, const char *mnem, unsigned cond);
 extern char *append_str(char *p, const char *s);
 
@@ -0,0 +1,407 @@
+/* Copyright 2025 Piers Wombwell
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "globals.h"
+
+#include "disass.h"
+#include "disass-arm.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Thumb (v4T, plus v5T's BLX and BKPT) disassembler, in the same style
+// as the ARM one: upper case, pre-UAL mnemonics, with the callback asked
+// for labels on branches and pc-relative loads and adds. The Thumb-2
+// instructions the compiler generates are decoded too, and instructions
+// in an IT block are shown with their condition.
+
+#define BITS(v,hi,lo) (((v) >> (lo)) & ((1u << ((hi)-(lo)+1)) - 1u))
+
+#define AL 0xEu
+
+static const char *const alu_opnames[16] = {
+    "AND", "EOR", "LSL", "LSR",
+    "ASR", "ADC", "SBC", "ROR",
+    "TST", "NEG", "CMP", "CMN",
+    "ORR", "MUL", "BIC", "MVN"
+};
+
+static char *append_imm(char *p, unsigned32 v)
+{
+    return p + sprintf(p, "#%lu", (unsigned long)v);
+}
+
+static char *append_rr(char *p, unsigned rd, unsigned rs)
+{
+    p = append_core_reg(p, rd);
+    p = append_str(p, ", ");
+    return append_core_reg(p, rs);
+}
+
+// "[Rb, Ro]" or "[Rb, #imm]".
+static char *append_addr(char *p, unsigned rb, bool isreg, unsigned32 x)
+{
+    p = append_str(p, "[");
+    p = append_core_reg(p, rb);
+    p = append_str(p, ", ");
+    if (isreg)
+        p = append_core_reg(p, x);
+    else
+        p = append_imm(p, x);
+    return append_str(p, "]");
+}
+
+static char *append_reglist(char *p, unsigned list, int extra)
+{
+    unsigned r;
+    bool first = true;
+    p = append_str(p, "{");
+    for (r = 0; r < 8; r++)
+        if (list & (1u << r)) {
+            unsigned hi = r;
+            while (hi + 1 < 8 && (list & (1u << (hi + 1)))) hi++;
+            if (!first) p = append_str(p, ", ");
+            p = append_core_reg(p, r);
+            if (hi > r) {
+                p = append_str(p, hi == r + 1 ? ", " : "-");
+                p = append_core_reg(p, hi);
+            }
+            first = false;
+            r = hi;
+        }
+    if (extra >= 0) {
+        if (!first) p = append_str(p, ", ");
+        p = append_core_reg(p, (unsigned)extra);
+    }
+    return append_str(p, "}");
+}
+
+static char *append_target(char *p, unsigned32 target, void *cb_arg, dis_cb_fn cb)
+{
+    if (cb != NULL)
+        return cb(D_BORBL, 0, target, 0, cb_arg, p);
+    return p + sprintf(p, "0x%.8lX", (unsigned long)target);
+}
+
+// ITSTATE (firstcond:mask) of the IT block being disassembled, if any.
+static unsigned it_state;
+
+static unsigned32 thumb_expand_imm(unsigned32 imm12)
+{
+    unsigned32 b = imm12 & 0xffu, rot;
+    if (BITS(imm12, 11, 10) == 0)
+        switch (BITS(imm12, 9, 8)) {
+        case 0:  return b;
+        case 1:  return b << 16 | b;
+        case 2:  return b << 24 | b << 8;
+        default: return b * 0x01010101u;
+        }
+    b = 0x80u | (imm12 & 0x7fu);
+    rot = BITS(imm12, 11, 7);
+    return b >> rot | b << (32 - rot);
+}
+
+// The 32 bit Thumb-2 instructions: false if not one of those known.
+static bool disass_32(unsigned32 instr, unsigned32 instr2, unsigned32 pc,
+                       char *p, unsigned cc, void *cb_arg, dis_cb_fn cb)
+{
+    unsigned rn = BITS(instr, 3, 0), rd = BITS(instr2, 11, 8);
+    unsigned32 imm12 = BITS(instr, 10, 10) << 11 | BITS(instr2, 14, 12) << 8 |
+                       BITS(instr2, 7, 0);
+
+    if ((instr & 0xfa00u) == 0xf000u && !BITS(instr2, 15, 15)) {
+        // data processing, modified immediate
+        static const char *const op[16] = {
+            "AND", "BIC", "ORR", "ORN", "EOR", 0, 0, 0,
+            "ADD", 0, "ADC", "SBC", 0, "SUB", "RSB", 0
+        };
+        unsigned o = BITS(instr, 8, 5);
+        bool s = BITS(instr, 4, 4);
+        const char *m = op[o];
+        if (m == NULL) return false;
+        if (rd == 15 && s && (o == 0 || o == 4 || o == 8 || o == 13)) {
+            static const char *const cmp[4] = { "TST", "TEQ", "CMN", "CMP" };
+            p = emit_mnemonic(p, cmp[o == 13 ? 3 : o / 4], cc);
+            p = append_core_reg(p, rn);
+        } else if (rn == 15 && (o == 2 || o == 3)) {
+            p = emit_mnemonic_with_suffix(p, o == 2 ? "MOV" : "MVN",
+                                          s ? "S.W" : ".W", cc);
+            p = append_core_reg(p, rd);
+        } else {
+            p = emit_mnemonic_with_suffix(p, m, s ? "S.W" : ".W", cc);
+            p = append_rr(p, rd, rn);
+        }
+        p = append_str(p, ", ");
+        append_immediate(p, thumb_expand_imm(imm12));
+        return true;
+    }
+    if ((instr & 0xfa00u) == 0xf200u && !BITS(instr2, 15, 15)) {
+        // plain binary immediate
+        switch (BITS(instr, 8, 4)) {
+        case 0x00: case 0x0a:
+            p = emit_mnemonic(p, BITS(instr, 8, 4) ? "SUBW" : "ADDW", cc);
+            p = append_rr(p, rd, rn);
+            p = append_str(p, ", ");
+            append_imm(p, imm12);
+            return true;
+        case 0x04: case 0x0c:
+            p = emit_mnemonic(p, BITS(instr, 8, 4) == 4 ? "MOVW" : "MOVT", cc);
+            p = append_core_reg(p, rd);
+            p = append_str(p, ", ");
+            append_immediate(p, rn << 12 | imm12);
+            return true;
+        }
+        return false;
+    }
+    if ((instr & 0xf800u) == 0xf000u && (instr2 & 0xd000u) == 0x9000u) {
+        // B.W
+        unsigned32 s = BITS(instr, 10, 10);
+        unsigned32 i1 = !(BITS(instr2, 13, 13) ^ s), i2 = !(BITS(instr2, 11, 11) ^ s);
+        int32 off = (int32)((s << 24 | i1 << 23 | i2 << 22 | BITS(instr, 9, 0) << 12 |
+                             BITS(instr2, 10, 0) << 1) ^ 0x1000000u) - 0x1000000;
+        p = emit_mnemonic_with_suffix(p, "B", ".W", cc);
+        append_target(p, pc + 4 + (unsigned32)off, cb_arg, cb);
+        return true;
+    }
+    if ((instr & 0xf800u) == 0xf000u && (instr2 & 0xd000u) == 0x8000u &&
+        BITS(instr, 9, 6) < AL) {
+        // Bcc.W
+        int32 off = (int32)((BITS(instr, 10, 10) << 20 | BITS(instr2, 11, 11) << 19 |
+                             BITS(instr2, 13, 13) << 18 | BITS(instr, 5, 0) << 12 |
+                             BITS(instr2, 10, 0) << 1) ^ 0x100000u) - 0x100000;
+        p = emit_mnemonic_with_suffix(p, "B", ".W", BITS(instr, 9, 6));
+        append_target(p, pc + 4 + (unsigned32)off, cb_arg, cb);
+        return true;
+    }
+    if ((instr & 0xffd0u) == 0xfb90u && (instr2 & 0xf0f0u) == 0xf0f0u) {
+        p = emit_mnemonic(p, BITS(instr, 5, 5) ? "UDIV" : "SDIV", cc);
+        p = append_rr(p, rd, rn);
+        p = append_str(p, ", ");
+        append_core_reg(p, BITS(instr2, 3, 0));
+        return true;
+    }
+    if ((instr & 0xfff0u) == 0xfb00u && (instr2 & 0x00f0u) <= 0x0010u) {
+        // MLA, MLS (MUL if Ra is pc)
+        bool mls = BITS(instr2, 4, 4);
+        unsigned ra = BITS(instr2, 15, 12);
+        p = emit_mnemonic(p, mls ? "MLS" : ra == 15 ? "MUL" : "MLA", cc);
+        p = append_rr(p, rd, rn);
+        p = append_str(p, ", ");
+        p = append_core_reg(p, BITS(instr2, 3, 0));
+        if (mls || ra != 15) {
+            p = append_str(p, ", ");
+            append_core_reg(p, ra);
+        }
+        return true;
+    }
+    return false;
+}
+
+int32 disass_16(unsigned32 instr, unsigned32 instr2, unsigned32 pc,
+                char *out, void *cb_arg, dis_cb_fn cb)
+{
+    unsigned rd = BITS(instr, 2, 0), rs = BITS(instr, 5, 3);
+    char *p = out;
+    int32 len = 2;
+    unsigned cc = AL;
+
+    instr &= 0xffffu;
+    sprintf(out, "DCW      0x%.4lX", (unsigned long)instr);
+    if (it_state != 0) {
+        cc = it_state >> 4;
+        it_state = (it_state & 7) == 0 ? 0 : (it_state & 0xe0) | ((it_state << 1) & 0x1f);
+    }
+
+    switch (BITS(instr, 15, 13)) {
+    case 0:
+        if (BITS(instr, 12, 11) != 3) {         // shift by immediate
+            static const char *const sh[3] = { "LSL", "LSR", "ASR" };
+            unsigned n = BITS(instr, 10, 6);
+            unsigned op = BITS(instr, 12, 11);
+            if (op == 0 && n == 0) {
+                p = emit_mnemonic(p, "MOV", cc);
+                append_rr(p, rd, rs);
+                break;
+            }
+            p = emit_mnemonic(p, sh[op], cc);
+            p = append_rr(p, rd, rs);
+            p = append_str(p, ", ");
+            append_imm(p, (op != 0 && n == 0) ? 32 : n);
+        } else {                                // ADD/SUB three operand
+            unsigned x = BITS(instr, 8, 6);
+            p = emit_mnemonic(p, BITS(instr, 9, 9) ? "SUB" : "ADD", cc);
+            p = append_rr(p, rd, rs);
+            p = append_str(p, ", ");
+            if (BITS(instr, 10, 10))
+                append_imm(p, x);
+            else
+                append_core_reg(p, x);
+        }
+        break;
+
+    case 1: {                                   // MOV/CMP/ADD/SUB imm8
+        static const char *const op[4] = { "MOV", "CMP", "ADD", "SUB" };
+        p = emit_mnemonic(p, op[BITS(instr, 12, 11)], cc);
+        p = append_core_reg(p, BITS(instr, 10, 8));
+        p = append_str(p, ", ");
+        append_imm(p, BITS(instr, 7, 0));
+        break;
+    }
+
+    case 2:
+        if (BITS(instr, 12, 10) == 0) {         // ALU operations
+            p = emit_mnemonic(p, alu_opnames[BITS(instr, 9, 6)], cc);
+            append_rr(p, rd, rs);
+        } else if (BITS(instr, 12, 10) == 1) {  // hi registers, BX, BLX
+            unsigned op = BITS(instr, 9, 8);
+            unsigned hd = rd | (BITS(instr, 7, 7) << 3);
+            unsigned hs = BITS(instr, 6, 3);
+            if (op == 3) {
+                p = emit_mnemonic(p, BITS(instr, 7, 7) ? "BLX" : "BX", cc);
+                append_core_reg(p, hs);
+            } else {
+                static const char *const hop[3] = { "ADD", "CMP", "MOV" };
+                p = emit_mnemonic(p, hop[op], cc);
+                append_rr(p, hd, hs);
+            }
+        } else if (BITS(instr, 12, 11) == 1) {  // LDR Rd, [pc, #imm]
+            unsigned32 off = BITS(instr, 7, 0) * 4;
+            p = emit_mnemonic(p, "LDR", cc);
+            p = append_core_reg(p, BITS(instr, 10, 8));
+            p = append_str(p, ", ");
+            if (cb != NULL)
+                cb(D_LOADPCREL, (int32)off, ((pc + 4) & ~3u) + off, (int)instr, cb_arg, p);
+            else
+                append_addr(p, 15, false, off);
+        } else {                                // load/store register offset
+            static const char *const op[8] = {
+                "STR", "STRH", "STRB", "LDRSB", "LDR", "LDRH", "LDRB", "LDRSH"
+            };
+            p = emit_mnemonic(p, op[BITS(instr, 11, 9)], cc);
+            p = append_core_reg(p, rd);
+            p = append_str(p, ", ");
+            append_addr(p, rs, true, BITS(instr, 8, 6));
+        }
+        break;
+
+    case 3: {                                   // LDR/STR{B} immediate
+        bool byte = BITS(instr, 12, 12);
+        bool load = BITS(instr, 11, 11);
+        unsigned32 off = BITS(instr, 10, 6) * (byte ? 1 : 4);
+        p = emit_mnemonic(p, load ? (byte ? "LDRB" : "LDR") : (byte ? "STRB" : "STR"), cc);
+        p = append_core_reg(p, rd);
+        p = append_str(p, ", ");
+        append_addr(p, rs, false, off);
+        break;
+    }
+
+    case 4:
+        if (BITS(instr, 12, 12) == 0) {         // LDRH/STRH immediate
+            p = emit_mnemonic(p, BITS(instr, 11, 11) ? "LDRH" : "STRH", cc);
+            p = append_core_reg(p, rd);
+            p = append_str(p, ", ");
+            append_addr(p, rs, false, BITS(instr, 10, 6) * 2);
+        } else {                                // LDR/STR sp-relative
+            p = emit_mnemonic(p, BITS(instr, 11, 11) ? "LDR" : "STR", cc);
+            p = append_core_reg(p, BITS(instr, 10, 8));
+            p = append_str(p, ", ");
+            append_addr(p, 13, false, BITS(instr, 7, 0) * 4);
+        }
+        break;
+
+    case 5:
+        if (BITS(instr, 12, 12) == 0) {         // ADD Rd, pc/sp, #imm
+            unsigned32 off = BITS(instr, 7, 0) * 4;
+            bool adr = !BITS(instr, 11, 11) && cb != NULL;
+            p = emit_mnemonic(p, adr ? "ADR" : "ADD", cc);
+            p = append_core_reg(p, BITS(instr, 10, 8));
+            p = append_str(p, ", ");
+            if (adr)
+                cb(D_ADDPCREL, (int32)off, (pc + 4) & ~3u, (int)instr, cb_arg, p);
+            else {
+                p = append_str(p, BITS(instr, 11, 11) ? "sp, " : "pc, ");
+                append_imm(p, off);
+            }
+        } else if (BITS(instr, 11, 8) == 0) {   // ADD/SUB sp, #imm
+            p = emit_mnemonic(p, BITS(instr, 7, 7) ? "SUB" : "ADD", cc);
+            p = append_str(p, "sp, ");
+            append_imm(p, BITS(instr, 6, 0) * 4);
+        } else if (BITS(instr, 10, 9) == 2) {   // PUSH/POP
+            bool pop = BITS(instr, 11, 11);
+            p = emit_mnemonic(p, pop ? "POP" : "PUSH", cc);
+            append_reglist(p, BITS(instr, 7, 0),
+                           BITS(instr, 8, 8) ? (pop ? 15 : 14) : -1);
+        } else if (BITS(instr, 11, 8) == 0xE) { // BKPT (v5T)
+            p = emit_mnemonic(p, "BKPT", cc);
+            append_imm(p, BITS(instr, 7, 0));
+        } else if (BITS(instr, 11, 8) == 0xF && BITS(instr, 3, 0) != 0) {
+            // IT (Thumb-2)
+            char m[5] = "IT";
+            unsigned firstcond = BITS(instr, 7, 4), mask = BITS(instr, 3, 0);
+            int n = 2;
+            for (; (mask & 7) != 0; mask = (mask << 1) & 0xf)
+                m[n++] = BITS(mask, 3, 3) == (firstcond & 1) ? 'T' : 'E';
+            m[n] = 0;
+            p = emit_mnemonic(p, m, AL);
+            append_str(p, cond_codes[firstcond]);
+            it_state = instr & 0xff;
+        } else if (BITS(instr, 10, 10) == 0 && BITS(instr, 8, 8) == 1) {
+            // CBZ, CBNZ (Thumb-2)
+            unsigned32 off = (BITS(instr, 9, 9) << 6 | BITS(instr, 7, 3)) << 1;
+            p = emit_mnemonic(p, BITS(instr, 11, 11) ? "CBNZ" : "CBZ", AL);
+            p = append_core_reg(p, rd);
+            p = append_str(p, ", ");
+            append_target(p, pc + 4 + off, cb_arg, cb);
+        }
+        break;
+
+    case 6:
+        if (BITS(instr, 12, 12) == 0) {         // LDMIA/STMIA
+            p = emit_mnemonic(p, BITS(instr, 11, 11) ? "LDMIA" : "STMIA", cc);
+            p = append_core_reg(p, BITS(instr, 10, 8));
+            p = append_str(p, "!, ");
+            append_reglist(p, BITS(instr, 7, 0), -1);
+        } else if (BITS(instr, 11, 8) == 0xF) { // SWI
+            p = emit_mnemonic(p, "SWI", cc);
+            append_imm(p, BITS(instr, 7, 0));
+        } else if (BITS(instr, 11, 8) != 0xE) { // Bcc
+            int32 off = (int32)(BITS(instr, 7, 0) ^ 0x80u) - 0x80;
+            p = emit_mnemonic(p, "B", BITS(instr, 11, 8));
+            append_target(p, pc + 4 + (unsigned32)(off * 2), cb_arg, cb);
+        }
+        break;
+
+    case 7:
+        if (BITS(instr, 12, 11) == 0) {         // B
+            int32 off = (int32)(BITS(instr, 10, 0) ^ 0x400u) - 0x400;
+            p = emit_mnemonic(p, "B", cc);
+            append_target(p, pc + 4 + (unsigned32)(off * 2), cb_arg, cb);
+        } else if (disass_32(instr, instr2 & 0xffffu, pc, p, cc, cb_arg, cb)) {
+            len = 4;                            // Thumb-2
+        } else if (BITS(instr, 12, 11) == 2 &&  // BL/BLX pair
+                   (instr2 & 0xe800u) == 0xe800u) {
+            int32 hi = (int32)(BITS(instr, 10, 0) ^ 0x400u) - 0x400;
+            unsigned32 target = pc + 4 + (unsigned32)(hi << 12) +
+                                (BITS(instr2, 10, 0) << 1);
+            bool blx = (instr2 & 0xf800u) == 0xe800u;
+            if (blx) target &= ~3u;
+            p = emit_mnemonic(p, blx ? "BLX" : "BL", cc);
+            append_target(p, target, cb_arg, cb);
+            len = 4;
+        }
+        break;
+    }
+    return len;
+}
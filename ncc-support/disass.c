@@ -63,6 +63,7 @@ static void disass_bx_blx_reg(unsigned32 instr, char *out);
 static void disass_clz(unsigned32 instr, char *out);
 static void disass_mrs(unsigned32 instr, char *out);
 static void disass_msr(unsigned32 instr, char *out);
+static void disass_movw_movt(unsigned32 instr, char *out);
 
 // This only covers classic ARM 32-bit instructions that Norcroft emits:
 // data-processing, single data transfer, branches and SWI.
@@ -684,6 +685,12 @@ void disass(uint64_t w, uint64_t oldq, const char* buf, void *cb_arg, dis_cb_fn
         return;
     }
 
+    /* MOVW / MOVT (v6T2 16-bit immediate moves). */
+    if ((instr & 0x0fb00000u) == 0x03000000u) {
+        disass_movw_movt(instr, out);
+        return;
+    }
+
     /* MRS / MSR (status register moves). */
     if ((instr & 0x0fbf0fffu) == 0x010f0000u) {
         disass_mrs(instr, out);
@@ -990,3 +997,17 @@ static void disass_msr(unsigned32 instr, char *out)
     }
 }
 
+/* ARM 16-bit immediate to register: MOVW / MOVT. */
+static void disass_movw_movt(unsigned32 instr, char *out)
+{
+    unsigned cond = BITS(instr, 31, 28);
+    unsigned top  = BITS(instr, 22, 22);  /* 0 = MOVW, 1 = MOVT */
+    unsigned rd   = BITS(instr, 15, 12);
+    unsigned32 imm = (BITS(instr, 19, 16) << 12) | BITS(instr, 11, 0);
+    char *p = out;
+
+    p = emit_mnemonic(p, top ? "MOVT" : "MOVW", cond);
+    p = append_core_reg(p, rd);
+    p = append_str(p, ", ");
+    p = append_immediate(p, imm);
+}
@@ -37,6 +37,11 @@ typedef char *(*dis_cb_fn)(dis_cb_type type,
 extern void disass(uint64_t w, uint64_t oldq, const char* buf,
                    void *cb_arg, dis_cb_fn cb);
 
+// Thumb: disassembles instr (with instr2, the next halfword, for BL) and
+// returns the length used, 2 or 4.
+extern int32 disass_16(unsigned32 instr, unsigned32 instr2, unsigned32 pc,
+                       char *out, void *cb_arg, dis_cb_fn cb);
+
 extern void disass_sethexprefix(const char* prefix);
 extern void disass_setregnames(const char* regnames[16],
                                const char* fregnames[8]);
@@ -0,0 +1,56 @@
+/* Copyright 2025 Piers Wombwell
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Test harness for ncc/tests, compiled by ncc for the target. armsim
+// provides the functions: each EQ* check prints "FAILED: ..." with the
+// caller when its arguments differ, and EndTest() prints "OK" if none
+// did.
+
+#ifndef testutil_h
+#define testutil_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void BeginTest(void);
+extern void EndTest(void);
+
+extern void EQI(int /*actual*/, int /*expected*/);
+extern void EQU(unsigned /*actual*/, unsigned /*expected*/);
+extern void EQP(const void * /*actual*/, const void * /*expected*/);
+extern void EQD(double /*actual*/, double /*expected*/);
+extern void EQS(const char * /*actual*/, const char * /*expected*/);
+extern void EQLL(long long /*actual*/, long long /*expected*/);
+extern void EQUU(unsigned long long /*actual*/, unsigned long long /*expected*/);
+
+// Floating point status, as the FPA's FPSR: cumulative exception flags
+// in the low byte, trap enables in the third.
+#define __fpsr_IOC  0x00000001
+#define __fpsr_DZC  0x00000002
+#define __fpsr_OFC  0x00000004
+#define __fpsr_IOE  0x00010000
+#define __fpsr_DZE  0x00020000
+#define __fpsr_OFE  0x00040000
+
+// Clear the bits in mask, set those in mask & flags; returns the old
+// status.
+extern unsigned __fp_status(unsigned /*mask*/, unsigned /*flags*/);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,34 @@
+/* Copyright 2025 Piers Wombwell
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// The test harness's internals, for tests that do their own checking.
+
+#ifndef testutili_h
+#define testutili_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void test_fail(void);            // count a failed check
+extern void test_execute(void);         // count a check
+extern int test_isverbose(void);
+extern char *test_name(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
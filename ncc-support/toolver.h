@@ -14,3 +14,5 @@
  */
 
 #define TOOLVER_ARMCC "SDT 2.11a Final"
+#define TOOLVER_TCC   "SDT 2.11a Final"
+#define TOOLVER_TCPP  "SDT 2.11a Final"
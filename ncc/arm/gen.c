@@ -71,6 +71,20 @@ static int32 literal_pool_start;
 static bool in_code;
 static int literal_pool_number;
 
+/* Literal pool placement statistics for the module (reported under     */
+/* localcg_debug(1)): pools which needed a branch round them are the    */
+/* ones to minimise, since they cost an instruction and a pipeline      */
+/* refill each time control passes through them.                       */
+static int32 litpool_count, litpool_bytes, litpool_branched, litpool_tailcall;
+
+/* Literals may be placed after an unconditional tail call just as      */
+/* after an unconditional J_B, since control never falls through.       */
+#define tailcall_dumplits() \
+    do { \
+        if (condition_mask == C_ALWAYS && litpoolp != 0) \
+            litpool_tailcall++, dumplits2(NO); \
+    } while (0)
+
 static LabelNumber *returnlab;
 
 static Symstr *lib_reloc_sym, *mod_reloc_sym;
@@ -1598,6 +1612,7 @@ case J_TAILCALLK:
             outinstr(OP_MOVR | F_RD(R_IP) | R_SB | SCC_of_PEEP(peep));
         routine_exit(C_FROMQ(Q_AL), NO, 0);
         call_k((Symstr *)r3, 1, (k_fltregs_(r2) != 0 ? aof_fpreg : 0), pcs_flags & PCS_REENTRANT);
+        tailcall_dumplits();
         break;
 
 case J_CALLR:
@@ -1665,23 +1680,27 @@ case J_TAILCALLX:
             }
             tailcallxk(r4, Arm_EightBits(r3), iop);
         }
+        tailcall_dumplits();
         break;
 case J_TAILCALLI:
         if (pcs_flags & PCS_INTERWORK) syserr(syserr_interwork);
         ldm_flush();
         bigdisp(&dispdesc, r3, 0xfff, r4);
         tailcallxk(dispdesc.r, dispdesc.m, prepost(op) | F_LDR | dispdesc.u_d | F_WORD);
+        tailcall_dumplits();
         break;
 case J_TAILCALLXR:
         if (pcs_flags & PCS_INTERWORK) syserr(syserr_interwork);
         ldm_flush();
         tailcallxr(r4, r3, ((op & J_NEGINDEX) ? OP_SUBR : OP_ADDR) | msh);
+        tailcall_dumplits();
         illbits &= ~(J_NEGINDEX|J_SHIFTMASK);
         break;
 case J_TAILCALLIR:
         if (pcs_flags & PCS_INTERWORK) syserr(syserr_interwork);
         ldm_flush();
         tailcallxr(r4, r3, OP_LDRR | (op & J_NEGINDEX ? F_DOWN : F_UP) | msh);
+        tailcall_dumplits();
         illbits &= ~(J_NEGINDEX|J_SHIFTMASK);
         break;
 case J_TAILCALLR:
@@ -1699,6 +1718,7 @@ case J_TAILCALLR:
             }
         } else
             tailcallxk(r3, 0, OP_ADDN);
+        tailcall_dumplits();
         break;
 case J_COUNT:
         ldm_flush();
@@ -3296,6 +3316,8 @@ static void describe_literal_pool(void) {
             obj_symref(sym_insert_id(b), xr_code+xr_defloc+xr_dataincode, literal_pool_start);
             sprintf(b, "x$litpool_e$%d", literal_pool_number++);
             obj_symref(sym_insert_id(b), xr_code+xr_defloc+xr_dataincode, codebase+codep-1);
+            litpool_count++;
+            litpool_bytes += codebase+codep-literal_pool_start;
         }
         in_code = YES;
     }
@@ -3667,6 +3689,41 @@ static int32 *load_integer_i(RealRegister r, int32 n, int32 scc, int32 *v)
     }
 }
 
+/* On v6T2 and later any constant can be built with MOVW (and MOVT if    */
+/* the top half is non-zero).  If r is already known to hold a value     */
+/* with the same bottom half, MOVT alone will do.                        */
+static int32 *load_integer_wide(RealRegister r, int32 n, int32 *v)
+{
+    uint32 hi = (uint32)n >> 16, lo = n & 0xffff;
+    if (ValueIsKnown(r) && (KnownValue(r) & 0xffff) == lo)
+        *v++ = OP_MOVT | F_RD(r) | F_IMM16(hi);
+    else {
+        *v++ = OP_MOVW | F_RD(r) | F_IMM16(lo);
+        if (hi != 0) *v++ = OP_MOVT | F_RD(r) | F_IMM16(hi);
+    }
+    return v;
+}
+
+/* Choose the cheapest way of loading n without using the literal pool: */
+/* derivation from a register already holding a related value or a      */
+/* sequence of rotated immediates (load_integer_i), or a MOVW/MOVT pair. */
+/* On a tie the rotated-immediate sequence is kept.  The caller compares */
+/* the result against the cost of a literal load (integer_load_max, -zi) */
+/* N.B. the wide sequence must be built first, since load_integer_i may  */
+/* forget the value known to be in r.                                    */
+static int32 *load_integer_c(RealRegister r, int32 n, int32 scc, int32 *v)
+{
+    int32 w[2], *we = w, *ve;
+    if (target_has_wide_immediates && scc == 0)
+        we = load_integer_wide(r, n, w);
+    ve = load_integer_i(r, n, scc, v);
+    if (we != w && we-w < ve-v) {
+        int32 *p = w;
+        for (ve = v; p != we; p++) *ve++ = *p;
+    }
+    return ve;
+}
+
 static void load_integer_literal(RealRegister r, int32 n) {
     int32 dirn = F_UP;
     int32 i;
@@ -3690,7 +3747,7 @@ static void load_integer(RealRegister r, int32 n, int32 flags)
 {   int32 v[5];  /* Pessimism here about the number of instructions add_integer
                     may decide to generate */
     int32 scc = SCC_of_PEEP (flags);
-    int32 *ve = load_integer_i(r, n, scc, v);
+    int32 *ve = load_integer_c(r, n, scc, v);
     int max = (scc == 0) ? integer_load_max : integer_load_max+1;
     if (ve-v <= max) {
         int32 *p = v;
@@ -3951,7 +4008,7 @@ static void compare_integer(RealRegister r, int32 n, RealRegister workreg,
     int32 v[5], w[5];
     int32 *ve = compare_integer_i(r, n, workreg, mask, when, v);
     unsigned iv = ve - v;
-    int32 *we = load_integer_i(workreg, n, 0, w);
+    int32 *we = load_integer_c(workreg, n, 0, w);
     unsigned iw = we - w + 1;
     if (0 < iv && iv <= integer_load_max+1 && iv <= iw && when == 0)
     {
@@ -5258,6 +5315,7 @@ void branch_round_literals(LabelNumber *m)
     int32 c = condition_mask;
     condition_mask = C_ALWAYS;   /* in case conditional instructions */
     literal_pool_start = codebase+codep+4;
+    litpool_branched++;
     conditional_branch_to(Q_AL, m, NO, 0);
     condition_mask = c;
 }
@@ -5345,6 +5403,7 @@ void mcdep_init(void)
     adconpool_init();
     in_code = YES;
     literal_pool_number = 0;
+    litpool_count = litpool_bytes = litpool_branched = litpool_tailcall = 0;
     localcg_newliteralpool();
     condition_mask = C_ALWAYS;
     if (fpu_type == fpu_amp) {
@@ -5411,6 +5470,12 @@ void localcg_tidy(void)
 {
     dbg_finalise();
     peephole_tidy();
+#ifdef ENABLE_LOCALCG
+    if (localcg_debug(1) || debugging(DEBUG_STORE))
+        cc_msg("literal pools: %ld (%ld bytes), %ld branched round, %ld after tail calls\n",
+               (long)litpool_count, (long)litpool_bytes,
+               (long)litpool_branched, (long)litpool_tailcall);
+#endif
 }
 
 /* End of section arm/gen.c */
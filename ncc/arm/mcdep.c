@@ -34,6 +34,8 @@ FPU_Type fpu_type;
 static int config_mulbits;          /* number of bits per cycle */
 static int config_multime;          /* minimum cycles for MUL */
 static int config_mlatime;          /* minimum cycles for MLA */
+static int config_loadlat;          /* load-use interlock cycles */
+static int config_mullat;           /* multiply result interlock cycles */
 
 typedef struct {
   char const *name;
@@ -124,6 +126,7 @@ int mcdep_toolenv_insertdefaults(ToolEnv *t) {
 }
 
 #define MULSPD(bits, mul, mla) bits, mul, mla
+#define LATENCY(ld, mul) ld, mul
 
 #define ARCH_2  PROCESSOR_HAS_26BIT_MODE
 #define ARCH_3  PROCESSOR_HAS_26BIT_MODE|PROCESSOR_HAS_32BIT_MODE
@@ -131,16 +134,25 @@ int mcdep_toolenv_insertdefaults(ToolEnv *t) {
 #define ARCH_3M ARCH_3|PROCESSOR_HAS_MULTIPLY
 #define ARCH_4  ARCH_3|(PROCESSOR_HAS_MULTIPLY|PROCESSOR_HAS_HALFWORDS)
 #define ARCH_4T ARCH_3|(PROCESSOR_HAS_MULTIPLY|PROCESSOR_HAS_HALFWORDS)|PROCESSOR_HAS_THUMB
-
-static Processor const p_arm6      = {"#ARM6",       ARCH_3,  "#3", MULSPD(2,2,2) };
-static Processor const p_arm7      = {"#ARM7",       ARCH_3,  "#3", MULSPD(2,2,2) };
-static Processor const p_arm7M     = {"#ARM7M",      ARCH_3M, "#3M",MULSPD(8,2,3) };
-static Processor const p_arm7TM    = {"#ARM7TM",     ARCH_4T, "#4T",MULSPD(8,2,3) };
-static Processor const p_arm8      = {"#ARM8",       ARCH_4,  "#4", MULSPD(8,3,3) };
-static Processor const p_strongarm = {"#StrongARM1", ARCH_4,  "#4", MULSPD(12,1,1)};
-static Processor const p_sa1500    = {"#SA1500",     ARCH_4,  "#4", MULSPD(12,1,1)};
-static Processor const p_arm2      = {"#ARM2",       ARCH_2,  "#2", MULSPD(2,2,2) };
-static Processor const p_arm3      = {"#ARM3",       ARCH_2,  "#2", MULSPD(2,2,2) };
+#define ARCH_6T2 ARCH_3G|(PROCESSOR_HAS_MULTIPLY|PROCESSOR_HAS_HALFWORDS)|PROCESSOR_HAS_THUMB|PROCESSOR_HAS_MOVW
+#define ARCH_7  ARCH_6T2
+
+/* LATENCY gives the extra cycles before the result of a load or a      */
+/* multiply can be used without an interlock (see result_latency).      */
+/* XScale is a v5TE part, but we generate v4T code for it.              */
+static Processor const p_arm6      = {"#ARM6",       ARCH_3,  "#3", MULSPD(2,2,2),  LATENCY(0,0) };
+static Processor const p_arm7      = {"#ARM7",       ARCH_3,  "#3", MULSPD(2,2,2),  LATENCY(0,0) };
+static Processor const p_arm7M     = {"#ARM7M",      ARCH_3M, "#3M",MULSPD(8,2,3),  LATENCY(0,0) };
+static Processor const p_arm7TM    = {"#ARM7TM",     ARCH_4T, "#4T",MULSPD(8,2,3),  LATENCY(0,0) };
+static Processor const p_arm8      = {"#ARM8",       ARCH_4,  "#4", MULSPD(8,3,3),  LATENCY(1,0) };
+static Processor const p_arm9TM    = {"#ARM9TM",     ARCH_4T, "#4T",MULSPD(8,2,3),  LATENCY(1,1) };
+static Processor const p_strongarm = {"#StrongARM1", ARCH_4,  "#4", MULSPD(12,1,1), LATENCY(1,2) };
+static Processor const p_sa1500    = {"#SA1500",     ARCH_4,  "#4", MULSPD(12,1,1), LATENCY(1,2) };
+static Processor const p_xscale    = {"#XScale",     ARCH_4T, "#4T",MULSPD(16,1,1), LATENCY(2,2) };
+static Processor const p_arm2      = {"#ARM2",       ARCH_2,  "#2", MULSPD(2,2,2),  LATENCY(0,0) };
+static Processor const p_arm3      = {"#ARM3",       ARCH_2,  "#2", MULSPD(2,2,2),  LATENCY(0,0) };
+static Processor const p_arm1156t2 = {"#ARM1156T2",  ARCH_6T2,"#6T2",MULSPD(32,2,2),LATENCY(2,2) };
+static Processor const p_cortexa8  = {"#CortexA8",   ARCH_7,  "#7", MULSPD(32,2,2), LATENCY(2,2) };
 
 static Processor const *const processors[] = {
   &p_arm6,  /* default: must come first */
@@ -148,17 +160,21 @@ static Processor const *const processors[] = {
   &p_arm7M,
   &p_arm7TM,
   &p_arm8,
+  &p_arm9TM,
   &p_strongarm,
   &p_sa1500,
+  &p_xscale,
   &p_arm2,
   &p_arm3,
+  &p_arm1156t2,
+  &p_cortexa8,
 };
 
 static const char *cistrchr(const char *s, int ch)
 {   char c1 = (char)safe_tolower(ch);
     for (;;)
-    {   char c = safe_tolower(*s++);
-        if (c == c1) return s - 1;
+    {   char c = *s++;              /* safe_tolower evaluates c twice */
+        if (safe_tolower(c) == c1) return s - 1;
         if (c == 0) return 0;
     }
 }
@@ -350,6 +366,12 @@ KW_Status mcdep_keyword(char const *key, char const *nextarg, ToolEnv *t) {
             return KW_OK;
         }
 
+    if (cistreq(key, "-peepstats")) {
+        if (nextarg == NULL) return KW_MISSINGARG;
+        tooledit_insertwithjoin(t, "-peepstats", '=', nextarg);
+        return KW_OKNEXT;
+    }
+
     if (cistreq(key, "-fpu")) {
         if (nextarg == NULL) return KW_MISSINGARG;
         if (cistreq(nextarg, "fpa")) {
@@ -508,6 +530,11 @@ void config_init(ToolEnv *t)
             if (proc->flags & PROCESSOR_HAS_MULTIPLY) config |= CONFIG_LONG_MULTIPLY;
             if (proc->flags & PROCESSOR_HAS_32BIT_MODE) config |= CONFIG_32BIT;
             if (proc->flags & PROCESSOR_HAS_26BIT_MODE) config |= CONFIG_26BIT;
+            if (proc->flags & PROCESSOR_HAS_MOVW) config |= CONFIG_WIDE_IMMEDIATES;
+            /* v6T2 and v7 do not rotate the word for an unaligned LDR,   */
+            /* so the rotated-load idioms for halfwords and signed bytes  */
+            /* must go: use the LDRH/LDRB sequences instead.              */
+            if (proc->flags & PROCESSOR_HAS_MOVW) config |= CONFIG_NO_UNALIGNED_LOADS;
         }
 
         /* processor dependent configuration */
@@ -515,6 +542,8 @@ void config_init(ToolEnv *t)
         config_mulbits = (proc != NULL) ? proc->mulbits : 0;
         config_multime = (proc != NULL) ? proc->multime : 0;
         config_mlatime = (proc != NULL) ? proc->mlatime : 0;
+        config_loadlat = (proc != NULL) ? proc->loadlat : 0;
+        config_mullat = (proc != NULL) ? proc->mullat : 0;
     }
 
     pcs_flags = 0;
@@ -562,7 +591,8 @@ void config_init(ToolEnv *t)
 }
 
 void mcdep_set_options(ToolEnv *t) {
-    IGNORE(t);
+    char const *val = toolenv_lookup(t, "-peepstats");
+    peepstats_file = (val == NULL) ? NULL : &val[1];
 }
 
 
@@ -1432,5 +1462,22 @@ int multiply_cycles(int val, bool accumulate)
             logbase2(val) / config_mulbits;
 }
 
+bool target_has_interlocks(void)
+{
+    return config_loadlat != 0 || config_mullat != 0;
+}
+
+int result_latency(PendingOp const *p)
+{
+    switch (p->ic.op & J_TABLE_BITS) {
+    case J_LDRK: case J_LDRBK: case J_LDRWK:
+    case J_LDRR: case J_LDRBR: case J_LDRWR:
+        return config_loadlat;
+    case J_MULR: case J_MLAR:
+        return config_mullat;
+    default:
+        return 0;
+    }
+}
 
 /* end of arm/mcdep.c */
@@ -214,6 +214,11 @@ extern int32 a_uses_mem(PendingOp const* const p);
 extern int32 a_modifies_mem(PendingOp const* const p);
 extern int32 a_uses_stack(PendingOp const* const p);
 
+/* Extra cycles before the result of p can be used without an interlock */
+/* on the selected -cpu (0 if there is no interlock).                   */
+extern int result_latency(PendingOp const *p);
+extern bool target_has_interlocks(void);
+
 extern bool a_corrupts_r1(PendingOp const* p);
 extern bool a_corrupts_r2(PendingOp const* p);
 
@@ -252,6 +257,8 @@ extern void peephole_reinit(void);
 extern void peephole_init(void);
 extern void peephole_tidy(void);
 
+extern char const *peepstats_file;  /* -peepstats: CSV file, or NULL */
+
 #ifdef TARGET_HAS_AOF
 
 #define  aof_fpreg   xr_objflg1     /* fn passes FP args in FP registers */
@@ -294,10 +301,12 @@ extern unsigned ldm_regs_max;
 #define PROCESSOR_HAS_26BIT_MODE        4
 #define PROCESSOR_HAS_32BIT_MODE        8
 #define PROCESSOR_HAS_THUMB            16
+#define PROCESSOR_HAS_MOVW             32  /* MOVW/MOVT (v6T2 and later) */
 
 typedef struct
-{   char name[16]; Uint flags; char arch[4];
+{   char name[16]; Uint flags; char arch[6];
     char mulbits, multime, mlatime;
+    char loadlat, mullat;
 } Processor;
 Processor const *LookupProcessor(char const *name);
 Processor const *LookupArchitecture(char const *name);
@@ -13,6 +13,8 @@
  */
 
 #include <string.h>
+#include <stdio.h>
+#include <time.h>
 
 #include "globals.h"
 #include "mcdep.h"
@@ -25,6 +27,7 @@
 #include "errors.h"
 #include "cg.h"        /* for procflags, greatest_stackdepth */
 #include "regalloc.h"  /* regmask */
+#include "peepstat.h"
 #include "builtin.h"
 #include "inlnasm.h"
 
@@ -371,6 +374,15 @@ extern int Profiler_Count_Index;
 int Profiler_Count_Index_Max = PeepholeMax;
 int Profiler_Count_Index;
 
+/* -peepstats <file>: per-pattern hit/miss counts, accumulated into a CSV */
+/* file by peepstats_write() (armthumb/peepstat.c).                        */
+
+char const *peepstats_file;
+
+#define PEEP_INSTBYTES 4  /* bytes per instruction, for the saving column */
+
+static PeepStat p_stats[PeepholeMax+1];
+
 #ifdef ENABLE_LOCALCG
 
 static int32 p_count[PeepholeMax+1];
@@ -1125,8 +1137,271 @@ static bool MayMatch(PendingOp *ops[], PeepOp const peepops[],
   return YES;
 }
 
+static bool TimedMayMatch(PendingOp *ops[], PeepOp const peepops[],
+                          PeepHole const *ph, int n, RegisterUsage *u) {
+  PeepStat *ps;
+  PeepTicks t0;
+  bool res;
+  if (peepstats_file == NULL) return MayMatch(ops, peepops, ph, n, u);
+  ps = &p_stats[ph - patterns];
+  t0 = peepstats_ticks();
+  res = MayMatch(ops, peepops, ph, n, u);
+  ps->mayticks += peepstats_ticks() - t0;
+  ps->maycalls++;
+  return res;
+}
+
+/* Before pending ops are passed to the code generator, word loads (and */
+/* stores) from the same base register are moved together where that is */
+/* safe, so that ldm_outinstr in gen.c sees them consecutively and can   */
+/* form an LDM (STM).  It gives up as soon as an op of the group would   */
+/* have to cross anything other than simple arithmetic or a memory       */
+/* access it provably cannot conflict with.                              */
+
+static bool ClusterCandidate(PendingOp const *p) {
+  int32 base = p->ic.r2.rr;
+  if (p->ic.op != J_LDRK+J_ALIGN4 && p->ic.op != J_STRK+J_ALIGN4) return NO;
+  if ((p->peep & (P_PRE|P_POST|P_TRANS)) || p->cond != Q_AL) return NO;
+  if (p->ic.r3.i < -0xfff || p->ic.r3.i > 0xfff) return NO;
+  /* avoid anything used as a scratch register by gen.c's expansions    */
+  if (p->ic.r1.rr == R_IP || p->ic.r1.rr == R_SP || p->ic.r1.rr == R_PC ||
+      base == R_IP || base == R_PC)
+    return NO;
+  return !(loads_r1(p->ic.op) && p->ic.r1.rr == base);
+}
+
+static int32 AccessSize(J_OPCODE op) {
+  /* Unaligned and halfword accesses may be expanded using scratch      */
+  /* registers, so only single-instruction accesses are considered.    */
+  switch (op & J_TABLE_BITS) {
+  case J_LDRBK: case J_STRBK: return 1;
+  case J_LDRK:  case J_STRK:  return j_aligned(op, J_ALIGN4) ? 4 : 0;
+  default:                    return 0;
+  }
+}
+
+static bool IsSimpleArithmetic(J_OPCODE op) {
+  switch (op & J_TABLE_BITS) {
+  case J_MOVK: case J_MOVR: case J_CMPK: case J_CMPR:
+  case J_ANDK: case J_ANDR: case J_ORRK: case J_ORRR:
+  case J_EORK: case J_EORR: case J_ADDK: case J_ADDR:
+  case J_SUBK: case J_SUBR: case J_RSBK: case J_RSBR:
+  case J_MULK: case J_MULR: case J_MLAR: case J_NEGR: case J_NOTR:
+  case J_SHLK: case J_SHLR: case J_SHRK: case J_SHRR:
+  case J_RORK: case J_RORR: case J_ADCON: case J_STRING:
+    return YES;
+  default:
+    return NO;
+  }
+}
+
+/* Ops which may be reordered at all: unconditional, no writeback, and   */
+/* not altering SP (moving memory accesses across a stack adjustment is  */
+/* unsafe if an interrupt could then use the space below SP).            */
+static bool IsReorderable(PendingOp const *x) {
+  RegisterUsage u;
+  if (x->cond != Q_AL || (x->peep & (P_PRE|P_POST|P_TRANS))) return NO;
+  if (!IsSimpleArithmetic(x->ic.op) && AccessSize(x->ic.op) == 0) return NO;
+  u.use = u.def = 0;
+  AccumulateRegisterUse(&u, (PendingOp *)x, aru_updatekills);
+  return !(u.def & regbit(R_SP));
+}
+
+/* Whether memory accesses x and y (at least one a store) may conflict.  */
+/* Offsets are only comparable if the base is not altered between them. */
+static bool MemoryConflict(PendingOp const *x, PendingOp const *y) {
+  int32 xoff = x->ic.r3.i, yoff = y->ic.r3.i;
+  if ((x->ic.op | y->ic.op) & J_VOLATILE) return YES;
+  if (x->ic.r2.rr != y->ic.r2.rr) return YES;
+  return !(xoff + AccessSize(x->ic.op) <= yoff ||
+           yoff + AccessSize(y->ic.op) <= xoff);
+}
+
+static bool CanMoveAbove(PendingOp const *p, PendingOp const *x) {
+  J_OPCODE op = x->ic.op & J_TABLE_BITS;
+  if (!IsReorderable(x)) return NO;
+  if (IsSimpleArithmetic(op)) return YES;
+  if (reads_mem(op) && loads_r1(p->ic.op) && !(x->ic.op & J_VOLATILE))
+    return YES;
+  return !MemoryConflict(p, x);
+}
+
+static void ClusterLoadsAndStores(PendingOp *first, PendingOp *last) {
+  PendingOp *p;
+  for (p = first+1; p <= last; p++) {
+    PendingOp *q;
+    RegisterUsage u;
+    int32 needs;
+    if (!ClusterCandidate(p)) continue;
+    u.use = u.def = 0;
+    for (q = p-1; q >= first; q--) {
+      if (q->ic.op == J_NOOP) continue;
+      if (ClusterCandidate(q) && q->ic.op == p->ic.op && q->ic.r2.rr == p->ic.r2.rr)
+        break;
+      if (!CanMoveAbove(p, q)) { q = first-1; break; }
+      AccumulateRegisterUse(&u, q, aru_updatekills);
+    }
+    if (q < first || q == p-1) continue;
+    /* p may not be moved above a definition of any register it reads,   */
+    /* nor (for a load) above any reference to the register it sets.  A   */
+    /* register p marks as dead must not be read by an op it moves above.*/
+    needs = regbit(p->ic.r2.rr) | (loads_r1(p->ic.op) ? 0 : regbit(p->ic.r1.rr));
+    if (u.def & needs) continue;
+    if (loads_r1(p->ic.op) && ((u.use | u.def) & regbit(p->ic.r1.rr))) continue;
+    if ((p->dataflow & J_DEAD_R1) && (u.use & regbit(p->ic.r1.rr))) continue;
+    if ((p->dataflow & J_DEAD_R2) && (u.use & regbit(p->ic.r2.rr))) continue;
+    { PendingOp temp, *r;
+      temp = *p;
+      for (r = p; r > q+1; r--) *r = *(r-1);
+      *r = temp;
+      if (localcg_debug(4)) {
+        cc_msg("-- ldm cluster: moved up %d\n", (int)(p - r));
+        a_pr_jopcode(r);
+      }
+    }
+  }
+}
+
+/* A list scheduler for the ops about to be flushed, run only when the  */
+/* selected -cpu has load-use or multiply interlocks (result_latency).  */
+/* Runs of reorderable ops are scheduled separately; anything else      */
+/* (including a label, branch, call or J_CONDEXEC) keeps its place.      */
+/* Dependencies are register def/use (including the PSR and IP, which  */
+/* gen.c may use as a scratch register when expanding an op), memory    */
+/* accesses which may conflict, and dead bits: an op marking a register */
+/* dead must stay after every other reader of it.  Priority is the      */
+/* latency-weighted height in the dependency graph; ties keep the       */
+/* original order.                                                      */
+
+#define SchedMax PendingStackSize
+
+/* Whether gen.c may need IP as a scratch register to expand p: for a  */
+/* constant operand which doesn't fit the instruction (conservatively,  */
+/* allowing only the complemented/negated forms MOV/AND/ADD/SUB/CMP     */
+/* have), or an offset out of range.                                    */
+static bool UsesScratch(PendingOp const *p) {
+  J_OPCODE op = p->ic.op & J_TABLE_BITS;
+  int32 n = p->ic.r3.i;
+  if (AccessSize(op) != 0) return n < -0xfff || n > 0xfff;
+  switch (op) {
+  case J_MULK: case J_ADCON: case J_STRING:
+    return YES;
+  case J_MOVK: case J_ANDK:
+    return Arm_EightBits(n) < 0 && Arm_EightBits(~n) < 0;
+  case J_ADDK: case J_SUBK: case J_CMPK:
+    return Arm_EightBits(n) < 0 && Arm_EightBits(-n) < 0;
+  case J_ORRK: case J_EORK: case J_RSBK:
+    return Arm_EightBits(n) < 0;
+  default:
+    return NO;
+  }
+}
+
+static void SchedUsage(PendingOp const *p, RegisterUsage *u) {
+  u->use = u->def = 0;
+  AccumulateRegisterUse(u, (PendingOp *)p, aru_updatekills);
+  if (UsesScratch(p)) u->use |= regbit(R_IP), u->def |= regbit(R_IP);
+}
+
+/* Whether q directly follows p in a run which gen.c's ldm_outinstr   */
+/* would turn into an LDM (STM): the scheduler keeps such runs intact. */
+static bool LdmPair(PendingOp const *p, PendingOp const *q) {
+  return q->ic.op == p->ic.op && AccessSize(q->ic.op) == 4 &&
+         q->ic.r2.rr == p->ic.r2.rr && q->ic.r3.i == p->ic.r3.i + 4 &&
+         !(loads_r1(p->ic.op) && p->ic.r1.rr == p->ic.r2.rr);
+}
+
+static bool ScheduleRun(PendingOp *first, int n) {
+  PendingOp ops[SchedMax];
+  RegisterUsage u[SchedMax];
+  uint32 pred[SchedMax];
+  int32 delay[SchedMax], height[SchedMax], ready[SchedMax];
+  int order[SchedMax];
+  bool glued[SchedMax];
+  int i, j, k, cycle;
+  uint32 done = 0;
+  bool moved = NO;
+  for (i = 0; i < n; i++) {
+    ops[i] = first[i];
+    SchedUsage(&ops[i], &u[i]);
+    delay[i] = 1 + result_latency(&ops[i]);
+  }
+  for (j = 0; j < n; j++) {
+    int32 deadregs = 0, basedefd = 0;
+    if (ops[j].dataflow & J_DEAD_R1) deadregs |= regbit(ops[j].ic.r1.rr);
+    if (ops[j].dataflow & J_DEAD_R2) deadregs |= regbit(ops[j].ic.r2.rr);
+    if (ops[j].dataflow & J_DEAD_R3) deadregs |= regbit(ops[j].ic.r3.rr);
+    if (ops[j].dataflow & J_DEAD_R4) deadregs |= regbit(ops[j].ic.r4.rr);
+    pred[j] = 0;
+    for (i = j-1; i >= 0; i--) {
+      J_OPCODE opi = ops[i].ic.op, opj = ops[j].ic.op;
+      if ((u[i].def & (u[j].use | u[j].def)) || (u[i].use & (u[j].def | deadregs)))
+        pred[j] |= 1L << i;
+      else if (AccessSize(opi) != 0 && AccessSize(opj) != 0 &&
+               (writes_mem(opi & J_TABLE_BITS) || writes_mem(opj & J_TABLE_BITS)) &&
+               ((basedefd & regbit(ops[j].ic.r2.rr)) || MemoryConflict(&ops[i], &ops[j])))
+        pred[j] |= 1L << i;
+      basedefd |= u[i].def;
+    }
+  }
+  /* An op glued to its predecessor is scheduled straight after it: it  */
+  /* depends on it, and its other dependencies are hoisted onto it.     */
+  for (j = n; --j >= 0; ) {
+    glued[j] = j > 0 && LdmPair(&ops[j-1], &ops[j]);
+    if (glued[j]) {
+      pred[j] |= 1L << (j-1);
+      pred[j-1] |= pred[j] & ~(1L << (j-1));
+    }
+  }
+  for (i = n; --i >= 0; ) {
+    height[i] = delay[i];
+    for (j = i+1; j < n; j++)
+      if ((pred[j] & (1L << i)) && delay[i] + height[j] > height[i])
+        height[i] = delay[i] + height[j];
+  }
+  for (cycle = 0, k = 0; k < n; k++, cycle++) {
+    int best = -1, next = -1;
+    int32 bestready = 0;
+    if (k > 0 && order[k-1]+1 < n && glued[order[k-1]+1]) next = order[k-1]+1;
+    for (j = 0; j < n; j++) {
+      int32 r = 0;
+      if ((done & (1L << j)) || (pred[j] & ~done)) continue;
+      if (next >= 0 && j != next) continue;
+      for (i = 0; i < j; i++)
+        if ((pred[j] & (1L << i)) && ready[i] + ((u[i].def & u[j].use) ? delay[i] : 1) > r)
+          r = ready[i] + ((u[i].def & u[j].use) ? delay[i] : 1);
+      if (r < cycle) r = cycle;
+      if (best < 0 || r < bestready ||
+          (r == bestready && height[j] > height[best])) {
+        best = j; bestready = r;
+      }
+    }
+    cycle = bestready;
+    ready[best] = cycle;
+    done |= 1L << best;
+    order[k] = best;
+    if (best != k) moved = YES;
+  }
+  if (moved)
+    for (k = 0; k < n; k++) first[k] = ops[order[k]];
+  return moved;
+}
+
+static void ScheduleOps(PendingOp *first, PendingOp *last) {
+  PendingOp *p = first;
+  while (p <= last) {
+    PendingOp *q = p;
+    while (q <= last && (q->ic.op == J_NOOP || IsReorderable(q))) q++;
+    if (q - p > 2 && ScheduleRun(p, (int)(q - p)) && localcg_debug(4))
+      cc_msg("-- scheduled %d ops\n", (int)(q - p));
+    p = q+1;
+  }
+}
+
 static void flush_pending(int leave)
 { PendingOp *p = &pendingstack[0];
+  if (target_has_interlocks()) ScheduleOps(p, pending-leave);
+  if (var_ldm_enabled != 0) ClusterLoadsAndStores(p, pending-leave);
   for (; p <= pending-leave; p++)
     if (p->ic.op != J_NOOP)
       show_inst_direct(p);
@@ -1225,6 +1500,7 @@ retry:
     peepix = peepv[pat];
     curpeep = &patterns[peepix];
     Profiler_Count_Index = peepix;
+    if (peepstats_file != NULL) p_stats[peepix].tried++;
     peepops = curpeep->insts;
     use.def = use.use = 0;
     depth = 0;
@@ -1238,7 +1514,7 @@ retry:
         dummy[depth-matched-1].dataflow = 0;
       } else {
         if (matched++ != 0) break;
-        if (!MayMatch(ops+1, peepops, curpeep, depth, &use))
+        if (!TimedMayMatch(ops+1, peepops, curpeep, depth, &use))
           goto next_pattern;
         ops[++depth] = cur;
       }
@@ -1254,7 +1530,7 @@ retry:
          pending - prev < PeepholeWindowSize;
          prev--) {
       (ops+1)[depth] = prev;
-      if (MayMatch(ops+1, peepops, curpeep, depth, &use)) {
+      if (TimedMayMatch(ops+1, peepops, curpeep, depth, &use)) {
         if (++depth == curpeep->instcount)
           goto peephole_found;
         if (depth == MaxInst) syserr(syserr_bad_maxinst);
@@ -1288,9 +1564,11 @@ peephole_found:
     PendingOp opcopy[MaxInst];
     PendingOp *opp[MaxInst+1];
     int d;
+    bool altered = NO;
 #ifdef ENABLE_LOCALCG
     p_count[peepix]++;
 #endif
+    if (peepstats_file != NULL) p_stats[peepix].matched++;
     if (depth > second)
       for (d = 0; d < depth; d++) {
         PendingOp *op = (ops+1)[d];
@@ -1306,8 +1584,15 @@ peephole_found:
     }
     for (d = depth; --d >= 0; ) {
       PendingOp *op = (ops+1)[d];
+      bool wasop = op->ic.op != J_NOOP;
       if (UpdateOp(op, opp+1, curpeep,
                    peepops[d].replacecount, peepops[d].replaceix, &use, NO) & Op_Altered) {
+        if (peepstats_file != NULL) {
+          PeepStat *ps = &p_stats[peepix];
+          if (!altered) ps->applied++;
+          ps->instssaved += (int32)wasop - (int32)(op->ic.op != J_NOOP);
+        }
+        altered = YES;
         if (d == 0) {
           if (op->ic.op != J_NOOP) {
             pat = peepix;
@@ -1382,10 +1667,13 @@ void peephole_reinit(void) {
 }
 
 void peephole_init(void) {
-#ifdef ENABLE_LOCALCG
   int i;
+#ifdef ENABLE_LOCALCG
   for (i = 0; i <= PeepholeMax; i++) p_count[i] = 0;
 #endif
+  for (i = 0; i <= PeepholeMax; i++)
+    memset(&p_stats[i], 0, sizeof(PeepStat));
+  if (peepstats_file != NULL) peepstats_start();
 }
 
 void peephole_tidy(void) {
@@ -1397,4 +1685,6 @@ void peephole_tidy(void) {
         cc_msg("{%3d}%6ld\n", i+1, p_count[i]);
   }
 #endif
+  if (peepstats_file != NULL)
+    peepstats_write(peepstats_file, p_stats, PeepholeMax, PEEP_INSTBYTES);
 }
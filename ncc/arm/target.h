@@ -42,6 +42,12 @@
 
 #define TARGET_HAS_DATA_VTABLES         1
 #define target_has_data_vtables         (!pcrel_vtables) /* should this be in PCS? */
+/* A data vtable entry is one address.  (A pc-relative one is one B, so */
+/* 4 suits both: mip/defaults.h's 12 makes cg.c plant J_ORGs, and then */
+/* flowgraf.c lays out a branch table whatever -zpu says.)              */
+#ifndef TARGET_VTAB_ELTSIZE
+#  define TARGET_VTAB_ELTSIZE           4
+#endif
 
 #ifndef NO_DEBUGGER
 #  define TARGET_HAS_DEBUGGER           1
@@ -79,6 +85,7 @@ extern bool arm_shiftop_allowed(int32 n, int32 m, int32 signedness, int32 op);
 #define TARGET_LACKS_RR_HALFWORD_STORE          1
 
 #define target_has_halfword_support      (config & CONFIG_HALFWORD_SPT)
+#define target_has_wide_immediates       (config & CONFIG_WIDE_IMMEDIATES)
 
 #define target_lacks_halfword_store      \
     ((config & (CONFIG_NO_HALFWORD_STORES|CONFIG_HALFWORD_SPT)) != CONFIG_HALFWORD_SPT)
@@ -166,6 +173,7 @@ extern char *target_asm_options(ToolEnv *);
 #ifdef TARGET_HAS_AOF
 #  define TARGET_HAS_ADCON_AREA 1
 #  define TARGET_HAS_MULTIPLE_CODE_AREAS 1
+#  define TARGET_HAS_DATA_BLOCKS 1
 #  define TARGET_DEBUGGER_WANTS_MACROS 1
 #endif
 
@@ -47,6 +47,79 @@ static bool byte_reversing = 0;
     /* byte_reversing == (host_lsbytefirst != target_lsbytefirst).        */
     /* (But faster to test one static per word than 2 externs per word).  */
 
+/* The object file is assembled in memory and written out in one go by  */
+/* obj_trailer().  Relocation indices which are unknown when a code area */
+/* is written, and the chunk file header, are then patched in store      */
+/* rather than by repositioning objstream.  All chunks but the last are */
+/* full, so a file offset maps directly onto a chunk and an index.      */
+
+#define OBJBUF_CHUNKSIZE 0x4000L
+
+typedef struct ObjBufChunk ObjBufChunk;
+struct ObjBufChunk {
+    ObjBufChunk *cdr;
+    int32 used;
+    uint8 b[OBJBUF_CHUNKSIZE];
+};
+
+static ObjBufChunk *objbuf_head, *objbuf_cur;
+static int32 objbuf_off;        /* write position within objbuf_cur   */
+static int32 objbuf_size;       /* total bytes in the buffer          */
+
+static void objbuf_init(void)
+{   objbuf_head = objbuf_cur = NULL;
+    objbuf_off = objbuf_size = 0;
+}
+
+static void objbuf_write(void const *buff, int32 len)
+{   uint8 const *p = (uint8 const *)buff;
+    while (len > 0)
+    {   int32 k;
+        if (objbuf_cur == NULL || objbuf_off == OBJBUF_CHUNKSIZE)
+        {   ObjBufChunk *c = objbuf_cur == NULL ? objbuf_head :
+                                                  objbuf_cur->cdr;
+            if (c == NULL)
+            {   c = (ObjBufChunk *)GlobAlloc(SU_Other, sizeof(ObjBufChunk));
+                c->cdr = NULL, c->used = 0;
+                if (objbuf_cur == NULL) objbuf_head = c;
+                else objbuf_cur->cdr = c;
+            }
+            objbuf_cur = c, objbuf_off = 0;
+        }
+        k = OBJBUF_CHUNKSIZE - objbuf_off;
+        if (k > len) k = len;
+        memcpy(&objbuf_cur->b[objbuf_off], p, (size_t)k);
+        p += k, len -= k, objbuf_off += k;
+        if (objbuf_off > objbuf_cur->used)
+        {   objbuf_size += objbuf_off - objbuf_cur->used;
+            objbuf_cur->used = objbuf_off;
+        }
+    }
+}
+
+static int32 obj_tell(void)
+{   if (debugging(DEBUG_OBJ)) return obj_fwrite_cnt;
+    return objbuf_size;
+}
+
+/* Subsequent writes overwrite the buffer from file offset pos.          */
+static void obj_seek(int32 pos)
+{   ObjBufChunk *c = objbuf_head;
+    if (debugging(DEBUG_OBJ)) { obj_fwrite_cnt = pos; return; }
+    while (pos > OBJBUF_CHUNKSIZE) c = c->cdr, pos -= OBJBUF_CHUNKSIZE;
+    objbuf_cur = c, objbuf_off = pos;
+}
+
+static void obj_flush(FILE *f)
+{   ObjBufChunk *c;
+    if (debugging(DEBUG_OBJ)) return;
+    for (c = objbuf_head; c != NULL; c = c->cdr)
+        fwrite(c->b, 1, (size_t)c->used, f);
+    objbuf_init();
+}
+
+#define OBJ_REVBUFWORDS 256
+
 static void obj_fwrite(void const *buff, int32 n, int32 m, FILE *f)
 {   if (debugging(DEBUG_OBJ))
     {   int32 i;
@@ -57,31 +130,41 @@ static void obj_fwrite(void const *buff, int32 n, int32 m, FILE *f)
         fprintf(f, "\n");
     }
     else if (n == 4 && byte_reversing)
-    {   /* word by word output */
-        uint32 const *p;
-        for (p = (uint32 const *)buff;  m > 0;  --m, ++p)
-        {   uint32 w, v = *p;
+    {   /* reversed a buffer at a time */
+        uint32 const *p = (uint32 const *)buff;
+        uint32 w[OBJ_REVBUFWORDS];
+        while (m > 0)
+        {   int32 i, k = m < OBJ_REVBUFWORDS ? m : OBJ_REVBUFWORDS;
+            for (i = 0; i < k; i++)
+            {   uint32 v = p[i];
         /* Amazingly, this generates better code on an ARM than the more  */
         /* obvious and transparent way to reverse the bytes. A future cse */
         /* may turn the simulations of ROR into ROR, giving optimal code. */
         /* t = v^(v ROR 16); t &= ~0xff0000; v = v ROR 8; v = v^(t >> 8). */
-            uint32 t = v ^ ((v << 16) | (v >> 16));        /* ...v ROR 16 */
-            t &= ~0xff0000;
-            v = (v << 24) | (v >> 8);                      /* v = v ROR 8 */
-            w = v ^ (t >> 8);
-            fwrite(&w, 4, 1, f);
+                uint32 t = v ^ ((v << 16) | (v >> 16));    /* ...v ROR 16 */
+                t &= ~0xff0000;
+                v = (v << 24) | (v >> 8);                  /* v = v ROR 8 */
+                w[i] = v ^ (t >> 8);
+            }
+            objbuf_write(w, k*4);
+            p += k, m -= k;
         }
     }
-    else if (n == 2 && byte_reversing) {
-        uint16 const *p;
-        for (p = (uint16 const *)buff; m > 0; --m, ++p) {
-            uint16 v = *p;
-            v = (v >> 8) | (v << 8);
-            fwrite(&v, 2, 1, f);
+    else if (n == 2 && byte_reversing)
+    {   uint16 const *p = (uint16 const *)buff;
+        uint16 h[2*OBJ_REVBUFWORDS];
+        while (m > 0)
+        {   int32 i, k = m < 2*OBJ_REVBUFWORDS ? m : 2*OBJ_REVBUFWORDS;
+            for (i = 0; i < k; i++)
+            {   uint16 v = p[i];
+                h[i] = (uint16)((v >> 8) | (v << 8));
+            }
+            objbuf_write(h, k*2);
+            p += k, m -= k;
         }
     }
     else
-        fwrite(buff, (size_t)n, (size_t)m, f);
+        objbuf_write(buff, n*m);
 }
 
 #ifdef TARGET_HAS_HALFWORD_INSTRUCTIONS
@@ -249,6 +332,7 @@ void obj_common_start(Symstr *name)
     {   p = (CommonDef *) GlobAlloc(SU_Data, sizeof(CommonDef));
         p->next = NULL;
         p->data.head = p->data.tail = NULL; p->data.size = 0;
+        p->data.blockfree = 0;
         p->name = name; p->index = i;
         setcurcommon(p);
         *q = p;
@@ -373,7 +457,11 @@ static void obj_outsymtab(void)
         if (!(x->extflags & OBJ_DELETED))
             obj_fwrite(symname_(s), 1, (int32)strlen(symname_(s))+1, objstream);
     }
-    while (stringpos & 3) {putc(0, objstream);  ++stringpos;}
+    if (stringpos & 3)
+    {   static char const pad[4] = {0, 0, 0, 0};
+        obj_fwrite(pad, 1, 4 - (stringpos & 3), objstream);
+        stringpos = (stringpos + 3) & ~3;
+    }
     obj_stringpos = stringpos;
 }
 
@@ -420,7 +508,7 @@ typedef struct RelocationPatch RelocationPatch;
 
 struct RelocationPatch {
     RelocationPatch *cdr;
-    long fpos;
+    int32 fpos;
     Symstr *sym;
     int32 flags;
 };
@@ -484,7 +572,7 @@ default:
         if (p != NULL) {
           obj_fwrite(&r.rel_offset, 4, 1, objstream);
           cdr_(p) = relocationpatches;
-          p->fpos = ftell(objstream);
+          p->fpos = obj_tell();
           p->sym = s;
           p->flags = r.rel_flags;
           relocationpatches = p;
@@ -523,6 +611,9 @@ static void obj_writedata(DataInit *p)
     {   case LIT_LABEL:   /* name only present for c.armasm */
             break;
         default:  syserr(syserr_obj_gendata, (long)sort);
+        case LIT_BYTES:   /* already in target sex */
+            obj_fwrite((void const *)ptrval, 1, len, objstream);
+            break;
         case LIT_BXXX:    /* The following are the same as LIT_NUMBER       */
         case LIT_BBX:     /* for cross-sex compilation                      */
         case LIT_BBBX:
@@ -834,6 +925,7 @@ Symstr *obj_notedebugarea(char const *name)
 void obj_init(void)
 {
     debugareas = NULL; debugareas_tail = &debugareas;
+    objbuf_init();
     ncommonareas = ncodeareas = nareas = 0;
     codeareasize = 0, ndatarelocs = 0, nadconrelocs = 0;
     obj_stringpos = 0, obj_symcount = 0, aof_hdr_offset = 0;
@@ -924,7 +1016,7 @@ static void obj_cf_header(int32 areachunk_size)
     cfe[4].cfe_offset = offset;
     cfe[4].cfe_size   = obj_stringpos;
 
-    obj_fwrite_cnt = 0;
+    obj_seek(0);
     obj_fwrite(space, 4, sizeof(space)/4, objstream);
 }
 
@@ -1107,14 +1199,14 @@ void obj_trailer(void)
     }
 #endif
     if (relocationpatches != NULL)
-    {   long fpos = ftell(objstream);
+    {   int32 fpos = obj_tell();
         RelocationPatch *p;
         for (p = relocationpatches; p != NULL; p = cdr_(p)) {
-            fseek(objstream, p->fpos, SEEK_SET);
+            obj_seek(p->fpos);
             p->flags |= obj_checksym(p->sym);
             obj_fwrite(&p->flags, 4, 1, objstream);
         }
-        fseek(objstream, fpos, SEEK_SET);
+        obj_seek(fpos);
     }
     area_siz = codeareasize;
     if (debugging(DEBUG_OBJ)) cc_msg("writedata\n");
@@ -1157,21 +1249,15 @@ void obj_trailer(void)
     if (debugging(DEBUG_OBJ)) cc_msg("symtab\n");
     obj_fwrite(CC_BANNER, 1, CC_BANNERlen, objstream);
     obj_outsymtab();
-    aof_hdr_offset = ftell(objstream);
+    aof_hdr_offset = obj_tell();
     obj_aof_header();
-    if (debugging(DEBUG_OBJ)) cc_msg("rewind\n");
-/* It is (unexpectedly) vital to use fseek here rather than rewind, since  */
-/* rewind clears error flags. Note further that if there is a partially    */
-/* full buffer just before the rewind & flushing that data causes an error */
-/* (e.g. because there is no room on disc for it) this error seems to get  */
-/* lost. This looks to me like a shambles in the October 1986 ANSI draft!  */
-    fseek(objstream, 0L, SEEK_SET);   /* works for hex format too */
+    if (debugging(DEBUG_OBJ)) cc_msg("rewriting header\n");
+    obj_cf_header(area_siz);/* re-write header at top of buffer */
+    obj_flush(objstream);
 /* The next line represents a balance between neurotic overchecking and    */
 /* the fact that it would be nice to detect I/O errors before the end of   */
 /* compilation.                                                            */
     if (ferror(objstream)) cc_fatalerr(obj_fatalerr_io_object);
-    if (debugging(DEBUG_OBJ)) cc_msg("rewriting header\n");
-    obj_cf_header(area_siz);/* re-write header at top of file */
     /* file now closed in main() where opened */
 }
 
@@ -107,6 +107,10 @@
 #define OP_SWP      0x01000090L
 #define OP_SWPB     0x01400090L
 
+#define OP_MOVW     0x03000000L     /* v6T2: Rd = imm16                  */
+#define OP_MOVT     0x03400000L     /* v6T2: Rd[31:16] = imm16           */
+#define F_IMM16(n)  ((((n) & 0xf000L) << 4) | ((n) & 0x0fffL))
+
 #define OP_CDP      0x0E000000L
 #define OP_MRC      0x0E100010L
 #define OP_MCR      0x0E000010L
@@ -24,6 +24,7 @@ cannot alter your program to avoid this failure, please contact your supplier\n"
 #define mcdep_warn_fpinconsistent \
         "Software floating point inconsistent with FPE2/3 and FPREGARGS"
 #define gen_warn_Lisp "Lisp-support stack push needed %ld"
+#define peep_warn_statsfile "couldn't write peephole statistics to '%s'"
 #define gen_err_swi "SWI number 0x%x too large"
 #define gen_err_irq "%s cannot handle __irq functions"
 #define obj_err_common "repeated common block $r"
@@ -0,0 +1,122 @@
+/*
+ * armthumb/peepstat.c
+ * SPDX-Licence-Identifier: Apache-2.0
+ *
+ * Per-pattern peephole statistics (-peepstats), shared by the ARM and
+ * Thumb peepholers
+ */
+
+#include <stdio.h>
+
+#include "globals.h"
+#include "store.h"
+#include "errors.h"
+#include "peepstat.h"
+
+#ifdef COMPILING_ON_UNIX
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+static PeepTicks start_ticks, read_ticks;
+static double start_usecs;
+
+/* The cycle counter runs at a fixed rate whether or not this process  */
+/* is, so its rate is found against elapsed time, not processor time.   */
+static double now_usecs(void) {
+#if defined(PEEPSTATS_CYCLE_COUNTER) && defined(COMPILING_ON_UNIX)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1.0e6 + ts.tv_nsec / 1.0e3;
+#else
+  return clock() * 1.0e6 / CLOCKS_PER_SEC;
+#endif
+}
+
+void peepstats_start(void) {
+  int i;
+  start_usecs = now_usecs();
+  start_ticks = peepstats_ticks();
+  /* The cheapest of a few back-to-back reads is the part of each       */
+  /* MayMatch timing that is the counter itself.                        */
+  for (i = 0; i < 8; i++) {
+    PeepTicks t0 = peepstats_ticks(), t1 = peepstats_ticks();
+    if (i == 0 || t1 - t0 < read_ticks) read_ticks = t1 - t0;
+  }
+}
+
+/* The CSV file is read back and merged on each compilation, so that    */
+/* one file can collect the figures for a whole build.  On Unix hosts   */
+/* the merge is done under a lockf() lock, which "make -j" needs; the   */
+/* lock goes when the file is closed, or if the compiler dies.          */
+
+void peepstats_write(char const *file, PeepStat *stats,
+                     int npatterns, int instbytes) {
+  char line[256];
+  FILE *f;
+  int i;
+  double *usecs;
+  /* Convert this compilation's ticks to microseconds, less the cost   */
+  /* of reading the counter around each call.                           */
+  {   PeepTicks ticks = peepstats_ticks() - start_ticks;
+      double usecs_per_tick = ticks == 0 ? 0.0 :
+          (now_usecs() - start_usecs) / (double)ticks;
+      usecs = (double *)GlobAlloc(SU_Other, npatterns * sizeof(double));
+      for (i = 0; i < npatterns; i++) {
+        PeepTicks overhead = read_ticks * (PeepTicks)stats[i].maycalls;
+        usecs[i] = stats[i].mayticks > overhead ?
+            (double)(stats[i].mayticks - overhead) * usecs_per_tick : 0.0;
+      }
+  }
+#ifdef COMPILING_ON_UNIX
+  {   int fd = open(file, O_RDWR|O_CREAT, 0666);
+      f = fd < 0 ? NULL : fdopen(fd, "r+");
+      if (f == NULL || lockf(fd, F_LOCK, 0) != 0) {
+        if (f != NULL) fclose(f); else if (fd >= 0) close(fd);
+        cc_warn(peep_warn_statsfile, file);
+        return;
+      }
+  }
+#else
+  f = fopen(file, "r");
+#endif
+  if (f != NULL) {
+    while (fgets(line, sizeof(line), f) != NULL) {
+      int n; long tried, matched, applied, saved, calls; double us;
+      if (sscanf(line, "%d,%ld,%ld,%ld,%ld,%*d,%ld,%lf", &n, &tried, &matched,
+                 &applied, &saved, &calls, &us) == 7
+          && n >= 1 && n <= npatterns) {
+        PeepStat *ps = &stats[n-1];
+        ps->tried += tried; ps->matched += matched; ps->applied += applied;
+        ps->instssaved += saved; ps->maycalls += calls; usecs[n-1] += us;
+      }
+    }
+#ifdef COMPILING_ON_UNIX
+    rewind(f);
+#else
+    fclose(f);
+#endif
+  }
+#ifndef COMPILING_ON_UNIX
+  if ((f = fopen(file, "w")) == NULL) {
+    cc_warn(peep_warn_statsfile, file);
+    return;
+  }
+#endif
+  fprintf(f, "pattern,tried,matched,applied,insts_saved,bytes_saved,"
+             "maymatch_calls,maymatch_usecs\n");
+  for (i = 0; i < npatterns; i++) {
+    PeepStat *ps = &stats[i];
+    fprintf(f, "%d,%ld,%ld,%ld,%ld,%ld,%ld,%.1f\n", i+1,
+            (long)ps->tried, (long)ps->matched, (long)ps->applied,
+            (long)ps->instssaved, (long)ps->instssaved * instbytes,
+            (long)ps->maycalls, usecs[i]);
+  }
+#ifdef COMPILING_ON_UNIX
+  fflush(f);
+  if (ftruncate(fileno(f), ftell(f)) != 0) cc_warn(peep_warn_statsfile, file);
+#endif
+  fclose(f);
+}
+
+/* end of armthumb/peepstat.c */
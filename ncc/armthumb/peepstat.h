@@ -0,0 +1,59 @@
+/*
+ * armthumb/peepstat.h
+ * SPDX-Licence-Identifier: Apache-2.0
+ *
+ * Per-pattern peephole statistics (-peepstats), shared by the ARM and
+ * Thumb peepholers
+ */
+
+#ifndef _peepstat_LOADED
+#define _peepstat_LOADED 1
+
+#include <time.h>
+
+#include "host.h"
+
+/* MayMatch takes well under a microsecond, so it is timed with the     */
+/* host's cycle counter where the host compiler gives access to one:    */
+/* clock() costs more than the call it would time.                      */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PEEPSTATS_CYCLE_COUNTER 1
+typedef unsigned long long PeepTicks;
+#  define peepstats_ticks() ((PeepTicks)__builtin_ia32_rdtsc())
+#elif defined(__GNUC__) && defined(__aarch64__)
+#define PEEPSTATS_CYCLE_COUNTER 1
+typedef unsigned long long PeepTicks;
+static __inline__ PeepTicks peepstats_ticks(void) {
+  PeepTicks t;
+  __asm__ __volatile__("mrs %0, cntvct_el0" : "=r" (t));
+  return t;
+}
+#else
+typedef clock_t PeepTicks;
+#  define peepstats_ticks() clock()
+#endif
+
+typedef struct {
+  int32 tried;        /* pattern considered for the current op           */
+  int32 matched;      /* all instructions and constraints satisfied       */
+  int32 applied;      /* replacement altered at least one op              */
+  int32 instssaved;   /* net ops removed (negative if the pattern adds)   */
+  int32 maycalls;     /* calls of MayMatch                                */
+  PeepTicks mayticks; /* peepstats_ticks() spent in those calls           */
+} PeepStat;
+
+/* Notes the tick count and time at the start of a compilation, from   */
+/* which peepstats_write() finds the counter's rate, and the cost of    */
+/* reading the counter.                                                 */
+extern void peepstats_start(void);
+
+/* Adds the figures already in file to stats[0..npatterns-1], then      */
+/* rewrites file with the totals; instbytes scales the bytes_saved      */
+/* column.  The file is locked meanwhile, so parallel compilations can  */
+/* share it.                                                            */
+extern void peepstats_write(char const *file, PeepStat *stats,
+                            int npatterns, int instbytes);
+
+#endif
+
+/* end of armthumb/peepstat.h */
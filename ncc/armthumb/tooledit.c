@@ -23,9 +23,6 @@
 
 static bool IsReadOnly(ToolEnv *t, char const *name) {
 #ifdef TARGET_IS_THUMB
-  if (StrEq(name, "-arch")
-      || StrEq(name, "-cpu"))
-    return YES;
   if (StrEq(name, "-apcs.32bit")
       || StrEq(name, "-apcs.softfp") || StrEq(name, "-apcs.fpis")
       || StrEq(name, "-apcs.fp") || StrEq(name, "-apcs.fpr"))
@@ -79,7 +76,14 @@ static EnvInit const nofp_implies[] =    { { "-D__APCS_NOFP", "?"}, {0, 0} };
 static EnvInit const softfp_implies[] =  { { "-D__SOFTFP__", "?"}, { "-D__SOFT_DOUBLES__", "?"}, {0, 0} };
 static EnvInit const softd_implies[] =   { { "-D__SOFTFP__", "="}, { "-D__SOFT_DOUBLES__", "?"}, {0, 0} };
 static EnvInit const nofpr_implies[]  =  { { "-D__PCS_FPREGARGS", "="}, {0, 0} };
-#ifndef TARGET_IS_THUMB
+#ifdef TARGET_IS_THUMB
+static EnvInit const arch4T_implies[] =  { { "-D__TARGET_FEATURE_THUMB2", "="},
+                                           { "-D__TARGET_FEATURE_DIVIDE", "="}, {0, 0} };
+static EnvInit const arch6T2_implies[] = { { "-D__TARGET_FEATURE_THUMB2", "?"},
+                                           { "-D__TARGET_FEATURE_DIVIDE", "="}, {0, 0} };
+static EnvInit const arch7M_implies[] =  { { "-D__TARGET_FEATURE_THUMB2", "?"},
+                                           { "-D__TARGET_FEATURE_DIVIDE", "?"}, {0, 0} };
+#else
 static EnvInit const b26_implies[] =     { { "-D__APCS_32", "="}, {0, 0} };
 static EnvInit const fp_implies[] =      { { "-D__APCS_NOFP", "="}, {0, 0} };
 static EnvInit const hardfp_implies[] =  { { "-D__SOFTFP__", "="}, { "-D__SOFT_DOUBLES__", "="}, {0, 0} };
@@ -94,6 +98,13 @@ static EnvValImplies const swst_vals[] = { {"#/swst", swst_implies}, {"#/noswst"
 static EnvValImplies const reent_vals[] = { {"#/reent", reent_implies}, {"#/noreent", noreent_implies}, {NULL, NULL} };
 static EnvValImplies const inter_vals[] = { {"#/interwork", inter_implies}, {"#/nointerwork", nointer_implies}, {NULL, NULL} };
 static EnvValImplies const sex_vals[] = { {"=-bi", bi_implies}, {"=-li", li_implies}, {NULL, NULL} };
+#ifdef TARGET_IS_THUMB
+/* thumb/mcdep.c keeps -arch in step with -cpu */
+static EnvValImplies const cpu_vals[] = { {"#ARM7TM", NULL}, {"#ARM9TM", NULL}, {"#ARM1156T2", NULL},
+                                          {"#CortexM3", NULL}, {"#generic", NULL}, {NULL, NULL} };
+static EnvValImplies const arch_vals[] = { {"#4T", arch4T_implies}, {"#6T2", arch6T2_implies},
+                                           {"#7M", arch7M_implies}, {NULL, NULL} };
+#endif
 #ifndef TARGET_IS_THUMB
 static EnvValImplies const softfp_vals[] = { {"#/softfp", softfp_implies}, {"#/hardfp", hardfp_implies},
                                              {"#/softdoubles", softd_implies}, {NULL, NULL} };
@@ -144,7 +155,10 @@ static KnownVals const known[] = {
   {"-apcs.reent",  reent_vals },
   {"-apcs.inter",  inter_vals },
   {".bytesex",     sex_vals },
-#ifndef TARGET_IS_THUMB
+#ifdef TARGET_IS_THUMB
+  {"-cpu",         cpu_vals },
+  {"-arch",        arch_vals },
+#else
   {"-apcs.softfp", softfp_vals },
   {"-apcs.fpr",    fpr_vals },
   {"-apcs.fp",     fp_vals },
@@ -198,8 +212,6 @@ typedef struct {
 
 static FixedVals const fixedvals[] = {
 #ifdef TARGET_IS_THUMB
-  {"-cpu",         {"#ARM7TM", NULL} },
-  {"-arch",        {"#4T", NULL} },
   {"-apcs.softfp", {"#/softfp", softfp_implies} },
   {"-apcs.fpr",    {"#/nofpregargs", nofpr_implies} },
   {"-apcs.fp",     {"#/nofp", nofp_implies} },
@@ -435,20 +447,35 @@ static char const * const langname[] = {
 };
 
 #ifdef TARGET_IS_THUMB
+static int valuecount_vals(EnvValImplies const *p) {
+  int n = 0;
+  for (; p->val != NULL; p++) n++;
+  return n;
+}
+
+static int enumvalues_vals(
+    ToolEnvItemFn *f, void *arg, char const *name, EnvValImplies const *p) {
+  for (; p->val != NULL; p++) {
+    int rc = f(arg, name, p->val);
+    if (rc != 0) return rc;
+  }
+  return 0;
+}
+
 static int valuecount_docpu(void) {
-    return 1;
+    return valuecount_vals(cpu_vals);
 }
 
 static int enumvalues_docpu(ToolEnvItemFn *f, void *arg) {
-  return f(arg, "-cpu", "#ARM7TM");
+  return enumvalues_vals(f, arg, "-cpu", cpu_vals);
 }
 
 static int valuecount_doarch(void) {
-    return 1;
+    return valuecount_vals(arch_vals);
 }
 
 static int enumvalues_doarch(ToolEnvItemFn *f, void *arg) {
-  return f(arg, "-arch", "#4T");
+  return enumvalues_vals(f, arg, "-arch", arch_vals);
 }
 #else
 
@@ -121,6 +121,7 @@
 
 #define TARGET_HAS_INLINE_ASSEMBLER 1
 #define THUMB_INLINE_ASSEMBLER      1
+#undef  ARM_INLINE_ASSEMBLER       /* host.h assumes ARM */
 
 #endif
 
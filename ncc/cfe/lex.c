@@ -57,6 +57,7 @@ typedef struct SymBuf {
   SymInfo *buf;
   int size, pos, count;
   bool dup_hack;    /* template and d-or-e uses have diverged (sigh!)   */
+  bool shared;      /* buf belongs to the template buffer we are a dup of */
   int old_put_handle; /* used to stop recording while playing (or while recording d-or-e */
 } SymBuf;
 
@@ -107,6 +108,13 @@ int errs_on_this_sym;    /* To help error recovery */
 /* the +4 in the next line is slop so we do not check on dec. pt. etc.  */
 static char namebuf[NAMEMAX+4];     /* Buffer for reading identifiers   */
 
+/* Identifiers (keywords are just identifiers with a symtype_) are      */
+/* hashed as they are read, and the last one seen with each hash value  */
+/* modulo LEX_IDCACHESIZE is remembered here, which usually saves       */
+/* walking a symbol table bucket.  Cleared by lex_init().               */
+#define LEX_IDCACHESIZE 1024
+static struct { unsigned32 hash; Symstr *sv; } lex_idcache[LEX_IDCACHESIZE];
+
 static unsigned32 lexclass[1+255];
                                     /* Character table, yielding:
                                        glue-ishness (low 8 bits),
@@ -716,10 +724,13 @@ default:    if (curchar == '#' || curchar == '\\')
             break;
 case l_idstart:
         {   int k = 0;          /* number of characters read */
+            unsigned32 hash = SYM_HASHINIT;
             do
             {   if (k < NAMEMAX)
                 {
-                    namebuf[k++] = curchar;
+                    namebuf[k] = curchar;
+                    hash = sym_hashstep_(hash, namebuf[k]);
+                    k++;
                 }
                 nextchar();
             } while (lexclass_(curchar) & l_idcont);
@@ -736,7 +747,14 @@ case l_idstart:
 #endif
             else
             {   int32 type;
-                curlex.a1.sv = sym_lookup(namebuf, SYM_GLOBAL);
+                int32 ix = hash % LEX_IDCACHESIZE;
+                Symstr *sv = lex_idcache[ix].sv;
+                if (sv == NULL || lex_idcache[ix].hash != hash ||
+                    strcmp(symname_(sv), namebuf) != 0)
+                {   sv = sym_lookup_hashed(namebuf, hash);
+                    lex_idcache[ix].hash = hash, lex_idcache[ix].sv = sv;
+                }
+                curlex.a1.sv = sv;
                 type = symtype_(curlex.a1.sv);
 /* To prepare for C++, give a warning ONCE per file in ANSI mode when a */
 /* C++ keyword is used as a C identifier.                               */
@@ -1309,7 +1327,11 @@ void lex_init()         /* C version  */
     lex_strend = lex_strptr = (char *)DUFF_ADDR;
     endofsym_fl.filepos = -1;  /* mark as invalid */
 
+    memclr(lex_idcache, sizeof(lex_idcache));
     lexbuf_max = 0; lexbuf_vec = (SymBuf *)DUFF_ADDR; nextsym_lookaside = 0;
+#ifdef CPLUSPLUS
+    lexbuf_freelist = NULL;
+#endif
     buffersym_bufidx = -1;
     nextsym_put_handle = -1;
 
@@ -1342,5 +1364,12 @@ void lex_reinit()
 #endif
 }
 
+void lex_restart(void)
+{   /* Forget any look-ahead, so the next nextsym() starts on new input */
+    /* (the interpreter reads each expression afresh).                  */
+    curchar = NOTACHAR;
+    nextlex.sym = s_nothing;
+}
+
 /* End of lex.c */
 
@@ -48,6 +48,8 @@ extern void lex_beware_reinit(void);
 
 extern void lex_reinit(void);
 
+extern void lex_restart(void);
+
 #ifdef CPLUSPLUS
 
 /* for C++ or ANSI C; harmless here */
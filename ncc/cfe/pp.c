@@ -206,6 +206,23 @@ typedef struct arglist {
 #define pp_argchain_(p)   ((p)->argchain)
 #define pp_argactual_(p)  ((p)->argactual)
 
+/* ANSI-mode macro bodies are compiled on first use into runs of text   */
+/* separated by references to parameters (see pp_compile_body()), so    */
+/* that pp_expand() neither re-parses the body text nor searches the    */
+/* parameter list for every identifier in it on each expansion.         */
+typedef struct PP_BODYOP {
+  int32 len;          /* chars of text to copy before the parameter     */
+  PP_ARGENTRY *arg;   /* the parameter, or 0 to end the body            */
+  int32 argno;        /* its position in the parameter list             */
+  int hashflag;       /* as in pp_expand(): 0 => expand the actual,     */
+                      /* 1 => stringise (#), 2 => operand of ##         */
+} PP_BODYOP;
+
+typedef struct PP_BODY {
+  char *text;
+  PP_BODYOP op[1];    /* [nops], the last with arg == 0                 */
+} PP_BODY;
+
 typedef union {
   uint32 w;
   struct {
@@ -236,6 +253,7 @@ typedef struct hashentry {
 /* interpretation too.                                                  */
   struct hashentry *unchain;   /* used to inhibit recursive expansion */
   int32 sleepleft;             /* ditto -- chars to read in ebuf.     */
+  PP_BODY *compiled;           /* 0 until first expanded (ANSI only)  */
 #define PP_NOARGHASHENTRY  offsetof(PP_HASHENTRY,arglist)
   struct arglist *arglist;     /* only if noargs==0   */
 } PP_HASHENTRY;
@@ -254,6 +272,7 @@ typedef PP_HASHENTRY *(PP_HASHTABLE[PP_HASHSIZE]);
 #define pp_unchain_(p)  ((p)->unchain)
 #define pp_sleepleft_(p)  ((p)->sleepleft)
 #define pp_hashdefchain_(p) ((p)->defchain)
+#define pp_hashcompiled_(p) ((p)->compiled)
 
 /* The following constants really are ints, or maybe enums */
 #define PP__LINE (-1)
@@ -1228,9 +1247,8 @@ out:
   pp_instring = 0;
 }
 
-static int32 pp_savstring(char const *p)
-/* p is a buffer holding a string in text form.  Copy into expansion    */
-/* buffer and return length copied.                                     */
+static int32 pp_stringlen(char const *p)
+/* p is a buffer holding a string in text form.  Return its length.     */
 {   int quote = *p;
     int32 i = 0;
     for (;;)
@@ -1241,6 +1259,13 @@ static int32 pp_savstring(char const *p)
       if (ch == '\\') if (p[++i] == 0) break;       /* really malformed */
 #endif
     }
+    return i;
+}
+
+static int32 pp_savstring(char const *p)
+/* p is a buffer holding a string in text form.  Copy into expansion    */
+/* buffer and return length copied.                                     */
+{   int32 i = pp_stringlen(p);
     pp_savbuf(p, i);
     return i;
 }
@@ -1364,6 +1389,173 @@ static void pp_argexpand(int32 ap)
   }
 }
 
+/* pp_compile_pass() follows the ANSI-mode body walk of pp_expand()     */
+/* exactly, but collects the text it would save into text[] and the     */
+/* parameter references into op[].  Called first with text == 0 to      */
+/* size the PP_BODY.  Returns the text length; *nopsp gets the count.   */
+static int32 pp_compile_pass(PP_HASHENTRY *p, char *text, PP_BODYOP *op,
+                             int32 *nopsp)
+{ char const *dp = pp_hashbody_(p);
+  int32 len = 0, runlen = 0, nops = 0;
+  int hashflag = 0, dch;
+#define pp_cput_(ch) ((text != 0 ? (void)(text[len] = (ch)) : (void)0), \
+                      ++len, ++runlen)
+  while ((dch = *dp) != 0) switch (dch)
+  {
+    case '%':
+        if (dp[1] != ':') goto defaultcase;
+        if (dp[2] == '%' && dp[3] == ':') {
+          hashflag |= 2;
+          dp += 4;
+        } else if (pp_hashnoargs_(p)) {
+          goto defaultcase;
+        } else {
+          hashflag |= 1;
+          dp += 2;
+        }
+        while (*dp == ' ') dp++;    /* whitespace ANSI normalised.  */
+        break;
+    case '#':
+        if (pp_hashnoargs_(p) && dp[1] != '#') goto defaultcase;
+        ++dp;
+        if (*dp == '#') {hashflag |= 2; ++dp;} else hashflag |= 1;
+        while (*dp == ' ') dp++;    /* whitespace ANSI normalised.  */
+        break;
+    case '\'':
+    case '"':
+      { int32 n = pp_stringlen(dp);
+        for (; n > 0; --n, ++dp) pp_cput_(*dp);
+        hashflag = 0;
+        break;
+      }
+    defaultcase:
+    default:
+        if (pp_macstart(dch))
+        { int32 i = 0;
+          PP_ARGENTRY *a;
+          do i++, dp++; while (pp_cidchar(*dp));
+          a = pp_hashnoargs_(p) ? 0 :
+                  pp_findarg(pp_hasharglist_(p), dp-i, i);
+          if (hashflag == 0)    /* not # or ## prefixed, maybe suffixed */
+          { char const *s = dp;
+            while (*s == ' ') ++s;      /* whitespace ANSI normalised.  */
+            if ((s[0] == '#' && s[1] == '#')
+                || (s[0] == '%' && s[1] == ':' && s[2] == '%' && s[3] == ':'))
+              hashflag = 2;
+          }
+          if (hashflag & 1) pp_cput_('"');
+          if (a == 0)                                   /* not an arg   */
+          { char const *s = dp-i;
+            for (; i > 0; --i, ++s) pp_cput_(*s);
+          }
+          else
+          { if (op != 0)
+            { PP_ARGENTRY *q;
+              int32 argno = 0;
+              for (q = pp_hasharglist_(p); q != a; q = pp_argchain_(q))
+                argno++;
+              op[nops].len = runlen, op[nops].arg = a;
+              op[nops].argno = argno, op[nops].hashflag = hashflag;
+            }
+            nops++, runlen = 0;
+          }
+          if (hashflag & 1) pp_cput_('"');
+        }
+        else
+        { if (dch != PP_TOKSEP) pp_cput_(dch);
+          ++dp;
+        }
+        /* The next line rests on ANSI whitespace normalisation.        */
+        if (dp[0] == ' ' &&
+            ((dp[1] == '#' && dp[2] == '#') ||
+             (dp[1] == '%' && dp[2] == ':' && dp[3] == '%' && dp[4] == ':')))
+          dp++;
+        hashflag = 0;
+        break;
+  }
+#undef pp_cput_
+  if (op != 0)
+    op[nops].len = runlen, op[nops].arg = 0,
+    op[nops].argno = 0, op[nops].hashflag = 0;
+  *nopsp = nops+1;
+  return len;
+}
+
+static PP_BODY *pp_compile_body(PP_HASHENTRY *p)
+{ int32 nops, len = pp_compile_pass(p, NULL, NULL, &nops);
+  PP_BODY *b = (PP_BODY *)pp_alloc((int32)offsetof(PP_BODY, op) +
+                                   nops * (int32)sizeof(PP_BODYOP) + len);
+  b->text = (char *)&b->op[nops];
+  (void)pp_compile_pass(p, b->text, b->op, &nops);
+  return b;
+}
+
+/* The expansion of an actual is the same wherever its parameter is     */
+/* used in one expansion of a body (pp_noexpand is the same for each),  */
+/* so the first few parameters' expansions are kept for re-use here.    */
+#define PP_ARGCACHE 16
+
+/* ANSI-mode pp_expand() body substitution, from the compiled form.     */
+static void pp_expand_compiled(PP_HASHENTRY *p)
+{ PP_BODY *b = pp_hashcompiled_(p);
+  char const *text;
+  PP_BODYOP const *op;
+  int32 cacheoff[PP_ARGCACHE], cachelen[PP_ARGCACHE];
+  int32 i;
+  if (b == 0) pp_hashcompiled_(p) = b = pp_compile_body(p);
+  for (i = 0; i < PP_ARGCACHE; i++) cacheoff[i] = -1;
+  text = b->text;
+  for (op = b->op;; op++)
+  { PP_ARGENTRY *a = op->arg;
+    int32 ap;
+    pp_savbuf(text, op->len);
+    text += op->len;
+    if (a == 0) break;
+    ap = pp_argactual_(a);
+    if (op->hashflag == 0)
+    { int32 k = op->argno;
+      pp_savch(PP_TOKSEP);                              /* no glueing   */
+      if (k < PP_ARGCACHE && cacheoff[k] >= 0)
+      { int32 n = cachelen[k];
+        pp_ebuf_ensure(n);
+        memcpy(pp_ebuftop, pp_ebufbase + cacheoff[k], (size_t)n);
+        pp_ebuftop += n;
+      }
+      else
+      { PP_HASHENTRY *oldsleepers = pp_noexpand;
+        int32 off = pp_ebuftop - pp_ebufbase;
+        pp_noexpand = 0;
+        pp_argexpand(ap);
+        pp_awaken_all();
+        pp_noexpand = oldsleepers;
+        if (k < PP_ARGCACHE)
+          cacheoff[k] = off, cachelen[k] = (pp_ebuftop - pp_ebufbase) - off;
+        if (debugging(DEBUG_PP))
+        { cc_msg("pp_argexpanded(%s)\n", pp_abufbase+ap);
+          pp_show_buffers("r1");
+        }
+      }
+      pp_savch(PP_TOKSEP);                              /* no glueing   */
+    }
+    else
+    { int ch, lastch = 0, in_string = 0, hashflag = op->hashflag;
+      while ((ch = pp_abufbase[ap++]) != 0)             /* PP_EOM       */
+      { if (!in_string)
+        {   if (ch == '"' || ch == '\'') in_string = ch;
+        }
+        else if (lastch != '\\' && ch == in_string)
+            in_string = 256;
+        if ((hashflag & 1) && in_string && (ch == '"' || ch == '\\'))
+            pp_savch('\\');
+        if (!((hashflag & 2 && ch == PP_NOEXPAND) ||
+              (hashflag & 1 && ch == PP_TOKSEP))) pp_savch(ch);
+        lastch = ch;
+        if (in_string == 256) in_string = 0;
+      }
+    }
+  }
+}
+
 /* pp_expand expands a macro whose args are in abuf into ebuf.          */
 static void pp_expand(PP_HASHENTRY *p, int32 nlsinargs)
 { int dch;
@@ -1398,6 +1590,8 @@ static void pp_expand(PP_HASHENTRY *p, int32 nlsinargs)
   ++pp_expand_level;
 #endif
   if (!(feature & FEATURE_PCC)) pp_savch(PP_TOKSEP);    /* no glueing   */
+  if (!(feature & FEATURE_PCC) && !pp_hashismagic_(p))
+    pp_expand_compiled(p), dp = "";     /* the loop is for PCC and magic */
   while ((dch = *dp) != 0) switch (dch)
   {
     case '%':
@@ -1854,6 +2048,7 @@ illopt:
   pp_noifdef_(p) = 0;
   if (n < 0) pp_hashmagic_(p) = n; else pp_hashbody_(p) = "1";
   pp_hashdefchain_(p) = 0;
+  pp_hashcompiled_(p) = 0;
   pp_unchain_(p) = 0, pp_sleepleft_(p) = 0;     /* (init only to check) */
   switch (ch)
   {  default:  if (n >= 0)
@@ -1979,6 +2174,7 @@ static void pp_define(int pp_ch, bool noifdef)
     pp_hashismagic_(p) = 0;
     pp_hashuses_(p) = 0;
     pp_hashdefchain_(p) = 0;
+    pp_hashcompiled_(p) = 0;
     pp_unchain_(p) = 0, pp_sleepleft_(p) = 0;   /* (init only to check) */
     pp_hashname_(p) = name;
     pp_ch = pp_skipb1(pp_ch);
@@ -2864,11 +3060,175 @@ void pp_pop_include(void)
 /* for #<directive>.  Note that it is not updated on <space> or <tab>.    */
 static int pp_lastch;   /* perhaps could be done via unrdch(). */
 
+#ifndef PASCAL_OR_FORTRAN
+/* pp_skipline() stands in for pp_rdch() at the start of each line of a  */
+/* skipped #if region.  Most such lines contain no directive, triglyph  */
+/* or continuation, so rather than translating them char by char it     */
+/* scans whole line buffers, consuming text (and comments and simple    */
+/* strings) that cannot matter while keeping pp_lastch, seen_pp_token   */
+/* and *pp_fl exactly as the pp_rdch()/pp_process() path would.  It     */
+/* returns the next char as pp_rdch() would: '\n' for a consumed line,  */
+/* or else whatever pp_rdch() (or pp_comment()) returns from the first  */
+/* char it chooses not to deal with -- '#' lines always go that way.    */
+
+#define pp_skipconsume_(k) \
+    (pp_rdptr += (k), pp_rdcnt -= (k), pp_fl->column += (k))
+
+/* Whether s[j] reads as itself through pp_rdch1()/pp_translate_1().     */
+static bool pp_skipplain(char const *s, int32 j, int32 n)
+{   int ch = s[j] & 0xff;
+    if (pp_translation(ch) == ch) return YES;
+    return ch == '?' && j+1 < n && s[j+1] != '?';       /* no triglyph  */
+}
+
+static int pp_skipnewline(int32 k)
+{   /* consume s[0..k], s[k] being '\n', as pp_rdch1() would.          */
+    pp_skipconsume_(k+1);
+    ++pp_fl->l;
+    pp_fl->filepos += (int32) pp_fl->column;
+    pp_fl->column = 1;
+    return '\n';
+}
+
+static bool pp_skipfill(void)
+{   if (pp_fillbuf() == PP_EOF) return NO;
+    ++pp_rdcnt, --pp_rdptr, --pp_fl->column;   /* unread its first char */
+    return YES;
+}
+
+static int pp_skipline(void)
+{   for (;;)
+    {   char const *s;
+        int32 n, k;
+        if (pp_rdcnt <= 0 && !pp_skipfill()) return PP_EOF;
+        s = pp_rdptr, n = pp_rdcnt;
+        for (k = 0; k < n; k++)
+        {   int ch = s[k] & 0xff;
+            if (ch == ' ' || ch == '\t') continue;
+            if (PP_EOLP(pp_lastch) && (ch == '#' || ch == '%')) break;
+            if (ch == '\n') return pp_skipnewline(k);
+            if (ch == '"' || ch == '\'')
+            {   /* a string closed on this line is copied silently.   */
+                int32 j = k+1;
+                for (; j < n && s[j] != ch; j++)
+                    if (s[j] == '\\' ? (++j == n || !pp_skipplain(s, j, n))
+                                     : (s[j] != '/' && !pp_skipplain(s, j, n)))
+                        break;
+                if (j >= n || s[j] != ch) break;
+                k = j;
+            }
+            else if (ch == COMMENT_START)
+            {   int ch2;
+                if (k+1 == n) break;
+                ch2 = s[k+1] & 0xff;
+                if (ch2 == '*')
+                {   int32 nls = 0;
+                    pp_skipconsume_(k+2);
+                    pp_incomment = BALANCED_COMMENT;
+                    for (;;)
+                    {   int32 j;
+                        if (pp_rdcnt <= 0 && !pp_skipfill())
+                        {   pp_rdch3nls += nls;
+                            cc_err(pp_err_eof_comment);
+                            return PP_EOF;
+                        }
+                        s = pp_rdptr, n = pp_rdcnt;
+                        for (j = 0; j < n; j++)
+                        {   int c = s[j];
+                            if (c == '*')
+                            {   if (j+1 == n) break;
+                                if (s[j+1] == COMMENT_END) break;
+                            }
+                            else if (c == COMMENT_START)
+                            {   if (j+1 == n || s[j+1] == '*') break;
+                            }
+                            else if (c == '\n' || !pp_skipplain(s, j, n))
+                                break;
+                        }
+                        if (j < n && s[j] == '\n')
+                        {   (void)pp_skipnewline(j);
+                            nls++;
+                            continue;
+                        }
+                        if (j < n && s[j] == '*' && j+1 < n &&
+                            s[j+1] == COMMENT_END)
+                        {   pp_skipconsume_(j+2);
+                            if (nls == 0) break;    /* just like a space */
+                            pp_rdch3nls += nls;
+                            return pp_rdch();
+                        }
+                        if (j < n)
+                        {   /* leave the rest to pp_comment(), but not  */
+                            /* just after a '*' or '/' it looks at.     */
+                            if (j > 0 && (s[j-1] == '*' ||
+                                             s[j-1] == COMMENT_START)) j--;
+                            pp_skipconsume_(j);
+                            pp_rdch3nls += nls;
+                            return pp_comment('*');
+                        }
+                        pp_skipconsume_(j);
+                    }
+                    s = pp_rdptr, n = pp_rdcnt, k = -1;
+                    continue;
+                }
+                if (ch2 == '/' &&
+                    (LanguageIsCPlusPlus || !(feature & FEATURE_FUSSY)))
+                {   pp_skipconsume_(k+2);
+                    pp_incomment = EOL_COMMENT;
+                    for (;;)
+                    {   int32 j;
+                        if (pp_rdcnt <= 0 && !pp_skipfill())
+                        {   pp_incomment = NO_COMMENT;
+                            return PP_EOF;
+                        }
+                        s = pp_rdptr, n = pp_rdcnt;
+                        for (j = 0; j < n; j++)
+                            if (s[j] == '\n' ||
+                                (s[j] != COMMENT_START && !pp_skipplain(s, j, n)))
+                                break;
+                        if (j < n && s[j] == '\n')
+                        {   pp_incomment = NO_COMMENT;
+                            return pp_skipnewline(j);
+                        }
+                        pp_skipconsume_(j);
+                        if (j < n)
+                        {   int c;
+                            do c = pp_rdch1(); while (c != '\n' && c != PP_EOF);
+                            pp_incomment = NO_COMMENT;
+                            return c;
+                        }
+                    }
+                }
+                if (ch2 == '\n' || !pp_skipplain(s, k+1, n)) break;
+            }
+            else if (!pp_skipplain(s, k, n))
+                break;
+            pp_lastch = ch;
+            seen_pp_token = 1;
+        }
+        pp_skipconsume_(k);
+        if (k < n) return pp_rdch();
+    }
+}
+#endif
+
 static int pp_process(void)
 {   int pp_ch;
     pp_abufptr = pp_abufbase;
     while (pp_abufptr == pp_abufbase) /* do {} while really. */
-    {   pp_ch = pp_rdch();
+    {
+#ifndef PASCAL_OR_FORTRAN
+        if (pp_skipping && PP_EOLP(pp_lastch) &&
+            pp_rdch_la == 0 && pp_rdch1nls == 0 && pp_rdch3nls == 0 &&
+            pp_scanidx < 0 && pp_ebufptr == pp_ebuftop &&
+#ifndef NO_LISTING_OUTPUT
+            listingstream == NULL &&
+#endif
+            !(feature & (FEATURE_PCC | FEATURE_PPCOMMENT)))
+            pp_ch = pp_skipline();
+        else
+#endif
+        pp_ch = pp_rdch();
         switch (pp_ch)
         {
     case PP_EOF:
@@ -3090,6 +3450,7 @@ void PP_LoadState(FILE *f) {
         pp_hashname_(h) = name = (char *)h + size;
         pp_unchain_(h) = NULL; pp_sleepleft_(h) = 0;
         pp_hashdefchain_(h) = NULL;
+        pp_hashcompiled_(h) = NULL;
         h->u.w = u.w;
         if (pp_hashlast == NULL)
           pp_hashfirst = h;
@@ -1507,6 +1507,39 @@ Expr *syn_rdinit(TypeExpr *t, Binder *whole, int32 flag)
     return e;
 }
 
+/* A fast path for the long lists of literals in generated tables: if   */
+/* the next initialiser is just an integer constant, representable in   */
+/* the integral type t and followed by ',' or '}', read it into *val    */
+/* (building no Expr) and return YES.  Otherwise leave the input for    */
+/* syn_rdinit().  Only values which need no conversion diagnostic are  */
+/* taken, so messages are the same whichever way an element is read.   */
+bool syn_rdinit_integer(TypeExpr *t, int32 *val)
+{   unsigned32 n = (unsigned32)curlex.a1.i, max;
+    bool uns = (typespecmap_(t) & bitoftype_(s_unsigned)) != 0;
+    if (syn_initpeek || syn_initdepth <= 0 || curlex.sym != s_integer)
+        return NO;
+    switch (sizeoftype(t))
+    {   case 1:  max = uns ? 0xff : 0x7f; break;
+        case 2:  max = uns ? 0xffff : 0x7fff; break;
+        case 4:  max = uns ? 0xffffffff : 0x7fffffff; break;
+        default: return NO;
+    }
+    if (n > max) return NO;
+    /* long int -> int/short/char moans (if only when not suppressed) */
+    if ((curlex.a2.flag & bitoftype_(s_long)) &&
+        !(typespecmap_(t) & bitoftype_(s_long)))
+        return NO;
+    nextsym();
+    if (curlex.sym == s_comma)
+        nextsym();
+    else if (curlex.sym != s_rbrace)
+    {   ungetsym();
+        return NO;
+    }
+    *val = (int32)n;
+    return YES;
+}
+
 bool syn_canrdinit(void)
 {  if (syn_initpeek) return 1;
    if (syn_initdepth < 0 ||
@@ -24,6 +24,7 @@ extern bool implicit_return_ok;
 extern int32 syn_begin_agg(void);
 extern void syn_end_agg(int32 beganbrace);
 extern Expr *syn_rdinit(TypeExpr *t, Binder *whole, int32 flag);
+extern bool syn_rdinit_integer(TypeExpr *t, int32 *val);
 extern bool syn_canrdinit(void);
 
 extern Expr *rd_expr(int n);
@@ -59,12 +60,17 @@ extern ScopeSaver copy_env(ScopeSaver env, int n);
 extern void parameter_names_transfer(FormTypeList *from, FormTypeList *to);
 extern void add_expr_dtors(Expr *edtor);
 extern void add_to_saved_temps(SynBindList *tmps);
+extern void syn_template_fn_requested(Symstr *name, Symstr *realname,
+                                      TagBinder *scope);
+extern void syn_template_stats(void);
 #else
 #define add_pendingfn(a,b,c,d,e,f,g,h,i) ((void)0)
 #define copy_env(a,b) 0
 #define parameter_names_transfer(a,b) 0
 #define add_expr_dtors(a) 0
 #define add_to_saved_temps(a) 0
+#define syn_template_fn_requested(a,b,c) ((void)0)
+#define syn_template_stats() ((void)0)
 #endif
 
 #endif
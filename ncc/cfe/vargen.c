@@ -710,8 +710,22 @@ case t_subscript:
             }
 /* Maybe generalise this one day:                                       */
 #define vg_init_to_null(t) (TARGET_NULL_BITPATTERN == 0)
+/* Arrays of plain integers (often huge, in generated tables) can mostly  */
+/* have their elements read straight into the data image.                 */
+            t2 = princtype(typearg_(t));
+            if (!(h0_(t2) == s_typespec &&
+                  (typespecmap_(t2) & (bitoftype_(s_char)|bitoftype_(s_int))) &&
+                  !(typespecmap_(t2) & BITFIELD) &&
+                  !int_islonglong_(typespecmap_(t2)) &&
+                  !(feature & FEATURE_PCC)))
+                t2 = NULL;
             for (i = 0; i < m; i++)
-            {   if (!syn_canrdinit())
+            {   int32 n;
+                if (t2 != NULL && syn_rdinit_integer(t2, &n))
+                {   gendcI_a(sizeoftype(t2), n, aligned);
+                    continue;
+                }
+                if (!syn_canrdinit())
                 {   if (typesubsize_(t) == 0 || h0_(typesubsize_(t)) == s_binder)
                     {   typesubsize_(t) = globalize_int(i);
                         break;  /* set size to number of elements read. */
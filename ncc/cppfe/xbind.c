@@ -1020,19 +1020,25 @@ ClassMember *derived_from(TagBinder *base, TagBinder *scope)
 /* since used as a predicate or to get a name for path_to_member...     */
     if ((l = tagbindmems_(scope)) != NULL && attributes_(l) & CB_CORE)
         return derived_from(base, typespectagbind_(princtype(memtype_(l))));
+/* Base and virtual base pointer members lead the member list (as     */
+/* path_to_base_member() relies on), so stop at the first other one.    */
     for (l = tagbindmems_(scope);  l != NULL;  l = memcdr_(l))
-        if (attributes_(l) & (CB_BASE | CB_VBPTR))
-        {   TypeExpr *t = princtype(memtype_(l));
-            if (attributes_(l) & CB_VBPTR) t = princtype(typearg_(t));
-            if (base == typespectagbind_(t)) return l;
-        }
+    {   TypeExpr *t;
+        if (!is_datamember_(l) || !(attributes_(l) & (CB_BASE | CB_VBPTR)))
+            break;
+        t = princtype(memtype_(l));
+        if (attributes_(l) & CB_VBPTR) t = princtype(typearg_(t));
+        if (base == typespectagbind_(t)) return l;
+    }
     for (l = tagbindmems_(scope);  l != NULL;  l = memcdr_(l))
-        if (attributes_(l) & (CB_BASE | CB_VBPTR))
-        {   TypeExpr *t = princtype(memtype_(l));
-            if (attributes_(l) & CB_VBPTR) t = princtype(typearg_(t));
-            if ((ll = derived_from(base, typespectagbind_(t))) != NULL)
-                return ll;
-        }
+    {   TypeExpr *t;
+        if (!is_datamember_(l) || !(attributes_(l) & (CB_BASE | CB_VBPTR)))
+            break;
+        t = princtype(memtype_(l));
+        if (attributes_(l) & CB_VBPTR) t = princtype(typearg_(t));
+        if ((ll = derived_from(base, typespectagbind_(t))) != NULL)
+            return ll;
+    }
     return 0;
 }
 
@@ -1108,6 +1114,10 @@ static Expr *path_to_base_member(ClassMember *member, TagBinder *b,
             continue;
 
         if (attributes_(l) & CB_VBPTR) t = typearg_(t);
+        /* Skip whole sub-hierarchies known not to contain the name.    */
+        if (h0_(member) == s_identifier &&
+            class_lacks_member(typespectagbind_(t), (Symstr *)member))
+            continue;
         tmp = path_to_member_2(member, typespectagbind_(t), flags, vbases,
                 (attributes_(l) & bitofaccess_(s_private)) ? b :
                     privately_deriving_class);
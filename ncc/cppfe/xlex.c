@@ -46,10 +46,17 @@ typedef struct { Symstr *old, *new; SymInfo next; } Restorable_Names;
 static List *restorable_names_list;
 static void save_names(bool glob);
 static void restore_names(void);
+
+/* Token vectors given up when a buffer grows or is trimmed are kept    */
+/* here for reuse by later saves: GlobAlloc store is only reclaimed at  */
+/* the end of the compilation, and header-heavy sources save a lot.     */
+typedef struct LexFreeBuf { struct LexFreeBuf *cdr; int size; } LexFreeBuf;
+static LexFreeBuf *lexbuf_freelist;
 #include "lex.c"
 
 static const SymBuf lexbuf_empty =
-   { 0, { s_eof }, (SymInfo *)DUFF_ADDR, 0, /*pos*/ -1, 0, NO, /* old_put_handle */ -1 };
+   { 0, { s_eof }, (SymInfo *)DUFF_ADDR, 0, /*pos*/ -1, 0, NO, NO,
+     /* old_put_handle */ -1 };
 #define INIT_NLEXBUFS 8         /* initially max 8 member fn defs.      */
 #define INIT_LEXBUFSIZE 32      /* initially max 32 tokens per def.     */
 
@@ -77,12 +84,41 @@ static int lex_findsavebuf(void)
     }
 }
 
+static void lex_freebuf(SymInfo *buf, int size)
+{   if (size >= INIT_LEXBUFSIZE)
+    {   LexFreeBuf *q = (LexFreeBuf *)buf;
+        q->cdr = lexbuf_freelist, q->size = size;
+        lexbuf_freelist = q;
+    }
+}
+
+/* Returns a token vector of at least *sizep entries (best fit from the */
+/* free list, else fresh store) and updates *sizep to its real size.    */
+/* Vectors more than four times too big are left for larger bodies.     */
+static SymInfo *lex_allocbuf(int *sizep)
+{   LexFreeBuf **pp, **best = NULL;
+    int n = *sizep;
+    for (pp = &lexbuf_freelist; *pp != NULL; pp = &(*pp)->cdr)
+        if ((*pp)->size >= n && (*pp)->size < 4*n &&
+            (best == NULL || (*pp)->size < (*best)->size))
+        {   best = pp;
+            if ((*pp)->size == n) break;
+        }
+    if (best != NULL)
+    {   LexFreeBuf *q = *best;
+        *best = q->cdr;
+        *sizep = q->size;
+        return (SymInfo *)q;
+    }
+    return (SymInfo *)GlobAlloc(SU_Other, (int32)n * sizeof(SymInfo));
+}
+
 static void lex_ensurebuf(SymBuf *p)
 {   int nsize = (p->size == 0 ? INIT_LEXBUFSIZE : p->size*2);
-    SymInfo *nbuf = (SymInfo *)GlobAlloc(SU_Other,
-                                         (int32)nsize * sizeof(SymInfo));
+    SymInfo *nbuf = lex_allocbuf(&nsize);
     memcpy(nbuf, p->buf, p->size * sizeof(SymInfo));
-    p->size = nsize, p->buf = nbuf;
+    if (!p->shared) lex_freebuf(p->buf, p->size);
+    p->size = nsize, p->buf = nbuf, p->shared = NO;
 }
 
 static void lex_putbodysym()
@@ -154,6 +190,17 @@ int lex_bodyend()
     if (p->pos >= p->size) lex_ensurebuf(p);
     p->buf[p->pos].sym = s_eof;         /* the token after '}' or ';'   */
     p->buf[p->pos].fl = p->pos < 0 ? p->buf[p->pos - 1].fl : curlex.fl;
+/* A template body lives as long as the compilation, so trim it to its  */
+/* length and give the slack back for the next body to be saved.        */
+    {   int n = p->pos + 1;
+        if (p->size - n >= INIT_LEXBUFSIZE)
+        {   SymInfo *nbuf = (SymInfo *)GlobAlloc(SU_Other,
+                                                 (int32)n * sizeof(SymInfo));
+            memcpy(nbuf, p->buf, (p->pos + 1) * sizeof(SymInfo));
+            lex_freebuf(p->buf, p->size);
+            p->size = n, p->buf = nbuf;
+        }
+    }
     p->pos = 0;                         /* inuse/ready to read.         */
     nextsym_put_handle = p->old_put_handle;
     if (debugging(DEBUG_LEX))
@@ -268,16 +315,11 @@ void lex_openbody(int h, bool dup, bool record, Symstr *old_sv, Symstr *new_sv)
             cc_msg("lex_openbody: dup [%d] -> [%d]\n", h, h2);
             lex_dumpbuf(p);
         }
-/* The memcpy of symbols is a bit wasteful when we could share the      */
-/* the buffer vectors, but this would make (re-)allocation harder.      */
-/* @@@ maybe not, let's do it soon.                                     */
-        if (p2->size < p->size)
-        {   int nsize = p->size;
-            SymInfo *nbuf = (SymInfo *)GlobAlloc(SU_Other,
-                                           (int32)nsize * sizeof(SymInfo));
-            p2->size = nsize, p2->buf = nbuf;
-        }
-        memcpy(p2->buf, p->buf, p->size * sizeof(SymInfo));
+/* A dup is only ever read, so it shares the template's token vector   */
+/* rather than copying it; its own vector goes back on the free list    */
+/* and lex_closebody() detaches the shared one again.                   */
+        if (!p2->shared) lex_freebuf(p2->buf, p2->size);
+        p2->buf = p->buf, p2->size = p->size, p2->shared = YES;
         p2->pos = 0;
         p2->dup_hack = YES;
         h = h2;
@@ -306,6 +348,11 @@ void lex_closebody(void)
     nextsym_lookaside->pos = -1;
     nextsym_lookaside->count = 0;
     nextsym_lookaside->dup_hack = NO;
+    if (nextsym_lookaside->shared)
+    {   nextsym_lookaside->buf = (SymInfo *)DUFF_ADDR;
+        nextsym_lookaside->size = 0;
+        nextsym_lookaside->shared = NO;
+    }
     template_new_sv = template_old_sv = NULL;
     curlex = nextsym_lookaside->prevsym;
     if (nextsym_lookaside->old_put_handle != -1)
@@ -372,6 +372,18 @@ static bool match_non_type_args(ScopeSaver tformals, ExprList *actuals)
     return (!tformals && !actuals) ? YES : NO;
 }
 
+/* Count a call of a member of a class template instance that has      */
+/* already been instantiated: syn_attempt_template_memfn() counts the   */
+/* first call, when the body is replayed.                               */
+static void note_memfn_request(Binder *b)
+{   if (debugging(DEBUG_STORE) && bindparent_(b) != NULL &&
+        tagprimary_(bindparent_(b)) != NULL && realbinder_(b) != NULL &&
+        !(bindstg_(realbinder_(b)) & b_undef) &&
+        !contains_typevars(bindtype_(b)))
+        syn_template_fn_requested(bindsym_(realbinder_(b)), NULL,
+                                  bindparent_(b));
+}
+
 static Binder *sem_instantiate_tmptfn(Binder *b, TypeExpr *bt, ExprList **l)
 {   Binder *fb = NULL;
     BindList *tmpts;
@@ -418,6 +430,17 @@ static Binder *sem_instantiate_tmptfn(Binder *b, TypeExpr *bt, ExprList **l)
             {   has_failed = YES;   /* pretends it's failed */
                 fb = bl->bindlistcar;
             }
+        if (fb != NULL && debugging(DEBUG_STORE) &&
+            !contains_typevars(bindtype_(fb)))
+        {   if (bindstg_(ftemp) & (b_memfna+b_memfns))
+                syn_template_fn_requested(
+                    bindsym_(realbinder_(fb) != NULL ? realbinder_(fb) : fb),
+                    NULL, bindparent_(ftemp));
+            else
+                syn_template_fn_requested(bindsym_(b),
+                    ovld_tmptfn_instance_name(bindsym_(ftemp), env),
+                    bindparent_(ftemp));
+        }
 
         if (!has_failed)
         {   Binder *fbind = NULL;
@@ -488,6 +511,11 @@ static Binder *sem_instantiate_tmptfn(Binder *b, TypeExpr *bt, ExprList **l)
                               NULL, bindtext_(ftemp), bindenv_(fbind), YES);
                 bindstg_(fb) &= ~b_undef;
             }
+            else if (!contains_typevars(bindtype_(fbind)))
+            {   bool ismemtemp = (bindstg_(ftemp) & (b_memfns+b_memfna)) != 0;
+                syn_template_fn_requested(ismemtemp ? bindsym_(fbind) : bindsym_(b),
+                                          ismemtemp ? NULL : sv, bindparent_(ftemp));
+            }
         }
     }
     bindactuals_(b) = NULL;
@@ -614,7 +642,11 @@ static Expr *mkfnap_cpp(Expr *e, ExprList **l, bool *curried, Expr **let_, Expr
                 b = (tmpt_bspecific) ? tmpt_bspecific :
                     ovld_resolve(b, typeovldlist_(bt), *l, ll, NO);
                 if (h0_(b) == s_error) return errornode;
+                /* sem_instantiate_tmptfn() counts its own requests.    */
+                if (tmpt_bspecific == NULL) note_memfn_request(b);
             }
+            else
+                note_memfn_request(b);
             if ((bindstg_(b) & b_undef) && !contains_typevars(bindtype_(b)))
             {   if (bindparent_(b) != NULL)
                 {   if (bindstg_(realbinder_(b)) & b_undef)
@@ -14,6 +14,7 @@
  */
 
 #include <string.h>    /* for memset */
+#include <time.h>      /* for clock() */
 #include "globals.h"
 #include "syn.h"
 #include "pp.h"        /* for pp_inhashif */
@@ -3432,6 +3433,78 @@ static void add_memfn_template(TagBinder *p, Symstr *name, Symstr *realname, Typ
                     formaltags, tokhandle, templateformals, YES);
 }
 
+/* Instantiation table.  Template instances are memoised by their      */
+/* canonical names (which ovld_template_app() and                       */
+/* ovld_tmptfn_instance_name() derive from the argument signatures):    */
+/* an instance's tag or binder, once defined, is found again by name,   */
+/* so its saved body is replayed only once.  This table records, per    */
+/* instance, how often it was asked for, how often its body was         */
+/* replayed and the time taken (including any nested instantiations),  */
+/* and syn_template_stats() reports them with the -zqU store summary.   */
+/* A function instance is asked for each time sem_instantiate_tmptfn()  */
+/* resolves a call to it, but replayed only by add_pendingfn().         */
+
+#define TEMPLSTAT_HASHSIZE 128
+
+typedef struct TemplateStat TemplateStat;
+struct TemplateStat {
+    TemplateStat *cdr;
+    Symstr *name;               /* canonical instance name              */
+    TagBinder *scope;           /* class instance, or owning class      */
+    int32 requests, instances;
+    clock_t time;
+};
+
+static TemplateStat *(*templstats)[TEMPLSTAT_HASHSIZE];
+static int32 ntemplstats;
+
+static TemplateStat *template_stat(Symstr *name, TagBinder *scope)
+{   TemplateStat **p, *s;
+    if (!debugging(DEBUG_STORE)) return NULL;
+    if (templstats == NULL)
+    {   templstats = (TemplateStat *(*)[TEMPLSTAT_HASHSIZE])
+            GlobAlloc(SU_Other, sizeof(*templstats));
+        memset(templstats, 0, sizeof(*templstats));
+    }
+    p = &(*templstats)[((IPtr)name >> 3) % TEMPLSTAT_HASHSIZE];
+    for (s = *p;  s != NULL;  s = s->cdr)
+        if (s->name == name && s->scope == scope) return s;
+    s = (TemplateStat *)GlobAlloc(SU_Other, sizeof(TemplateStat));
+    s->cdr = *p, s->name = name, s->scope = scope;
+    s->requests = s->instances = 0, s->time = 0;
+    ntemplstats++;
+    return *p = s;
+}
+
+/* A function template instance was named but not replayed: it was    */
+/* already defined, or its template has no body yet.  The arguments    */
+/* are those add_pendingfn() would have been given.                    */
+void syn_template_fn_requested(Symstr *name, Symstr *realname, TagBinder *scope)
+{   TemplateStat *stat = template_stat(realname != NULL ? realname : name, scope);
+    if (stat != NULL) stat->requests++;
+}
+
+void syn_template_stats(void)
+{   TemplateStat *sorted = NULL, *s, *next, **q;
+    int32 i, requests = 0, instances = 0;
+    if (templstats == NULL) return;
+    /* Merge the buckets into one list, slowest instance first.         */
+    for (i = 0;  i < TEMPLSTAT_HASHSIZE;  i++)
+        for (s = (*templstats)[i];  s != NULL;  s = next)
+        {   next = s->cdr;
+            requests += s->requests, instances += s->instances;
+            for (q = &sorted;  *q != NULL && (*q)->time >= s->time;  q = &(*q)->cdr)
+                continue;
+            s->cdr = *q, *q = s;
+        }
+    cc_msg("Templates: %ld instances, %ld requested, %ld replayed\n",
+           (long)ntemplstats, (long)requests, (long)instances);
+    for (s = sorted;  s != NULL;  s = s->cdr)
+        cc_msg("%7ldcs %5ld %5ld  %s\n", (long)(s->time * 100 / CLOCKS_PER_SEC),
+               (long)s->requests, (long)s->instances, symname_(s->name));
+    templstats = NULL, ntemplstats = 0;
+}
+
 void add_pendingfn(Symstr *name, Symstr *realname, TypeExpr *t, SET_BITMAP stg,
                    TagBinder *scope, ScopeSaver formaltags, int tokhandle,
                    ScopeSaver templateformals, bool tfn)
@@ -3447,6 +3520,8 @@ void add_pendingfn(Symstr *name, Symstr *realname, TypeExpr *t, SET_BITMAP stg,
         SynBindList *old_syn_reftemps = syn_reftemps;
         FuncMisc tmp;
         Mark* mark;
+        TemplateStat *stat = template_stat(realname != NULL ? realname : name, scope);
+        clock_t t0 = stat != NULL ? clock() : 0;
         syn_reftemps = NULL;
         save_curfn_misc(&tmp);
         if (scope && tagactuals_(scope))
@@ -3483,6 +3558,8 @@ void add_pendingfn(Symstr *name, Symstr *realname, TypeExpr *t, SET_BITMAP stg,
         alloc_unmark(mark);
         syn_reftemps = old_syn_reftemps;
         restore_curfn_misc(&tmp);
+        if (stat != NULL)
+            stat->requests++, stat->instances++, stat->time += clock() - t0;
     }
     else
         add_pendingfn_0(&syn_pendingfns, name, realname, t, stg, scope, formaltags,
@@ -3640,7 +3717,10 @@ ScopeSaver cur_tformals(void)
 
 static void syn_implicit_instantiate(TagBinder *primary, TagBinder *instance)
 {   TagBinder *instantiatetemplate;
+    TemplateStat *stat = template_stat(bindsym_(instance), instance);
+    clock_t t0 = stat != NULL ? clock() : 0;
 
+    if (stat != NULL) stat->requests++;
     if ((tagbindbits_(instance) & TB_DEFD) || (tagbindbits_(instance) & TB_BEINGDEFD))
         return;
     instantiatetemplate = class_template_reduce(primary, taginstances_(primary),
@@ -3689,6 +3769,7 @@ static void syn_implicit_instantiate(TagBinder *primary, TagBinder *instance)
                 (void)set_access_context(old_access_context, NULL);
             }
             pop_nested_context();
+            if (stat != NULL) stat->instances++, stat->time += clock() - t0;
         }
         cur_template_formals = old_cur_template_formals;
     }
@@ -3740,6 +3821,7 @@ void xsyn_reinit()
 static void xsyn_init(void)
 {   saved_temps = NULL;
     recursing = 0;
+    templstats = NULL, ntemplstats = 0;
 }
 
 /* End of cppfe/xsyn.c */
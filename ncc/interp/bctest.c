@@ -0,0 +1,263 @@
+/*
+ * interp/bctest.c: check the compiled expression evaluator in interp.c
+ * SPDX-Licence-Identifier: Apache-2.0
+ */
+
+/*
+ * Runs each test expression by walking the tree (eval_expr) and through
+ * the bytecode (bc_run) against a small fake target memory, and checks
+ * that the values agree and that the compiled code makes the reads, of
+ * the sizes, that it should.  The debugger is replaced by the stubs
+ * below (and stub/dbg_hdr.h), and the preprocessor by interp.c's own
+ * pp_nextchar(), so this links with ncc's objects less main, vargen and
+ * pp.
+ */
+
+#define NO_DEBUG_TABLES 1
+#include "interp.c"
+#include "mcdep.h"            /* dbg_setformat */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MEMBASE 0x1000
+#define MEMSIZE 0x40
+
+static unsigned char mem[MEMSIZE];
+static int32 nreads[sizeof(ARMword)+1];        /* by access size */
+
+static Dbg_MCState bctest_state;
+static Dbg_Environment bctest_env;
+
+static char const decls[] =
+    "struct S { int w; short h; unsigned short uh;"
+    " signed char c; unsigned char uc; short pad; };"
+    "extern struct S s;"
+    "extern int x, y;"
+    "extern struct S *ps;";
+
+static struct { char const *name; ARMaddress addr; } const syms[] = {
+    { "s",  MEMBASE },
+    { "x",  MEMBASE + 0x10 },
+    { "y",  MEMBASE + 0x14 },
+    { "ps", MEMBASE + 0x18 }
+};
+
+static void memwrite(ARMaddress a, int32 size, unsigned32 v)
+{
+    int32 i;
+
+    for (i = 0; i < size; i++) {
+        int32 k = target_lsbytefirst ? i : size - 1 - i;
+        mem[a - MEMBASE + k] = (unsigned char)(v >> (8*i));
+    }
+}
+
+static unsigned32 memread(ARMaddress a, int32 size)
+{
+    unsigned32 v = 0;
+    int32 i;
+
+    for (i = 0; i < size; i++) {
+        int32 k = target_lsbytefirst ? i : size - 1 - i;
+        v |= (unsigned32)mem[a - MEMBASE + k] << (8*i);
+    }
+    return v;
+}
+
+static bool inmem(ARMaddress a, int32 size)
+{
+    return a >= MEMBASE && a + size <= MEMBASE + MEMSIZE;
+}
+
+static void mem_reset(void)
+{
+    memset(mem, 0, sizeof(mem));
+    memwrite(MEMBASE + 0x00, 4, 0x12345678);    /* s.w  */
+    memwrite(MEMBASE + 0x04, 2, 0xfffe);        /* s.h  = -2 */
+    memwrite(MEMBASE + 0x06, 2, 0x8001);        /* s.uh */
+    memwrite(MEMBASE + 0x08, 1, 0xfd);          /* s.c  = -3 */
+    memwrite(MEMBASE + 0x09, 1, 0xf0);          /* s.uc */
+    memwrite(MEMBASE + 0x10, 4, 0);             /* x    */
+    memwrite(MEMBASE + 0x14, 4, 5);             /* y    */
+    memwrite(MEMBASE + 0x18, 4, MEMBASE);       /* ps = &s */
+    memset(nreads, 0, sizeof(nreads));
+}
+
+Dbg_Error dbg_ReadWord(Dbg_MCState *state, ARMword *word, ARMaddress addr)
+{
+    if (!inmem(addr, 4)) return 1;
+    nreads[4]++;
+    *word = memread(addr, 4);
+    return 0;
+}
+
+Dbg_Error Dbg_ReadHalf(Dbg_MCState *state, ARMhword *hword, ARMaddress addr)
+{
+    if (!inmem(addr, 2)) return 1;
+    nreads[2]++;
+    *hword = (ARMhword)memread(addr, 2);
+    return 0;
+}
+
+Dbg_Error dbg_ReadByte(Dbg_MCState *state, Dbg_Byte *byte, ARMaddress addr)
+{
+    if (!inmem(addr, 1)) return 1;
+    nreads[1]++;
+    *byte = (Dbg_Byte)memread(addr, 1);
+    return 0;
+}
+
+Dbg_Error dbg_WriteWord(Dbg_MCState *state, ARMaddress addr, ARMword word)
+{
+    if (!inmem(addr, 4)) return 1;
+    memwrite(addr, 4, word);
+    return 0;
+}
+
+Dbg_Error Dbg_WriteHalf(Dbg_MCState *state, ARMaddress addr, ARMhword hword)
+{
+    if (!inmem(addr, 2)) return 1;
+    memwrite(addr, 2, hword);
+    return 0;
+}
+
+Dbg_Error dbg_WriteByte(Dbg_MCState *state, ARMaddress addr, Dbg_Byte byte)
+{
+    if (!inmem(addr, 1)) return 1;
+    memwrite(addr, 1, byte);
+    return 0;
+}
+
+void *dbg_LLSymVal(Dbg_MCState *state, void *st, char const *name,
+                   Dbg_LLSymType *type, unsigned32 *val)
+{
+    size_t i;
+
+    for (i = 0; i < sizeof(syms)/sizeof(syms[0]); i++)
+        if (strcmp(syms[i].name, name) == 0) {
+            *type = 0;
+            *val = syms[i].addr;
+            return (void *)&syms[i];
+        }
+    return 0;
+}
+
+int Dbg_CallNaturalSize(Dbg_MCState *state, ARMword fn, int argw,
+                        ARMword *args)
+{
+    return ps_callreturned + 1;         /* no target code to call */
+}
+
+/* Dummy definitions for what main.c, cfe/pp.c and cfe/vargen.c would */
+/* provide in a real compiler.                                         */
+int Tool_EditEnv(ToolEnv *t, HWND wh) { return 0; }
+bool Tool_Configurable(ToolEnv *t, char const *name) { return NO; }
+void pp_notesource(char const *filename, FILE *stream, bool preinclude) {}
+void pp_copy(void) {}
+void pp_tidyup(void) {}
+void pp_predefine(char *s) {}
+void pp_init(FileLine *fl) {}
+bool map_init(FILE *mapstream) { return NO; }
+PragmaSpelling const *keyword_pragma(char const *name, bool *negp) { return 0; }
+FILE *open_builtin_header(const char *name, pp_uncompression_record **urp)
+{
+    return 0;
+}
+void PP_LoadState(FILE *f) {}
+void PP_DumpState(FILE *f) {}
+void vg_generate_deferred_const(Binder *b) {}
+void Vargen_LoadState(FILE *f) {}
+void Vargen_DumpState(FILE *f) {}
+
+/* The expected compiled reads are 4-, 2- and 1-byte counts.  The tree */
+/* walk doesn't short circuit && or || and reads 's.h + s.h' twice, so */
+/* it may read more, but never less.                                   */
+static struct {
+    char *text;
+    int32 words, halves, bytes;
+} const tests[] = {
+    { "s.w + s.h + s.uh + s.c + s.uc",           1, 2, 2 },
+    { "s.h + s.h",                               0, 1, 0 },
+    { "s.c + s.uc + *(unsigned char *)&s.c",     0, 0, 2 },
+    { "*(unsigned char *)&s.h + s.h",            0, 1, 1 },
+    { "x && s.w",                                1, 0, 0 },
+    { "y || s.h",                                1, 0, 0 },
+    { "y && s.c == -3 && s.uc == 0xf0",          1, 0, 2 },
+    { "x ? s.w : s.h",                           1, 1, 0 },
+    { "y ? s.c : s.uc",                          1, 0, 1 },
+    { "(x ? s.h : 0) + s.h",                     1, 1, 0 },
+    { "(y ? s.h : 0) + s.h",                     1, 2, 0 },
+    { "ps->w + ps->h",                           2, 1, 0 },
+    { "x ? 1 : ((x = 7), x + y)",                3, 0, 0 },
+    { "sizeof(s) + s.uh",                        0, 1, 0 }
+};
+
+static bool run_test(int i)
+{
+    char *text = tests[i].text;
+    CompiledExpr *ce;
+    Expr *x;
+    int32 tv, cv, tr[sizeof(ARMword)+1];
+
+    if (setjmp(eval_recover) != 0) {
+        printf("%s: error\n", text);
+        return NO;
+    }
+    ce = compiled_expr(text);
+    if (ce == 0 || ce->code == 0) {
+        printf("%s: not compiled\n", text);
+        return NO;
+    }
+    sp = stack + STACKSIZE;
+    sp = adjust_sp(ce->spoffset);
+    mem_reset();
+    x = eval_expr(ce->e);
+    if (!x || h0_(x) != s_integer) {
+        printf("%s: tree walk gave no value\n", text);
+        return NO;
+    }
+    tv = intval_(x);
+    memcpy(tr, nreads, sizeof(tr));
+    mem_reset();
+    cv = bc_run(ce);
+    sp = adjust_sp(-ce->spoffset);
+    if (cv != tv) {
+        printf("%s: compiled %ld, tree %ld\n", text, (long)cv, (long)tv);
+        return NO;
+    }
+    if (nreads[4] != tests[i].words || nreads[2] != tests[i].halves ||
+            nreads[1] != tests[i].bytes ||
+            nreads[4] > tr[4] || nreads[2] > tr[2] || nreads[1] > tr[1]) {
+        printf("%s: compiled reads %ld/%ld/%ld, expected %ld/%ld/%ld,"
+               " tree %ld/%ld/%ld\n", text,
+               (long)nreads[4], (long)nreads[2], (long)nreads[1],
+               (long)tests[i].words, (long)tests[i].halves,
+               (long)tests[i].bytes,
+               (long)tr[4], (long)tr[2], (long)tr[1]);
+        return NO;
+    }
+    return YES;
+}
+
+int main(void)
+{
+    int i, failed = 0, n = sizeof(tests)/sizeof(tests[0]);
+    TopDecl *t;
+
+    cc_init();
+    dbg_setformat("=-asd");     /* as the driver's config would, for ncc's */
+    cc_dbg_state = &bctest_state;
+    cc_dbg_env = &bctest_env;
+    expr_string = (char *)decls;
+    lex_restart();
+    nextsym();
+    do t = rd_topdecl(YES); while (h0_(t) != s_eof);
+    for (i = 0; i < n; i++)
+        if (!run_test(i)) failed++;
+    mem_reset();
+    cc_rd_expr(&bctest_state, &bctest_env, "s.w + s.c", "");
+    cc_time_expr(&bctest_state, &bctest_env, "s.h + s.h + s.uc", 1000);
+    printf("bctest: %d of %d passed\n", n - failed, n);
+    return failed != 0;
+}
@@ -13,6 +13,8 @@
  */
 
 #include <setjmp.h>
+#include <string.h>
+#include <time.h>
 
 #include "globals.h"
 #include "lex.h"
@@ -27,13 +29,16 @@
 #include "store.h"
 #include "simplify.h"
 #include "util.h"
+#include "compiler.h"
 #ifdef USE_PP
 #include "pp.h"
 #endif
 
 #include "asdfmt.h"
 #include "dbg_hdr.h"
+#ifndef NO_DEBUG_TABLES
 #include "dbg_tbl.h"
+#endif
 
 #ifndef USE_PP
 /* Dummy definitions for stuff in cfe/pp.c */
@@ -43,11 +48,9 @@ int pp_inhashif;
 #else
 FILE *asmstream, *objstream;
 #endif
-bool target_lsbitfirst;
 int32 config;
 char *expr_string;
 
-extern int curchar;
 extern Expr *rd_expr();
 
 static Dbg_MCState *cc_dbg_state;
@@ -60,6 +63,7 @@ typedef char *SP;
 SP sp;
 char stack[STACKSIZE];          /* /* a tiny stack for the moment */
 static int32 max_spoffset;
+static int32 target_reads;       /* count of reads which reach Dbg */
 
 static void inst_decls(Cmd *x, int32 spoffset);
 static void inst_exprdecls(Expr *e, int32 spoffset);
@@ -77,6 +81,7 @@ static Dbg_Error readword(Dbg_MCState *state, ARMword *word, ARMaddress addr)
         *word = *(ARMword *)(addr & ~b_dbgaddr);
         return 0;
     } else {
+        target_reads++;
         return dbg_ReadWord(state, word, addr);
     }
 }
@@ -97,6 +102,7 @@ static Dbg_Error readhalf(Dbg_MCState *state, ARMhword *hword, ARMaddress addr)
         *hword = *(ARMhword *)(addr & ~b_dbgaddr);
         return 0;
     } else {
+        target_reads++;
         return Dbg_ReadHalf(state, hword, addr);
     }
 }
@@ -117,6 +123,7 @@ static Dbg_Error readbyte(Dbg_MCState *state, Dbg_Byte *byte, ARMaddress addr)
         *byte = *(Dbg_Byte *)(addr & ~b_dbgaddr);
         return 0;
     } else {
+        target_reads++;
         return dbg_ReadByte(state, byte, addr);
     }
 }
@@ -131,16 +138,21 @@ static Dbg_Error writebyte(Dbg_MCState *state, ARMaddress addr, Dbg_Byte byte)
     }
 }
 
-static void define(Binder *b)
+static bool try_define(Binder *b)
 {
     Dbg_LLSymType junk;
     unsigned32 val;
     void *llsym;
 
     llsym = dbg_LLSymVal(cc_dbg_state, cc_dbg_env->st, symname_(bindsym_(b)), &junk, &val);
-    if (llsym)
-        bindaddr_(b) = val;
-    else
+    if (!llsym) return NO;
+    bindaddr_(b) = val;
+    return YES;
+}
+
+static void define(Binder *b)
+{
+    if (!try_define(b))
         eval_error("$b not defined\n", b);
 }
 
@@ -169,7 +181,7 @@ static void eval_error(char *s, ...)
 {
     va_list a;
     va_start(a, s);
-    sstart_string_char(s); ssuperrprintf(a);
+    cc_vmsg(s, a);
     va_end(a);
     cc_msg("\n");
     longjmp(eval_recover, 0);
@@ -199,7 +211,7 @@ static int32 read_with_mcrep(ARMaddress a, int32 m)
             readbyte(cc_dbg_state, &b, a);
             i = (int32)(unsigned32)b;
             if ((m & MCR_SORT_MASK) == MCR_SORT_SIGNED)
-                i = (int32)(h << 24) / (1 << 24);
+                i = (int32)(b << 24) / (1 << 24);
             break;
         default:
             eval_error("read_with_mcrep 0x%8x", m);
@@ -524,6 +536,559 @@ Expr *eval_expr(Expr *e)
     }
 }
 
+/* Compiled expressions.                                                */
+/* Conditional breakpoints and watch expressions are evaluated again    */
+/* and again with the same text, so cc_rd_expr() keeps each parsed      */
+/* expression, keyed on its text and the environment it was bound in,  */
+/* and compiles the integer subset of it into a small accumulator and   */
+/* stack code.  Address arithmetic on static objects is folded while    */
+/* compiling, and each (address, size) read at a fixed address gets a  */
+/* snapshot slot: the first BC_LOADK of it in an evaluation makes the   */
+/* Dbg read, at the size the expression asked for, and sets the slot's */
+/* valid bit, so 's.a + s.a' costs one read.  A slot first used in one  */
+/* arm of &&, || or ?: isn't shared with code outside that arm, so no   */
+/* read is made that the tree walk's short circuit wouldn't make.  All  */
+/* the valid bits are cleared at the start of each evaluation and after */
+/* anything handed back to eval_expr() (calls, assignment, aggregates,  */
+/* through BC_EVAL or BC_EXEC), as that may write target memory.       */
+
+typedef enum {
+    BC_END,
+    BC_CONST,           /* k        acc = k                             */
+    BC_LOCAL,           /* k        acc = k + sp                        */
+    BC_PUSH,            /*          push acc                            */
+    BC_LOAD,            /* m        acc = *(m)acc                       */
+    BC_LOADK,           /* i m      acc = (m)snap[i]                    */
+    BC_BINOP,           /* op       acc = pop op acc                    */
+    BC_BINOPK,          /* op k     acc = acc op k                      */
+    BC_UNOP,            /* op       acc = op acc                        */
+    BC_JMPF,            /* l        if (!acc) goto l                    */
+    BC_JMP,             /* l        goto l                              */
+    BC_ANDAND,          /* l        if (!acc) { acc = 0; goto l }       */
+    BC_OROR,            /* l        if (acc) { acc = 1; goto l }        */
+    BC_BOOL,            /*          acc = acc != 0                      */
+    BC_EVAL,            /* e        acc = eval_expr(e)                  */
+    BC_EXEC             /* e        eval_expr(e)                        */
+} BC_Op;
+
+#define BC_MAXCODE      512
+#define BC_MAXSNAP      32      /* one valid bit each in an unsigned32  */
+#define BC_MAXDEPTH     32
+
+typedef struct CompiledExpr {
+    struct CompiledExpr *cdr;
+    char *text;
+    void *st, *proc;
+    IPtr fp;
+    Expr *e;
+    int32 spoffset;
+    IPtr *code;                 /* 0 => evaluate e by tree walking     */
+    int32 nsnap;
+    ARMaddress *snap;           /* address of each snapshot slot       */
+} CompiledExpr;
+
+#define BC_HASHSIZE     64
+static CompiledExpr *bc_cache[BC_HASHSIZE];
+
+static IPtr bc_code[BC_MAXCODE];
+static int32 bc_pc, bc_depth, bc_maxdepth;
+static ARMaddress bc_snap[BC_MAXSNAP];
+static int32 bc_snapsize[BC_MAXSNAP];
+static int32 bc_nsnap;
+static unsigned32 bc_snapshared;        /* slots visible at this point  */
+static bool bc_overflow;        /* too big for bc_code or the stack      */
+
+static bool is_scalar_mcrep(int32 m)
+{
+    return ((m & MCR_SORT_MASK) == MCR_SORT_SIGNED ||
+            (m & MCR_SORT_MASK) == MCR_SORT_UNSIGNED) &&
+           (m & MCR_SIZE_MASK) <= sizeof(ARMword);
+}
+
+/* An expression too big to compile is left to the tree walker, so     */
+/* running out of room only sets bc_overflow.                           */
+static void bc_emit(IPtr w)
+{
+    if (bc_pc >= BC_MAXCODE)
+        bc_overflow = YES;
+    else
+        bc_code[bc_pc++] = w;
+}
+
+/* Point the jump operand at l to the current end of the code.          */
+static void bc_patch(int32 l)
+{
+    if (!bc_overflow) bc_code[l] = bc_pc;
+}
+
+static void bc_push(void)
+{
+    bc_emit(BC_PUSH);
+    if (++bc_depth > bc_maxdepth) {
+        if (bc_depth > BC_MAXDEPTH)
+            bc_overflow = YES;
+        bc_maxdepth = bc_depth;
+    }
+}
+
+static int32 bc_fold(AEop op, int32 i1, int32 i2)
+{
+    /* Must agree with the arithmetic in eval_expr() */
+    switch (op) {
+        case s_plus:            return i1+i2;
+        case s_minus:           return i1-i2;
+        case s_times:           return i1*i2;
+        case s_div:             return i1/i2;
+        case s_rem:             return i1%i2;
+        case s_and:             return i1&i2;
+        case s_or:              return i1|i2;
+        case s_xor:             return i1^i2;
+        case s_andand:          return i1&&i2;
+        case s_oror:            return i1||i2;
+        case s_leftshift:       return i1<<i2;
+        case s_rightshift:      return i1>>i2;
+        case s_equalequal:      return i1==i2;
+        case s_notequal:        return i1!=i2;
+        case s_less:            return i1<i2;
+        case s_lessequal:       return i1<=i2;
+        case s_greater:         return i1>i2;
+        case s_greaterequal:    return i1>=i2;
+        case s_monplus:         return i1;
+        case s_neg:             return -i1;
+        case s_bitnot:          return ~i1;
+        case s_boolnot:         return !i1;
+    }
+    eval_error("Unknown op(%d) in bc_fold", op);
+    return 0;
+}
+
+static bool bc_binaryop(AEop op)
+{
+    switch (op) {
+        case s_plus: case s_minus: case s_times: case s_div: case s_rem:
+        case s_and: case s_or: case s_xor:
+        case s_leftshift: case s_rightshift:
+        case s_equalequal: case s_notequal: case s_less: case s_lessequal:
+        case s_greater: case s_greaterequal:
+            return YES;
+    }
+    return NO;
+}
+
+static bool bc_unaryop(AEop op)
+{
+    return op == s_monplus || op == s_neg || op == s_bitnot || op == s_boolnot;
+}
+
+static bool bc_constval(Expr *e, int32 *val);
+
+/* Is the address of the object e known now?  Frame-relative target     */
+/* autos count, since their address was fixed when the binder was made */
+/* and the cache key includes the frame.  Interpreter locals move with */
+/* sp and registers have no address.                                   */
+static bool bc_constaddr(Expr *e, int32 *addr)
+{
+    Binder *b;
+    int32 a;
+
+    switch (h0_(e)) {
+        case s_binder:
+            b = (Binder *)e;
+            if (bindstg_(b) & bitofstg_(s_register)) return NO;
+            if ((bindstg_(b) & b_undef) && !try_define(b)) return NO;
+            a = bindaddr_(b);
+            if ((bindstg_(b) & bitofstg_(s_auto)) && (a & b_dbgaddr))
+                return NO;
+            *addr = a;
+            return YES;
+        case s_dot:
+            if (!bc_constaddr(arg1_(e), &a)) return NO;
+            *addr = a + exprdotoff_(e);
+            return YES;
+        case s_content:
+            return bc_constval(arg1_(e), addr);
+    }
+    return NO;
+}
+
+static bool bc_constval(Expr *e, int32 *val)
+{
+    int32 i1, i2;
+    AEop op = h0_(e);
+
+    switch (op) {
+        case s_integer:
+            *val = intval_(e);
+            return YES;
+        case s_cast:
+            return bc_constval(arg1_(e), val);
+        case s_addrof:
+            return bc_constaddr(arg1_(e), val);
+        case s_cond:
+            if (!bc_constval(arg1_(e), &i1)) return NO;
+            return bc_constval(i1 ? arg2_(e) : arg3_(e), val);
+        case s_andand:
+        case s_oror:
+            if (!bc_constval(arg1_(e), &i1)) return NO;
+            if (op == s_andand ? !i1 : i1) {
+                *val = op == s_oror;
+                return YES;
+            }
+            if (!bc_constval(arg2_(e), &i2)) return NO;
+            *val = i2 != 0;
+            return YES;
+    }
+    if (bc_unaryop(op)) {
+        if (!bc_constval(arg1_(e), &i1)) return NO;
+        *val = bc_fold(op, i1, 0);
+        return YES;
+    }
+    if (bc_binaryop(op)) {
+        if (!bc_constval(arg1_(e), &i1) || !bc_constval(arg2_(e), &i2))
+            return NO;
+        if ((op == s_div || op == s_rem) && i2 == 0) return NO;
+        *val = bc_fold(op, i1, i2);
+        return YES;
+    }
+    return NO;
+}
+
+/* Index of the snapshot slot for a read of size m at addr, or -1 if   */
+/* they have all gone.  Only slots in bc_snapshared are reused.        */
+static int32 bc_snapslot(ARMaddress addr, int32 m)
+{
+    int32 size = m & MCR_SIZE_MASK;
+    int32 i;
+
+    for (i = 0; i < bc_nsnap; i++)
+        if ((bc_snapshared & (unsigned32)1 << i) &&
+                bc_snap[i] == addr && bc_snapsize[i] == size)
+            return i;
+    if (bc_nsnap >= BC_MAXSNAP) return -1;
+    bc_snap[bc_nsnap] = addr;
+    bc_snapsize[bc_nsnap] = size;
+    bc_snapshared |= (unsigned32)1 << bc_nsnap;
+    return bc_nsnap++;
+}
+
+static void bc_expr(Expr *e);
+
+static void bc_eval(Expr *e, BC_Op op)
+{
+    bc_emit(op);
+    bc_emit((IPtr)e);
+}
+
+static void bc_addr(Expr *e)
+{
+    Binder *b;
+    int32 a;
+
+    if (bc_constaddr(e, &a)) {
+        bc_emit(BC_CONST);
+        bc_emit(a);
+        return;
+    }
+    switch (h0_(e)) {
+        case s_binder:
+            b = (Binder *)e;
+            if ((bindstg_(b) & bitofstg_(s_auto)) && (bindaddr_(b) & b_dbgaddr)) {
+                /* An interpreter local, placed by inst_exprdecls() */
+                bc_emit(BC_LOCAL);
+                bc_emit(bindaddr_(b));
+                return;
+            }
+            break;
+        case s_dot:
+            bc_addr(arg1_(e));
+            bc_emit(BC_BINOPK);
+            bc_emit(s_plus);
+            bc_emit(exprdotoff_(e));
+            return;
+        case s_content:
+            bc_expr(arg1_(e));
+            return;
+    }
+    bc_eval(mk_expr1(s_addrof, ptrtotype_(typeofexpr(e)), e), BC_EVAL);
+}
+
+static void bc_load(Expr *e, int32 m)
+{
+    int32 a, i;
+
+    if (bc_constaddr(e, &a) && (i = bc_snapslot(a, m)) >= 0) {
+        bc_emit(BC_LOADK);
+        bc_emit(i);
+        bc_emit(m);
+        return;
+    }
+    bc_addr(e);
+    bc_emit(BC_LOAD);
+    bc_emit(m);
+}
+
+/* Compile e, which is only evaluated on some paths.                    */
+static void bc_condexpr(Expr *e)
+{
+    unsigned32 shared = bc_snapshared;
+
+    bc_expr(e);
+    bc_snapshared = shared;
+}
+
+static void bc_expr(Expr *e)
+{
+    AEop op = h0_(e);
+    int32 k, l1, l2;
+
+    if (bc_constval(e, &k)) {
+        bc_emit(BC_CONST);
+        bc_emit(k);
+        return;
+    }
+    if (!is_scalar_mcrep(mcrepofexpr(e))) {
+        bc_eval(e, BC_EVAL);
+        return;
+    }
+    switch (op) {
+        case s_let:
+        case s_invisible:
+            bc_expr(arg2_(e));
+            return;
+        case s_cast:
+            if (is_scalar_mcrep(mcrepofexpr(arg1_(e)))) {
+                bc_expr(arg1_(e));
+                return;
+            }
+            break;
+        case s_comma:
+            if (is_scalar_mcrep(mcrepofexpr(arg1_(e))))
+                bc_expr(arg1_(e));
+            else
+                bc_eval(arg1_(e), BC_EXEC);
+            bc_expr(arg2_(e));
+            return;
+        case s_binder:
+        case s_content:
+        case s_dot:
+            if (op == s_binder && (bindstg_((Binder *)e) & bitofstg_(s_register)))
+                break;
+            bc_load(e, mcrepofexpr(e));
+            return;
+        case s_addrof:
+            bc_addr(arg1_(e));
+            return;
+        case s_cond:
+            bc_expr(arg1_(e));
+            bc_emit(BC_JMPF); l1 = bc_pc; bc_emit(0);
+            bc_condexpr(arg2_(e));
+            bc_emit(BC_JMP); l2 = bc_pc; bc_emit(0);
+            bc_patch(l1);
+            bc_condexpr(arg3_(e));
+            bc_patch(l2);
+            return;
+        case s_andand:
+        case s_oror:
+            bc_expr(arg1_(e));
+            bc_emit(op == s_andand ? BC_ANDAND : BC_OROR);
+            l1 = bc_pc; bc_emit(0);
+            bc_condexpr(arg2_(e));
+            bc_emit(BC_BOOL);
+            bc_patch(l1);
+            return;
+        default:
+            if (bc_unaryop(op)) {
+                bc_expr(arg1_(e));
+                bc_emit(BC_UNOP);
+                bc_emit(op);
+                return;
+            }
+            if (bc_binaryop(op)) {
+                bc_expr(arg1_(e));
+                if (bc_constval(arg2_(e), &k) &&
+                        !((op == s_div || op == s_rem) && k == 0)) {
+                    bc_emit(BC_BINOPK);
+                    bc_emit(op);
+                    bc_emit(k);
+                } else {
+                    bc_push();
+                    bc_expr(arg2_(e));
+                    bc_emit(BC_BINOP);
+                    bc_emit(op);
+                    bc_depth--;
+                }
+                return;
+            }
+            break;
+    }
+    bc_eval(e, BC_EVAL);
+}
+
+static void bc_compile(CompiledExpr *ce)
+{
+    Expr *e = ce->e;
+
+    ce->code = 0;
+    ce->nsnap = 0;
+    if (!is_scalar_mcrep(mcrepofexpr(e))) return;
+    bc_pc = bc_depth = bc_maxdepth = 0;
+    bc_nsnap = 0;
+    bc_snapshared = 0;
+    bc_overflow = NO;
+    bc_expr(e);
+    bc_emit(BC_END);
+    if (bc_overflow) return;            /* ce->code == 0: tree walk it  */
+    ce->code = (IPtr *)PermAlloc(bc_pc * sizeof(IPtr));
+    memcpy(ce->code, bc_code, bc_pc * sizeof(IPtr));
+    ce->nsnap = bc_nsnap;
+    if (bc_nsnap > 0) {
+        ce->snap = (ARMaddress *)PermAlloc(bc_nsnap * sizeof(ARMaddress));
+        memcpy(ce->snap, bc_snap, bc_nsnap * sizeof(ARMaddress));
+    }
+}
+
+/* A slot is shared by signed and unsigned reads of the same size, so  */
+/* its value is extended again for each.                               */
+static int32 bc_extend(int32 i, int32 m)
+{
+    int32 size = m & MCR_SIZE_MASK;
+
+    if (size == sizeof(ARMword)) return i;
+    if ((m & MCR_SORT_MASK) == MCR_SORT_SIGNED)
+        return (int32)((unsigned32)i << (32 - 8*size)) >> (32 - 8*size);
+    return i & ((1L << (8*size)) - 1);
+}
+
+static int32 bc_run(CompiledExpr *ce)
+{
+    IPtr *pc = ce->code;
+    int32 acc = 0, i;
+    int32 stk[BC_MAXDEPTH];
+    int32 *top = stk;
+    int32 snap[BC_MAXSNAP];
+    unsigned32 valid = 0;
+    Expr *x;
+
+    for (;;) {
+        switch ((BC_Op)*pc++) {
+            case BC_END:
+                return acc;
+            case BC_CONST:
+                acc = (int32)*pc++;
+                break;
+            case BC_LOCAL:
+                acc = (int32)*pc++ + (int32)sp;
+                break;
+            case BC_PUSH:
+                *top++ = acc;
+                break;
+            case BC_LOAD:
+                acc = read_with_mcrep(acc, (int32)*pc++);
+                break;
+            case BC_LOADK:
+                i = (int32)pc[0];
+                if (!(valid & (unsigned32)1 << i)) {
+                    snap[i] = read_with_mcrep(ce->snap[i], (int32)pc[1]);
+                    valid |= (unsigned32)1 << i;
+                }
+                acc = bc_extend(snap[i], (int32)pc[1]);
+                pc += 2;
+                break;
+            case BC_BINOP:
+                if ((*pc == s_div || *pc == s_rem) && acc == 0)
+                    eval_error("Division by zero");
+                acc = bc_fold((AEop)*pc++, *--top, acc);
+                break;
+            case BC_BINOPK:
+                acc = bc_fold((AEop)pc[0], acc, (int32)pc[1]);
+                pc += 2;
+                break;
+            case BC_UNOP:
+                acc = bc_fold((AEop)*pc++, acc, 0);
+                break;
+            case BC_JMPF:
+                if (!acc) pc = ce->code + *pc; else pc++;
+                break;
+            case BC_JMP:
+                pc = ce->code + *pc;
+                break;
+            case BC_ANDAND:
+                if (!acc) { acc = 0; pc = ce->code + *pc; } else pc++;
+                break;
+            case BC_OROR:
+                if (acc) { acc = 1; pc = ce->code + *pc; } else pc++;
+                break;
+            case BC_BOOL:
+                acc = acc != 0;
+                break;
+            case BC_EVAL:
+                x = eval_expr((Expr *)*pc);
+                if (!x || h0_(x) != s_integer)
+                    eval_error("Cannot evaluate $e", (Expr *)*pc);
+                acc = intval_(x);
+                pc++;
+                valid = 0;
+                break;
+            case BC_EXEC:
+                eval_expr((Expr *)*pc++);
+                valid = 0;
+                break;
+            default:
+                eval_error("Bad compiled expression");
+        }
+    }
+}
+
+static Expr *run_compiled_expr(CompiledExpr *ce)
+{
+    if (ce->code == 0) return eval_expr(ce->e);
+    return mkintconst(typeofexpr(ce->e), bc_run(ce), 0);
+}
+
+static unsigned32 bc_hash(char const *s)
+{
+    unsigned32 h = 0;
+    while (*s) h = h * 31 + (unsigned char)*s++;
+    return h % BC_HASHSIZE;
+}
+
+/* Find (or parse, bind and compile) the expression s in the current    */
+/* environment.  Returns 0 if s doesn't parse; nothing is cached then, */
+/* so the diagnostics come out again next time.                        */
+static CompiledExpr *compiled_expr(char *s)
+{
+    CompiledExpr *ce, **p = &bc_cache[bc_hash(s)];
+    void *st = (void *)cc_dbg_env->st, *proc = (void *)cc_dbg_env->proc;
+    IPtr fp = (IPtr)cc_dbg_env->frame.fp;
+    Expr *e;
+
+    for (ce = *p; ce; ce = ce->cdr)
+        if (ce->st == st && ce->proc == proc && ce->fp == fp &&
+                strcmp(ce->text, s) == 0)
+            return ce;
+    expr_string = s;
+    lex_restart();
+#ifdef USE_PP
+    pp_notesource("<expr>", 0);
+#endif
+    nextsym();
+    push_exprtemp_scope();
+    e = rd_expr(10/*PASTCOMMA*/);
+    if (!e || h0_(e) == s_error) return 0;
+    e = optimise0(e);
+    ce = (CompiledExpr *)PermAlloc(sizeof(CompiledExpr));
+    ce->text = strcpy((char *)PermAlloc(strlen(s) + 1), s);
+    ce->st = st, ce->proc = proc, ce->fp = fp;
+    ce->e = e;
+    max_spoffset = 0;
+    inst_exprdecls(e, 0);
+    ce->spoffset = max_spoffset;
+    bc_compile(ce);
+    ce->cdr = *p;
+    *p = ce;
+    return ce;
+}
+
 static void spaces(int i)
 {
     while (i--) cc_msg(" ");
@@ -629,32 +1194,19 @@ static void display_expr(Expr *e, TypeExpr *t, char *format, int indent)
 
 void cc_rd_expr(Dbg_MCState *state, Dbg_Environment *env, char *s, char *format)
 {
-    Expr *e, *x;
-    int32 i;
+    CompiledExpr *ce;
+    Expr *x;
     TypeExpr *t;
-    int32 spoffset;
-    Expr *edtor;
 
     cc_dbg_state = state;
     cc_dbg_env = env;
-    expr_string = s;
-    curchar = 0;
-#ifdef USE_PP
-    pp_notesource("<expr>", 0);
-#endif
-    nextsym();
     if (setjmp(eval_recover) == 0) {
-        push_exprtemp_scope();
-        e = rd_expr(10/*PASTCOMMA*/);
-        if (e && h0_(e) != s_error) {
-            e = optimise0(e);
+        ce = compiled_expr(s);
+        if (ce) {
             sp = stack + STACKSIZE;
-            max_spoffset = 0;
-            inst_exprdecls(e, 0);
-            spoffset = max_spoffset;
-            sp = adjust_sp(spoffset);
-            x = eval_expr(e);
-            pr_expr(e);
+            sp = adjust_sp(ce->spoffset);
+            x = run_compiled_expr(ce);
+            pr_expr(ce->e);
             if (x) {
                 t = typeofexpr(x);
                 cc_msg(" = [");
@@ -663,13 +1215,51 @@ void cc_rd_expr(Dbg_MCState *state, Dbg_Environment *env, char *s, char *format)
                 display_expr(x, t, format, 0);
             } else
                 cc_msg("void");
-            sp = adjust_sp(-spoffset);
+            sp = adjust_sp(-ce->spoffset);
             cc_msg("\n");
         }
     }
     return;
 }
 
+/* Evaluate s n times by walking the tree and n times with the compiled */
+/* code, and report the time and target reads each took.                */
+void cc_time_expr(Dbg_MCState *state, Dbg_Environment *env, char *s, int32 n)
+{
+    CompiledExpr *ce;
+    clock_t t0, t1, t2;
+    int32 i, r0, r1, r2;
+
+    cc_dbg_state = state;
+    cc_dbg_env = env;
+    if (setjmp(eval_recover) == 0) {
+        ce = compiled_expr(s);
+        if (ce) {
+            sp = stack + STACKSIZE;
+            sp = adjust_sp(ce->spoffset);
+            r0 = target_reads;
+            t0 = clock();
+            for (i = 0; i < n; i++) eval_expr(ce->e);
+            r1 = target_reads;
+            t1 = clock();
+            if (ce->code != 0)
+                for (i = 0; i < n; i++) bc_run(ce);
+            r2 = target_reads;
+            t2 = clock();
+            sp = adjust_sp(-ce->spoffset);
+            pr_expr(ce->e);
+            cc_msg("\n%ld evaluations: tree %ld ticks %ld reads",
+                   (long)n, (long)(t1-t0), (long)(r1-r0));
+            if (ce->code != 0)
+                cc_msg(", compiled %ld ticks %ld reads",
+                       (long)(t2-t1), (long)(r2-r1));
+            else
+                cc_msg(", not compiled");
+            cc_msg("\n");
+        }
+    }
+}
+
 static void inst_exprdecls(Expr *e, int32 spoffset)
 {
     Expr *e1, *e2;
@@ -950,7 +1540,7 @@ Dbg_Error cc_rd_topdecl(Dbg_MCState *state, Dbg_Environment *env, char *s)
     cc_dbg_state = state;
     cc_dbg_env = env;
     expr_string = 0;
-    curchar = 0;
+    lex_restart();
 #ifdef USE_PP
     while (isspace(*s)) s++;
     if (*s) {
@@ -967,7 +1557,7 @@ Dbg_Error cc_rd_topdecl(Dbg_MCState *state, Dbg_Environment *env, char *s)
 #endif
     nextsym();
     while (1) {
-        t = rd_topdecl();
+        t = rd_topdecl(YES);
         pr_topdecl(t);
         sp = stack + STACKSIZE;
         if (h0_(t) == s_eof)
@@ -975,7 +1565,6 @@ Dbg_Error cc_rd_topdecl(Dbg_MCState *state, Dbg_Environment *env, char *s)
         else if (h0_(t) == s_fndef) {
             cc_msg("Defined function $b\n", t->v_f.fn.name);
             bindaddr_(t->v_f.fn.name) = (IPtr)t | b_dbgaddr;
-            t->v_f.fn.structresult = currentfunction.structresult;
         }
     }
 #ifdef USE_PP
@@ -984,6 +1573,7 @@ Dbg_Error cc_rd_topdecl(Dbg_MCState *state, Dbg_Environment *env, char *s)
     return 0;
 }
 
+#ifndef NO_DEBUG_TABLES
 static int gensymno;
 
 typedef struct Faked_TypeExpr {
@@ -1238,18 +1828,13 @@ Symstr *int_sym_lookup(char const *name, int glo)
 
     return sym;
 }
+#endif /* NO_DEBUG_TABLES */
 
 /* Dummy definitions for stuff in cfe/vargen.c */
 void initstaticvar(Binder *b, bool topflag)
 {
 }
 
-void compile_abort(int sig_no)
-{
-    /* May be a bit unfriendly for an interactive program */
-    exit(1);
-}
-
 #ifndef USE_PP
 int pp_nextchar(void)
 {
@@ -1263,6 +1848,22 @@ int pp_nextchar(void)
 }
 #endif
 
+/* There's no driver to take the diagnostics, so print them here.       */
+static int interp_backchat(void *handle, unsigned code, const void *msg)
+{
+    backchat_Diagnostic const *diag = (backchat_Diagnostic const *)msg;
+    char b[256];
+
+    if (code == BC_DIAGMSG) {
+        if (diag->severity != BC_SEVERITY_NONE) {
+            cc_announce_error(b, diag->severity, diag->filename, diag->lineno);
+            fputs(b, stdout);
+        }
+        fputs(diag->msgtext, stdout);
+    }
+    return 0;
+}
+
 extern void cc_init(void)
 {
     int i;
@@ -1274,9 +1875,11 @@ extern void cc_init(void)
     feature &= ~(FEATURE_PCC|FEATURE_CPP|FEATURE_CFRONT);
 #endif
     expr_string = "";
-    errstate_init();
+    errstate_initialise();
+    errstate_perfileinit();
     aetree_init();
-    alloc_init();
+    alloc_initialise();
+    alloc_perfileinit();            /* the whole session is one "file" */
 #ifndef USE_PP
     for (i = 0; i <= 'z'-'a'; i++)
         pp_pragmavec[i] = -1;
@@ -1290,4 +1893,6 @@ extern void cc_init(void)
     builtin_init();
     sem_init();
     syn_init();
+    backchat.send = interp_backchat;
+    backchat.handle = NULL;
 }
@@ -0,0 +1,50 @@
+/*
+ * interp/stub/dbg_hdr.h: the part of the debugger interface interp.c uses
+ * SPDX-Licence-Identifier: Apache-2.0
+ */
+
+/*
+ * The debugger's own dbg_hdr.h isn't in this tree.  This declares just
+ * the target memory, call and symbol interface that interp.c needs, so
+ * that interp/bctest.c can build it against fake target memory.
+ */
+
+#ifndef _dbg_hdr_LOADED
+#define _dbg_hdr_LOADED 1
+
+typedef unsigned32 ARMword;
+typedef unsigned short ARMhword;
+typedef unsigned char Dbg_Byte;
+typedef unsigned32 ARMaddress;
+
+typedef int Dbg_Error;
+typedef int Dbg_LLSymType;
+
+typedef struct Dbg_MCState {
+    struct {
+        union { int32 intres; } res;
+    } call;
+} Dbg_MCState;
+
+typedef struct Dbg_Environment {
+    void *st;                   /* symbol table                        */
+    void *proc;                 /* procedure                           */
+    struct { ARMword fp; } frame;
+} Dbg_Environment;
+
+#define ps_callreturned 0
+
+extern Dbg_Error dbg_ReadWord(Dbg_MCState *, ARMword *, ARMaddress);
+extern Dbg_Error Dbg_ReadHalf(Dbg_MCState *, ARMhword *, ARMaddress);
+extern Dbg_Error dbg_ReadByte(Dbg_MCState *, Dbg_Byte *, ARMaddress);
+extern Dbg_Error dbg_WriteWord(Dbg_MCState *, ARMaddress, ARMword);
+extern Dbg_Error Dbg_WriteHalf(Dbg_MCState *, ARMaddress, ARMhword);
+extern Dbg_Error dbg_WriteByte(Dbg_MCState *, ARMaddress, Dbg_Byte);
+
+extern void *dbg_LLSymVal(Dbg_MCState *, void *st, char const *name,
+                          Dbg_LLSymType *type, unsigned32 *val);
+
+extern int Dbg_CallNaturalSize(Dbg_MCState *, ARMword fn, int argw,
+                               ARMword *args);
+
+#endif
@@ -101,10 +101,8 @@ static int lang_namecmp(char *s, char *t)
 #include "dbg_hl.h"
 #endif
 
-Symstr *sym_lookup(char const *name, int glo)
+static Symstr *sym_lookup_1(char const *name, int glo, unsigned32 hash)
 {   int32 wsize;
-    unsigned32 hash, temp;
-    char const *s;
     Symstr *next, **lvptr = NULL;
   /*
    * 'glo' ==  SYM_LOCAL  => allocate in Binder store
@@ -118,12 +116,6 @@ Symstr *sym_lookup(char const *name, int glo)
 #ifdef CALLABLE_COMPILER
         if ((next = dbg_findhash(name)) != NULL) return next;
 #endif
-        hash = 1;
-        for (s = name; *s != 0; ++s)
-        {   temp = just32bits_(hash << 7);
-            hash = ((hash >> 25)^(temp >> 1)^(temp >> 4) ^
-                                             lang_hashofchar(*s)) & 0x7fffffff;
-        }
         lvptr = &(*hashvec)[hash % BIND_HASHSIZE];
         while ((next = *lvptr) != NULL)
         {   if (lang_namecmp(symname_(next), name) == 0) return(next);
@@ -166,6 +158,21 @@ Symstr *sym_lookup(char const *name, int glo)
     return(next);
 }
 
+Symstr *sym_lookup(char const *name, int glo)
+{   unsigned32 hash = SYM_HASHINIT;
+    if (!(glo & NO_CHAIN))
+    {   char const *s;
+        for (s = name; *s != 0; ++s)
+            hash = sym_hashstep_(hash, lang_hashofchar(*s));
+    }
+    return sym_lookup_1(name, glo, hash);
+}
+
+/* For callers (the lexer) which have hashed the name while reading it. */
+Symstr *sym_lookup_hashed(char const *name, unsigned32 hash)
+{   return sym_lookup_1(name, SYM_GLOBAL, hash);
+}
+
 Symstr *sym_insert(char const *name, AEop type)
 {   Symstr *p = (sym_lookup)(name, SYM_GLOBAL);
     symtype_(p) = type;
@@ -589,31 +596,188 @@ static Scope *set_local_block_scope(void)
     return scope0;
 }
 
-static TagBinder *findtag_in_members(Symstr *sv, ClassMember *ll)
-{   TagBinder *l = (TagBinder *)ll;
-    for (; l != NULL;  l = tagbindcdr_(l))
-    {   if (debugging(DEBUG_BIND))
-            cc_msg("findtag try $r %lx\n", memsv_(l), (long)attributes_(l));
-        if (h0_(l) == s_tagbind &&
-            (h0_(sv)==s_tagbind && l == (TagBinder *)sv || tagbindsym_(l)==sv))
-                break;
-        /* this happens only in template arg scope where the tagbinders
-           were deliberately lost.
-         */
-        if (tagbindsym_(l) == sv && isclasstype_(princtype(tagbindtype_(l))))
-        {   Expr *deftexpr = bindconst_((ClassMember *)l);
-            TagBinder *res = typespectagbind_(princtype(tagbindtype_(l)));
-            if (local_scope->class_tag != NULL &&
-                !(tagbindbits_(local_scope->class_tag) & TB_TEMPLATE) &&
-                deftexpr != NULL)
-            {   if (!isclasstype_(princtype(type_(deftexpr))))
-                    syserr("default class type expected");
-                res = typespectagbind_(princtype(type_(deftexpr)));
-            }
-            return res;
+/* Member name indices for completed classes.  A class's member list is  */
+/* only appended to while TB_BEINGDEFD, so once the class is complete a  */
+/* hash from member name to the same-named members (in list order) can   */
+/* replace the list walk in path_to_member_1() and findtagbinding().     */
+/* Indices are built lazily on first lookup; the head and tail of the    */
+/* list are remembered so that a list altered since is re-indexed.       */
+/* Classes with few members are not worth indexing and are marked so.    */
+
+#define MEMINDEX_CLASSES   256L     /* buckets of class -> index hash    */
+#define MEMINDEX_MINMEMS     8L     /* smaller classes use the list      */
+#define MEMABSENT_SIZE    1024L     /* (class, name) absent cache        */
+
+typedef struct MemIndexEntry MemIndexEntry;
+struct MemIndexEntry {
+    MemIndexEntry *cdr;             /* next in bucket, in list order     */
+    ClassMember *mem;
+};
+
+typedef struct MemIndex MemIndex;
+struct MemIndex {
+    MemIndex *cdr;
+    TagBinder *cl;
+    ClassMember *head, *tail;       /* member list when indexed          */
+    int32 mask;                     /* bucket count - 1, or -1 if none   */
+    MemIndexEntry **buckets;
+};
+
+static MemIndex *(*memindexvec)[MEMINDEX_CLASSES];
+static struct { TagBinder *cl; Symstr *sv; } (*memabsentvec)[MEMABSENT_SIZE];
+
+#define memindexhash_(p) ((unsigned32)((IPtr)(p) >> 3) * 0x9e3779b1UL)
+
+static bool memindexable(TagBinder *cl)
+{   return (tagbindbits_(cl) & (TB_DEFD|TB_BEINGDEFD)) == TB_DEFD;
+}
+
+static void memindex_build(MemIndex *x)
+{   ClassMember *l, *tail = NULL;
+    int32 n = 0, size;
+    for (l = tagbindmems_(x->cl);  l != NULL;  l = memcdr_(l)) tail = l, n++;
+    x->head = tagbindmems_(x->cl), x->tail = tail;
+    if (n < MEMINDEX_MINMEMS)
+    {   x->mask = -1, x->buckets = NULL;
+        return;
+    }
+    for (size = 16;  size < 2*n;  size <<= 1) continue;
+    x->mask = size - 1;
+    x->buckets = (MemIndexEntry **)GlobAlloc(SU_Bind, size * sizeof(MemIndexEntry *));
+    memset(x->buckets, 0, (size_t)size * sizeof(MemIndexEntry *));
+    for (l = x->head;  l != NULL;  l = memcdr_(l))
+    {   MemIndexEntry **q = &x->buckets[memindexhash_(memsv_(l)) >> 8 & x->mask];
+        MemIndexEntry *e = (MemIndexEntry *)GlobAlloc(SU_Bind, sizeof(MemIndexEntry));
+        while (*q != NULL) q = &(*q)->cdr;
+        e->cdr = NULL, e->mem = l;
+        *q = e;
+    }
+}
+
+/* Returns the index for cl, or NULL if cl's list must be walked.       */
+static MemIndex *class_memindex(TagBinder *cl)
+{   MemIndex **p, *x;
+    if (!memindexable(cl)) return NULL;
+    p = &(*memindexvec)[memindexhash_(cl) >> 8 & (MEMINDEX_CLASSES-1)];
+    for (x = *p;  x != NULL;  x = x->cdr)
+        if (x->cl == cl) break;
+    if (x == NULL)
+    {   x = (MemIndex *)GlobAlloc(SU_Bind, sizeof(MemIndex));
+        x->cdr = *p, x->cl = cl;
+        *p = x;
+        memindex_build(x);
+    }
+    else if (x->head != tagbindmems_(cl) ||
+             (x->tail != NULL && memcdr_(x->tail) != NULL))
+    {   /* Members have been added: forget every cached absence.        */
+        memset(memabsentvec, 0, sizeof(*memabsentvec));
+        memindex_build(x);
+    }
+    return x->mask < 0 ? NULL : x;
+}
+
+/* Iteration over the members of a class which may be called sv: all    */
+/* of them if sv is NULL or the class is not indexed.                    */
+typedef struct MemIter {
+    Symstr *sv;
+    MemIndexEntry *e;
+} MemIter;
+
+static ClassMember *MemIter_next(MemIter *it, ClassMember *l)
+{   MemIndexEntry *e = it->e;
+    if (e == NULL) return l == NULL ? NULL : memcdr_(l);
+    for (e = e->cdr;  e != NULL;  e = e->cdr)
+        if (memsv_(e->mem) == it->sv) break;
+    if ((it->e = e) == NULL) return NULL;
+    return e->mem;
+}
+
+static ClassMember *MemIter_first(MemIter *it, TagBinder *cl, Symstr *sv)
+{   MemIndex *x = sv == NULL ? NULL : class_memindex(cl);
+    MemIndexEntry *e;
+    it->sv = sv, it->e = NULL;
+    if (x == NULL) return tagbindmems_(cl);
+    for (e = x->buckets[memindexhash_(sv) >> 8 & x->mask];  e != NULL;  e = e->cdr)
+        if (memsv_(e->mem) == sv) break;
+    if ((it->e = e) == NULL)
+    {   it->sv = NULL;          /* definitely absent: iteration is over  */
+        return NULL;
+    }
+    return e->mem;
+}
+
+#ifdef CPLUSPLUS
+/* YES if no member called sv can be found in cl or in any class it is  */
+/* derived from, so that path_to_member_2() on cl would find nothing    */
+/* and have no side effects.  Only complete classes whose size is known */
+/* qualify; positive answers are cached.                                */
+static bool class_lacks_member(TagBinder *cl, Symstr *sv)
+{   MemIter it;
+    ClassMember *l;
+    unsigned32 h = (memindexhash_(cl) ^ memindexhash_(sv)) >> 8;
+    if ((*memabsentvec)[h & (MEMABSENT_SIZE-1)].cl == cl &&
+        (*memabsentvec)[h & (MEMABSENT_SIZE-1)].sv == sv)
+        return YES;
+    if (!memindexable(cl) || !(tagbindbits_(cl) & TB_SIZECACHED) ||
+        class_memindex(cl) == NULL)
+        return NO;
+    if (MemIter_first(&it, cl, sv) != NULL) return NO;
+    /* Core, base and virtual base members lead the member list.        */
+    for (l = tagbindmems_(cl);  l != NULL;  l = memcdr_(l))
+    {   TypeExpr *t;
+        if (h0_(l) != s_member ||
+            !(attributes_(l) & (CB_CORE|CB_BASE|CB_VBPTR|CB_VBASE)))
+            break;
+        t = princtype(memtype_(l));
+        if (attributes_(l) & CB_VBPTR) t = princtype(typearg_(t));
+        if (!isclasstype_(t) || !class_lacks_member(typespectagbind_(t), sv))
+            return NO;
+    }
+    (*memabsentvec)[h & (MEMABSENT_SIZE-1)].cl = cl;
+    (*memabsentvec)[h & (MEMABSENT_SIZE-1)].sv = sv;
+    return YES;
+}
+#endif
+
+static TagBinder *findtag_member(Symstr *sv, TagBinder *l)
+{   if (debugging(DEBUG_BIND))
+        cc_msg("findtag try $r %lx\n", memsv_(l), (long)attributes_(l));
+    if (h0_(l) == s_tagbind &&
+        (h0_(sv)==s_tagbind && l == (TagBinder *)sv || tagbindsym_(l)==sv))
+            return l;
+    /* this happens only in template arg scope where the tagbinders
+       were deliberately lost.
+     */
+    if (tagbindsym_(l) == sv && isclasstype_(princtype(tagbindtype_(l))))
+    {   Expr *deftexpr = bindconst_((ClassMember *)l);
+        TagBinder *res = typespectagbind_(princtype(tagbindtype_(l)));
+        if (local_scope->class_tag != NULL &&
+            !(tagbindbits_(local_scope->class_tag) & TB_TEMPLATE) &&
+            deftexpr != NULL)
+        {   if (!isclasstype_(princtype(type_(deftexpr))))
+                syserr("default class type expected");
+            res = typespectagbind_(princtype(type_(deftexpr)));
         }
+        return res;
     }
-    return l;
+    return NULL;
+}
+
+static TagBinder *findtag_in_members(Symstr *sv, ClassMember *ll)
+{   TagBinder *l = (TagBinder *)ll, *b;
+    for (; l != NULL;  l = tagbindcdr_(l))
+        if ((b = findtag_member(sv, l)) != NULL) return b;
+    return NULL;
+}
+
+static TagBinder *findtag_in_class(Symstr *sv, TagBinder *cl)
+{   MemIter it;
+    ClassMember *l;
+    TagBinder *b;
+    if (h0_(sv) != s_identifier) return findtag_in_members(sv, tagbindmems_(cl));
+    for (l = MemIter_first(&it, cl, sv);  l != NULL;  l = MemIter_next(&it, l))
+        if ((b = findtag_member(sv, (TagBinder *)l)) != NULL) return b;
+    return NULL;
 }
 
 /* @@@ no access control? */
@@ -634,22 +798,21 @@ TagBinder *findtagbinding(Symstr *sv, TagBinder *cl, int fbflags)
                     break;
                 }
         }
-        return findtag_in_members(sv, tagbindmems_(core_class(cl)));
+        return findtag_in_class(sv, core_class(cl));
     }
 
     if (fbflags == ALLSCOPES)
         for (scope = local_scope;  scope != NULL;  scope = scope->prev)
-        {   ClassMember *l;
-            TagBinder *b;
+        {   TagBinder *b;
             if ((cl = scope->class_tag) != NULL)
             {   if (LanguageIsCPlusPlus)
-                    l = tagbindmems_(core_class(cl));
+                    b = findtag_in_class(sv, core_class(cl));
                 else
                     continue;           /* C class scopes don't nest.   */
             }
             else
-                l = scope->scopemems;
-            if ((b = findtag_in_members(sv, l)) != 0)
+                b = findtag_in_members(sv, scope->scopemems);
+            if (b != 0)
                 return (tag_found_in_local_scope = first, b);
             first = 0;
         }
@@ -691,6 +854,7 @@ static TagBinder *startScope;       /* another one */
 static Expr *path_to_member_1(ClassMember *member, TagBinder *tb, int flags,
         ClassMember *vbases, TagBinder *privately_deriving_class)
 {   ClassMember *l;
+    MemIter it;
 
     /* This can never happen C-only... */
     if (qualifyingBase != 0 &&
@@ -706,7 +870,9 @@ if (!(flags & FB_NOTYET))
         tagbindbits_(tb) |= opaque;
     }
 
-    for (l = tagbindmems_(tb);  l != NULL;  l = memcdr_(l))
+    for (l = MemIter_first(&it, tb, h0_(member) == s_identifier ?
+                                        (Symstr *)member : memsv_(member));
+         l != NULL;  l = MemIter_next(&it, l))
     {   if (debugging(DEBUG_BIND))
             cc_msg("see $r %lx in $c\n", memsv_(l), (long)attributes_(l), tb);
         if (h0_(member) == s_identifier)
@@ -2348,6 +2514,11 @@ void bind_init(void)
     hashvec = (Symstr *((*)[BIND_HASHSIZE]))
         GlobAlloc(SU_Other, sizeof(*hashvec));
     for (i = 0; i < BIND_HASHSIZE; i++) (*hashvec)[i] = NULL;
+    memindexvec = (MemIndex *((*)[MEMINDEX_CLASSES]))
+        GlobAlloc(SU_Bind, sizeof(*memindexvec));
+    memset(memindexvec, 0, sizeof(*memindexvec));
+    memabsentvec = GlobAlloc(SU_Bind, sizeof(*memabsentvec));
+    memset(memabsentvec, 0, sizeof(*memabsentvec));
 }
 
 /* end of bind.c */
@@ -41,6 +41,15 @@ extern const char *sym_name_table[];  /* translation back to strings  */
 
 extern Symstr *(sym_lookup)(char const *name, int glo);
 
+/* The symbol table hash, one character at a time, so that the lexer    */
+/* can hash an identifier as it reads it and call sym_lookup_hashed().  */
+#define SYM_HASHINIT 1
+#define sym_hashstep_(h, c) \
+    ((((h) >> 25) ^ (just32bits_((h) << 7) >> 1) ^ \
+      (just32bits_((h) << 7) >> 4) ^ (c)) & 0x7fffffff)
+
+extern Symstr *sym_lookup_hashed(char const *name, unsigned32 hash);
+
 extern Symstr *sym_insert(char const *name, AEop type);
 
 extern Symstr *sym_insert_id(char const *name);
@@ -522,7 +522,8 @@ case s_rem:
                           && h0_(arg2_(x)) != s_integer) return ISHARD;
 #endif
 #ifndef TARGET_HAS_DIVIDE
-        if ((op == s_div || op == s_rem) && h0_(arg2_(x)) != s_integer)
+        if (!target_has_divide &&
+            (op == s_div || op == s_rem) && h0_(arg2_(x)) != s_integer)
             return ISHARD;
 #endif
         return max_(ISEXPR, nr);            /* always a little bit hard. */
@@ -551,8 +552,10 @@ static BindList *datasegbinders;
 #define cg_divrem(op,type,fname,a1,a2) \
         cg_binary(op,a1,a2,0,INTREG)
 #else
+/* target_has_divide may still select the instructions at run time (thumb) */
 #define cg_divrem(op,type,fname,a1,a2) \
-        cg_binary_or_fn(op,type,fname,a1,a2,0)
+        (target_has_divide ? cg_binary(op,a1,a2,0,INTREG) : \
+                             cg_binary_or_fn(op,type,fname,a1,a2,0))
 #endif
 
 #define mkArg(x,y)        ((Expr*)mkExprList(x,y))
@@ -100,12 +100,16 @@ LabList *asm_lablist;         /* @@@ This is not really part of codebuf */
                               /* here as "gen/obj/asm support.          */
 
 /* For the sake of a cleaner separation between the FE and the BE       */
+/* A caller holding on to the tail must not see it grow, so these close */
+/* any open LIT_BYTES block.                                            */
 DataInit *get_datadesc_ht(bool head)
-{   return (head) ? datap->head : datap->tail;
+{   datap->blockfree = 0;
+    return (head) ? datap->head : datap->tail;
 }
 
 void set_datadesc_ht(bool head, DataInit *val)
-{   if (head) datap->head = val; else datap->tail = val;
+{   datap->blockfree = 0;
+    if (head) datap->head = val; else datap->tail = val;
 }
 
 int32 get_datadesc_size(void)
@@ -137,11 +141,13 @@ DataDesc *get_datadesc(void)
 }
 
 void copy_datadesc(DataDesc *dest)
-{   *dest = data;
+{   data.blockfree = 0;
+    *dest = data;
 }
 
 void restore_datadesc(DataDesc *src)
 {   data = *src;
+    data.blockfree = 0;
 }
 
 int32 data_size(void)
@@ -308,6 +314,7 @@ static void adddata1(DataInit *x)
 #endif
     if (datap->head == 0) datap->head = datap->tail = x;
     else datap->tail->datacdr = x, datap->tail = x;
+    datap->blockfree = 0;
 }
 
 static void adddata(DataInit *a, int32 b, int32 c, IPtr d, IPtr e)
@@ -316,6 +323,48 @@ static void adddata(DataInit *a, int32 b, int32 c, IPtr d, IPtr e)
     adddata1(x);
 }
 
+#ifdef TARGET_HAS_DATA_BLOCKS
+/* Runs of complete data words are kept as byte images in target sex    */
+/* (LIT_BYTES) rather than as a DataInit each, which for big tables     */
+/* costs several times the size of the data and a long list walk in the */
+/* object writer.  Blocks start small (most statics are) and double in  */
+/* size up to datablock_max while a run continues.  Assembly output     */
+/* wants the individual LIT_xxx sorts, so is left alone.                */
+#define datablock_min   16
+#define datablock_max   4096
+#define datablock_zeros 16      /* zero runs this short join a block    */
+
+static void adddataword(int32 sort, int32 w)
+{   if (asmstream == NULL)
+    {   DataInit *x = datap->tail;
+        unsigned32 v = (unsigned32)totargetsex(w, (int)sort);
+        unsigned8 *b;
+        if (datap->blockfree <= 0)
+        {   int32 n = datablock_min;
+            if (datap->blockfree < 0 && (n = 2 * x->len) > datablock_max)
+                n = datablock_max;
+            adddata(0, 1, LIT_BYTES, 0,
+                    (IPtr)GlobAlloc(SU_Data, n));
+            x = datap->tail;
+            datap->blockfree = n;
+        }
+        b = (unsigned8 *)x->val + x->len;
+        if (target_lsbytefirst)
+            b[0] = (unsigned8)v, b[1] = (unsigned8)(v >> 8),
+            b[2] = (unsigned8)(v >> 16), b[3] = (unsigned8)(v >> 24);
+        else
+            b[0] = (unsigned8)(v >> 24), b[1] = (unsigned8)(v >> 16),
+            b[2] = (unsigned8)(v >> 8), b[3] = (unsigned8)v;
+        x->len += 4;
+        if ((datap->blockfree -= 4) == 0) datap->blockfree = -1;
+        return;
+    }
+    adddata(0, 1, sort, 4, w);
+}
+#else
+#define adddataword(sort, w) adddata(0, 1, sort, 4, w)
+#endif
+
 /* (sizeof_ptr == 2) or unaligned */
 /* This routine outputs a LIT_BBX or LIT_HX just before a LIT_ADCON in   */
 /* the case where pointers are 2 bytes long.  In this case not all data  */
@@ -380,7 +429,7 @@ void gendcI_a(int32 len, int32 val, bool aligned)
             case 13: lit_flag = LIT_BBH;    break;
         }
         datap->wpos = 0, datap->wtype = 0;
-        adddata(0, 1, lit_flag, 4, datap->wbuff.w32[0]);
+        adddataword(lit_flag, datap->wbuff.w32[0]);
     }
     datap->size += len;
 }
@@ -456,6 +505,13 @@ void gendc0(int32 nbytes)
 {   if (debugging(DEBUG_DATA))
         cc_msg("%.6lx:   DC %ldX'00'\n", (long)datap->size, (long)nbytes);
     while (nbytes != 0 && datap->wpos != 0) gendcI(1,0), nbytes--;
+#ifdef TARGET_HAS_DATA_BLOCKS
+    if (datap->blockfree != 0 && nbytes <= datablock_zeros)
+    {   int32 n;
+        for (n = nbytes>>2; n != 0; n--) adddataword(LIT_NUMBER, 0);
+    }
+    else
+#endif
     if ((nbytes>>2) != 0)
         adddata(0, nbytes>>2, LIT_NUMBER, 4, 0);
     while (nbytes & 3) gendcI(1,0), nbytes--;
@@ -492,6 +548,7 @@ void padstatic(int32 align)
 void labeldata(Symstr *s)
 {
     vg_wflush();                /* only if sizeof_ptr == 2 */
+    datap->blockfree = 0;       /* keep each object's data separate */
     if (asmstream != NULL       /* nasty space-saving hack */
         && s != NULL)           /* labeldata(NULL) provides access to vg_wflush() externally */
         adddata1((DataInit *)global_list5(SU_Data, (DataInit *)0, s, LIT_LABEL, 0, 0));
@@ -509,7 +566,7 @@ void labeldata(Symstr *s)
  */
 
 int32 trydeletezerodata(DataInit *previous, int32 minsize)
-{   int32 size = 0;
+{   int32 size = 0, qzeros = 0;
     DataInit *p,*q = previous;
     for (p = q ? q->datacdr : datap->head; p; p = p->datacdr)
         switch (p->sort)
@@ -518,11 +575,26 @@ int32 trydeletezerodata(DataInit *previous, int32 minsize)
                 if (p->val == 0) { size += p->rpt * 4; break; }
                 /* else drop through */
             default:
-                size = 0, q = p;
+                size = 0, q = p, qzeros = 0;
+                break;
+#ifdef TARGET_HAS_DATA_BLOCKS
+            case LIT_BYTES:
+            {   /* whole words of trailing zeros can be cut off a block */
+                unsigned8 const *b = (unsigned8 const *)p->val;
+                int32 n = p->len;
+                while (n >= 4 && (b[n-1] | b[n-2] | b[n-3] | b[n-4]) == 0)
+                    n -= 4;
+                if (n == 0) { size += p->len; break; }
+                size = qzeros = p->len - n, q = p;
+                break;
+            }
+#endif
         }
     if (size >= minsize)
-    {   if (q==0) datap->head = 0; else datap->tail=q, q->datacdr=0;
+    {   if (q==0) datap->head = 0;
+        else datap->tail=q, q->datacdr=0, q->len -= qzeros;
         datap->size -= size;
+        datap->blockfree = 0;
         return size;
     }
     return 0;
@@ -1200,16 +1272,20 @@ void codebuf_init(void)
     data.head = NULL;  data.tail = NULL;
     data.size = 0; data.xrefs = NULL; data.xrarea = xr_data;
     data.wpos = 0, data.wtype = 0, data.wbuff.w32[0] = 0;
+    data.blockfree = 0;
     extable.head = NULL; extable.size = 0;
     extable.xrefs = NULL; extable.xrarea = xr_constdata;
     extable.wpos = 0; extable.wtype = 0; extable.wbuff.w32[0] = 0;
+    extable.blockfree = 0;
     exhandler.head = NULL; exhandler.size = 0;
     exhandler.xrefs = NULL; exhandler.xrarea = xr_constdata;
     exhandler.wpos = 0; exhandler.wtype = 0; exhandler.wbuff.w32[0] = 0;
+    exhandler.blockfree = 0;
 #ifdef CONST_DATA_IN_CODE
     constdata.head = NULL; constdata.size = 0;
     constdata.xrefs = NULL; constdata.xrarea = xr_constdata;
     constdata.wpos = 0; constdata.wtype = 0; constdata.wbuff.w32[0] = 0;
+    constdata.blockfree = 0;
 #endif
     datap = &data;
 #ifdef TARGET_CALL_USES_DESCRIPTOR
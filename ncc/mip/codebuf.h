@@ -29,6 +29,8 @@ typedef struct DataDesc {
     union { int32 w32[1]; int16 w16[2]; int8 w8[4]; } wbuff;
     uint8 wpos;
     uint8 wtype;
+    int32 blockfree;    /* room in tail LIT_BYTES block: 0 if closed,   */
+                        /* -1 if full (the next block may be bigger).   */
 } DataDesc;
 
 typedef enum {
@@ -143,6 +143,9 @@ static const char *asmfile, *listingfile, *makefile;
 /* to a different symbol from on ANSI (as their results differ).        */
 static char const *system_flavour;
 static FILE *makestream;
+/* makefile is written under the name maketemp (if non-empty) and only   */
+/* renamed when complete, so make never sees a truncated dependency list */
+static char maketemp[MAX_NAME];
 #ifndef NO_DUMP_STATE
 static char const *compiledheader;
 static FILE *dumpstream;
@@ -171,6 +174,9 @@ static void set_time_stamp(const char *file, bool good)
 #else
 #  define DEPEND_FORMAT     "%s:\t%s\n"
 #endif
+/* In-store headers have no file to depend on, so are only noted.       */
+#define DEPEND_INSTORE_FORMAT "# %s:\t<%s> (in store)\n"
+#define MAKEFILE_TMPSUFFIX  "-tmp"
 
 /*
  * Abort compilation if major fault found.
@@ -245,7 +251,8 @@ extern void compile_abort(int sig_no)
 #endif
     if (makestream != NULL)
     {   cc_close(&makestream, makefile);
-        if (makefile != NULL) remove(makefile);
+        if (maketemp[0] != 0) remove(maketemp);
+        else if (makefile != NULL) remove(makefile);
     }
 #ifndef NO_DUMP_STATE
     if (dumpstream != NULL)
@@ -795,6 +802,7 @@ static void cleanup(void)
   {
       cc_msg("Time: %ldcs front-end %ldcs back-end\n",
              (long) tmuse_front,(long) tmuse_back);
+      syn_template_stats();
       show_store_use();
   }
 
@@ -829,6 +837,13 @@ static void cleanup(void)
 
   cc_close(&listingstream, listingfile);
   cc_close(&makestream, makefile);
+  if (maketemp[0] != 0)
+  {   /* Not all hosts' rename() will replace an existing file.         */
+      if (rename(maketemp, makefile) != 0 &&
+          (remove(makefile), rename(maketemp, makefile) != 0))
+          cc_fatalerr(compiler_fatalerr_io_error, makefile);
+      maketemp[0] = 0;
+  }
 
   summarise();
 
@@ -881,6 +896,10 @@ static FILE *try_instore_file(const char *file, pp_uncompression_record **urp)
     {   if (debugging(DEBUG_FILES))
             cc_msg("Opened instore file '%s'\n", file);
         show_h_line(1, file, NO);
+        if (ccom_flags & FLG_MAKEFILE &&
+            makestream != NULL && makestream != stdout &&
+            !(ccom_flags & FLG_NOSYSINCLUDES))
+            fprintf(makestream, DEPEND_INSTORE_FORMAT, objectfile, file);
         push_include(NULL, file);
     }
     else if (FILES_DEBUG_LEVEL(1))
@@ -1104,6 +1123,7 @@ extern int ccom(ToolEnv *t, char const *infile, char const *outfile,
   listingstream = 0;
 #endif
   makestream = 0;
+  maketemp[0] = 0;
   makeflag = 0;
 
   tmuse_front = tmuse_back = 0;
@@ -1265,9 +1285,20 @@ extern int ccom(ToolEnv *t, char const *infile, char const *outfile,
     }
     else
     { /* if -M+, then open with append ("a") if already writing to  */
-      /* makefile (makeflag != 0)                                   */
-      makestream = cc_open(makefile,
-              makeflag ? TEXT_FILE_APPEND : TEXT_FILE);
+      /* makefile (makeflag != 0); otherwise write to maketemp.     */
+      /* If maketemp cannot be opened, write makefile directly, so  */
+      /* that any error names the file the user asked for.          */
+      makestream = NULL;
+      if (!makeflag && makefile[0] != 0 && !StrEq(makefile, "-") &&
+          strlen(makefile) + sizeof(MAKEFILE_TMPSUFFIX) <= MAX_NAME)
+      {   strcpy(maketemp, makefile);
+          strcat(maketemp, MAKEFILE_TMPSUFFIX);
+          makestream = fopen(maketemp, "w");
+          if (makestream == NULL) maketemp[0] = 0;
+      }
+      if (makestream == NULL)
+          makestream = cc_open(makefile,
+                  makeflag ? TEXT_FILE_APPEND : TEXT_FILE);
       makeflag = 1;
       /* Print out source file and object file for -M option...     */
       fprintf(makestream, DEPEND_FORMAT, objectfile, sourcefile);
@@ -613,6 +613,24 @@ extern long sysdebugmask;
 #  define two_address_code(op) 1
 #endif
 
+/* Targets whose conditional execution or divide instructions depend on */
+/* the -cpu/-arch selected define these in terms of config.              */
+#ifndef target_has_cond_exec
+#  ifdef TARGET_HAS_COND_EXEC
+#    define target_has_cond_exec 1
+#  else
+#    define target_has_cond_exec 0
+#  endif
+#endif
+
+#ifndef target_has_divide
+#  ifdef TARGET_HAS_DIVIDE
+#    define target_has_divide 1
+#  else
+#    define target_has_divide 0
+#  endif
+#endif
+
 /* TARGET_PREFIX is a prefix to be attached to all builtin functions
  * Eg. __rt_sdiv & co. This is required where there may be more than
  * one version of the builtin function depending on compiler & options
@@ -353,6 +353,7 @@ static ArgV ld_arg, ld_fil;
 
 static int   cmd_error_count, main_error_count;
 static int32 driver_flags;
+static char const *md_output_file;      /* -MF <file>, else foo.d       */
 #ifdef FORTRAN
 static int32 pragmax_flags;
 #endif
@@ -875,6 +876,29 @@ static int PrintEnv(void *arg, char const *name, char const *val) {
   return 0;
 }
 
+/*
+ * Count the files process_file_names() will compile, rather than pass to
+ * the assembler or the linker.
+ */
+
+static Uint count_sources(ArgV const *v, int32 flags)
+{
+  Uint count, n = 0;
+  UnparsedName unparse;
+
+  for (count = 0; count < v->n; ++count)
+  {   fname_parse(v->v[count], FNAME_SUFFIXES, &unparse);
+      if (!(flags & (KEY_PREPROCESS+KEY_MAKEFILE)) && unparse.extn != NULL)
+          switch (unparse.extn[0])
+          {
+      case 'a': case 'o': case 'O': case 's': case 'S':
+              continue;
+          }
+      ++n;
+  }
+  return n;
+}
+
 /*
  * Process input file names.
  */
@@ -991,7 +1015,8 @@ case LANG_EXTN:
                   listing_file = copy_unparse(&unparse, setupenv.list);
 
               if (flags & KEY_MD)
-                  md_file = copy_unparse(&unparse, "d");
+                  md_file = md_output_file != NULL ? (char *)md_output_file :
+                                                   copy_unparse(&unparse, "d");
 
               source_file = copy_unparse(&unparse, NULL);
 
@@ -1556,6 +1581,22 @@ static bool HandleArg(ToolEnv *t, char const *current, char const *nextarg, bool
                       if (current [3] == 0) flags |= KEY_MD;
                       break;
                   }
+                  goto defolt;
+      case 'F':   /* -MF <file>: as -MD, but naming the dependency file */
+                  if (current[3] == 0)
+                  {   if (nextarg == NULL) {
+                          if (!ignoreerrors) cc_msg_lookup(driver_option_missing_arg, current);
+                          ++cmd_error_count;
+                          break;
+                      }
+                      usednext = YES;
+                  }
+                  else
+                      nextarg = &current[3];
+                  tooledit_insert(t, "-M", "=D");
+                  flags |= KEY_MD;
+                  md_output_file = nextarg;
+                  break;
       default:
       defolt:     if (!ignoreerrors) bad_option(current);
               }
@@ -2201,6 +2242,7 @@ static int cc_main(int argc, char **argv, ToolEnv *t)
 
   get_external_environment();
   driver_flags = setupenv.initial_flags;
+  md_output_file = NULL;
 #ifdef FORTRAN
   pragmax_flags = setupenv.initial_pragmax;
 #endif
@@ -2299,6 +2341,12 @@ static int cc_main(int argc, char **argv, ToolEnv *t)
   {
       if (driver_flags & KEY_STDIN)
           cc_msg_lookup(driver_stdin_otherfiles);
+      /* Each compilation would replace the last one's -MF file.        */
+      if ((driver_flags & KEY_MD) && md_output_file != NULL &&
+          count_sources(&cc_fil, driver_flags) > 1)
+      {   cc_msg_lookup(driver_conflict_MF, md_output_file);
+          compiler_exit(EXIT_error);
+      }
       process_file_names(t, &cc_fil);
   }
   else if (is_cpp || (driver_flags & KEY_STDIN))
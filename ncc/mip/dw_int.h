@@ -312,6 +312,7 @@ struct Dw_ItemList {
 #define high_pc_(p)     endproc_endaddr_(proc_endproc_(p))
 
 extern Dw_ItemList *dw_list, *dw_listproc;
+extern Dw_ItemList *dw_section;
 extern Dw_ItemList *dw_basetypes;
 
 typedef struct {
@@ -402,12 +403,32 @@ extern DataXref *dw_xrefs;
 DataXref *Dw_Relocate(DataXref *xrefs, int32 where, Symstr const *sym);
 uint32 Dw_WriteW_Relocated(uint32 u, Symstr const *sym, uint32 offset);
 
+/* While dw_infostream is set, the Dw_Write functions append to an      */
+/* in-store buffer (in target byte order) rather than to the object     */
+/* file.  DWARF 2 .debug_info is built there a function at a time.      */
+extern bool dw_infostream;
+extern uint32 dw_infobufsize;
+void Dw_InfoBufPatch(uint32 where, uint8 const *p, int32 n);
+void Dw_InfoBufWrite(void);
+void Dw_InfoBufInit(void);
+
+/* dbgloc_ of a forward-referenced struct or enum which has been written */
+/* before the end of the compilation: references to it are written in   */
+/* fixed-size form, and repointed if the type is defined later.         */
+#define DW_LOC_FREF 0x40000000
+#define dwloc_(p) (dbgloc_(p) & ~(0x80000000|DW_LOC_FREF))
+
 char const *Dw_Unmangle(char const *s);
 
 void Dw_1_WriteInfo(void);
 void Dw_1_WriteLineinfo(void);
 
 void Dw_2_WriteMacros(void);
+bool Dw_2_InfoCanStream(void);
+void Dw_2_StreamInfo(Dw_ItemList *list, bool final);
+void Dw_2_RedirectFref(Dw_ItemList *fref, Dw_ItemList *def);
+void Dw_2_RelocateVar(Dw_ItemList *p);
+void Dw_2_InitInfo(void);
 void Dw_2_WriteInfo(void);
 void Dw_2_WriteAbbrevs(void);
 void Dw_2_WriteLineinfo(void);
@@ -83,7 +83,7 @@ Symstr *dw_macro_sym, *dw_abbrev_sym, *dw_location_sym;
 
 static int dw_version;
 static uint32 dw_nameindex_size;
-static Dw_ItemList *dw_section;
+Dw_ItemList *dw_section;
 
 #ifndef TARGET_HAS_MULTIPLE_DEBUG_FORMATS
 
@@ -94,12 +94,43 @@ int usrdbgmask;
 
 static void dw_sub_init(void);
 static bool dw_init_done, dw_sub_init_done;
+static void dw_flushinfo(bool final);
 
 #define DbgAlloc(n) GlobAlloc(SU_Dbg, n)
 #define DbgNew(type) ((type *)DbgAlloc(sizeof(type)))
 
+/* The items already made for a file name, function type, typedef or    */
+/* array element type are found by hashing the pointer they were made   */
+/* from, rather than by walking all the items made so far: with large   */
+/* headers that walk dominated -g compilation.  Chains are most-recent  */
+/* first, as dw_list is.                                                 */
+#define DW_HASHSIZE 512
+#define dw_hashptr_(p) \
+  ((Uint)((IPtr)(p) >> 4 ^ (IPtr)(p) >> 13) & (DW_HASHSIZE-1))
+
+typedef struct Dw_HashEntry Dw_HashEntry;
+struct Dw_HashEntry {
+  Dw_HashEntry *cdr;
+  void const *key;
+  void *val;
+};
+
+static Dw_HashEntry *dw_filehash[DW_HASHSIZE],
+                    *dw_fnhash[DW_HASHSIZE],
+                    *dw_typedefhash[DW_HASHSIZE],
+                    *dw_arrayhash[DW_HASHSIZE];
+
+static void dw_hashadd(Dw_HashEntry **tab, void const *key, void *val) {
+  Dw_HashEntry **hp = &tab[dw_hashptr_(key)];
+  Dw_HashEntry *h = DbgNew(Dw_HashEntry);
+  cdr_(h) = *hp; h->key = key; h->val = val;
+  *hp = h;
+}
+
 Dw_ItemList *dw_list, *dw_listproc;
 Dw_ItemList *dw_basetypes;
+/* Items of dw_list from this one on have been written (DWARF 2 only).  */
+static Dw_ItemList *dw_listflushed;
 
 Dw_LocList *dw_loclist;
 Dw_MacroList *dw_macrolist;
@@ -117,21 +148,70 @@ struct Dw_Scope {
 static Dw_Scope *freescopes,
                 *scopestack;
 
+/* The entries for what is local to a function body - its formals and  */
+/* automatic variables, its lexical blocks and the ends of their child  */
+/* lists - are referred to by nothing outside the function.  They are   */
+/* made in this store, which is reused once dw_flushinfo has written    */
+/* them (DWARF 2 only), so that the entries kept to the end are just    */
+/* those later ones may refer to: types, functions and top-level        */
+/* variables.                                                           */
+#define DW_LOCALCHUNK 4096
+
+typedef struct Dw_LocalChunk Dw_LocalChunk;
+struct Dw_LocalChunk {
+  Dw_LocalChunk *cdr;
+  IPtr b[DW_LOCALCHUNK/sizeof(IPtr)];
+};
+
+static Dw_LocalChunk *dw_localchunks, *dw_localcur;
+static size_t dw_localused;     /* bytes of dw_localcur->b */
+
+static VoidStar Dw_LocalAlloc(size_t n) {
+  n = (n + sizeof(IPtr) - 1) & ~(sizeof(IPtr) - 1);
+  if (dw_localcur == NULL || dw_localused + n > sizeof(dw_localcur->b)) {
+    Dw_LocalChunk *c = dw_localcur == NULL ? dw_localchunks : cdr_(dw_localcur);
+    if (c == NULL) {
+      c = DbgNew(Dw_LocalChunk);
+      cdr_(c) = NULL;
+      if (dw_localcur == NULL) dw_localchunks = c; else cdr_(dw_localcur) = c;
+    }
+    dw_localcur = c; dw_localused = 0;
+  }
+  dw_localused += n;
+  return (char *)dw_localcur->b + (dw_localused - n);
+}
+
+static bool dw_islocal(Dw_ItemList const *p) {
+  Dw_LocalChunk const *c = dw_localchunks;
+  if (dw_localcur != NULL)
+    for (;; c = cdr_(c)) {
+      if ((char const *)p >= (char const *)c->b &&
+          (char const *)p < (char const *)c->b + sizeof(c->b))
+        return YES;
+      if (c == dw_localcur) break;
+    }
+  return NO;
+}
+
 #define Dw_ItemAlloc(variant, tag) \
-  Dw_ItemAlloc_S((size_t)(sizeof(dw_list->car.variant)+offsetof(Dw_ItemList,car)), tag)
+  Dw_ItemAlloc_S((size_t)(sizeof(dw_list->car.variant)+offsetof(Dw_ItemList,car)), tag, NO)
+#define Dw_LocalItemAlloc(variant, tag) \
+  Dw_ItemAlloc_S((size_t)(sizeof(dw_list->car.variant)+offsetof(Dw_ItemList,car)), tag, YES)
 
-static Dw_ItemList *Dw_ItemAlloc_S(size_t size, unsigned tag) {
-  Dw_ItemList *p = (Dw_ItemList *)DbgAlloc(size);
+static Dw_ItemList *Dw_ItemAlloc_S(size_t size, unsigned tag, bool local) {
+  Dw_ItemList *p = (Dw_ItemList *)(local ? Dw_LocalAlloc(size) : DbgAlloc(size));
   debsort_(p) = tag;
   dbgloc_(p) = 0;
   return p;
 }
 
 #define dw_additem(sort, tag) \
-  dw_additem_s((size_t)(sizeof(dw_list->car.sort)+offsetof(Dw_ItemList,car)), tag)
+  dw_additem_s((size_t)(sizeof(dw_list->car.sort)+offsetof(Dw_ItemList,car)), tag, NO)
+#define dw_addlocalitem(sort, tag) \
+  dw_additem_s((size_t)(sizeof(dw_list->car.sort)+offsetof(Dw_ItemList,car)), tag, YES)
 
-static Dw_ItemList *dw_additem_s(size_t size, unsigned tag) {
-  Dw_ItemList *p = (Dw_ItemList *)DbgAlloc(size);
+static Dw_ItemList *dw_additem_s(size_t size, unsigned tag, bool local) {
+  Dw_ItemList *p = (Dw_ItemList *)(local ? Dw_LocalAlloc(size) : DbgAlloc(size));
   debsort_(p) = tag;
   sibling_(p) = NULL; *scopestack->childp = p; scopestack->childp = &sibling_(p);
   cdr_(p) = dw_list; dw_list = p;
@@ -171,7 +251,11 @@ static void PopScope(bool force) {
    * there's only the 'has children' one, in which case an end of scope
    * item must always be produced.
    */
-    Dw_ItemList *terminator = Dw_ItemAlloc(DEB_NULL, TAG_padding);
+    Dw_ItemList *terminator =
+      debsort_(p->item) == DW_TAG_subprogram ||
+      debsort_(p->item) == DW_TAG_lexical_block ?
+        Dw_LocalItemAlloc(DEB_NULL, TAG_padding) :
+        Dw_ItemAlloc(DEB_NULL, TAG_padding);
     cdr_(terminator) = dw_list; dw_list = terminator;
     sibling_(terminator) = NULL;
     null_parent_(terminator) = p->childlist;
@@ -198,15 +282,17 @@ int32 dbg_tableindex(int32 dt_number)
 }
 
 static Dw_FileList *Dw_FindFile(char const *name) {
-  Dw_FileList *p = dw_filelist;
-  for (; p != NULL; p = cdr_(p))
-    if (p->filename == name) return p;
+  Dw_FileList *p;
+  Dw_HashEntry *h = dw_filehash[dw_hashptr_(name)];
+  for (; h != NULL; h = cdr_(h))
+    if (h->key == name) return (Dw_FileList *)h->val;
 
   p = DbgNew(Dw_FileList);
   cdr_(p) = dw_filelist; p->filename = name; p->linelist = 0;
   p->index = (name != NULL && StrEq(name, "<command line>")) ? 0 : ++dw_fileindex;
   p->dir = NULL; p->timestamp = 0; p->filelength = 0;
   dw_filelist = p;
+  dw_hashadd(dw_filehash, name, p);
   return p;
 }
 
@@ -272,36 +358,120 @@ DataXref *Dw_Relocate(DataXref *xrefs, int32 where, Symstr const *symbol) {
   return (DataXref*)global_list3(SU_Xref, xrefs, where, symbol);
 }
 
+bool dw_infostream;
+uint32 dw_infobufsize;
+
+#define DW_INFOCHUNK 4096
+
+typedef struct Dw_InfoChunk Dw_InfoChunk;
+struct Dw_InfoChunk {
+  Dw_InfoChunk *cdr;
+  uint8 b[DW_INFOCHUNK];
+};
+
+static Dw_InfoChunk *dw_infochunks, *dw_infolast;
+
+static void Dw_InfoBufBytes(void const *p, int32 n) {
+  uint8 const *b = (uint8 const *)p;
+  while (n > 0) {
+    int32 used = (int32)(dw_infobufsize % DW_INFOCHUNK), k;
+    if (used == 0 && (dw_infolast == NULL || dw_infobufsize != 0)) {
+      Dw_InfoChunk *c = DbgNew(Dw_InfoChunk);
+      cdr_(c) = NULL;
+      if (dw_infolast == NULL) dw_infochunks = c; else cdr_(dw_infolast) = c;
+      dw_infolast = c;
+    }
+    k = DW_INFOCHUNK - used;
+    if (k > n) k = n;
+    memcpy(&dw_infolast->b[used], b, (size_t)k);
+    dw_infobufsize += k; b += k; n -= k;
+  }
+}
+
+void Dw_InfoBufPatch(uint32 where, uint8 const *p, int32 n) {
+  Dw_InfoChunk *c = dw_infochunks;
+  uint32 i;
+  for (i = where / DW_INFOCHUNK; i != 0; i--) c = cdr_(c);
+  for (where %= DW_INFOCHUNK; n > 0; n--, where++) {
+    if (where == DW_INFOCHUNK) c = cdr_(c), where = 0;
+    c->b[where] = *p++;
+  }
+}
+
+void Dw_InfoBufWrite(void) {
+  Dw_InfoChunk *c = dw_infochunks;
+  uint32 n = dw_infobufsize;
+  for (; n > DW_INFOCHUNK; n -= DW_INFOCHUNK, c = cdr_(c))
+    obj_writedebug(c->b, DW_INFOCHUNK);
+  if (n != 0) obj_writedebug(c->b, (int32)n);
+}
+
+void Dw_InfoBufInit(void) {
+  dw_infochunks = dw_infolast = NULL;
+  dw_infobufsize = 0;
+  dw_infostream = NO;
+}
+
+/* Store the n-byte value u in target byte order */
+static void Dw_TargetBytes(uint8 *b, uint32 u, int n) {
+  int i;
+  for (i = 0; i < n; i++, u >>= 8)
+    b[target_lsbytefirst ? i : n-1-i] = (uint8)u;
+}
+
 uint32 Dw_WriteInlineString(char const *s, uint32 offset) {
   uint32 n = strlen(s);
-  obj_writedebug(s, n+1);
+  if (dw_infostream)
+    Dw_InfoBufBytes(s, n+1);
+  else
+    obj_writedebug(s, n+1);
   return offset + n + 1;
 }
 
 uint32 Dw_WriteB(unsigned u, uint32 offset) {
   char b[1];
-  b[0] = u; obj_writedebug(b, 1);
+  b[0] = u;
+  if (dw_infostream)
+    Dw_InfoBufBytes(b, 1);
+  else
+    obj_writedebug(b, 1);
   return offset + 1;
 }
 
 uint32 Dw_WriteBN(uint8 const *p, int32 n, uint32 offset) {
-  obj_writedebug(p, n);
+  if (dw_infostream)
+    Dw_InfoBufBytes(p, n);
+  else
+    obj_writedebug(p, n);
   return offset + n;
 }
 
 uint32 Dw_WriteH(uint32 u, uint32 offset) {
-  uint16 h[1];
-  h[0] = (uint16)u; obj_writedebug(h, 1+DBG_SHORTFLAG);
+  if (dw_infostream) {
+    uint8 b[2];
+    Dw_TargetBytes(b, u, 2); Dw_InfoBufBytes(b, 2);
+  } else {
+    uint16 h[1];
+    h[0] = (uint16)u; obj_writedebug(h, 1+DBG_SHORTFLAG);
+  }
   return offset + 2;
 }
 
 uint32 Dw_WriteW(uint32 u, uint32 offset) {
-  obj_writedebug(&u, 1+DBG_INTFLAG);
+  if (dw_infostream) {
+    uint8 b[4];
+    Dw_TargetBytes(b, u, 4); Dw_InfoBufBytes(b, 4);
+  } else
+    obj_writedebug(&u, 1+DBG_INTFLAG);
   return offset + 4;
 }
 
 uint32 Dw_WriteL(uint32 const *d, uint32 offset) {
-  obj_writedebug(d, 2+DBG_INTFLAG);
+  if (dw_infostream) {
+    Dw_WriteW(d[0], offset);
+    Dw_WriteW(d[1], offset);
+  } else
+    obj_writedebug(d, 2+DBG_INTFLAG);
   return offset + 8;
 }
 
@@ -398,15 +568,29 @@ static bool dw_hasdefaultvalues(FormTypeList *ft) {
 static Dw_TypeRep *dw_arrayrep(TypeExpr *t, Expr *e)
 { /* e is the array size. Since C arrays start at 0, the upper bound is */
   /* one less                                                           */
-  Dw_ItemList *p = Dw_ItemAlloc(DEB_ARRAY, DW_TAG_array_type);
+  Dw_ItemList *p;
+  Dw_TypeRep *basetype;
+  int32 upperbound;
+  Dw_HashEntry *h;
   if (e && h0_(e) == s_binder) e = NULL;
+  dw_typerep(t, &basetype);
+  upperbound = e ? evaluate(e)-1:0;
+  /* An array of the same shape has been described already?            */
+  for (h = dw_arrayhash[dw_hashptr_(basetype)]; h != NULL; h = cdr_(h))
+    if (h->key == basetype) {
+      p = (Dw_ItemList *)h->val;
+      if (array_open_(p) == (e == NULL) && array_upperbound_(p) == upperbound)
+        return p;
+    }
+  p = Dw_ItemAlloc(DEB_ARRAY, DW_TAG_array_type);
   array_open_(p) = e == NULL;
-  dw_typerep(t, &array_basetype_(p));
+  array_basetype_(p) = basetype;
   array_lowerbound_(p) = 0;
-  array_upperbound_(p) = e ? evaluate(e)-1:0;
+  array_upperbound_(p) = upperbound;
   array_size_(p) = sizeoftype(t);
   array_qual_(p) = NULL;
   dw_addtoitemlist(p);            /* do this last (typerep above) */
+  dw_hashadd(dw_arrayhash, basetype, p);
   PushScope(p, &array_children_(p));
   { Dw_ItemList *bound = dw_additem(DEB_ARRAYBOUND, DW_TAG_array_bound);
     arraybound_open_(bound) = array_open_(p);
@@ -482,6 +666,12 @@ static Dw_TypeRep *dw_structentry(Dw_TypeRep *p, TagBinder *b, TypeExpr *x) {
 #if 0
   Dw_ItemList *prev_dw_list = NULL;
 #endif
+  Dw_ItemList *fref = NULL;
+  if (p != NULL && dbgloc_(p) != 0) {
+    /* Already written as a declaration: it can't be moved or grown now, */
+    /* so the definition is a new item and references are repointed.    */
+    fref = p; p = NULL;
+  }
   if (p == NULL) {
     p = dw_additem(DEB_STRUCT, itemsort);
     struct_size_(p) = 0;    /* filled in later */
@@ -490,6 +680,7 @@ static Dw_TypeRep *dw_structentry(Dw_TypeRep *p, TagBinder *b, TypeExpr *x) {
     struct_qual_(p) = NULL;
     struct_friends_(p) = NULL;
     if (b != NULL) tagbinddbg_(b) = (IPtr)p;
+    if (fref != NULL) Dw_2_RedirectFref(fref, p);
     if (!(tagbindbits_(b) & TB_DEFD)) {
       debsort_(p) = DW_TAG_fref;
       struct_undefsort_(p) = itemsort;
@@ -567,13 +758,15 @@ static Dw_TypeRep *dw_enumentry(Dw_TypeRep *p, TagBinder *b) {
       FT_unsigned_char, FT_unsigned_short, FT_unsigned_integer, FT_unsigned_integer
   };
   static char const s[] = { 1, 2, 4, 4, 1, 2, 4, 4};
-  Dw_ItemList *prev_dw_list = NULL;
+  Dw_ItemList *prev_dw_list = NULL, *fref = NULL;
+  if (p != NULL && dbgloc_(p) != 0) fref = p, p = NULL;   /* as for structs */
   if (p == NULL) {
     p = dw_additem(DEB_ENUM, DW_TAG_enumeration_type);
     enum_children_(p) = NULL;
     enum_name_(p) = isgensym(tagbindsym_(b)) ? NULL : symname_(tagbindsym_(b));
     enum_qual_(p) = NULL;
     if (b != NULL) tagbinddbg_(b) = (IPtr)p;
+    if (fref != NULL) Dw_2_RedirectFref(fref, p);
     if (!(tagbindbits_(b) & TB_DEFD)) {
       debsort_(p) = DW_TAG_fref;
       return p;
@@ -637,19 +830,10 @@ static Dw_QualType *CVQualType(SET_BITMAP m, Dw_QualType *p) {
   return p;
 }
 
-typedef struct Dw_ftList Dw_ftList;
-struct Dw_ftList {
-  Dw_ftList *cdr;
-  TypeExpr *t;
-  Dw_ItemList *p;
-};
-
-static Dw_ftList *dw_ftlist;
-
 static Dw_ItemList *find_ftlist(TypeExpr *te)
-{ Dw_ftList *ft = dw_ftlist;
-  for (; ft != NULL; ft = cdr_(ft))
-    if (ft->t == te) return ft->p;
+{ Dw_HashEntry *h = dw_fnhash[dw_hashptr_(te)];
+  for (; h != NULL; h = cdr_(h))
+    if (h->key == te) return (Dw_ItemList *)h->val;
   return NULL;
 }
 
@@ -663,10 +847,7 @@ static Dw_TypeRep *dw_fnrep(TypeExpr *x) {
   PushScope(t, &proctype_children_(t));
   dw_formalparameterlistrep(x);
   PopScope(dw_version == 2);
-  { Dw_ftList *p = DbgNew(Dw_ftList);
-    cdr_(p) = dw_ftlist;
-    p->t = x; p->p = t; dw_ftlist = p;
-  }
+  dw_hashadd(dw_fnhash, x, t);
   return t;
 }
 
@@ -719,15 +900,16 @@ static void dw_typerep(TypeExpr *x, Dw_TypeRep **typep)
         case bitoftype_(s_typedefname):
           { Binder *b = typespecbind_(x);
             /* is there already a table entry for it ? */
-            { Dw_ItemList *l;
-              for ( l = dw_list ; l != NULL ; l = cdr_(l))
-                if ( debsort_(l)==DW_TAG_typedef &&
-                     type_typex_(l)==bindtype_(b) &&
+            { Dw_HashEntry *h = dw_typedefhash[dw_hashptr_(bindtype_(b))];
+              for (; h != NULL; h = cdr_(h)) {
+                Dw_ItemList *l = (Dw_ItemList *)h->val;
+                if ( h->key==bindtype_(b) &&
                      typename_match(type_name_(l), symname_(bindsym_(b)))) {
                   restype = l;
                   break;
                 }
-              if (l == NULL) syserr("typerep $b", b);
+              }
+              if (h == NULL) syserr("typerep $b", b);
             }
             break;
           }
@@ -832,10 +1014,11 @@ static void dw_typerep(TypeExpr *x, Dw_TypeRep **typep)
   if (typep != NULL) *typep = restype;
 }
 
-static void dw_addvar(Symstr *name, Dw_TypeRep *t,
-                      StgClass stgclass, SymOrReg base, int32 addr, TypeExpr *type)
+static void dw_addvar(Symstr *name, Dw_TypeRep *t, StgClass stgclass,
+                      SymOrReg base, int32 addr, TypeExpr *type, bool local)
 { unsigned tag = stgclass >= Stg_ArgReg ? DW_TAG_formal_parameter: DW_TAG_variable;
-  Dw_ItemList *p = Dw_ItemAlloc(DEB_VAR, tag);
+  Dw_ItemList *p = local ? Dw_LocalItemAlloc(DEB_VAR, tag) :
+                           Dw_ItemAlloc(DEB_VAR, tag);
   var_type_(p) = t;
   var_stgclass_(p) = stgclass;
   var_loc_(p) = addr;
@@ -878,11 +1061,13 @@ void dbg_topvar(Symstr *name, int32 addr, TypeExpr *t, int stgclass,
               var_stgclass_(p) == Stg_Static) &&
              var_loc_(p) == 0 &&
              var_sym_(p) == name) {
+          bool moved = var_base_(p).sym != base.sym;
           var_loc_(p) = addr;
           var_base_(p) = base;
+          if (moved && dbgloc_(p) != 0) Dw_2_RelocateVar(p);
           return;
         }
-    dw_addvar(name, 0, stg, base, addr, t);
+    dw_addvar(name, 0, stg, base, addr, t, NO);
   }
 }
 
@@ -907,6 +1092,7 @@ static void dw_typeinternal(Symstr *name, Dw_TypeRep *t, TypeExpr *type)
     type_name_(p) = symname_(name);
     type_qual_(p) = NULL;
     dw_addtoitemlist(p);
+    dw_hashadd(dw_typedefhash, type, p);
   }
 }
 
@@ -996,11 +1182,11 @@ void dbg_xendproc(FileLine fl)
   if (bindsym_(codesegment) == dw_baseseg.sym) dw_baseseg.len = codebase+codep;
   if (usrdbg(DBG_PROC))
   { Dw_ItemList *q = dw_listproc;
-    Dw_ItemList *p = Dw_ItemAlloc(DEB_ENDPROC, DW_TAG_endproc);
+    Dw_ItemList *p = Dw_LocalItemAlloc(DEB_ENDPROC, DW_TAG_endproc);
     if (q == 0 || debsort_(q) != DW_TAG_subprogram || proc_endproc_(q) != 0)
       syserr(syserr_dbg_proc1);
     /* ... for nested fns */
-    for (dw_listproc = cdr_(dw_list); dw_listproc != NULL; dw_listproc = cdr_(dw_listproc))
+    for (dw_listproc = cdr_(dw_list); dw_listproc != dw_listflushed; dw_listproc = cdr_(dw_listproc))
       if (debsort_(dw_listproc) == DW_TAG_subprogram
           && proc_endproc_(dw_listproc) == 0
           && proc_body_(dw_listproc) == 0
@@ -1008,11 +1194,20 @@ void dbg_xendproc(FileLine fl)
          break;
     if (debugging(DEBUG_Q))
       cc_msg("endproc '%s' @ %.6lx\n", proc_name_(q), (long)(codebase+codep));
+    if (dw_listproc == dw_listflushed) dw_listproc = NULL;
     proc_endproc_(q) = p;
     endproc_endaddr_(p) = codebase+codep;
     cdr_(p) = dw_list; dw_list = p;
     dw_loclist = 0;
     PopScope(dw_version == 2);
+    /* Once a top-level function is complete, the entries made so far   */
+    /* change only in ways the DWARF 2 writer can patch afterwards (see */
+    /* dw_structentry and dbg_topvar), so they are written now rather   */
+    /* than held to the end - unless a formal's default value names a   */
+    /* function not yet defined.                                        */
+    if (dw_version == 2 && scopestack->item == dw_section &&
+        dw_fmllist == NULL && Dw_2_InfoCanStream())
+      dw_flushinfo(NO);
   }
 }
 
@@ -1114,7 +1309,7 @@ void dbg_locvar1(Binder *b) {
     break;
   }
   if (debugging(DEBUG_Q)) cc_msg(" %c %#lx", stgclassname, (long)addr);
-  dw_addvar(name, p->typeref, stgclass, base, addr, NULL);
+  dw_addvar(name, p->typeref, stgclass, base, addr, NULL, stgclass != Stg_Static);
 }
 
 static void dwarf_scope_2(int entering, BindListList *newbll, BindListList *oldbll)
@@ -1126,12 +1321,12 @@ static void dwarf_scope_2(int entering, BindListList *newbll, BindListList *oldb
       if (bll->bllcar != NULL) {
         Dw_ItemList *p;
         if (entering > 0) {
-          p = dw_additem(DEB_STARTSCOPE, DW_TAG_lexical_block);
+          p = dw_addlocalitem(DEB_STARTSCOPE, DW_TAG_lexical_block);
           startscope_next_(p) = last; /* filled in soon by INFOSCOPE */
           startscope_codeseg_(p) = bindsym_(codesegment);
           PushScope(p, &startscope_children_(p));
         } else {
-          p = Dw_ItemAlloc(DEB_ENDSCOPE, DW_TAG_end_lexical_block);
+          p = Dw_LocalItemAlloc(DEB_ENDSCOPE, DW_TAG_end_lexical_block);
           startscope_next_(p) = last; /* filled in soon by INFOSCOPE */
           startscope_end_(scopestack->item) = p;
           PopScope(NO);
@@ -1408,7 +1603,7 @@ static uint32 Dw_1or2_NameindexSize(void) {
 }
 
 static void Dw_1or2_WriteNameindexEntry(Dw_ItemList const *p, char const *s) {
-  Dw_WriteW(dbgloc_(p), 0);
+  Dw_WriteW(dwloc_(p), 0);
   Dw_WriteInlineString(s, 0);
 }
 
@@ -1499,15 +1694,9 @@ bool dbg_debugareaexists(char const *name) {
   return NO;
 }
 
-void dbg_writedebug(void) {
+static void dw_unspecifiedparams(Dw_ItemList *list) {
   Dw_ItemList *p;
-  if (dw_list != NULL) {
-    PopScope(NO);
-    dw_list = (Dw_ItemList *)dreverse((List *)dw_list);
-  }
-  dw_macrolist = (Dw_MacroList *)dreverse((List *)dw_macrolist);
-
-  for (p = dw_list; p != NULL; p = cdr_(p))
+  for (p = list; p != NULL; p = cdr_(p))
     if (debsort_(p) == DW_TAG_subprogram && proc_variadic_(p)) {
       Dw_ItemList *q,
               **prevp = &cdr_(p),
@@ -1523,13 +1712,49 @@ void dbg_writedebug(void) {
       sibling_(q) = *prevsibling; cdr_(q) = *prevp;
       *prevsibling = q; *prevp = q;
     }
+}
+
+/* Write the DWARF 2 entries for the items added to dw_list since the    */
+/* last call.  That part of the list is reversed into output order for   */
+/* the writer, then put back (newest first) for the searches which walk  */
+/* dw_list - less the function-local items, whose store is reused.       */
+static void dw_flushinfo(bool final) {
+  Dw_ItemList *oldest = dw_list, *list, *p, *next;
+  if (dw_list == dw_listflushed) {
+    if (final) Dw_2_StreamInfo(NULL, YES);
+    return;
+  }
+  for (; cdr_(oldest) != dw_listflushed; oldest = cdr_(oldest)) continue;
+  cdr_(oldest) = NULL;
+  list = (Dw_ItemList *)dreverse((List *)dw_list);
+  dw_unspecifiedparams(list);
+  Dw_2_StreamInfo(list, final);
+  dw_list = dw_listflushed;
+  for (p = list; p != NULL; p = next) {
+    next = cdr_(p);
+    if (final || !dw_islocal(p)) cdr_(p) = dw_list, dw_list = p;
+  }
+  dw_listflushed = dw_list;
+  if (!final) dw_localcur = NULL;
+}
+
+void dbg_writedebug(void) {
+  if (dw_list != NULL) PopScope(NO);
+  dw_macrolist = (Dw_MacroList *)dreverse((List *)dw_macrolist);
 
   if (dw_version == 1) {
-    if (dw_list != NULL) Dw_1_WriteInfo();
+    if (dw_list != NULL) {
+      dw_list = (Dw_ItemList *)dreverse((List *)dw_list);
+      dw_unspecifiedparams(dw_list);
+      Dw_1_WriteInfo();
+    }
     if (dw_coord_p != NULL) Dw_1_WriteLineinfo();
     if (dw_nameindex_size != 0) Dw_1or2_WriteNameindex();
   } else {
-    if (dw_list != NULL) Dw_2_WriteInfo();
+    if (dw_list != NULL) {
+      dw_flushinfo(YES);
+      Dw_2_WriteInfo();
+    }
     if (dw_coord_p != NULL) Dw_2_WriteLineinfo();
     if (dw_nameindex_size != 0) Dw_1or2_WriteNameindex();
     if (dw_macrolist != NULL) Dw_2_WriteMacros();
@@ -1540,6 +1765,10 @@ void dbg_writedebug(void) {
 
 static void dw_sub_init(void) {
   dw_list = NULL; dw_basetypes = NULL;
+  dw_listflushed = NULL;
+  dw_localchunks = dw_localcur = NULL;
+  Dw_InfoBufInit();
+  Dw_2_InitInfo();
   dw_baseseg.len = 0;
   dw_listproc = NULL;
   dw_listscope = NULL;
@@ -1549,8 +1778,11 @@ static void dw_sub_init(void) {
   dw_loclist = NULL;
   dw_sub_init_done = YES;
   dw_nameindex_size =0;
-  dw_ftlist = NULL;
   dw_fmllist = NULL;
+  memclr(dw_filehash, sizeof(dw_filehash));
+  memclr(dw_fnhash, sizeof(dw_fnhash));
+  memclr(dw_typedefhash, sizeof(dw_typedefhash));
+  memclr(dw_arrayhash, sizeof(dw_arrayhash));
   dw_macrolist = NULL;
 }
 
@@ -22,6 +22,7 @@
 #include "cgdefs.h"
 #include "version.h"
 #include "xrefs.h"
+#include "store.h"
 #include "codebuf.h"
 #include "builtin.h"   /* te_xxx, xxxsegment */
 #include "simplify.h"  /* mcrep */
@@ -508,15 +509,19 @@ static uint8 const block_mem[] = { 2, DW_FORM_data1, DW_FORM_udata, 0 };
 
 #define ATTRIBBUFSIZE 20
 
-static uint32 Dw_WriteLEB128_U_3(uint32 u, uint32 offset) {
-  uint8 b[3];
-  u &= ~0x80000000;
+static void Dw_LEB128_U_3(uint8 *b, uint32 u) {
+  u &= ~(0x80000000|DW_LOC_FREF);
   b[0] = ((Uint)u & 0x7f) | 0x80;
   u = u >> 7;
   b[1] = ((Uint)u & 0x7f) | 0x80;
   u = u >> 7;
   b[2] = ((Uint)u & 0x7f);
   if ((u & ~0x7f) != 0) syserr("Dw_WriteLEB128_U_3");
+}
+
+static uint32 Dw_WriteLEB128_U_3(uint32 u, uint32 offset) {
+  uint8 b[3];
+  Dw_LEB128_U_3(b, u);
   return Dw_WriteBN(b, 3, offset);
 }
 
@@ -930,11 +935,29 @@ static AbbrevEntry const *Dw_2_ItemEntry(Dw_ItemList const *p, AttribVal *w) {
   }
 }
 
+/* Abbreviation codes are found twice per item written, so the index of  */
+/* each entry in the current table is hashed (by address) on first use.  */
+#define ABBREVHASHSIZE 256      /* > 2 * entries in either table */
+#define abbrevhash_(p) ((Uint)((IPtr)(p) >> 3) & (ABBREVHASHSIZE-1))
+
+static AbbrevEntry const * const *abbrevhash_table;
+static struct { AbbrevEntry const *abbrev; Uint index; } abbrevhash[ABBREVHASHSIZE];
+
 static Uint Dw_2_AbbrevLookup(AbbrevEntry const *abbrev) {
   Uint i;
   AbbrevEntry const * const *table = LanguageIsCPlusPlus ? abbrevlist_cpp : abbrevlist_c;
-  for (i = 0; table[i] != NULL; i++)
-    if (table[i] == abbrev) return i;
+  if (table != abbrevhash_table) {
+    memclr(abbrevhash, sizeof(abbrevhash));
+    for (i = 0; table[i] != NULL; i++) {
+      Uint h = abbrevhash_(table[i]);
+      while (abbrevhash[h].abbrev != NULL) h = (h + 1) & (ABBREVHASHSIZE-1);
+      abbrevhash[h].abbrev = table[i]; abbrevhash[h].index = i;
+    }
+    abbrevhash_table = table;
+  }
+  for (i = abbrevhash_(abbrev); abbrevhash[i].abbrev != NULL;
+       i = (i + 1) & (ABBREVHASHSIZE-1))
+    if (abbrevhash[i].abbrev == abbrev) return abbrevhash[i].index;
   syserr("Dw_2_AbbrevLookup %p (%d)", abbrev, abbrev->tag);
   return 0;
 }
@@ -962,7 +985,8 @@ static uint32 Dw_2_InfoItemSize(Dw_ItemList const *p, AttribVal *w) {
       case DW_FORM_data4:    size += 4; break;
       case DW_FORM_data8:    size += 8; break;
       case DW_FORM_ref_udata:if (w[i].i == 0               /* forward reference before writing */
-                                 || (w[i].i & 0x80000000)) /* forward reference after writing */
+                                 || (w[i].i & 0x80000000)  /* forward reference after writing */
+                                 || (w[i].i & DW_LOC_FREF))/* may be repointed */
                                size += 3;
                              else
                                size += Dw_SizeLEB128_U(w[i].i);
@@ -991,92 +1015,204 @@ static void Dw_RoundUp(uint32 offset) {
   }
 }
 
-void Dw_2_WriteInfo(void) {
+/* .debug_info is written as it is made, a top-level function at a time */
+/* (see dbg_xendproc), into a buffer which is copied to the object file */
+/* at the end.  The compile unit entry comes first but is written last, */
+/* so its form (and so its size) is fixed when the first items are.     */
+/* References to structs and enums which were still undefined when     */
+/* written are noted, and patched if a definition is made later: the    */
+/* definitions are found by hashing the location of the declaration    */
+/* referred to, as a file may have many such references and many such   */
+/* definitions.                                                         */
+
+typedef struct Dw_InfoPatch Dw_InfoPatch;
+struct Dw_InfoPatch {
+  Dw_InfoPatch *cdr;
+  uint32 where, loc;
+};
+
+typedef struct Dw_FrefDef Dw_FrefDef;
+struct Dw_FrefDef {
+  Dw_FrefDef *cdr;
+  uint32 loc;                   /* of the declaration, as written */
+  Dw_ItemList *def;
+};
+
+#define DW_FREFHASHSIZE 256
+#define dw_frefhash_(loc) ((Uint)((loc) ^ (loc) >> 8) & (DW_FREFHASHSIZE-1))
+
+static uint32 dw_infobase, dw_infosize;
+static AbbrevEntry const *dw_cuabbrev;
+static DataXref *dw_infoxrefs;
+static Dw_InfoPatch *dw_infopatches;
+static Dw_FrefDef *dw_frefdefs[DW_FREFHASHSIZE];
+
+static uint32 Dw_2_WriteItem(Dw_ItemList *p, AttribVal *w, uint32 offset) {
+  AbbrevEntry const *abbrev = Dw_2_ItemEntry(p, w);
+  if (abbrev == NULL) return offset;
+  { Uint abbrevindex = Dw_2_AbbrevLookup(abbrev);
+    Uint i;
+    dbgloc_(p) &= ~0x80000000;
+    if (offset != dwloc_(p)) syserr("dw_2_writeinfo %lx != %lx", offset, dbgloc_(p));
+    offset = Dw_WriteLEB128_U(abbrevindex, offset);
+    for (i = 0; ; i++)
+      if (abbrev->attribs[i].form == 0)
+        break;
+      else {
+        Uint form = abbrev->attribs[i].form;
+      indirect:
+        switch (form) {
+        default:               syserr("Dw_2_WriteInfo from %d", abbrev->attribs[i].form);
+        case DW_FORM_flag:
+        case DW_FORM_data1:    offset = Dw_WriteB(w[i].i, offset); break;
+        case DW_FORM_data2:    offset = Dw_WriteH(w[i].i, offset); break;
+        case DW_FORM_data4:    offset = Dw_WriteW(w[i].i, offset); break;
+        case DW_FORM_data8:    offset = Dw_WriteL((uint32 const *)w[i].p, offset); break;
+        case DW_FORM_ref_udata:if (w[i].i & DW_LOC_FREF) {
+                                 Dw_InfoPatch *x = (Dw_InfoPatch *)GlobAlloc(SU_Dbg, sizeof(Dw_InfoPatch));
+                                 cdr_(x) = dw_infopatches; dw_infopatches = x;
+                                 x->where = offset - dw_infobase;
+                                 x->loc = w[i].i & ~(0x80000000|DW_LOC_FREF);
+                               }
+                               if (w[i].i & (0x80000000|DW_LOC_FREF))
+                                 offset = Dw_WriteLEB128_U_3(w[i].i, offset);
+                               else
+                                 offset = Dw_WriteLEB128_U(w[i].i, offset);
+                               break;
+        case DW_FORM_udata:    offset = Dw_WriteLEB128_U(w[i].i, offset); break;
+        case DW_FORM_string:   offset = Dw_WriteInlineString((char const *)w[i].p, offset); break;
+        case DW_FORM_tref:
+        case DW_FORM_addr:     offset = Dw_WriteW_Relocated(w[i].i, (Symstr const *)w[i].p, offset); break;
+
+        case DW_FORM_indirect:
+          { uint32 n = form = w[i].form;
+            if (n == DW_FORM_string_expr) n = DW_FORM_string;
+            offset = Dw_WriteLEB128_U(n, offset);
+            goto indirect;
+          }
+
+        case DW_FORM_string_expr:
+          { StringSegList const *p = (StringSegList const *)w[i].p;
+            for (; p != NULL; p = p->strsegcdr)
+              offset = Dw_WriteBN((uint8 *)p->strsegbase, p->strseglen, offset);
+
+            offset = Dw_WriteB(0, offset);
+          }
+          break;
+
+        case DW_FORM_block:
+          offset = Dw_WriteLEB128_U(blocksize_(w[i].i), offset);
+          { uint8 const *p = (uint8 const *)w[i].p+1;
+            uint32 j = blockix_(w[i].i);
+            for (; *p != 0; p++, j++)
+              switch (*p) {
+              case DW_FORM_data1: offset = Dw_WriteB(w[j].i, offset); break;
+              case DW_FORM_data2: offset = Dw_WriteH(w[j].i, offset); break;
+              case DW_FORM_data4: offset = Dw_WriteW(w[j].i, offset); break;
+              case DW_FORM_addr:  offset = Dw_WriteW_Relocated(w[j].i, (Symstr const *)w[j].p, offset); break;
+              case DW_FORM_udata: offset = Dw_WriteLEB128_U(w[j].i, offset); break;
+              case DW_FORM_sdata: offset = Dw_WriteLEB128_S(w[j].i, offset); break;
+              default:            syserr("Dw_2_WriteInfo block op %d", *p);
+              }
+          }
+        }
+      }
+  }
+  return offset;
+}
+
+bool Dw_2_InfoCanStream(void) {
+  AttribVal w[ATTRIBBUFSIZE];
+  return dw_cuabbrev != NULL || Dw_2_ItemEntry(dw_section, w) == &abbr_compileunit;
+}
+
+/* Write the items of list (in output order).  Unless final, forward-    */
+/* referenced structs and enums among them are tagged as such.           */
+void Dw_2_StreamInfo(Dw_ItemList *list, bool final) {
   Dw_ItemList *p;
-  uint32 infosize, offset;
+  uint32 offset;
   AttribVal w[ATTRIBBUFSIZE];
-  dw_xrefs = NULL;
-  obj_startdebugarea(Dwarf2DebugAreaName);
-  for (infosize = 11, p = dw_list; p != NULL; p = cdr_(p)) {
-    uint32 n = Dw_2_InfoItemSize(p, w);
-    dbgloc_(p) = n == 0 ? 0 : infosize;
-    infosize += n;
+  if (dw_cuabbrev == NULL) {
+    dw_cuabbrev = Dw_2_ItemEntry(dw_section, w);
+    dbgloc_(dw_section) = 11;
+    dw_infobase = dw_infosize = 11 + Dw_2_InfoItemSize(dw_section, w);
   }
-  for (p = dw_list; p != NULL; p = cdr_(p)) {
-    if (dbgloc_(p) != 0) dbgloc_(p) |= 0x80000000;
+  for (offset = dw_infosize, p = list; p != NULL; p = cdr_(p))
+    if (p != dw_section) {
+      uint32 n = Dw_2_InfoItemSize(p, w);
+      dbgloc_(p) = n == 0 ? 0 :
+                   !final && debsort_(p) == DW_TAG_fref ? offset | DW_LOC_FREF :
+                                                         offset;
+      offset += n;
+    }
+  for (p = list; p != NULL; p = cdr_(p))
+    if (dbgloc_(p) != 0 && p != dw_section) dbgloc_(p) |= 0x80000000;
+
+  dw_xrefs = dw_infoxrefs;
+  dw_infostream = YES;
+  for (p = list; p != NULL; p = cdr_(p))
+    if (p != dw_section) dw_infosize = Dw_2_WriteItem(p, w, dw_infosize);
+  dw_infostream = NO;
+  dw_infoxrefs = dw_xrefs;
+}
+
+void Dw_2_RedirectFref(Dw_ItemList *fref, Dw_ItemList *def) {
+  Dw_FrefDef *d = (Dw_FrefDef *)GlobAlloc(SU_Dbg, sizeof(Dw_FrefDef));
+  Dw_FrefDef **h = &dw_frefdefs[dw_frefhash_(dwloc_(fref))];
+  cdr_(d) = *h; d->loc = dwloc_(fref); d->def = def;
+  *h = d;
+}
+
+/* A top-level variable already written has been given a new base.  Its */
+/* location's address operand is the only relocation in its entry, so   */
+/* it is the first made at or after the start of the entry.             */
+void Dw_2_RelocateVar(Dw_ItemList *p) {
+  DataXref *xr, *addr = NULL;
+  Symstr *sym = var_base_(p).sym;
+  for (xr = dw_infoxrefs; xr != NULL && xr->dataxroff >= (int32)dwloc_(p); xr = xr->dataxrcdr)
+    addr = xr;
+  if (addr == NULL) syserr("Dw_2_RelocateVar $r", var_sym_(p));
+  obj_symref(sym, symext_(sym) == NULL ? xr_data|xr_weak : xr_data, 0);
+  addr->dataxrsym = sym;
+}
+
+void Dw_2_InitInfo(void) {
+  dw_infobase = dw_infosize = 0;
+  dw_cuabbrev = NULL;
+  dw_infoxrefs = NULL;
+  dw_infopatches = NULL;
+  memclr(dw_frefdefs, sizeof(dw_frefdefs));
+}
+
+void Dw_2_WriteInfo(void) {
+  Dw_InfoPatch *x;
+  uint32 offset;
+  AttribVal w[ATTRIBBUFSIZE];
+  for (x = dw_infopatches; x != NULL; x = cdr_(x)) {
+    Dw_FrefDef *d = dw_frefdefs[dw_frefhash_(x->loc)];
+    for (; d != NULL; d = cdr_(d))
+      if (d->loc == x->loc) {
+        uint8 b[3];
+        Dw_LEB128_U_3(b, dbgloc_(d->def));
+        Dw_InfoBufPatch(x->where, b, 3);
+        break;
+      }
   }
-  offset = Dw_WriteW(infosize-4, 0);
+  dw_xrefs = NULL;
+  obj_startdebugarea(Dwarf2DebugAreaName);
+  offset = Dw_WriteW(dw_infosize-4, 0);
   offset = Dw_WriteH(2, offset);
   offset = Dw_WriteW_Relocated(0, dw_abbrev_sym, offset);
   offset = Dw_WriteB(4, offset);
-
-  for (p = dw_list; p != NULL; p = cdr_(p)) {
-    AbbrevEntry const *abbrev = Dw_2_ItemEntry(p, w);
-    if (abbrev == NULL) continue;
-    { Uint abbrevindex = Dw_2_AbbrevLookup(abbrev);
-      Uint i;
-      dbgloc_(p) &= ~0x80000000;
-      if (offset != dbgloc_(p)) syserr("dw_2_writeinfo %lx != %lx", offset, dbgloc_(p));
-      offset = Dw_WriteLEB128_U(abbrevindex, offset);
-      for (i = 0; ; i++)
-        if (abbrev->attribs[i].form == 0)
-          break;
-        else {
-          Uint form = abbrev->attribs[i].form;
-        indirect:
-          switch (form) {
-          default:               syserr("Dw_2_WriteInfo from %d", abbrev->attribs[i].form);
-          case DW_FORM_flag:
-          case DW_FORM_data1:    offset = Dw_WriteB(w[i].i, offset); break;
-          case DW_FORM_data2:    offset = Dw_WriteH(w[i].i, offset); break;
-          case DW_FORM_data4:    offset = Dw_WriteW(w[i].i, offset); break;
-          case DW_FORM_data8:    offset = Dw_WriteL((uint32 const *)w[i].p, offset); break;
-          case DW_FORM_ref_udata:if (w[i].i & 0x80000000)
-                                   offset = Dw_WriteLEB128_U_3(w[i].i, offset);
-                                 else
-                                   offset = Dw_WriteLEB128_U(w[i].i, offset);
-                                 break;
-          case DW_FORM_udata:    offset = Dw_WriteLEB128_U(w[i].i, offset); break;
-          case DW_FORM_string:   offset = Dw_WriteInlineString((char const *)w[i].p, offset); break;
-          case DW_FORM_tref:
-          case DW_FORM_addr:     offset = Dw_WriteW_Relocated(w[i].i, (Symstr const *)w[i].p, offset); break;
-
-          case DW_FORM_indirect:
-            { uint32 n = form = w[i].form;
-              if (n == DW_FORM_string_expr) n = DW_FORM_string;
-              offset = Dw_WriteLEB128_U(n, offset);
-              goto indirect;
-            }
-
-          case DW_FORM_string_expr:
-            { StringSegList const *p = (StringSegList const *)w[i].p;
-              for (; p != NULL; p = p->strsegcdr)
-                offset = Dw_WriteBN((uint8 *)p->strsegbase, p->strseglen, offset);
-
-              offset = Dw_WriteB(0, offset);
-            }
-            break;
-
-          case DW_FORM_block:
-            offset = Dw_WriteLEB128_U(blocksize_(w[i].i), offset);
-            { uint8 const *p = (uint8 const *)w[i].p+1;
-              uint32 j = blockix_(w[i].i);
-              for (; *p != 0; p++, j++)
-                switch (*p) {
-                case DW_FORM_data1: offset = Dw_WriteB(w[j].i, offset); break;
-                case DW_FORM_data2: offset = Dw_WriteH(w[j].i, offset); break;
-                case DW_FORM_data4: offset = Dw_WriteW(w[j].i, offset); break;
-                case DW_FORM_addr:  offset = Dw_WriteW_Relocated(w[j].i, (Symstr const *)w[j].p, offset); break;
-                case DW_FORM_udata: offset = Dw_WriteLEB128_U(w[j].i, offset); break;
-                case DW_FORM_sdata: offset = Dw_WriteLEB128_S(w[j].i, offset); break;
-                default:            syserr("Dw_2_WriteInfo block op %d", *p);
-                }
-            }
-          }
-        }
-    }
+  if (Dw_2_ItemEntry(dw_section, w) != dw_cuabbrev) syserr("Dw_2_WriteInfo compile unit");
+  offset = Dw_2_WriteItem(dw_section, w, offset);
+  if (offset != dw_infobase) syserr("dw_2_writeinfo %lx != %lx", offset, dw_infobase);
+  Dw_InfoBufWrite();
+  Dw_RoundUp(dw_infosize);
+  { DataXref **xp = &dw_xrefs;
+    for (; *xp != NULL; xp = &(*xp)->dataxrcdr) continue;
+    *xp = dw_infoxrefs;
   }
-  Dw_RoundUp(offset);
   obj_enddebugarea(Dwarf2DebugAreaName, dw_xrefs);
 }
 
@@ -1333,7 +1333,7 @@ static int block_preserves_cc(BlockHead *b, int fl, int maxl)
     /* Some cases get expanded into a loop ...
        These I want to reject even as the last op in a block.
      */
-            if (alterscc(&c[i])) return Bpcc_No;
+            if (cond_alterscc(&c[i])) return Bpcc_No;
             /* increment instruction count by 3 */
             n += 2;
             break;
@@ -1344,7 +1344,7 @@ static int block_preserves_cc(BlockHead *b, int fl, int maxl)
             continue;
     default:
             if (((fl & (cc_ignorecmp|cc_includelast)) || i+1 < len) &&
-                alterscc(&c[i]))
+                cond_alterscc(&c[i]))
               return Bpcc_No;
         }
         if (++n > maxl) return Bpcc_No;
@@ -1549,7 +1549,7 @@ static LabelNumber *use_cond_field(BlockHead *p)
     blkflags_(p) |= BLKCODED;   /* a bit of a hack -- see show_basic_block */
 #ifdef TARGET_HAS_COND_EXEC
     /* Look for a sequence of 2-exit blocks with a common successor */
-    if (!usrdbg(DBG_VAR+DBG_LINE))
+    if (target_has_cond_exec && !usrdbg(DBG_VAR+DBG_LINE))
     {   int32 cond2 = 0;
         LabelNumber *commonexit = NULL;
         BlockHead *bh = NULL;
@@ -1662,7 +1662,7 @@ static LabelNumber *use_cond_field(BlockHead *p)
             return (next == way_out) ? RETLAB : next;
         }
 #ifdef TARGET_HAS_COND_EXEC
-        if (!usrdbg(DBG_VAR+DBG_LINE))
+        if (target_has_cond_exec && !usrdbg(DBG_VAR+DBG_LINE))
         {   int condb = Bpcc_No, lcondb = Bpcc_No,
                 condb1 = Bpcc_No, lcondb1 = Bpcc_No;
             if (b != 0 && !block_coded(b)) {
@@ -353,6 +353,9 @@ extern int32 config;
 #define CONFIG_LONG_MULTIPLY    0x40000L /* target has long multiply */
 #define CONFIG_32BIT            0x80000L /* target supports 32 bit mode */
 #define CONFIG_26BIT           0x100000L /* target supports 26 bit mode */
+#define CONFIG_WIDE_IMMEDIATES 0x200000L /* target has 16 bit immediate moves */
+#define CONFIG_THUMB2          0x400000L /* target has 32 bit Thumb instructions */
+#define CONFIG_HARDWARE_DIVIDE 0x800000L /* target has integer divide */
 
 #ifdef TARGET_IS_BIG_ENDIAN
 #define target_lsbytefirst 0
@@ -458,6 +461,7 @@ extern void cc_msg(char *s, ...);  /* NB still an uncompressed string */
 #ifdef __CC_NORCROFT
 #  pragma -v0
 #endif
+extern void cc_vmsg(char *s, va_list a);
 #ifdef NLS
 extern void cc_msg_lookup(msg_t errcode, ...);
 #else
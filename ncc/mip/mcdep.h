@@ -72,9 +72,23 @@ int32 CheckSWIValue(int32);
 extern int32 target_inlinable(Binder const *b, int32 nargs);
 #endif
 
+#ifdef TARGET_HAS_SPILL_REGISTERS
+extern int32 target_spillregs(void);
+/* Returns a mask of registers outside the allocator's set which may hold
+ * spilt binders for the current procedure (see regalloc.c).
+ */
+#endif
+
 #ifndef alterscc
 #define alterscc(ic) (sets_psr(ic) || corrupts_psr(ic))
 #endif
+#ifdef TARGET_HAS_COND_ALTERSCC
+extern bool cond_alterscc(Icode const *ic);
+/* Whether ic may not appear inside a conditionally executed block, for   */
+/* targets where that is a weaker condition than alterscc().              */
+#else
+#define cond_alterscc(ic) alterscc(ic)
+#endif
 extern bool sets_psr(Icode const *ic);
 extern bool reads_psr(Icode const *ic);
 extern bool uses_psr(Icode const *ic);
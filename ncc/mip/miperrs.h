@@ -446,6 +446,8 @@ extern void pop_nested_context(void);
     "Warning: linker flag(s) ignored with -c -E -M or -S\n"
 #endif
 #define driver_conflict_EM "Warning: options -E and -M conflict: -E assumed\n"
+#define driver_conflict_MF \
+    "Error: -MF %s names one dependency file, but there are several sources\n"
 #ifdef FORTRAN
 #define driver_conflict_strict_onetrip \
     "Warning: -onetrip and -strict conflict: -strict assumed\n"
@@ -1291,13 +1291,18 @@ static void ReportNestedContexts(void)
         Report1NestedContext(c->fl.f, c->fl.l, c->msg, c->arg1, c->arg2);
 }
 
-void cc_msg(char *s, ...)
+void cc_vmsg(char *s, va_list a)
 {
-    va_list a;
-    va_start(a, s);
     sstart_string_char(s); ssuperrprintf(a, NO);
     if (errbuf[errbufp-1] == '\n')
         ReportError(BC_SEVERITY_NONE, -1);
+}
+
+void cc_msg(char *s, ...)
+{
+    va_list a;
+    va_start(a, s);
+    cc_vmsg(s, a);
     va_end(a);
 }
 
@@ -2396,6 +2396,110 @@ static void flattenrelation_cb(VRegnum n, VoidStar arg)
     *v = vregset_insert(n, *v, NULL, &clashvallocrec);
 }
 
+#ifdef TARGET_HAS_SPILL_REGISTERS
+/* Some targets have registers which cannot be given to general values  */
+/* (Thumb's r8-r11 are reached only by MOV, ADD and CMP) but which can   */
+/* still hold a spilt binder, so that each load or store of it becomes a */
+/* register move.  target_spillregs() says which may be used; they are   */
+/* callee-save, so each one used costs a save and restore, and the      */
+/* busiest spilt binders are placed first.  A binder may then share a    */
+/* register with others it does not clash with, provided the clash lists */
+/* of spilt registers have been completed (see the cleaning pass).       */
+#define SPILLREG_MINCOST (8L << 2)  /* ~4 references outside any loop    */
+
+static bool spillreg_clashes(VRegister *rr, RealRegister r)
+{   uint32 i;
+    for (i = 1; i < vregistername-NMAGICREGS; i++)
+    {   VRegister *r2 = permregheap_(i);
+        if (r2->realreg == r &&
+            (vregset_member(vregname_(r2), rr->clash2) ||
+             vregset_member(vregname_(rr), r2->clash2)))
+            return YES;
+    }
+    return NO;
+}
+
+static VRegSetP spillreg_direct1(VRegnum r, VRegSetP s)
+{   if (r != GAP && !isany_realreg_(r) && vreg_(r)->realreg == R_SPILT)
+        s = vregset_insert(r, s, NULL, &listallocrec);
+    return s;
+}
+
+/* A spilt register still named directly (by the loop optimiser's MOVK   */
+/* and ADCON pseudo-ops, which load it only if it got a real register)   */
+/* would have to be loaded in place, which r8-r11 do not allow.          */
+static VRegSetP spillreg_direct(void)
+{   VRegSetP s = NULL;
+    BlockHead *p;
+    for (p = top_block; p != NULL; p = blkdown_(p))
+    {   Icode *ic = blkcode_(p), *end = ic + blklength_(p);
+        for (; ic < end; ic++)
+        {   J_OPCODE op = ic->op & J_TABLE_BITS;
+            if (uses_r1(op) || pseudo_reads_r1(op))
+                s = spillreg_direct1(ic->r1.r, s);
+            if (uses_r2(op) || pseudo_reads_r2(op))
+                s = spillreg_direct1(ic->r2.r, s);
+            if (uses_r3(op) && !uses_stack(op))
+                s = spillreg_direct1(ic->r3.r, s);
+            if (uses_r4(op))
+                s = spillreg_direct1(ic->r4.r, s);
+        }
+    }
+    return s;
+}
+
+static bool spillreg_candidate(VRegister *rr, VRegSetP direct)
+{   return rr->realreg == R_SPILT && vregtype_(rr) == INTREG &&
+           (bindaddr_(rr->u.spillbinder) & BINDADDR_MASK) != BINDADDR_ARG &&
+           !vregset_member(vregname_(rr), direct);
+}
+
+static void spill_to_registers(bool clashes_known)
+{   int32 avail = target_spillregs();
+    RealRegister r;
+    VRegSetP direct;
+    for (r = 0; r < NMAGICREGS; r++)
+        if (member_RealRegSet(&regmaskvec, r) ||
+            member_RealRegSet(&globalregvarvec, r))
+            avail &= ~regbit(r);        /* already used physically */
+    if (avail == 0) return;
+    direct = spillreg_direct();
+    for (r = 0; avail != 0; r++)
+    {   uint32 i;
+        bool used = NO;
+        if (!(avail & regbit(r))) continue;
+        avail &= ~regbit(r);
+        for (;;)
+        {   VRegister *best = NULL;
+            Binder *bb;
+            for (i = 1; i < vregistername-NMAGICREGS; i++)
+            {   VRegister *rr = permregheap_(i);
+                if (spillreg_candidate(rr, direct) &&
+                    (best == NULL || rr->refcount > best->refcount) &&
+                    (!used || !spillreg_clashes(rr, r)))
+                    best = rr;
+            }
+            if (best == NULL || (!used && best->refcount < SPILLREG_MINCOST))
+                break;
+            bb = best->u.spillbinder;
+            best->realreg = r;
+            bindxx_(bb) = vregname_(best);
+            if (bindstg_(bb) & b_pseudonym)
+                bindsuper_(bb)->spillcount--;
+            if (debugging(DEBUG_SPILL))
+                cc_msg("    spill: $b, v%lu to r%ld, cost = %lu\n",
+                       bb, (long)vregname_(best), (long)r,
+                       (long)best->refcount);
+            if (!used) augment_RealRegSet(&regmaskvec, r);
+            used = YES;
+            if (!clashes_known) break;
+        }
+        if (!used) break;               /* nothing left worth a register */
+    }
+    vregset_discard(direct);
+}
+#endif
+
 void allocate_registers(BindList *spill_order)
 /* spill_order is a list of all binders active in this function,         */
 /* ordered with the first-mentioned register variables LAST so that they */
@@ -2404,6 +2508,7 @@ void allocate_registers(BindList *spill_order)
     clock_t t0 = clock();
     uint32 i, nn;
     VRegSetP spillset = NULL;
+    bool spillclashes = NO;
 
 #ifndef TARGET_IS_NULL
     ReadonlyCopy *p;
@@ -2555,7 +2660,7 @@ void allocate_registers(BindList *spill_order)
     nn = 0;
     if ((n_real_spills + n_cse_spills)> 1 &&        /* retrying may help */
         (var_cc_private_flags & 4L) == 0)     /* cleaning not suppressed */
-    {
+    {   spillclashes = YES;
 /* Here, we do some cleaning up of the register colouring to trying to   */
 /* the things that have already been spilt. Sometimes we'll succeed.     */
 /* This heuristic reduces the number of spills in the compiler by 2%,    */
@@ -2597,13 +2702,20 @@ void allocate_registers(BindList *spill_order)
                    cc_msg("    unspill: $b, v%lu = r%lu, saving = %lu\n",
                        bb, vregname_(rr), rr->realreg, rr->refcount);
             }
-            else if (debugging(DEBUG_SPILL))
-                cc_msg("\n");
+            else
+            {   rr->realreg = R_SPILT;  /* choose_real_register() said BOGUS */
+                if (debugging(DEBUG_SPILL)) cc_msg("\n");
+            }
         }
         if (debugging(DEBUG_SPILL))
             cc_msg("%lu vregs unspilt by cleaning pass in %ucs\n",
                    nn, clock() - us_t);
     }
+#ifdef TARGET_HAS_SPILL_REGISTERS
+    spill_to_registers(spillclashes);
+#else
+    IGNORE(spillclashes);
+#endif
 
 /* WGD Now check for spurious deadbits arising from register copies */
     {   BlockHead *p;
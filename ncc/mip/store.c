@@ -54,6 +54,23 @@ void ClearToNull(void **a, int32 n) {
   #define CHECKING_TRASH 0
 #endif
 
+/* STORE_RELEASE lets the pool of spare local store segments (see       */
+/* pool_trim) hand the pages of segments beyond its warm set back to    */
+/* the host.  The segments themselves stay in the pool, so a later use  */
+/* just faults fresh pages in.  It is off when trashing store, as spare */
+/* segments are then expected to keep their trash.                      */
+#ifndef STORE_RELEASE
+  #if defined(COMPILING_ON_UNIX) && !STORE_TRASHING
+    #define STORE_RELEASE 1
+  #else
+    #define STORE_RELEASE 0
+  #endif
+#endif
+#if STORE_RELEASE
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif
+
 typedef struct AllocHeader AllocHeader;
 struct AllocHeader {
         AllocHeader *next;
@@ -149,16 +166,22 @@ static VoidStar cc_alloc(int32 n)
 void alloc_finalise(void)
 {
     unsigned32 count = 0;
-    if (debugging(DEBUG_STORE)) cc_msg("Freeing block(s) at:");
+/* cc_msg()'s buffer lives in this store, so say everything before it  */
+/* is freed, a line at a time so that the buffer need not grow (which   */
+/* would allocate, and report that, in the middle of a message).        */
+    if (debugging(DEBUG_STORE))
+    {   AllocHeader *p;
+        cc_msg("Freeing block(s) at:\n");
+        for (p = alloc_chain; p != NULL; p = p->next)
+          cc_msg(" %p%s", p, ++count % 8 == 0 ? "\n":"");
+        if (count % 8 != 0) cc_msg("\n");
+    }
     while (alloc_chain != NULL)
     {   AllocHeader *next = alloc_chain->next;
-        if (debugging(DEBUG_STORE))
-          cc_msg("%s %p", count++ % 8 == 0 ? "\n":"", alloc_chain);
         trash_block((VoidStar)alloc_chain, alloc_chain->size);
         free(alloc_chain);
         alloc_chain = next;
     }
-    if (debugging(DEBUG_STORE)) cc_msg("\n");
 }
 
 struct Mark {
@@ -200,6 +223,18 @@ static int segmax;
 #define SEGMAX_INIT  16
 #define SEGMAX_FACTOR 4
 
+/* The spare segments bindsegbase[bindsegcur..bindsegcnt) form a pool   */
+/* shared by all the allocators.  Those below bindsegcold are warm; the */
+/* rest have been released (see pool_trim).  segtypical is a decaying   */
+/* average of the local store segments a function needs at its peak.   */
+#define SEGWARM_SLACK 2
+static int     bindsegcold;        /* bindsegcur..bindsegcnt             */
+static int     segpeak, segtypical;
+static int32   segreleased;
+#if STORE_RELEASE
+static IPtr    pagemask;
+#endif
+
 /* AM: one day turn segbase/segptr into a struct.                       */
 static char    **synsegbase;       /* array of blocks of 'per routine' store */
 static char    **synsegptr;        /* array of corresponding free addresses  */
@@ -281,13 +316,67 @@ static void expand_segmax(int newsegmax)
     segmax = newsegmax;
 }
 
+static void pool_add(char *p)
+/* A segment returned to the pool goes to the top of the warm set.      */
+{   if (bindsegcnt >= segmax) expand_segmax(segmax * SEGMAX_FACTOR);
+    if (bindsegcold < bindsegcnt)
+        bindsegbase[bindsegcnt] = bindsegbase[bindsegcold];
+    bindsegbase[bindsegcold++] = p;
+    bindsegcnt++;
+}
+
+static char *pool_take(void)
+/* Only call when bindsegcur < bindsegcnt.  Warm segments are preferred */
+/* so that released pages are only touched again when the pool runs dry. */
+{   char *w;
+    if (bindsegcold > bindsegcur)
+    {   w = bindsegbase[--bindsegcold];
+        bindsegbase[bindsegcold] = bindsegbase[--bindsegcnt];
+    }
+    else
+        w = bindsegbase[--bindsegcnt];
+    if (bindsegcold > bindsegcnt) bindsegcold = bindsegcnt;
+    return w;
+}
+
+static void pool_trim(void)
+/* Keep enough warm segments for a typical function on top of those in  */
+/* use, and give back the pages of the rest, so that one pathological   */
+/* function does not pin its peak store for the rest of the compilation. */
+{   int inuse = bindsegcur + synsegcnt;
+    int keep = (segtypical > inuse ? segtypical - inuse : 0) + SEGWARM_SLACK;
+    int n = 0;
+    while (bindsegcold - bindsegcur > keep)
+    {   char *w = bindsegbase[--bindsegcold];
+#if STORE_RELEASE
+        char *lo = (char *)(((IPtr)w + pagemask) & ~pagemask),
+             *hi = (char *)(((IPtr)w + SEGSIZE) & ~pagemask);
+        if (lo < hi) (void)madvise(lo, (size_t)(hi - lo), MADV_DONTNEED);
+#else
+        IGNORE(w);
+#endif
+        n++;
+    }
+    if (n != 0)
+    {   segreleased += n;
+        if (debugging(DEBUG_STORE))
+            cc_msg("Released %d spare segment(s), %d warm, typical %d\n",
+                    n, bindsegcold - bindsegcur, segtypical);
+    }
+}
+
+static void note_segpeak(void)
+{   int inuse = bindsegcur + synsegcnt;
+    if (inuse > segpeak) segpeak = inuse;
+}
+
 static char *new_perm_segment(void)
 {
     char *w;
 /* I will recycle a segment that had been used for local space if there  */
 /* are any such available.                                               */
     if (bindsegcur < bindsegcnt)
-    {   w = bindsegbase[--bindsegcnt];
+    {   w = pool_take();
         if (debugging(DEBUG_STORE))
             cc_msg("Permanent store %d from binder size %ld at %p\n",
                     (int)globsegcnt, (long)SEGSIZE, w);
@@ -342,7 +431,7 @@ static char *new_global_segment(void)
                     (int)globsegcnt, (long)size, w);
     }
     else if (bindsegcur < bindsegcnt)
-    {   w = bindsegbase[--bindsegcnt];
+    {   w = pool_take();
         if (debugging(DEBUG_STORE))
             cc_msg("Global store %d from binder size %ld at %p\n",
                     (int)globsegcnt, (long)SEGSIZE, w);
@@ -401,7 +490,10 @@ static char *new_bindalloc_segment(void)
     }
     else
         check_trashed(bindsegbase[bindsegcur], SEGSIZE);
-    return bindsegbase[bindsegcur++];
+    if (bindsegcold <= bindsegcur) bindsegcold = bindsegcur + 1;
+    bindsegcur++;
+    note_segpeak();
+    return bindsegbase[bindsegcur-1];
 }
 
 static char *new_synalloc_segment(void)
@@ -409,7 +501,7 @@ static char *new_synalloc_segment(void)
     char *w;
     if (synsegcnt >= segmax) expand_segmax(segmax * SEGMAX_FACTOR);
     if (bindsegcur < bindsegcnt)
-    {   w = bindsegbase[--bindsegcnt];
+    {   w = pool_take();
         if (debugging(DEBUG_2STORE) && synsegcnt>0)
             cc_msg("Syntax store %d from binder size %ld at %p\n",
                     (int)synsegcnt, (long)SEGSIZE, w);
@@ -422,7 +514,9 @@ static char *new_synalloc_segment(void)
                     (int)synsegcnt, (long)SEGSIZE, w,
                     phasename, currentfunction.symstr);
     }
-    return synsegbase[synsegcnt++] = w;
+    synsegbase[synsegcnt++] = w;
+    note_segpeak();
+    return w;
 }
 
 VoidStar BindAlloc(int32 n)
@@ -760,8 +854,7 @@ void drop_local_store(void)
         check_watch_for(p, SEGSIZE, "syntax segment");
         trash_block(p, SEGSIZE);
 /* we do not need to mess with limits here as set to SEGSIZE when used */
-        if (bindsegcnt >= segmax) expand_segmax(segmax * SEGMAX_FACTOR);
-        bindsegbase[bindsegcnt++] = p;
+        pool_add(p);
     }
     synallp = marklist->syn_allp;
     if (synallp == DUFF_ADDR)
@@ -801,6 +894,9 @@ void alloc_reinit(void)
     bindalltop = (bindallp == DUFF_ADDR) ? (char *)DUFF_ADDR
                                          : bindsegbase[bindsegcur-1] + SEGSIZE;
     bindall2 = NULL; bindall3 = NULL;   /* see comment in alloc_unmark */
+    segtypical = (3 * segtypical + segpeak + 3) / 4;
+    segpeak = bindsegcur + synsegcnt;
+    pool_trim();
 }
 
 void alloc_initialise(void)
@@ -808,6 +904,11 @@ void alloc_initialise(void)
     /* Called once per invocation of the compiler */
     alloc_chain = NULL;
     bindsegcnt = 0;
+    bindsegcold = 0;
+    segpeak = segtypical = 0; segreleased = 0;
+#if STORE_RELEASE
+    pagemask = (IPtr)sysconf(_SC_PAGESIZE) - 1;
+#endif
     globsegcnt = 0;
     globoschain = NULL;
     synsegbase = synsegptr = bindsegbase = bindsegptr = (char **)DUFF_ADDR;
@@ -844,9 +945,7 @@ void alloc_perfilefinalise(void)
     {   char *p = globsegbase[--globsegcnt];
         int32 size = globsegsize[globsegcnt];
         if (size == SEGSIZE)
-        {   if (bindsegcnt >= segmax) expand_segmax(segmax * SEGMAX_FACTOR);
-            bindsegbase[bindsegcnt++] = p;
-        }
+            pool_add(p);
         else
         {   OverlargeBlockHeader *h = (OverlargeBlockHeader *)p;
             h->next = globoschain;
@@ -854,6 +953,7 @@ void alloc_perfilefinalise(void)
             globoschain = h;
         }
     }
+    pool_trim();
 }
 
 void alloc_noteAEstoreuse(void)
@@ -890,6 +990,8 @@ void show_store_use(void)
         (long)synallmax, (long)bindallmax,
         (long)((int32)(int)(synsegcnt+bindsegcnt)*SEGSIZE),
         (long)maxAEstore);
+    cc_msg("  %ld spare segments released, %d kept warm\n",
+        (long)segreleased, bindsegcold - bindsegcur);
 #endif /* ENABLE_STORE */
 }
 
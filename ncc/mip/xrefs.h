@@ -177,6 +177,9 @@ struct ExtRef
 #endif
 #define LIT_INT64_1 0x1a
 #define LIT_INT64_2 0x1b
+/* a run of plain data words held as a byte image in target sex: len    */
+/* bytes at (unsigned8 *)val (only if TARGET_HAS_DATA_BLOCKS).          */
+#define LIT_BYTES   0x1c
 
 extern CodeXref *codexrefs;
 extern ExtRef *obj_symlist;
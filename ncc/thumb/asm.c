@@ -184,7 +184,6 @@ static char *disass_cb(dis_cb_type type, int32 offset, unsigned32 address,
     {
 case D_LOAD:
 case D_STORE:
-case D_SWI:
         return buf;
     }
     if (destination_label != -1)
@@ -490,11 +489,13 @@ static void asm_data(DataInit *p, int constdata)
   int32 offset = 0;
 
   for (; p != 0; p = p->datacdr) {
-    int32 rpt = p->rpt, sort = p->sort, len = p->len;
+    int32 sort = p->sort;
+    IPtr rpt = p->rpt, len = p->len;
+    FloatCon *ptrval = (FloatCon *)p->val;
     union { unsigned32 l;
             unsigned16 w[2];
             unsigned8 b[4];
-            FloatCon *f;
+            /* FloatCon *f; may be bigger than unsigned32 */
           } val;
 
     val.l = p->val;
@@ -569,10 +570,10 @@ static void asm_data(DataInit *p, int constdata)
             else syserr(syserr_asm_trailer1, (long)rpt, (long)val.l);
             break;
         case LIT_FPNUM:
-        {   int32 *p = ((FloatCon *)val.l) -> floatbin.irep;
+        {   int32 *p = ptrval -> floatbin.irep;
             decode_DC(p[0]);
             if (annotations)
-                fprintf(asmstream, " ; %s", ((FloatCon *)val.l) -> floatstr);
+                fprintf(asmstream, " ; %s", ptrval -> floatstr);
             if (len == 8) fprintf(asmstream, "\n"),
                           asm_padcol9(1), decode_DC(p[1]);
             break;
@@ -74,6 +74,7 @@ Branch *available_branches;
 #define FREF_BRANCH     0
 #define FREF_DCB        1
 #define FREF_DCW        2
+#define FREF_CBZ        3       /* Thumb-2 CBZ/CBNZ: forward only, short */
 
 #define FREF_CONDITION(x) ((x) & 0xffff0000)
 #define FREF_TYPE(x) ((x) & 0xff)
@@ -136,6 +137,21 @@ RealRegister local_base(Binder const *b)
     return R_SP;
 }
 
+int32 target_spillregs(void)
+{
+    /* r8-r11 may hold spilt binders, bar those the PCS gives a role: sb
+     * when reentrant, sl when the stack is checked, and fp, which ARM
+     * code we call may still chain through. Saving them costs code, so
+     * not when optimising for space.
+     */
+    int32 m = regbit(R_V5);
+    if ((config & CONFIG_OPTIMISE_SPACE) || (procflags & BLKSETJMP))
+        return 0;
+    if (!(pcs_flags & PCS_REENTRANT)) m |= regbit(R_SB);
+    if (pcs_flags & PCS_NOSTACKCHECK) m |= regbit(R_SL);
+    return m;
+}
+
 static int32 c_of_q(int32 q)
 {
     switch (q & ~Q_UBIT) {
@@ -164,6 +180,7 @@ static bool stack_args_split;
 static bool pushed_lr;
 static int32 r_fr;
 static int32 intsavewordsbelowfp, argwordsbelowfp, realargwordsbelowfp;
+static int32 hisavemask, hisavewords; /* spill registers saved below them */
 
 #ifdef TARGET_HAS_FP_OFFSET_TABLES
 
@@ -181,6 +198,7 @@ static void fpdesc_init(void) {
     fpd.desc.initoffset = fpd.offset = -4;
     /* Ensure fpdesc_newsp gets the correct offset if called before routine_entry */
     intsavewordsbelowfp = 0;
+    hisavewords = 0;
     realargwordsbelowfp = 0;
     argwordsbelowfp = 0;
 }
@@ -213,7 +231,7 @@ static void fpdesc_notespchange(int32 n) {
 }
 
 static void fpdesc_newsp(int32 n) {
-    n += 4*(intsavewordsbelowfp + realargwordsbelowfp) - 4;
+    n += 4*(intsavewordsbelowfp + hisavewords + realargwordsbelowfp) - 4;
     if (n - fpd.offset != 0) fplist_add(n - fpd.offset);
 }
 
@@ -244,7 +262,7 @@ case BINDADDR_LOC:
 case BINDADDR_ARG:
         if (stack_args_split) {
             if (n < NARGREGS * 4) {
-                return fp_minus_sp + n;
+                return fp_minus_sp + 4 * hisavewords + n;
             } else {
                 return fp_minus_sp + firstargoff - NARGREGS * 4 + n;
             }
@@ -260,7 +278,7 @@ int32 local_fpaddress(Binder const *b)
 
     switch (p & BINDADDR_MASK) {
 case BINDADDR_LOC:
-        n = -(n + 4 * (intsavewordsbelowfp + realargwordsbelowfp));
+        n = -(n + 4 * (intsavewordsbelowfp + hisavewords + realargwordsbelowfp));
         break;
 case BINDADDR_ARG:
         n = (n >= 4*argwordsbelowfp) ?
@@ -413,13 +431,38 @@ static uint32 andk_flag;
 static RealRegister cmp_reg;
 static int32 cmp_value;
 
+/* Thumb-2: the end of the last instruction if it was a CMP rn, #0 which  */
+/* a forward BEQ or BNE may turn into a CBZ or CBNZ rn, and while the     */
+/* flags that CMP would have set may still be wanted, rn.                 */
+static int32 cmp0_end = -1;
+static RealRegister cbz_reg = NoRegister;
+
+/* Thumb-2 conditional execution. Between a J_CONDEXEC and the J_CONDEXEC */
+/* Q_AL ending the region it_cond holds the region's condition (a C_xx    */
+/* value), and each instruction is put in an IT block, a fresh one or the */
+/* previous one extended. Literal pools and branches are emitted with the */
+/* region suspended, and end the current IT block.                        */
+#define IT_NONE (-1)
+static int32 it_cond = IT_NONE;
+static int32 it_q;              /* it_cond as a Q_xx value, for branches  */
+static int32 it_codep;          /* the IT instruction of the current block */
+static int32 it_end;            /* the end of the last instruction in it   */
+static int it_count;            /* instructions in the block, 0 if none    */
+static int it_suspended;
+static uint32 it_andk;          /* andk_flag when the region was entered   */
+static bool it_cmpz;            /* P_CMPZ without a flag setting form      */
+static bool it_prefixed;        /* it_prefix() done for the next instruction */
+
+#define it_active() (it_cond != IT_NONE && !it_suspended)
+
 static void outop(int32 op, int32 r1, int32 r2, int32 m);
-static int outop0(int32 op, int32 r1, int32 r2, int32 m);
+static bool outop0(int32 op, int32 r1, int32 r2, int32 m);
 static void outop2(int32 op, int32 r1, int32 r2, int32 m);
 static void outop_direct(int32 op, int32 r1, int32 r2, int32 m);
 static void flush_spareregs(int32 mask);
 static void flush_pending(int32 mask);
 static void check_pending(int32 op, int32 r1, int32 r2, int32 m, int nospcheck);
+static int is_cmp_op(int32 op);
 
 int32 CheckSWIValue(int32 n) {
     if ((uint32)n > 0xff) {
@@ -433,10 +476,62 @@ int32 CheckSWIValue(int32 n) {
   syserr("Instruction field overflow, op = %x, r1 = %x, r2 = %x, m = %x",\
          (int)(op), (int)(r1), (int)(r2), (int)(m))
 
+static void it_prefix(void)
+/* Called before each instruction is output: in a conditionally executed */
+/* region it extends the current IT block if it can, else starts one.    */
+/* Code which records the instruction's address for a fixup calls it     */
+/* first, so that the address is that of the instruction and not the IT; */
+/* it then does nothing when the instruction itself is output.           */
+{
+    int32 c, fc, w, n;
+
+    if (it_cond == IT_NONE || it_prefixed) return;
+    if (it_suspended) {
+        it_count = 0;
+        return;
+    }
+    c = it_cond >> 8;
+    if (it_count > 0 && it_count < 4 && codep == it_end) {
+        w = code_hword_(it_codep);
+        fc = (w >> 4) & 0xf;
+        n = it_count;
+        if (c == fc || ((c ^ 1) == fc && fc != C_AL >> 8)) {
+            w = (w & ~(1L << (4-n))) | (c & 1) << (4-n) | 1L << (3-n);
+            code_hword_(it_codep) = (unsigned16)w;
+            it_count++;
+            it_prefixed = YES;
+            return;
+        }
+    }
+    it_codep = codep;
+    outHW(F_IT | c << 4 | 8);
+    it_count = 1;
+    it_prefixed = YES;
+}
+
+static void it_next(bool setsflags)
+/* Called after an instruction in an IT block. Ones that would set the   */
+/* flags outside an IT block do not inside it.                           */
+{
+    it_prefixed = NO;
+    if (!it_active()) return;
+    it_end = codep;
+    flags_reg = NoRegister;
+    cmp_reg = NoRegister;
+    cmpz_flag = 0;
+    andk_flag = 0;
+    if (setsflags) it_andk = 0;
+}
+
 static void outop_direct(int32 op, int32 r1, int32 r2, int32 m)
 {
     int32 spchange = 0;
     int i;
+    bool setsflags = is_cmp_op(op) ||
+                     op == F_CMPHL || op == F_CMPLH || op == F_CMPHH;
+
+    if (op == F_BC && it_active()) syserr("Conditional branch in IT block");
+    cbz_reg = NoRegister;
 
 #if 0
     if (!(disable_opt)) {
@@ -872,7 +967,7 @@ static void outop_direct(int32 op, int32 r1, int32 r2, int32 m)
         spchange = bitcount(m) * 4;
         if (op == F_POP) spchange = -spchange;
         op |= m;
-    } else if (op == F_B || op == F_CALL1 || op == F_CALL) {
+    } else if (op == F_B || op == F_CALL1 || op == F_CALL || op == F_BW) {
         if ((unsigned32)m > 0x7ff)
             InstructionFieldOverflow(op, r1, r2, m);
         op |= m;
@@ -883,7 +978,13 @@ static void outop_direct(int32 op, int32 r1, int32 r2, int32 m)
     } else
         syserr("unknown op 0x%x in outop_direct\n", (int)op);
 #endif
+    /* LSL Rd, Rm, #0 is MOVS, which may not appear in an IT block */
+    if (it_active() && (op & ~0x3fL) == F_LSLK) op = 0x4600 | (op & 0x3f);
+    it_prefix();
     outHW((unsigned)op);
+    cmp0_end = ((op & ~0x7ffL) == F_CMP8 && (op & 0xff) == 0 &&
+                it_cond == IT_NONE) ? codep : -1;
+    it_next(setsflags);
     if (spchange) fpdesc_notespchange(spchange);
 }
 
@@ -922,7 +1023,7 @@ static void outop2(int32 op, int32 r1, int32 r2, int32 m)
       }
     }
 #else
-    if (!(disable_opt)) {
+    if (!(disable_opt) && it_cond == IT_NONE) {
         if (op == F_ADDI8 || op == F_SUBI8 || op == F_ADDI3 || op == F_SUBI3) {
           if (op == F_ADDI8 || op == F_SUBI8) r2 = r1;
           reg_values[r1].typ = REGV_BASE;
@@ -1226,6 +1327,16 @@ static void ldm_op(int32 op, int32 r1, int32 r2, int32 m)
   if (r2 == ldm_stm.base && op == F_LDRI5) ldm_flush();
 }
 
+static void cbz_flags(void)
+/* Puts back the CMP rn, #0 a CBZ or CBNZ replaced, for a second use of   */
+/* its flags.                                                            */
+{
+    RealRegister r = cbz_reg;
+    if (r == NoRegister) return;
+    cbz_reg = NoRegister;
+    outop(F_CMP8, r, 0, 0);
+}
+
 static void reissue_cmp(void)
 {
     int32 t = flags_reg;
@@ -1286,6 +1397,18 @@ static int32 check_cmp(int32 condition)
     return condition;
 }
 
+static int32 it_check_cmp(int32 condition)
+/* check_cmp() for a conditionally executed region entered after an AND  */
+/* which set the flags by shifting, until the region compares something. */
+{
+    if (it_andk != 0 && condition != Q_AL) {
+        andk_flag = it_andk;
+        condition = check_cmp(condition);
+        andk_flag = 0;
+    }
+    return condition;
+}
+
 static void reg_flush(void)
 {
     RealRegister i;
@@ -1312,6 +1435,7 @@ static int32 call_k(Symstr *name)
     w = 0;
     ldm_flush();
     flush_pending(0xff | (1 << R_SP));
+    it_prefix();
     /* the next two lines' data structures may be mergeable. */
     d = obj_symref(name, xr_code, 0);
     if (d == -1) {
@@ -1322,6 +1446,9 @@ static int32 call_k(Symstr *name)
     w += ((d - (codebase+codep+PC_OFFSET)) >> 1) & 0x003fffff;
     outHWaux(F_CALL1 + ((w >> 11) & 0x7ff), name);
     outHW(F_CALL + (w & 0x7ff));
+    it_count = 0;       /* a BL must be the last instruction of an IT block */
+    it_prefixed = NO;
+    cbz_reg = NoRegister;
     for (i = 0; i < 4; i++)
         reg_values[i].typ = REGV_UNKNOWN;
     flags_reg = NoRegister;
@@ -1845,6 +1972,80 @@ static void outop(int32 op, int32 r1, int32 r2, int32 m)
     }
 }
 
+/* Output a 32 bit Thumb-2 instruction writing r1 (or NoRegister). Any  */
+/* condition codes it sets are for the caller to note.                   */
+static void outop32(int32 r1, unsigned32 hw1, unsigned32 hw2)
+{
+    int32 i;
+
+    ldm_flush();
+    flush_pending(0xff | (1 << R_SP));
+    if (r1 != NoRegister) {
+        for (i = 0; i < 8; i++)
+            if (reg_values[i].typ == REGV_BASE && reg_values[i].reg == r1)
+                reg_values[i].typ = REGV_UNKNOWN;
+        reg_values[r1].typ = REGV_UNKNOWN;
+        if (flags_reg == r1) flags_reg = NoRegister;
+        if (cmp_reg == r1) cmp_reg = NoRegister;
+    }
+    cbz_reg = NoRegister;
+    it_prefix();
+    outHW(hw1);
+    outHW(hw2);
+    it_next(NO);
+}
+
+/* ThumbExpandImm: the 12 bit encoding of n as a modified immediate, or  */
+/* -1 if it has none.                                                    */
+static int32 thumb2_immediate(unsigned32 n)
+{
+    unsigned32 b = n & 0xff, u;
+    int32 rot;
+
+    if (n <= 0xff) return n;
+    if (n == (b << 16 | b)) return 0x100 | b;
+    b = (n >> 8) & 0xff;
+    if (n == (b << 24 | b << 8)) return 0x200 | b;
+    if (n == b * 0x01010101) return 0x300 | b;
+    for (rot = 8; rot < 32; rot++) {
+        u = n << rot | n >> (32 - rot);
+        if (u >= 0x80 && u <= 0xff) return rot << 7 | (u & 0x7f);
+    }
+    return -1;
+}
+
+/* A data processing instruction with a modified immediate (or, for      */
+/* T2_ADDW etc, a plain 12 bit one) k.                                   */
+static void outop32_imm(int32 op, int32 r1, int32 r2, int32 k)
+{
+    outop32(r1, op | (k & 0x800) >> 1 | r2,
+            (k & 0x700) << 4 | r1 << 8 | (k & 0xff));
+}
+
+/* r1 = r2 op #k (a modified immediate), setting the flags as the 16 bit */
+/* instructions would: that is, unless in an IT block.                   */
+static void outop32_dp(int32 op, int32 r1, int32 r2, int32 k)
+{
+    if (it_cond != IT_NONE) {
+        outop32_imm(op, r1, r2, k);
+        return;
+    }
+    outop32_imm(op | T2_S, r1, r2, k);
+    if (!(disable_opt)) {
+        flags_reg = cmp_reg = r1;
+        cmp_value = 0;
+        cmpz_flag = 0;
+        andk_flag = 0;
+    }
+}
+
+/* MOVW or MOVT r1, #n, for n in 0..0xffff                               */
+static void outop32_movw(int32 op, int32 r1, int32 n)
+{
+    outop32(r1, op | (n & 0x800) >> 1 | (n >> 12 & 0xf),
+            (n & 0x700) << 4 | r1 << 8 | (n & 0xff));
+}
+
 void cnop(void)
 {
     if (codep & 1) outDCB(0);
@@ -1886,6 +2087,7 @@ static void setlabel2(LabelNumber *ll, int32 codep)
 #define LABREF_WORD8    0x04000000
 #define LABREF_BXX_8    0x05000000
 #define LABREF_BXX_16   0x06000000
+#define LABREF_CBZ      0x07000000
 #ifdef THUMB_CPLUSPLUS
 #define LABREF_WORD32   0x08000000
 #endif
@@ -1919,6 +2121,13 @@ static void setlabel1(LabelNumber *l)
           w = (w & ~0xff) | (d & 0xff);
           code_hword_(q) = (unsigned16)w;
           break;
+        case LABREF_CBZ:   /* CBZ Rn, xxx */
+          w = code_hword_(q);
+          d = codep-q-PC_OFFSET;
+          if ((int32)d < 0 || (int32)d >= 0x80) syserr(syserr_displacement, (long)d);
+          w = (w & ~0x2f8) | (d & 0x40) << 3 | (d & 0x3e) << 2;
+          code_hword_(q) = (unsigned16)w;
+          break;
         case LABREF_BL:    /* BL xxx */
           w = code_hword_(q);
           d = (codep-q-PC_OFFSET >> 1);
@@ -1969,12 +2178,16 @@ static void setlabel1(LabelNumber *l)
     }
     label_values = (List3 *)binder_icons3(label_values, codep, lab_name_(l) & 0xfffff);
     lab_setloc_(l, codep | 0x80000000); /* cheapo union checker for ->frefs */
+    it_count = 0;   /* code may branch here: end any IT block */
+    cmp0_end = -1;
+    cbz_reg = NoRegister;
 }
 
 static int32 branch_range(int32 flags)
 {
   if (FREF_TYPE(flags) == FREF_DCB) return 512 - 24L;
   if (FREF_TYPE(flags) == FREF_DCW) return 65536 - 24L;
+  if (FREF_TYPE(flags) == FREF_CBZ) return 130 - 32L;
   return (FREF_CONDITION(flags) == Q_AL ? 2048L : 256L) - 24L; /* Margin for safety */
 }
 
@@ -2031,6 +2244,7 @@ static void dump_branch_lits(int needs_jump, int32 poolsize)
     mustbranchlitby = 0x10000000;
     ldm_flush();
     flush_pending(0xff | (1 << R_SP));
+    it_suspended++;
     poolsize += branchpoolsize;
     if (needs_jump) {
       ll = nextlabel();
@@ -2039,6 +2253,10 @@ static void dump_branch_lits(int needs_jump, int32 poolsize)
     fref_p = &fref_branches;
     while ((fref = *fref_p) != 0) {
       int range = branch_range(fref->flags);
+      /* Also takes frefs that would expire before the next dead point.   */
+      /* 6/8 and 8/8 (here and at forced dumps) were both measured: code  */
+      /* size moves by < 0.1% either way, as fewer wasted islands cost    */
+      /* more jumps round them.                                           */
       range = range * 7 / 8;
       if (codep - fref->pcref + poolsize > range)
       {
@@ -2062,12 +2280,16 @@ static void dump_branch_lits(int needs_jump, int32 poolsize)
       setlabel(ll); /* recalculates mustbranchlitby */
     else
       recalc_mustbranchlitby();
+    it_suspended--;
 }
 
 static void dumplits(int needs_jump)
 {
     LabelNumber *ll = NULL;
 
+    ldm_flush();
+    flush_pending(0xff | (1 << R_SP));
+    it_suspended++;
     if (needs_jump) {
       ll = nextlabel();
       branch_round_literals(ll);
@@ -2077,6 +2299,7 @@ static void dumplits(int needs_jump)
     dumplits2(0);
     if (needs_jump)
       setlabel(ll);
+    it_suspended--;
 }
 
 static void addressability(int32 n)
@@ -2099,12 +2322,14 @@ static void load_lit(RealRegister r1, int32 n)
     ldm_flush();
     flush_pending(0xff | (1 << R_SP));
     if ((i = lit_findwordaux(n, LIT_NUMBER, 0, LITF_INCODE|LITF_FIRST|LITF_LAST|LITF_PEEK)) >=0) {
+        it_prefix();
         addfref_(litlab, codep | LABREF_WORD8);
         AddLitPoolReference(codep, i);
         outop(F_LDRLIT, r1, 0, i/4);
     } else {
         addressability(1024);
         i = lit_findwordaux(n, LIT_NUMBER, 0, LITF_INCODE|LITF_FIRST|LITF_LAST|LITF_NEW);
+        it_prefix();
         addfref_(litlab, codep | LABREF_WORD8);
         AddLitPoolReference(codep, i);
         outop(F_LDRLIT, r1, 0, i/4);
@@ -2137,6 +2362,7 @@ static void load_adcon(RealRegister r1, Symstr *name, int32 offset)
             add_integer(r1, r1, d);
         } else if ((i = lit_findword(offset, LIT_ADCON, name,
                               LITF_INCODE|LITF_FIRST|LITF_LAST|LITF_PEEK)) >= 0) {
+            it_prefix();
             addfref_(litlab, codep | LABREF_WORD8);
             AddLitPoolReference(codep, i);
             outop(F_LDRLIT, r1, 0, i/4);
@@ -2153,6 +2379,7 @@ static void load_adcon(RealRegister r1, Symstr *name, int32 offset)
                 addressability(1024);
                 i = lit_findword(offset, LIT_ADCON, name,
                                   LITF_INCODE|LITF_FIRST|LITF_LAST|LITF_NEW);
+                it_prefix();
                 addfref_(litlab, codep | LABREF_WORD8);
                 AddLitPoolReference(codep, i);
                 outop(F_LDRLIT, r1, 0, i/4);
@@ -2192,6 +2419,7 @@ static void load_fp_adcon(RealRegister r1, J_OPCODE op, FloatCon *fc)
                     LITF_INCODE|LITF_LAST) - 4;
         }
     }
+    it_prefix();
     addfref_(litlab, codep | LABREF_WORD8);
     AddLitPoolReference(codep, disp);
     outop(F_ADDRPC, r1, 0, disp/4);
@@ -2213,6 +2441,7 @@ static void load_ll_adcon(RealRegister r1, J_OPCODE op, Int64Con *c)
     {   (void)lit_findword(w[0], LIT_INT64_1, NULL, LITF_INCODE|LITF_FIRST);
         disp = lit_findword(w[1], LIT_INT64_2, NULL, LITF_INCODE|LITF_LAST) - 4;
     }
+    it_prefix();
     addfref_(litlab, codep | LABREF_WORD8);
     AddLitPoolReference(codep, disp);
     outop(F_ADDRPC, r1, 0, disp/4);
@@ -2325,6 +2554,16 @@ static int add_integer0(RealRegister r1, RealRegister r2, int32 n, int len_only)
         return l;
       }
     }
+    if (config & CONFIG_THUMB2) {
+      if ((r = thumb2_immediate(m)) >= 0) {
+        if (!len_only) outop32_dp(n < 0 ? T2_SUB : T2_ADD, r1, r2, r);
+        return 2;
+      }
+      if (m <= 0xfff) {
+        if (!len_only) outop32_imm(n < 0 ? T2_SUBW : T2_ADDW, r1, r2, m);
+        return 2;
+      }
+    }
     uses_IP = YES;
     if (r2 == R_IP)
     {   if (len_only) return 1000;  /* cannot generate code for this, so return large number */
@@ -2352,6 +2591,11 @@ static void add_integer(RealRegister r1, RealRegister r2, int32 n)
     if (r2 == R_SP)
     {   /* Magic special for SP-relative address calculation */
       if (r1 < 8) {
+        if ((config & CONFIG_THUMB2) && ((n & 3) || n >= 1024) &&
+            n >= 0 && n <= 0xfff) {
+          outop32_imm(T2_ADDW, r1, R_SP, n);
+          return;
+        }
         if ((n & 3) || n >= 1024 || n < 0) {
           int32 n1;
 
@@ -2464,6 +2708,28 @@ static int load_integer0(RealRegister r, int32 n, int len_only)
         return 1;
       }
     }
+    if (config & CONFIG_THUMB2) {
+      /* one 32 bit instruction, no bigger than two 16 bit ones */
+      if ((i = thumb2_immediate(n)) >= 0) {
+        if (!len_only) outop32_imm(T2_ORR, r, R_PC, i);    /* MOV.W */
+        return 2;
+      }
+      if ((i = thumb2_immediate(~n)) >= 0) {
+        if (!len_only) outop32_imm(T2_MVN, r, R_PC, i);    /* MVN.W */
+        return 2;
+      }
+      if ((unsigned32)n <= 0xffff) {
+        if (!len_only) outop32_movw(T2_MOVW, r, n);
+        return 2;
+      }
+      if (!(config & CONFIG_OPTIMISE_SPACE)) {
+        if (!len_only) {
+          outop32_movw(T2_MOVW, r, n & 0xffff);
+          outop32_movw(T2_MOVT, r, (n >> 16) & 0xffff);
+        }
+        return 4;
+      }
+    }
     if (n < 0 && n >= -256) {
       if (!len_only) {
         outop(F_MOV8, r, 0, ~n);
@@ -2576,6 +2842,14 @@ static void and_integer(RealRegister r1, RealRegister r2, int32 n, int32 peep)
           return;
         }
     }
+    if ((config & CONFIG_THUMB2) && (t = thumb2_immediate(n)) >= 0) {
+        outop32_dp(T2_AND, r1, r2, t);
+        return;
+    }
+    if ((config & CONFIG_THUMB2) && (t = thumb2_immediate(~n)) >= 0) {
+        outop32_dp(T2_BIC, r1, r2, t);
+        return;
+    }
     r_ip = R_IP;
     if (r2 == R_IP)
         syserr("and_integer: IP clash @ %.8lx", codebase+codep);
@@ -2702,6 +2976,30 @@ static int32 bigindexbyte(RealRegister r, int32 m)
 extern int sanity_check_has_callr;
 #endif
 
+/*
+ * High registers holding spilt binders are saved below the other saved
+ * registers, passing through the var registers which were pushed (and so
+ * are free) on entry and are about to be popped on exit.
+ */
+#define HISAVE_SAVE     1
+#define HISAVE_RESTORE  2
+
+static int32 hisave_regs(int moves)
+{
+    int32 lo = R_V1, hi, lows = 0;
+
+    for (hi = R_V5; hi < ARM_R_IP; hi++) {
+        if (!(hisavemask & regbit(hi))) continue;
+        while (!(procmask & regbit(lo))) lo++;
+        if (moves == HISAVE_RESTORE)
+            outop(F_MOVLH, 0, hi-8, lo);
+        else if (moves == HISAVE_SAVE)
+            outop(F_MOVHL, 0, lo, hi-8);
+        lows |= regbit(lo++);
+    }
+    return lows;
+}
+
 static void routine_entry(int32 m)
 {
     int32 mask = (regmask & M_VARREGS);
@@ -2722,6 +3020,8 @@ static void routine_entry(int32 m)
     firstargoff = -16;
     stack_args_split = 0;
     res_regs = currentfunction.nresultregs;
+    hisavemask = regmask & (regbit(ARM_R_IP) - regbit(R_V5));
+    hisavewords = bitcount(hisavemask);
     nspareregs = (regmask & M_VARREGS) & ((1 << 4) | (1 << 5) | (1 << 6) | (1 << 7));
     if (R_IP >= R_V1) mask |= regbit(R_IP);
     r_fr = R_IP;
@@ -2778,6 +3078,8 @@ static void routine_entry(int32 m)
         firstargoff = 0;
     } else
         argwordsbelowfp = n;
+    for (i = R_V1; bitcount(mask & M_VARREGS) < hisavewords; i++)
+        mask |= regbit(i);
     pushed_lr = 0;
     procmask = mask;
     sp_offset = 4*bitcount(mask);
@@ -2815,6 +3117,10 @@ static void routine_entry(int32 m)
       }
     }
     firstargoff += sp_offset;;
+    if (hisavemask) {
+        outop(F_PUSH, 0, 0, hisave_regs(HISAVE_SAVE));
+        firstargoff += 4 * hisavewords;
+    }
 
     if ((procflags & STACKCHECK) && !no_stack_checks && !(pcs_flags & PCS_NOSTACKCHECK)) {
         Symstr *name = stackoverflow;
@@ -2897,6 +3203,13 @@ static void routine_exit(int to_pc)
       fp_minus_sp /= 4;
       assert(fp_minus_sp >= 0);
       mask &= ~0x0f;
+      if (hisavemask) {
+          add_to_sp(fp_minus_sp);
+          fp_minus_sp = 0;
+          flush_pending(1 << R_SP);
+          outop(F_POP, 0, 0, hisave_regs(0));
+          hisave_regs(HISAVE_RESTORE);
+      }
       if (procflags & ARGS2STACK && pushed_args != 0 && stack_args_split == 0) {
           if (fp_minus_sp <= 4 - res_regs && (config & CONFIG_OPTIMISE_SPACE)) {
               for (i = 0; i < fp_minus_sp; i++)
@@ -3060,8 +3373,10 @@ static void add_casebranch(LabelNumber *destination)
     }
 }
 
-static LabelNumber *add_fref_branch(LabelNumber *destination, int32 codep, uint32 condition)
+static LabelNumber *add_fref_branch(LabelNumber *destination, int32 codep, uint32 flags)
+/* flags is the branch's condition, with FREF_CBZ for a CBZ or CBNZ. */
 {
+    uint32 condition = FREF_CONDITION(flags);
     LabelNumber *ll;
     FRef_Branch *new_fref, *fref, **fref_p;
     int32 max_dest;
@@ -3070,7 +3385,7 @@ static LabelNumber *add_fref_branch(LabelNumber *destination, int32 codep, uint3
 #if 0
     fprintf(stderr, "%.8x: (add_fref_branch) F%dL%d\n", codebase + codep, current_procnum, lab_name_(destination) & 0xfffff);
 #endif
-    span = branch_range(FREF_BRANCH | condition);
+    span = branch_range(flags);
     max_dest = codep + span;
     fref_p = &fref_branches;
     for (; (fref = *fref_p) != NULL; fref_p = &cdr_(fref)) {
@@ -3087,7 +3402,7 @@ static LabelNumber *add_fref_branch(LabelNumber *destination, int32 codep, uint3
                 fref->chained_dest = nextlabel();
                 fref->pcref = codep;
                 fref->codep = codep;
-                fref->flags = condition | FREF_BRANCH;
+                fref->flags = flags;
             } else {
                 if (max_dest < fref->pcref + branch_range(fref->flags)) {
                     *fref_p = cdr_(fref);
@@ -3101,7 +3416,7 @@ static LabelNumber *add_fref_branch(LabelNumber *destination, int32 codep, uint3
                     cdr_(new_fref) = fref;
                     new_fref->pcref = codep;
                     new_fref->codep = codep;
-                    new_fref->flags = condition | FREF_BRANCH;
+                    new_fref->flags = flags;
                     *fref_p = new_fref;
                     if (!fref) fref_branches_head = &cdr_(new_fref);
                     fref = new_fref;
@@ -3122,7 +3437,7 @@ static LabelNumber *add_fref_branch(LabelNumber *destination, int32 codep, uint3
     cdr_(new_fref) = fref;
     new_fref->pcref = codep;
     new_fref->codep = codep;
-    new_fref->flags = condition | FREF_BRANCH;
+    new_fref->flags = flags;
     new_fref->real_dest = destination;
     new_fref->chained_dest = ll;
     *fref_p = new_fref;
@@ -3210,6 +3525,7 @@ static void conditional_branch_to(int32 condition, LabelNumber *destination, int
 /*
  * Unconditional branches can reach MUCH further than conditional ones...
  */
+    if (condition != Q_AL) cbz_flags();
     inst_codep = codep;
     if (condition == Q_AL) {
         if (lab_isset_(destination) || use_bl) {
@@ -3218,7 +3534,9 @@ static void conditional_branch_to(int32 condition, LabelNumber *destination, int
             int32 span = dest - (codep + PC_OFFSET);
             ll = destination;
             if (use_bl || span < -2048 || span >= 2048) {
-              if (!pushed_lr) syserr(syserr_leaf_fn, symname_(currentfunction.symstr));
+              /* Thumb-2 has B.W, so only BL needs lr saved */
+              if (!pushed_lr && (use_bl || !(config & CONFIG_THUMB2)))
+                  syserr(syserr_leaf_fn, symname_(currentfunction.symstr));
               if (!use_bl && (b = branch_available(destination, condition)) != 0) {
                 ll = nextlabel();
                 AddLabelReference(inst_codep, ll);
@@ -3234,7 +3552,8 @@ static void conditional_branch_to(int32 condition, LabelNumber *destination, int
                 else
                     d = pcref(dest, 0x400000);
                 outop(F_CALL1, 0, 0, (d >> 11) & 0x7ff);
-                outop(F_CALL, 0, 0, d & 0x7ff);
+                outop(use_bl || !(config & CONFIG_THUMB2) ? F_CALL : F_BW,
+                      0, 0, d & 0x7ff);
               }
             } else {
               AddLabelReference(inst_codep, ll);
@@ -3258,10 +3577,19 @@ static void conditional_branch_to(int32 condition, LabelNumber *destination, int
               add_branch(destination, condition, inst_codep);
           } else {
               ll = nextlabel();
-              if ((b = branch_available(destination, codep)) != 0) {
+              if ((b = branch_available(destination, condition)) != 0) {
                   AddLabelReference(inst_codep, ll);
                   outop(F_BC, 0, C_of_Q(condition), pcref(b->codep, 0x100));
                   setlabel2(ll, b->codep);
+              } else if ((config & CONFIG_THUMB2) && span >= -0x100000) {
+                  /* Bcc.W: span is in range, so take all 20 offset bits */
+                  int32 d = pcref(destination->u.defn & 0x00ffffff, 0x100000);
+                  AddLabelReference(inst_codep, destination);
+                  outop32(NoRegister,
+                          T2_BC | (d >> 9 & 0x400) | C_of_Q(condition) >> 2 |
+                              (d >> 11 & 0x3f),
+                          0x8000 | (d >> 4 & 0x2000) | (d >> 7 & 0x800) | (d & 0x7ff));
+                  add_branch(destination, condition, inst_codep);
               } else {
                   AddLabelReference(inst_codep, ll);
                   addfref_(ll, codep | LABREF_BC);
@@ -3270,6 +3598,19 @@ static void conditional_branch_to(int32 condition, LabelNumber *destination, int
                   setlabel(ll);
               }
           }
+        } else if ((config & CONFIG_THUMB2) && codep == cmp0_end &&
+                   it_cond == IT_NONE && !disable_opt &&
+                   ((condition & ~Q_UBIT) == Q_EQ || (condition & ~Q_UBIT) == Q_NE)) {
+          /* A forward branch on CMP rn, #0: replace both by CBZ or CBNZ */
+          RealRegister r = code_hword_(codep-2) >> 8 & 7;
+          codep -= 2;
+          cmp0_end = -1;
+          ll = add_fref_branch(destination, codep, condition | FREF_CBZ);
+          addfref_(ll, codep | LABREF_CBZ);
+          outHW(((condition & ~Q_UBIT) == Q_EQ ? F_CBZ : F_CBNZ) | r);
+          flags_reg = NoRegister;
+          cmp_reg = NoRegister;
+          cbz_reg = r;
         } else {
           ll = add_fref_branch(destination, codep, condition);
           addfref_(ll, codep | LABREF_BC);
@@ -3288,6 +3629,22 @@ static void dump_backwards_branches(void)
     backwards_branches = NULL;
 }
 
+static void divide_op(int32 op, RealRegister r1, RealRegister r2, RealRegister r3)
+/* r1 = r2 / r3 (J_DIVR) or r2 % r3 (J_REMR), with the Thumb-2 divide     */
+/* instructions; the remainder is r2 - (r2 / r3) * r3 by MLS.            */
+{
+    unsigned32 div = (op & J_UNSIGNED) ? T2_UDIV : T2_SDIV;
+    RealRegister q = r1;
+
+    if ((op & J_TABLE_BITS) == J_DIVR) {
+        outop32(r1, div | r2, 0xf0f0 | r1 << 8 | r3);
+        return;
+    }
+    if (q == r2 || q == r3) q = ARM_R_IP;
+    outop32(q, div | r2, 0xf0f0 | q << 8 | r3);
+    outop32(r1, T2_MLS | q, r2 << 12 | r1 << 8 | 0x10 | r3);
+}
+
 static int is_commutative(int32 op)
 {
     return op == F_AND || op == F_EOR || op == F_OR || op == F_MUL;
@@ -3316,6 +3673,11 @@ static void rk_op(int32 op, int32 r1, int32 r2, int32 m)
             return;
         }
     }
+    if ((config & CONFIG_THUMB2) && (op == F_OR || op == F_EOR) &&
+            (r = thumb2_immediate(m)) >= 0) {
+        outop32_dp(op == F_OR ? T2_ORR : T2_EOR, r1, r2, r);
+        return;
+    }
     if (r1 == r2) {
         load_integer(R_IP, m);
         outop(op, 0, r1, R_IP);
@@ -3475,6 +3837,12 @@ void show_inst_direct(PendingOp *p)
         if (peep & P_BASEALIGNED) debug_putc('%'); else debug_putc(' ');
         if (op & J_BASEALIGN4) debug_putc('^'); else debug_putc(' ');
     }
+    it_cmpz = NO;
+    if ((peep & P_CMPZ) && it_cond != IT_NONE) {
+        /* Flag setting instructions do not set them in an IT block */
+        peep &= ~P_CMPZ;
+        it_cmpz = YES;
+    }
     if (peep & P_CMPZ) {
         ldm_flush();
         flush_pending(0xff | (1 << R_SP));
@@ -3501,6 +3869,8 @@ void show_inst_direct(PendingOp *p)
     }
     if (a_loads_r1(p) && !(deadbits & J_DEAD_R1)) nspareregs &= ~(1L << r1);
     if (a_loads_r2(p) && !(deadbits & J_DEAD_R2)) nspareregs &= ~(1L << r2);
+    /* a dead spill register (see target_spillregs()) is no work register */
+    nspareregs &= ~(regbit(ARM_R_IP) - regbit(R_V5));
     if (debugging(DEBUG_LOCALCG)) {
         for (i = 0; i < 8; i++)
             debug_putc((int)((nspareregs & (1L << i)) ? '0' + i : '-'));
@@ -3757,12 +4127,14 @@ case J_STRING: {
             if (r2 >= 0) w = r2 & ~3;
             disp = lit_findstringincurpool(s);
             if (disp >= 0) {
+                it_prefix();
                 addfref_(litlab, codep | LABREF_WORD8);
                 AddLitPoolReference(codep, disp);
                 outop(F_ADDRPC, r1r, 0, (disp + w) / 4);
             } else {
                 disp = lit_findstringinprevpools(s, codebase+codep+PC_OFFSET-252+w);
                 if (disp >= 0) {
+                    it_prefix();
                     disp = codebase+codep+PC_OFFSET-disp+w;
                     outop(F_MOVHL, 0, r1r, R_PC-8);
                     outop(F_SUBI8, r1r, 0, disp);
@@ -3771,6 +4143,7 @@ case J_STRING: {
                         load_adcon(r1r, bindsym_(codesegment), disp+r2);
                     } else {
                         addressability(1024 - r2);
+                        it_prefix();
                         addfref_(litlab, codep | LABREF_WORD8);
                         AddLitPoolReference(codep, litpoolp << 2);
                         outop(F_ADDRPC, r1r, 0, litpoolp + w / 4);
@@ -3782,9 +4155,57 @@ case J_STRING: {
         }
         break;
 
+case J_CONDEXEC:
+        ldm_flush();
+        flush_pending(0xff | (1 << R_SP));
+        if ((op & Q_MASK) == Q_AL) {
+            it_cond = IT_NONE;
+            it_count = 0;
+            it_prefixed = NO;
+        } else {
+            int32 condition = op & Q_MASK;
+            if ((condition & ~Q_UBIT) == Q_AL)
+                condition = Q_AL;
+            else if (it_cond == IT_NONE) {
+                /* Entering the region: the flags are those of the code   */
+                /* before it, perhaps with an elided CMP rn, #0.          */
+                cbz_flags();
+                if (andk_flag == 0 && cmpz_flag && flags_reg != NoRegister &&
+                    condition != Q_EQ && condition != Q_NE &&
+                    condition != Q_UEQ && condition != Q_UNE)
+                    reissue_cmp();
+                it_andk = andk_flag;
+            }
+            it_q = it_check_cmp(condition);
+            it_cond = C_of_Q(it_q);
+        }
+        reg_flush();
+        cmpz_flag = 0;
+        nspareregs = 0;
+        illbits &= ~Q_MASK;
+        break;
+
 case J_B: {
           int32 condition;
 
+          if (it_cond != IT_NONE) {
+            /* Ends a conditionally executed block, so its condition is  */
+            /* the region's; branches are not put in IT blocks.          */
+            condition = it_check_cmp(op & Q_MASK);
+            it_suspended++;
+            if (condition == Q_AL)
+              conditional_branch_to(it_q, (LabelNumber *)m, 0);
+            else {
+              LabelNumber *ll = nextlabel();
+              if (it_q != Q_AL)
+                conditional_branch_to(Q_NEGATE(it_q), ll, 0);
+              conditional_branch_to(condition, (LabelNumber *)m, 0);
+              setlabel(ll);
+            }
+            it_suspended--;
+            illbits &= ~Q_MASK;
+            break;
+          }
           condition = check_cmp(op & Q_MASK);
           if (condition == Q_AL && !disable_opt)
             deadcode = (LabelNumber *)m;
@@ -3925,6 +4346,20 @@ case J_RORK:
         peep &= ~P_CMPZ;
         break;
 
+case J_DIVK:
+case J_REMK:
+        if (r2r == R_IP) syserr("op = %x: IP clash @ %.8lx", (int)op, codebase+codep);
+        uses_IP = YES;
+        load_integer(R_IP, m);
+        divide_op(op - J_DIVK + J_DIVR, r1r, r2r, R_IP);
+        illbits &= ~(J_SIGNED|J_UNSIGNED);
+        break;
+case J_DIVR:
+case J_REMR:
+        divide_op(op, r1r, r2r, mr);
+        illbits &= ~(J_SIGNED|J_UNSIGNED);
+        break;
+
 #ifdef THUMB_CPLUSPLUS
 case J_THIS_ADJUST:
           {   int32 v[4]; int32 *ve, *p;
@@ -3952,9 +4387,15 @@ case J_ADDK:
             else {
                 add_integer(r1r, r2r, m);
                 flush_pending(1 << r1r);
+                if ((config & CONFIG_THUMB2) && r1r < 8 && flags_reg != r1r)
+                    outop(F_CMP8, r1r, 0, 0);   /* after ADDW */
             }
-        } else
+        } else {
             add_integer(r1r, r2r, m);
+            if ((config & CONFIG_THUMB2) && (peep & P_CMPZ) &&
+                    r1r < 8 && flags_reg != r1r)
+                outop(F_CMP8, r1r, 0, 0);   /* after ADDW */
+        }
         if (r2r >= 8 && (peep & P_CMPZ)) {
             if (r1r >= 8) syserr("P_CMPZ set with Rd >= 8 and Rn >=8 in J_ADDK");
             outop(F_CMP8, r1r, 0, 0);
@@ -4690,6 +5131,16 @@ default:
     /* Check we've tidied up correctly */
     if ((peep & ~P_BASEALIGNED) | illbits)
       syserr("show_inst_direct: peep = %lx illbits = %lx", (long)peep, (long)illbits);
+    if (it_cmpz) {
+        if (r1r < 8)
+            outop(F_CMP8, r1r, 0, 0);
+        else if (op1 == J_MOVR && mr < 8)
+            outop(F_CMP8, mr, 0, 0);
+        else {
+            outop32(NoRegister, T2_SUB|T2_S|r1r, R_PC << 8);  /* CMP.W r1, #0 */
+            it_andk = 0;
+        }
+    }
     /* ECN: If P_CMPZ and the result is not used we must ensure the
      *      opcode is actually emitted.
      */
@@ -4820,12 +5271,12 @@ void show_instruction(const Icode *const ic)
                 case J_WORD:
                 case J_USE:
                 case J_VOLATILE:
+                case J_CONDEXEC:
                         flush = YES;
                         break;
                 case J_PUSHD:
                 case J_PUSHF:
                 case J_ORG:
-                case J_CONDEXEC:
                         /* Things the ARM peepholer handles but we don't */
                         syserr("show_instruction(%#lx)", (long)op);
                         break;
@@ -168,6 +168,15 @@ static kw const pcs_keywords[] = {
     { "narrow",         "-apcs.wide",   "#/narrow"}
 };
 
+/* -cpu selects the architecture too; Thumb-2 code is generated for 6T2 */
+/* and 7M, whose config bits are set by config_init from -arch.          */
+static kw const cpu_keywords[] = {
+    { "ARM7TM",         "-arch",        "#4T" },
+    { "ARM9TM",         "-arch",        "#4T" },
+    { "ARM1156T2",      "-arch",        "#6T2" },
+    { "CortexM3",       "-arch",        "#7M" }
+};
+
 static char const * const debug_table_keywords[] = {
 #ifdef TARGET_HAS_ASD
     "-asd",
@@ -208,12 +217,31 @@ KW_Status mcdep_keyword(char const *key, char const *nextarg, ToolEnv *t) {
         }
     }
 
+    if (cistreq(key, "-cpu") || cistreq(key, "-arch")) {
+        bool cpu = cistreq(key, "-cpu");
+        if (nextarg == NULL) return KW_MISSINGARG;
+        for (i = 0; i < sizeof(cpu_keywords) / sizeof(cpu_keywords[0]); i++)
+            if (cistreq(nextarg, cpu ? cpu_keywords[i].opt : &cpu_keywords[i].val[1])) {
+                if (cpu) sprintf(str, "#%s", cpu_keywords[i].opt);
+                tooledit_insert(t, "-cpu", cpu ? str : "#generic");
+                tooledit_insert(t, cpu_keywords[i].name, cpu_keywords[i].val);
+                return KW_OKNEXT;
+            }
+        return KW_BADNEXT;
+    }
+
     for (i = 0; i < sizeof(debug_table_keywords) / sizeof(debug_table_keywords[0]); i++)
         if (cistreq(key, debug_table_keywords[i])) {
             tooledit_insert(t, ".debugtable", EqualString(str, debug_table_keywords[i]));
             return KW_OK;
         }
 
+    if (cistreq(key, "-peepstats")) {
+        if (nextarg == NULL) return KW_MISSINGARG;
+        tooledit_insertwithjoin(t, "-peepstats", '=', nextarg);
+        return KW_OKNEXT;
+    }
+
     return KW_NONE;
 
 }
@@ -268,6 +296,9 @@ static Opt const config_opts[] = {
     {".bytesex",     "=-bi",        CONFIG_BIG_ENDIAN},
     {"-apcs.reent",  "#/reent",     CONFIG_REENTRANT_CODE},
     {"-apcs.wide",   "#/narrow",    CONFIG_UNWIDENED_NARROW_ARGS},
+    {"-arch",        "#6T2",        CONFIG_THUMB2+CONFIG_WIDE_IMMEDIATES},
+    {"-arch",        "#7M",         CONFIG_THUMB2+CONFIG_WIDE_IMMEDIATES+
+                                    CONFIG_HARDWARE_DIVIDE},
     {NULL, NULL, 0}
 };
 
@@ -316,7 +347,8 @@ void config_init(ToolEnv *t)
 }
 
 void mcdep_set_options(ToolEnv *t) {
-    IGNORE(t);
+    char const *val = toolenv_lookup(t, "-peepstats");
+    peepstats_file = (val == NULL) ? NULL : &val[1];
 }
 
 /**********************************************************************************/
@@ -472,6 +504,30 @@ bool corrupts_psr(const Icode *ic)
     return 0;
 }
 
+/* Inside a Thumb-2 IT block only comparisons set the flags, so it is    */
+/* those, and what must end an IT block or cannot be in one (branches,   */
+/* calls and stack adjustments), which may only be the last instruction  */
+/* of a conditionally executed block.                                    */
+bool cond_alterscc(Icode const *ic)
+{   J_OPCODE op = ic->op & J_TABLE_BITS;
+    if (op == J_CMPR || op == J_CMPK || reads_psr(ic)
+#ifdef THUMB_INLINE_ASSEMBLER
+             ||
+                op == J_CMNK || op == J_CMNR || op == J_ADCK || op == J_ADCR ||
+                op == J_SBCK || op == J_SBCR || op == J_BL || op == J_SWI
+#endif
+             ||
+                op == J_CALLK || op == J_CALLR || op == J_OPSYSK ||
+                op == J_TAILCALLK || op == J_TAILCALLR ||
+                op == J_MOVC || op == J_CLRC || j_is_check(op) ||
+                op == J_CASEBRANCH || op == J_BXX ||
+                op == J_SETSP || op == J_SETSPENV || op == J_SETSPGOTO ||
+                op == J_PUSHM || op == J_PUSHR || op == J_PUSHD || op == J_PUSHF ||
+                op == J_ENTER || op == J_SAVE || op == J_ENDPROC)
+        return YES;
+    return NO;
+}
+
 int32 a_modifies_mem(const PendingOp *const p)
 {   J_OPCODE op = p->ic.op & J_TABLE_BITS;
     return (op & J_TABLE_BITS) > J_LAST_JOPCODE ? a_attributes(op) & _a_modify_mem :
@@ -561,6 +617,8 @@ static bool InputsClashWithIP(const Icode *const p)
         case J_ORRK:
         case J_EORK:
         case J_MULK:
+        case J_DIVK:    /* (hardware divide) the divisor is loaded into IP */
+        case J_REMK:
 
         case J_CASEBRANCH:
             return YES;
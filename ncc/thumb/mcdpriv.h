@@ -163,7 +163,7 @@ typedef struct
 #define regs_used(u)    ((u)->use | (u)->def | (u)->corrupt)
 
 /* returns the complete register usage of c */
-extern GetRegisterUsage(const PendingOp *c, RegisterUsage *u);
+extern bool GetRegisterUsage(const PendingOp *c, RegisterUsage *u);
 
 extern char *CheckJopcodeP(const PendingOp *p, CheckJopcode_flags flags);
 
@@ -178,6 +178,8 @@ extern void peephole_reinit(void);
 extern void peephole_init(void);
 extern void peephole_tidy(void);
 
+extern char const *peepstats_file;  /* -peepstats: CSV file, or NULL */
+
 #ifdef TARGET_HAS_AOF
 
 #define  aof_fpreg   xr_objflg1     /* fn passes FP args in FP registers */
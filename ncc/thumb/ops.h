@@ -177,6 +177,33 @@
 
 #define F_CALL1    0xf000L   /* prefix for a F_CALL */
 #define F_CALL     0xf800L
+#define F_BW       0xb800L   /* Thumb-2: suffix for a B.W                     */
+
+/* Thumb-2 32 bit opcodes (first halfword) */
+
+#define F_IT       0xbf00L   /* firstcond in bits 4..7, mask in bits 0..3     */
+#define F_CBZ      0xb100L   /* offset/2 in bits 3..7, and bit 9 for 64..126  */
+#define F_CBNZ     0xb900L
+
+#define T2_AND     0xf000L   /* data processing, modified immediate           */
+#define T2_BIC     0xf020L
+#define T2_ORR     0xf040L   /* MOV.W if Rn is PC                             */
+#define T2_MVN     0xf060L   /* ORN; MVN.W if Rn is PC                        */
+#define T2_EOR     0xf080L
+#define T2_ADD     0xf100L
+#define T2_SUB     0xf1a0L
+#define T2_S       0x0010L   /* set condition codes                           */
+
+#define T2_ADDW    0xf200L   /* plain 12 bit immediate                        */
+#define T2_MOVW    0xf240L   /* 16 bit immediate                              */
+#define T2_SUBW    0xf2a0L
+#define T2_MOVT    0xf2c0L
+
+#define T2_MLS     0xfb00L   /* second halfword 0x0010|Ra<<12|Rd<<8|Rm        */
+#define T2_SDIV    0xfb90L   /* second halfword 0xf0f0|Rd<<8|Rm               */
+#define T2_UDIV    0xfbb0L
+
+#define T2_BC      0xf000L   /* Bcc.W, second halfword 0x8000 | offset        */
 
 /*
  * Register names - some defined in target.h.
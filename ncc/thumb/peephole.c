@@ -13,6 +13,8 @@
  */
 
 #include <string.h>
+#include <stdio.h>
+#include <time.h>
 
 #include "globals.h"
 #include "host.h"
@@ -26,6 +28,7 @@
 #include "errors.h"
 #include "cg.h"        /* for procflags, greatest_stackdepth */
 #include "regalloc.h"  /* regmask */
+#include "peepstat.h"
 #include "simplify.h"  /* for MCR_SIZE_MASK */
 
 #define PendingStackSize 30
@@ -326,6 +329,15 @@ extern int Profiler_Count_Index;
 int Profiler_Count_Index_Max = PeepholeMax;
 int Profiler_Count_Index;
 
+/* -peepstats <file>: per-pattern hit/miss counts, accumulated into a CSV */
+/* file by peepstats_write() (armthumb/peepstat.c).                        */
+
+char const *peepstats_file;
+
+#define PEEP_INSTBYTES 2  /* bytes per instruction, for the saving column */
+
+static PeepStat p_stats[PeepholeMax+1];
+
 #ifdef ENABLE_LOCALCG
 
 static int32 p_count[PeepholeMax+1];
@@ -939,6 +951,20 @@ static bool MayMatch(PendingOp *ops[], PeepOp const peepops[],
   return YES;
 }
 
+static bool TimedMayMatch(PendingOp *ops[], PeepOp const peepops[],
+                          PeepHole const *ph, int n, RegisterUsage *u) {
+  PeepStat *ps;
+  PeepTicks t0;
+  bool res;
+  if (peepstats_file == NULL) return MayMatch(ops, peepops, ph, n, u);
+  ps = &p_stats[ph - patterns];
+  t0 = peepstats_ticks();
+  res = MayMatch(ops, peepops, ph, n, u);
+  ps->mayticks += peepstats_ticks() - t0;
+  ps->maycalls++;
+  return res;
+}
+
 static void flush_pending(int leave)
 { PendingOp *p = &pendingstack[0];
   for (; p <= pending-leave; p++)
@@ -1019,6 +1045,7 @@ retry:
     peepix = peepv[pat];
     curpeep = &patterns[peepix];
     Profiler_Count_Index = peepix;
+    if (peepstats_file != NULL) p_stats[peepix].tried++;
     peepops = curpeep->insts;
     use.def = use.use = 0;
     depth = 0;
@@ -1033,7 +1060,7 @@ retry:
         dummy[depth-matched-1].dataflow = 0;
       } else {
         if (matched++ != 0) break;
-        if (!MayMatch(ops+1, peepops, curpeep, depth, &use))
+        if (!TimedMayMatch(ops+1, peepops, curpeep, depth, &use))
           goto next_pattern;
         ops[++depth] = cur;
       }
@@ -1049,7 +1076,7 @@ retry:
          pending - prev < PeepholeWindowSize;
          prev--) {
       (ops+1)[depth] = prev;
-      if (MayMatch(ops+1, peepops, curpeep, depth, &use)) {
+      if (TimedMayMatch(ops+1, peepops, curpeep, depth, &use)) {
         if (++depth == curpeep->instcount)
           goto peephole_found;
         if (depth == MaxInst) syserr(syserr_bad_maxinst);
@@ -1070,9 +1097,11 @@ peephole_found:
     PendingOp opcopy[MaxInst];
     PendingOp *opp[MaxInst+1];
     int d;
+    bool altered = NO;
 #ifdef ENABLE_LOCALCG
     p_count[peepix]++;
 #endif
+    if (peepstats_file != NULL) p_stats[peepix].matched++;
     if (depth > second)
       for (d = 0; d < depth; d++) {
         if (peepops[d].p.maynotkill & pu_r1) KillDeadBits(ops, depth, (ops+1)[d]->ic.r1.rr, peepix);
@@ -1086,8 +1115,15 @@ peephole_found:
     }
     for (d = depth; --d >= 0; ) {
       PendingOp *op = (ops+1)[d];
+      bool wasop = op->ic.op != J_NOOP;
       if (UpdateOp(op, opp+1, curpeep,
                    peepops[d].replacecount, peepops[d].replaceix, &use, NO) & Op_Altered) {
+        if (peepstats_file != NULL) {
+          PeepStat *ps = &p_stats[peepix];
+          if (!altered) ps->applied++;
+          ps->instssaved += (int32)wasop - (int32)(op->ic.op != J_NOOP);
+        }
+        altered = YES;
         if (d == 0) {
           if (op->ic.op != J_NOOP) {
             pat = peepix;
@@ -1163,10 +1199,13 @@ void peephole_reinit(void) {
 }
 
 void peephole_init(void) {
-#ifdef ENABLE_LOCALCG
   int i;
+#ifdef ENABLE_LOCALCG
   for (i = 0; i <= PeepholeMax; i++) p_count[i] = 0;
 #endif
+  for (i = 0; i <= PeepholeMax; i++)
+    memset(&p_stats[i], 0, sizeof(PeepStat));
+  if (peepstats_file != NULL) peepstats_start();
 }
 
 void peephole_tidy(void) {
@@ -1178,5 +1217,7 @@ void peephole_tidy(void) {
         cc_msg("{%3d}%6ld\n", i+1, p_count[i]);
   }
 #endif
+  if (peepstats_file != NULL)
+    peepstats_write(peepstats_file, p_stats, PeepholeMax, PEEP_INSTBYTES);
 }
 
@@ -66,6 +66,12 @@ extern int target_scalable(int32 m, int32 n);
 /*#define TARGET_HAS_TAILCALLR            1*/
 #define TARGET_HAS_RECURSIVE_TAILCALL_ONLY 1
 #define TARGET_HAS_MULTIPLY             1
+/* Thumb-2 (-cpu/-arch 6T2 or 7-M) adds IT blocks, and 7-M adds divide */
+#define TARGET_HAS_COND_EXEC            1
+#define target_has_cond_exec            (config & CONFIG_THUMB2)
+#define target_has_divide               (config & CONFIG_HARDWARE_DIVIDE)
+#define target_has_wide_immediates      (config & CONFIG_WIDE_IMMEDIATES)
+#define TARGET_HAS_COND_ALTERSCC        1
 #define TARGET_HAS_ROTATE               1
 #define TARGET_HAS_BLOCKMOVE            1
 #define THUMB_MOVC                      1
@@ -83,6 +89,9 @@ extern int target_scalable(int32 m, int32 n);
 
 #define DO_NOT_EXPLOIT_REGISTERS_PRESERVED_BY_CALLEE 1
 
+/* r8-r11 are not allocated, but can hold spilt binders (MOV to/from) */
+#define TARGET_HAS_SPILL_REGISTERS      1
+
 /* #define TARGET_INLINES_MONADS           1 */
 
 #define TARGET_LACKS_RR_UNALIGNED_ACCESSES 1
@@ -186,6 +195,7 @@ extern int target_scalable(int32 m, int32 n);
 #ifdef TARGET_HAS_AOF
 #  define TARGET_HAS_ADCON_AREA 1
 #  define TARGET_HAS_MULTIPLE_CODE_AREAS 1
+#  define TARGET_HAS_DATA_BLOCKS 1
 #endif
 
 
@@ -200,7 +210,7 @@ extern int target_scalable(int32 m, int32 n);
 #  define LDM_REGCOUNT_MIN_DEFAULT  3
 #endif
 
-#define TARGET_PREFIX(fname) "__16" ## fname
+#define TARGET_PREFIX(fname) "__16" fname
 
 #ifdef TARGET_HAS_DEBUGGER
 #  ifndef TARGET_HAS_DWARF